@@ -29,6 +29,8 @@ import subprocess
 import glob
 import tempfile
 import requests
+import hashlib
+import queue
 
 
 VERSION = "1.2"
@@ -84,6 +86,8 @@ class MediaSyncManager:
         self.bridge = bridge
         self.throttle_interval = throttle_interval  # seconds (default 10Hz = 0.1s)
         self.layers_state = {}  # {layer_name: {index, position, state, last_sent_time, last_sent_index}}
+        self.batch_enabled = True  # Send one MEDIA_SYNC_BATCH per tick (disabled if firmware rejects it)
+        self.pending_batch = []  # Layer updates waiting for flush_batch()
     
     def parse_media_index(self, filename):
         """Parse media index from filename (1-3 digits at start)"""
@@ -98,8 +102,12 @@ class MediaSyncManager:
             return min(max(index, 1), 127)
         return 0  # No index found
     
-    def update_layer(self, layer_name, filename, position, duration, state):
-        """Update layer state and send MIDI if needed"""
+    def update_layer(self, layer_name, filename, position, duration, state, defer=False):
+        """Update layer state and send MIDI if needed
+        
+        With defer=True (and batching enabled) the update is queued and sent with
+        the other layers of this tick by flush_batch().
+        """
         current_time = time.time()
         # Media index is always 0 when stopped, otherwise parse from filename
         media_index = 0 if state == 'stopped' else self.parse_media_index(filename)
@@ -139,21 +147,41 @@ class MediaSyncManager:
             fps = self.bridge.sync_settings['mtc_framerate']
             frame_correction_ms = int((frame_correction_frames / fps) * 1000) if fps > 0 else 0
             corrected_position_ms = max(0, position_ms + frame_correction_ms)
-            self.output_manager.send_media_sync(
-                layer_name=layer_name,
-                media_index=media_index,
-                position_ms=corrected_position_ms,
-                state=state
-            )
+            if defer and self.batch_enabled:
+                self.pending_batch.append({
+                    'layer_name': layer_name,
+                    'media_index': media_index,
+                    'position_ms': corrected_position_ms,
+                    'state': state
+                })
+            else:
+                self.output_manager.send_media_sync(
+                    layer_name=layer_name,
+                    media_index=media_index,
+                    position_ms=corrected_position_ms,
+                    state=state
+                )
             
             layer_state['last_sent_time'] = current_time
             layer_state['last_sent_index'] = media_index
     
+    def flush_batch(self):
+        """Send all deferred layer updates as a single MEDIA_SYNC_BATCH"""
+        if not self.pending_batch:
+            return
+        entries = self.pending_batch
+        self.pending_batch = []
+        self.output_manager.send_media_sync_batch(entries)
+    
     def set_throttle_interval(self, interval):
         """Update throttle interval (in seconds)"""
         self.throttle_interval = max(0.01, interval)  # Minimum 10ms
 
 class MilluBridge:
+    # Sender config keys of the RF simulation impairment model (PUSH_FULL_CONFIG extras)
+    RF_SIM_IMPAIRMENT_KEYS = ('rf_simulation_loss_percent', 'rf_simulation_reorder_percent',
+                              'rf_simulation_outage_per_mille', 'rf_simulation_outage_ms')
+    
     def __init__(self, osc_port=None):
         # Load config first
         if PERSIST_SETTINGS:
@@ -173,6 +201,9 @@ class MilluBridge:
             sysex_callback=self.handle_sysex_message
         )
         self.dali_manager = DaliManager(status_callback=self.on_dali_status_changed)
+        # OTA_ACK messages from the Nowde, consumed by the firmware upload thread
+        self.ota_ack_queue = queue.Queue()
+        self.last_mesh_ota_phase = None
         self.selected_port = None
         self.is_running = False
         self.last_osc_time = 0
@@ -206,6 +237,10 @@ class MilluBridge:
         self.remote_nowdes = {}  # {mac: {name, version, layer}}
         self.remote_nowdes_last_update = {}  # {mac: timestamp} - track when we last received update from Nowde
         self.running_state_session = None  # Aggregate chunked RUNNING_STATE responses
+        self.running_state_slots = {}  # {slot: receiver} maintained from RUNNING_STATE_DELTA
+        self.running_state_seq = None  # Last delta sequence number (None = no subscription yet)
+        self.running_state_last_delta = 0.0  # time.time() of the last delta or heartbeat
+        self.nowde_metrics = {}  # {mac: {'source', 'last', 'rates', 'p95_ms'}} from METRICS SysEx
         
         # Layer editing modal state
         self.editing_layer_mac = None  # Track which device is being edited
@@ -293,6 +328,8 @@ class MilluBridge:
                 
                 config['sender_config'].setdefault('rf_simulation_enabled', False)
                 config['sender_config'].setdefault('rf_simulation_max_delay_ms', 400)
+                for key in self.RF_SIM_IMPAIRMENT_KEYS:
+                    config['sender_config'].setdefault(key, 0)
                 
                 print(f"Config loaded from {self.config_file}")
                 return config
@@ -321,7 +358,11 @@ class MilluBridge:
         return {
             "sender_config": {
                 "rf_simulation_enabled": False,
-                "rf_simulation_max_delay_ms": 400
+                "rf_simulation_max_delay_ms": 400,
+                "rf_simulation_loss_percent": 0,
+                "rf_simulation_reorder_percent": 0,
+                "rf_simulation_outage_per_mille": 0,
+                "rf_simulation_outage_ms": 0
             },
             "gui_preferences": {
                 "window_position": [100, 100],
@@ -481,6 +522,12 @@ class MilluBridge:
                         dpg.add_text("[X]", tag="nowde_status_indicator", color=(255, 0, 0))  # Red by default
                         dpg.add_text("Not connected", tag="nowde_status_text", color=(150, 150, 150))
                         dpg.add_button(label="Show Logs", tag="nowde_logs_toggle_btn", callback=self.toggle_nowde_logs, width=100)
+                        dpg.add_button(label="Benchmark", tag="nowde_benchmark_btn", callback=self.run_nowde_benchmark, width=100)
+                        dpg.add_button(label="Channel Survey", tag="nowde_channel_survey_btn", callback=self.run_channel_survey, width=120)
+                        dpg.add_button(label="Diagnostics", tag="nowde_diagnostics_btn", callback=self.run_nowde_diagnostics, width=100)
+                        dpg.add_input_int(tag="nowde_phantom_count", default_value=0, width=40, step=0,
+                                          min_value=0, min_clamped=True, max_value=48, max_clamped=True)
+                        dpg.add_button(label="Phantoms", tag="nowde_phantoms_btn", callback=self.run_phantom_receivers, width=80)
                     
                     # Nowde version and firmware upgrade
                     with dpg.group(horizontal=True):
@@ -489,6 +536,8 @@ class MilluBridge:
                         dpg.add_spacer(width=20)
                         dpg.add_button(label="Upgrade Firmware", tag="upgrade_nowde_btn",
                                      callback=self.upgrade_nowde_firmware, width=150)
+                        dpg.add_button(label="Upgrade Receivers", tag="upgrade_receivers_btn",
+                                     callback=self.upgrade_receivers_firmware, width=150)
                     dpg.add_progress_bar(tag="firmware_upload_progress", 
                                         default_value=0.0, width=-1, show=False)
                     dpg.add_text("", tag="firmware_upload_status", color=(150, 150, 150))
@@ -535,8 +584,24 @@ class MilluBridge:
                 dpg.add_table_column(label="State", width_fixed=True, init_width_or_weight=80)
                 dpg.add_table_column(label="Index", width_fixed=True, init_width_or_weight=60)
                 dpg.add_table_column(label="Layer", width_fixed=True, init_width_or_weight=150)
+                dpg.add_table_column(label="Sync", width_fixed=True, init_width_or_weight=110)
+                dpg.add_table_column(label="Link", width_fixed=True, init_width_or_weight=130)
                 dpg.add_table_column(label="Simulate", width_fixed=True, init_width_or_weight=100)
             
+            # Per-Nowde counters and latency percentiles (METRICS SysEx, rates over the last report)
+            dpg.add_text("Nowde Metrics", color=(150, 200, 255))
+            with dpg.table(header_row=True, tag="nowde_metrics_table",
+                          borders_innerH=True, borders_outerH=True,
+                          borders_innerV=True, borders_outerV=True,
+                          row_background=True, resizable=True, height=120):
+                dpg.add_table_column(label="Nowde", width_fixed=True, init_width_or_weight=100)
+                dpg.add_table_column(label="Sync/s", width_fixed=True, init_width_or_weight=70)
+                dpg.add_table_column(label="Discards/s", width_fixed=True, init_width_or_weight=80)
+                dpg.add_table_column(label="TX fail/s", width_fixed=True, init_width_or_weight=70)
+                dpg.add_table_column(label="USB>TX p95", width_fixed=True, init_width_or_weight=90)
+                dpg.add_table_column(label="RX>MTC p95", width_fixed=True, init_width_or_weight=90)
+                dpg.add_table_column(label="|Delta| p95", width_fixed=True, init_width_or_weight=90)
+            
             dpg.add_separator()
             
             # Simulation Clock control
@@ -566,6 +631,30 @@ class MilluBridge:
                                  min_value=1, max_value=1000, width=100,
                                  callback=self.on_rf_sim_max_delay_changed)
                 dpg.add_text("ms")
+            with dpg.group(horizontal=True):
+                dpg.add_text("Loss")
+                dpg.add_slider_int(tag="rf_sim_loss_slider",
+                                 default_value=self.config['sender_config']['rf_simulation_loss_percent'],
+                                 min_value=0, max_value=100, width=80, format="%d%%",
+                                 user_data='rf_simulation_loss_percent',
+                                 callback=self.on_rf_sim_impairment_changed)
+                dpg.add_text("Reorder")
+                dpg.add_slider_int(tag="rf_sim_reorder_slider",
+                                 default_value=self.config['sender_config']['rf_simulation_reorder_percent'],
+                                 min_value=0, max_value=100, width=80, format="%d%%",
+                                 user_data='rf_simulation_reorder_percent',
+                                 callback=self.on_rf_sim_impairment_changed)
+                dpg.add_text("Outage")
+                dpg.add_slider_int(tag="rf_sim_outage_rate_slider",
+                                 default_value=self.config['sender_config']['rf_simulation_outage_per_mille'],
+                                 min_value=0, max_value=127, width=80, format="%d/1000",
+                                 user_data='rf_simulation_outage_per_mille',
+                                 callback=self.on_rf_sim_impairment_changed)
+                dpg.add_slider_int(tag="rf_sim_outage_ms_slider",
+                                 default_value=self.config['sender_config']['rf_simulation_outage_ms'],
+                                 min_value=0, max_value=5000, width=80, format="%d ms",
+                                 user_data='rf_simulation_outage_ms',
+                                 callback=self.on_rf_sim_impairment_changed)
 
     def handle_sysex_message(self, msg_type, data):
         """Handle parsed SysEx messages from Nowde"""
@@ -591,17 +680,19 @@ class MilluBridge:
             # Mark sender as initialized
             self.sender_initialized = True
             
+            # Assume batched sync until the firmware reports it as unknown
+            self.media_sync.batch_enabled = True
+            
             # Clear stale state
             self.remote_nowdes.clear()
+            self.nowde_metrics.clear()
             self.update_remote_nowdes_table()
+            self.update_metrics_table()
             
             # Push our config to sender (don't query again - we already did that)
             if self.current_nowde_device and self.output_manager.current_port:
                 # Push saved config to sender
-                rf_sim_enabled = self.config['sender_config']['rf_simulation_enabled']
-                rf_sim_max_delay = self.config['sender_config']['rf_simulation_max_delay_ms']
-                
-                result = self.output_manager.send_push_full_config(rf_sim_enabled, rf_sim_max_delay)
+                result = self._push_sender_config()
                 if result and result[0]:
                     success, formatted_msg = result
                     self.log_nowde_message(f"TX: {formatted_msg}")
@@ -613,11 +704,23 @@ class MilluBridge:
                 if result and result[0]:
                     success, formatted_msg = result
                     self.log_nowde_message(f"TX: {formatted_msg}")
+                
+                # Then ask for change-driven updates; older firmware answers with an
+                # unknown-command error and stays on polling
+                self.running_state_seq = None
+                self.running_state_last_delta = 0.0
+                result = self.output_manager.send_subscribe_running_state(True)
+                if result and result[0]:
+                    success, formatted_msg = result
+                    self.log_nowde_message(f"TX: {formatted_msg}")
         
         elif msg_type == 'config_state':
             # Update config from sender's response
             self.config['sender_config']['rf_simulation_enabled'] = data['rf_simulation_enabled']
             self.config['sender_config']['rf_simulation_max_delay_ms'] = data['rf_simulation_max_delay_ms']
+            for key in self.RF_SIM_IMPAIRMENT_KEYS:
+                if key in data:
+                    self.config['sender_config'][key] = data[key]
             
             # Update GUI if RF sim checkbox exists
             if dpg.does_item_exist("rf_sim_checkbox"):
@@ -679,6 +782,9 @@ class MilluBridge:
                 )
                 self.running_state_session = None
         
+        elif msg_type == 'running_state_delta':
+            self._handle_running_state_delta(data)
+        
         elif msg_type == 'error_report':
             # Log error from Nowde
             error_msg = f"Nowde Error: {data['error_name']} (0x{data['error_code']:02X})"
@@ -686,12 +792,98 @@ class MilluBridge:
                 error_msg += f" Context: {' '.join(f'{b:02X}' for b in data['context_bytes'])}"
             self.update_osc_log(error_msg)
             self.log_nowde_message(f"ERROR: {error_msg}")
+            
+            # Older firmware rejects MEDIA_SYNC_BATCH as an unknown command: fall back to per-layer sync
+            if (data['error_code'] == 0x02 and list(data['context_bytes']) == [self.output_manager.SYSEX_CMD_MEDIA_SYNC_BATCH]
+                    and self.media_sync.batch_enabled):
+                self.media_sync.batch_enabled = False
+                self.update_osc_log("Nowde firmware does not support batched sync - using per-layer MEDIA_SYNC")
+        
+        elif msg_type == 'ota_ack':
+            self.ota_ack_queue.put(data)
+        
+        elif msg_type == 'mesh_ota_status':
+            self._handle_mesh_ota_status(data)
+        
+        elif msg_type == 'metrics':
+            self._handle_metrics(data)
+            self.update_metrics_table()
+        
+        elif msg_type == 'benchmark_result':
+            self.log_nowde_message(self._format_benchmark_result(data))
+        
+        elif msg_type == 'channel_survey':
+            for line in self._format_channel_survey(data):
+                self.log_nowde_message(line)
+        
+        elif msg_type == 'diagnostics':
+            for line in self._format_diagnostics(data):
+                self.log_nowde_message(line)
+        
+        elif msg_type == 'phantom_report':
+            for line in self._format_phantom_report(data):
+                self.log_nowde_message(line)
         
         elif msg_type == 'sysex_received':
             # Log received SysEx in human-readable format
             self.log_nowde_message(f"RX: {data}")
     
-    def _apply_running_state_receivers(self, receivers, current_time, mesh_synced, uptime_s, total_receivers):
+    def _handle_running_state_delta(self, data):
+        """Apply a RUNNING_STATE_DELTA (slot-keyed JOIN/UPDATE/LEAVE ops, or a heartbeat)."""
+        current_time = time.time()
+        expected_seq = None if self.running_state_seq is None else (self.running_state_seq + 1) & 0x7F
+        
+        if data['reset']:
+            self.running_state_slots = {}
+        elif expected_seq is None:
+            return  # Waiting for the RESET baseline we asked for
+        elif data['seq'] != expected_seq:
+            # Missed a delta: our slot map can't be trusted, ask for a new baseline
+            self.running_state_seq = None
+            self.output_manager.send_subscribe_running_state(True)
+            return
+        
+        self.running_state_seq = data['seq']
+        self.running_state_last_delta = current_time
+        
+        membership_changed = data['reset']
+        for op in data['ops']:
+            if op['op'] == 'join':
+                receiver = dict(op['receiver'])
+                receiver['_reported_at'] = current_time
+                self.running_state_slots[op['slot']] = receiver
+                membership_changed = True
+            elif op['op'] == 'update' and op['slot'] in self.running_state_slots:
+                receiver = self.running_state_slots[op['slot']]
+                receiver.update(op['fields'])
+                receiver['_reported_at'] = current_time
+            elif op['op'] == 'leave':
+                membership_changed |= self.running_state_slots.pop(op['slot'], None) is not None
+        
+        if not data['more'] and len(self.running_state_slots) != data['total_receivers']:
+            # Out of step despite the sequence check: ask for a fresh baseline
+            self.running_state_seq = None
+            self.output_manager.send_subscribe_running_state(True)
+            return
+        
+        # lastSeen was reported at _reported_at; age it locally between updates
+        receivers = []
+        for receiver in self.running_state_slots.values():
+            aged = {k: v for k, v in receiver.items() if k != '_reported_at'}
+            aged['last_seen_ms'] = receiver['last_seen_ms'] + int((current_time - receiver['_reported_at']) * 1000)
+            receivers.append(aged)
+        
+        self._apply_running_state_receivers(
+            receivers,
+            current_time,
+            data['mesh_synced'],
+            data['uptime_s'],
+            data['total_receivers'],
+            log_summary=membership_changed
+        )
+    
+    def _apply_running_state_receivers(self, receivers, current_time, mesh_synced, uptime_s, total_receivers,
+                                       log_summary=True):
         """Apply a fully aggregated RUNNING_STATE update to the remote Nowde table."""
         received_macs = set()
         receiver_count = len(receivers)
@@ -733,10 +925,11 @@ class MilluBridge:
         # Update GUI (handles 15-minute removal logic)
         self.update_remote_nowdes_table()
 
-        mesh_status = "SYNCED" if mesh_synced else "NOT SYNCED"
-        self.update_osc_log(
-            f"Running state: Uptime {uptime_s:.1f}s, Mesh {mesh_status}, {total_receivers} receiver(s)"
-        )
+        if log_summary:
+            mesh_status = "SYNCED" if mesh_synced else "NOT SYNCED"
+            self.update_osc_log(
+                f"Running state: Uptime {uptime_s:.1f}s, Mesh {mesh_status}, {total_receivers} receiver(s)"
+            )
 
     def on_layer_changed(self, mac_address, new_layer):
         """Handle layer change from GUI"""
@@ -850,6 +1043,125 @@ class MilluBridge:
             return full_name.split(':', 1)[0]
         return full_name
     
+    def _format_sync_state(self, sync, clock, text_color):
+        """Short text + color for a receiver's sync estimator / clock reports (None on older firmware)."""
+        if not sync:
+            return "-", text_color
+        if clock and not clock['mesh_synced']:
+            # Mesh clock still converging: sync runs on the beacon offset (if any)
+            if clock['offset_valid']:
+                return f"clk {clock['sender_offset_ms']:+d}ms", (255, 200, 0)
+            return "clk unsynced", (255, 80, 80)
+        if not sync['tracking']:
+            return "idle", text_color
+        if sync['locked']:
+            return f"LOCK ±{sync['jitter_ms']:.1f}ms", (0, 255, 0)
+        return f"slew {sync['error_ms']:+.1f}ms", (255, 200, 0)
+    
+    @staticmethod
+    def _histogram_p95_ms(buckets, base_us):
+        """Upper bound (ms) of the log2 bucket holding the 95th percentile, None when empty."""
+        total = sum(buckets)
+        if total == 0:
+            return None
+        threshold = total * 0.95
+        running = 0
+        for i, count in enumerate(buckets):
+            running += count
+            if running >= threshold:
+                return (base_us << i) / 1000.0
+        return (base_us << (len(buckets) - 1)) / 1000.0
+    
+    def _handle_metrics(self, data):
+        """Turn cumulative METRICS counters into per-second rates and per-report percentiles."""
+        mac = data['mac']
+        entry = self.nowde_metrics.get(mac)
+        last = entry['last'] if entry else None
+        
+        # Nowde rebooted (or first report): diff against zero
+        if last is None or data['uptime_ms'] < last['uptime_ms']:
+            last = {'uptime_ms': 0, 'counters': {}, 'histograms': {}}
+        
+        elapsed_s = max(0.001, (data['uptime_ms'] - last['uptime_ms']) / 1000.0)
+        deltas = {name: (value - last['counters'].get(name, 0)) & 0xFFFFFFFF
+                  for name, value in data['counters'].items()}
+        
+        p95_ms = {}
+        for name, buckets in data['histograms'].items():
+            previous = last['histograms'].get(name, [0] * len(buckets))
+            window = [(cur - prev) & 0xFFFF for cur, prev in zip(buckets, previous)]
+            p95_ms[name] = self._histogram_p95_ms(window, data['bucket_base_us'])
+        
+        discards = sum(deltas.get(name, 0) for name in ('discard_desync', 'discard_sender', 'discard_malformed'))
+        self.nowde_metrics[mac] = {
+            'source': data['source'],
+            'last': data,
+            'rates': {
+                'sync': (deltas.get('sync_rx', 0) + deltas.get('sync_tx', 0)) / elapsed_s,
+                'discards': discards / elapsed_s,
+                'tx_fail': deltas.get('espnow_tx_fail', 0) / elapsed_s
+            },
+            'p95_ms': p95_ms
+        }
+    
+    def update_metrics_table(self):
+        """Rebuild the Nowde Metrics table (one row per reporting Nowde, sender first)."""
+        if not dpg.does_item_exist("nowde_metrics_table"):
+            return
+        
+        children = dpg.get_item_children("nowde_metrics_table", slot=1)
+        for child in children or []:
+            dpg.delete_item(child)
+        
+        def fmt_ms(value):
+            return "-" if value is None else f"<{value:.1f}ms"
+        
+        ordered = sorted(self.nowde_metrics.items(), key=lambda x: (x[1]['source'] != 'self', x[0]))
+        for mac, metrics in ordered:
+            if metrics['source'] == 'self':
+                name = "Sender"
+            else:
+                name = self.remote_nowdes.get(mac, {}).get('uuid', mac)
+            rates = metrics['rates']
+            p95 = metrics['p95_ms']
+            discard_color = (255, 200, 0) if rates['discards'] > 0 else (255, 255, 255)
+            fail_color = (255, 80, 80) if rates['tx_fail'] > 0 else (255, 255, 255)
+            with dpg.table_row(parent="nowde_metrics_table"):
+                dpg.add_text(name)
+                dpg.add_text(f"{rates['sync']:.1f}")
+                dpg.add_text(f"{rates['discards']:.1f}", color=discard_color)
+                dpg.add_text(f"{rates['tx_fail']:.1f}", color=fail_color)
+                dpg.add_text(fmt_ms(p95.get('usb_to_espnow')))
+                dpg.add_text(fmt_ms(p95.get('rx_to_mtc')))
+                dpg.add_text(fmt_ms(p95.get('sync_delta')))
+    
+    def _format_link_state(self, link, text_color, tx=None):
+        """Short text + color for a receiver's link report (None on older firmware).
+        tx is the sender's TX report towards the receiver, if the sender has one."""
+        if not link:
+            return "-", text_color
+        # Weakest direction decides: receiver hearing the sender, or the sender hearing it
+        heard = [r for r in (link['rssi_avg_dbm'], link['uplink_rssi_dbm']) if r != 0]
+        rssi = min(heard) if heard else None
+        total = link['sync_received'] + link['sync_discarded']
+        loss_pct = 100.0 * link['sync_discarded'] / total if total else 0.0
+        
+        text = f"{rssi}dBm" if rssi is not None else "? dBm"
+        text += f" {loss_pct:.0f}%"
+        if link['link_lost']:
+            text += f" lost {link['link_lost']}"
+        tx_failed = tx['failed'] if tx else 0
+        if tx_failed:
+            text += f" txfail {tx_failed}"
+        
+        if rssi is None or rssi < -80 or loss_pct > 10:
+            color = (255, 80, 80)
+        elif rssi < -70 or loss_pct > 0 or link['link_lost'] or tx_failed:
+            color = (255, 200, 0)
+        else:
+            color = (0, 255, 0)
+        return text, color
+    
     def update_remote_nowdes_table(self):
         """Update the Remote Nowdes table in the GUI"""
         if not dpg.does_item_exist("remote_nowdes_table"):
@@ -915,9 +1227,14 @@ class MilluBridge:
             version_tag = f"nowde_version_{mac}"
             state_tag = f"nowde_state_{mac}"
             index_tag = f"nowde_index_{mac}"
+            sync_tag = f"nowde_sync_{mac}"
+            link_tag = f"nowde_link_{mac}"
             layer_btn_tag = f"layer_btn_{mac}"
             sim_combo_tag = f"sim_combo_{mac}"
             
+            sync_text, sync_color = self._format_sync_state(nowde.get('sync'), nowde.get('clock'), text_color)
+            link_text, link_color = self._format_link_state(nowde.get('link'), text_color, nowde.get('tx'))
+            
             if mac in existing_rows:
                 # Update existing row
                 if dpg.does_item_exist(uuid_tag):
@@ -935,6 +1252,12 @@ class MilluBridge:
                     dpg.configure_item(index_tag, color=text_color)
                 if dpg.does_item_exist(layer_btn_tag):
                     dpg.configure_item(layer_btn_tag, label=nowde.get('layer', '-'))
+                if dpg.does_item_exist(sync_tag):
+                    dpg.set_value(sync_tag, sync_text)
+                    dpg.configure_item(sync_tag, color=sync_color)
+                if dpg.does_item_exist(link_tag):
+                    dpg.set_value(link_tag, link_text)
+                    dpg.configure_item(link_tag, color=link_color)
                 # Simulation combo is handled by callback, no need to update
             else:
                 # Create new row
@@ -954,6 +1277,8 @@ class MilluBridge:
                         callback=lambda s, a, u: self.open_layer_editor(u['mac']),
                         user_data={'mac': mac}
                     )
+                    dpg.add_text(sync_text, tag=sync_tag, color=sync_color)
+                    dpg.add_text(link_text, tag=link_tag, color=link_color)
                     dpg.add_combo(
                         tag=sim_combo_tag,
                         items=sim_options,
@@ -1558,14 +1883,16 @@ class MilluBridge:
             
             # Send sync for all tracked layers
             if self.current_nowde_device and self.layers:
-                for layer_name, layer_data in self.layers.items():
+                for layer_name, layer_data in list(self.layers.items()):
                     self.media_sync.update_layer(
                         layer_name=layer_name,
                         filename=layer_data["filename"],
                         position=layer_data["position"],
                         duration=layer_data["duration"],
-                        state=layer_data["state"]
+                        state=layer_data["state"],
+                        defer=True
                     )
+                self.media_sync.flush_batch()
     
     def start_running_state_thread(self):
         """Start background thread to query running state periodically"""
@@ -1574,8 +1901,11 @@ class MilluBridge:
         def running_state_loop():
             while not self.stop_running_state:
                 try:
-                    # Query running state only if sender is initialized (received HELLO)
-                    if self.current_nowde_device and self.output_manager.current_port and self.sender_initialized:
+                    # Query running state only if sender is initialized (received HELLO),
+                    # and only while no subscription deltas/heartbeats are coming in
+                    subscribed = (time.time() - self.running_state_last_delta) < 3.0
+                    if (self.current_nowde_device and self.output_manager.current_port
+                            and self.sender_initialized and not subscribed):
                         self.output_manager.send_query_running_state()
                     time.sleep(2.0)  # 0.5Hz query rate to reduce large SysEx bursts
                 except Exception as e:
@@ -1754,8 +2084,7 @@ class MilluBridge:
         
         # Send to Nowde if connected
         if self.current_nowde_device:
-            rf_sim_max_delay = self.config['sender_config']['rf_simulation_max_delay_ms']
-            result = self.output_manager.send_push_full_config(rf_sim_enabled, rf_sim_max_delay)
+            result = self._push_sender_config()
             if result and result[0]:
                 success, formatted_msg = result
                 self.log_nowde_message(f"TX: {formatted_msg}")
@@ -1779,8 +2108,7 @@ class MilluBridge:
         
         # Send to Nowde if connected and RF sim is enabled
         if self.current_nowde_device:
-            rf_sim_enabled = self.config['sender_config']['rf_simulation_enabled']
-            result = self.output_manager.send_push_full_config(rf_sim_enabled, rf_sim_max_delay)
+            result = self._push_sender_config()
             if result and result[0]:
                 success, formatted_msg = result
                 self.log_nowde_message(f"TX: {formatted_msg}")
@@ -1793,6 +2121,135 @@ class MilluBridge:
         # Save config to file
         self.save_config()
     
+    def on_rf_sim_impairment_changed(self, sender, app_data, user_data):
+        """Callback for the RF simulation loss / reorder / outage sliders (user_data is the config key)"""
+        self.config['sender_config'][user_data] = app_data
+        
+        if self.current_nowde_device:
+            result = self._push_sender_config()
+            if result and result[0]:
+                success, formatted_msg = result
+                self.log_nowde_message(f"TX: {formatted_msg}")
+            else:
+                self.update_osc_log("Error: Failed to send RF simulation config")
+        
+        self.save_config()
+    
+    def _push_sender_config(self):
+        """Send the saved sender config (RF simulation settings) to the Nowde"""
+        cfg = self.config['sender_config']
+        return self.output_manager.send_push_full_config(
+            cfg['rf_simulation_enabled'], cfg['rf_simulation_max_delay_ms'],
+            cfg['rf_simulation_loss_percent'], cfg['rf_simulation_reorder_percent'],
+            cfg['rf_simulation_outage_per_mille'], cfg['rf_simulation_outage_ms'])
+    
+    def run_nowde_benchmark(self):
+        """Run the on-device benchmarks of the connected Nowde; results land in the Nowde log"""
+        if not self.current_nowde_device:
+            self.update_osc_log("ERROR: No Nowde connected")
+            return
+        
+        result = self.output_manager.send_run_benchmark()
+        if result:
+            self.log_nowde_message(f"TX: {result[1]}")
+            self.update_osc_log("Nowde benchmark started (results in the Nowde log)")
+    
+    @staticmethod
+    def _format_benchmark_result(data):
+        """One log line per BENCHMARK_RESULT, timings in microseconds"""
+        def us(ns):
+            return f"{ns / 1000:.1f}"
+        return (f"BENCH {data['name']} ({data['param']} {data['param_name']}, n={data['samples']}): "
+                f"min {us(data['min_ns'])} / avg {us(data['avg_ns'])} / max {us(data['max_ns'])} us")
+    
+    def run_channel_survey(self):
+        """Survey the WiFi channels from the sender; it moves the mesh if one is clearly better"""
+        if not self.current_nowde_device:
+            self.update_osc_log("ERROR: No Nowde connected")
+            return
+        
+        result = self.output_manager.send_channel_survey(auto_switch=True)
+        if result:
+            self.log_nowde_message(f"TX: {result[1]}")
+            self.update_osc_log("Channel survey started (results in the Nowde log)")
+    
+    @staticmethod
+    def _format_channel_survey(data):
+        """Summary line plus one line per channel for a CHANNEL_SURVEY_REPORT"""
+        if data['chosen']:
+            outcome = f"switching to {data['chosen']}"
+        else:
+            outcome = "staying"
+        lines = [f"CHANNEL survey: on {data['current']} (loss {data['loss_percent']}%), {outcome}"]
+        for entry in data['channels']:
+            marker = '*' if entry['channel'] == data['current'] else ' '
+            lines.append(f"  {marker}ch {entry['channel']:2d}: {entry['ap_count']:3d} AP(s), "
+                         f"{entry['interference_dbm']} dBm")
+        return lines
+    
+    def run_nowde_diagnostics(self):
+        """Query heap, table and task stack usage of the connected Nowde; results land in the Nowde log"""
+        if not self.current_nowde_device:
+            self.update_osc_log("ERROR: No Nowde connected")
+            return
+        
+        result = self.output_manager.send_query_diagnostics()
+        if result:
+            self.log_nowde_message(f"TX: {result[1]}")
+    
+    # Stack headroom below this is flagged in the DIAGNOSTICS log lines
+    DIAGNOSTICS_STACK_WARN_BYTES = 512
+    
+    @classmethod
+    def _format_diagnostics(cls, data):
+        """Heap and table summary plus one line per task for a DIAGNOSTICS report"""
+        receivers = data['receiver_entry_bytes'] * data['receiver_slots']
+        senders = data['sender_entry_bytes'] * data['sender_slots']
+        lines = [f"DIAG heap: {data['heap_free']} bytes free (min {data['heap_min_free']}), "
+                 f"tables: receivers {data['receiver_slots']} x {data['receiver_entry_bytes']} = {receivers} B, "
+                 f"senders {data['sender_slots']} x {data['sender_entry_bytes']} = {senders} B"]
+        for task in data['tasks']:
+            size = f"{task['stack_size']}" if task['stack_size'] else "?"
+            warn = "  << low" if task['stack_free_min'] < cls.DIAGNOSTICS_STACK_WARN_BYTES else ""
+            lines.append(f"  {task['name']:<14} stack {size:>5} B, never used {task['stack_free_min']:>5} B{warn}")
+        return lines
+    
+    def run_phantom_receivers(self):
+        """Make the sender emulate N receivers on the Millumin layers (0 stops them); reports land in the Nowde log"""
+        if not self.current_nowde_device:
+            self.update_osc_log("ERROR: No Nowde connected")
+            return
+        
+        count = dpg.get_value("nowde_phantom_count") if dpg.does_item_exist("nowde_phantom_count") else 0
+        layers = sorted(self.layers.keys())
+        result = self.output_manager.send_phantom_receivers(count, layers)
+        if result:
+            self.log_nowde_message(f"TX: {result[1]}")
+            if count:
+                self.update_osc_log(f"Phantom receivers: {count} on {len(layers) or 'the default'} layer(s)")
+            else:
+                self.update_osc_log("Phantom receivers stopped")
+    
+    @staticmethod
+    def _format_phantom_report(data):
+        """Summary line per PHANTOM_REPORT; the final one (stopped) adds a line per phantom"""
+        phantoms = data['phantoms']
+        expected = sum(p['expected'] for p in phantoms)
+        arrived = sum(p['arrived'] for p in phantoms)
+        lost = max(0, expected - arrived)
+        loss = 100.0 * lost / expected if expected else 0.0
+        avg_us = (sum(p['latency_avg_us'] * p['arrived'] for p in phantoms) / arrived) if arrived else 0
+        max_us = max((p['latency_max_us'] for p in phantoms), default=0)
+        state = "running" if data['running'] else "stopped"
+        lines = [f"PHANTOM {len(phantoms)} ({state}): {arrived}/{expected} sync frames, loss {loss:.1f}%, "
+                 f"latency avg {avg_us / 1000:.2f} / max {max_us / 1000:.2f} ms"]
+        if not data['running']:
+            for p in phantoms:
+                lines.append(f"  #{p['index']:2d} layer {p['layer_id']:2d}: {p['arrived']}/{p['expected']} "
+                             f"(lost {p['lost']}), avg {p['latency_avg_us'] / 1000:.2f} / "
+                             f"max {p['latency_max_us'] / 1000:.2f} ms")
+        return lines
+    
     def upgrade_nowde_firmware(self):
         """Upgrade Nowde firmware from GitHub"""
         if not self.current_nowde_device:
@@ -1816,106 +2273,112 @@ class MilluBridge:
         thread = threading.Thread(target=self._upgrade_firmware_thread, daemon=True)
         thread.start()
     
-    def _upgrade_firmware_thread(self):
-        """Background thread for firmware upgrade via OTA"""
-        firmware_file = None
+    def _download_firmware(self):
+        """Download the latest Nowde firmware image from GitHub"""
+        self.update_osc_log("Downloading firmware from GitHub...")
+        firmware_url = "https://github.com/Hemisphere-Project/MillluBridge/raw/refs/heads/main/Nowde/bin/firmware.bin"
+        
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Downloading...")
+        
+        # Download with timeout
+        response = requests.get(firmware_url, timeout=30)
+        response.raise_for_status()
+        
+        firmware_data = response.content
+        self.update_osc_log(f"✅ Downloaded firmware ({len(firmware_data)} bytes)")
+        
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.set_value("firmware_upload_progress", 0.1)
+        return firmware_data
+    
+    def upgrade_receivers_firmware(self):
+        """Upgrade all receiver Nowdes over ESP-NOW, relayed by the USB-connected sender"""
+        if not self.current_nowde_device:
+            self.update_osc_log("ERROR: No Nowde connected")
+            return
+        
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Fetching firmware from GitHub...")
+            dpg.configure_item("firmware_upload_status", color=(255, 255, 0))
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.configure_item("firmware_upload_progress", show=True)
+            dpg.set_value("firmware_upload_progress", 0.0)
+        
+        self.update_osc_log("Starting mesh firmware upgrade of receivers...")
+        thread = threading.Thread(target=self._upgrade_receivers_thread, daemon=True)
+        thread.start()
+    
+    def _upgrade_receivers_thread(self):
+        """Background thread: upload the image to the sender, which relays it over ESP-NOW"""
         try:
-            # Step 1: Download firmware from GitHub
-            self.update_osc_log("Downloading firmware from GitHub...")
-            firmware_url = "https://github.com/Hemisphere-Project/MillluBridge/raw/refs/heads/main/Nowde/bin/firmware.bin"
+            firmware_data = self._download_firmware()
+            if not self._upload_firmware_v2(firmware_data, target=self.output_manager.OTA_TARGET_MESH):
+                raise Exception("Nowde firmware too old for mesh OTA - upgrade the sender first")
             
+            # Progress from here on comes from MESH_OTA_STATUS reports
+            self.update_osc_log("✅ Image verified by sender - relaying to receivers over ESP-NOW...")
             if dpg.does_item_exist("firmware_upload_status"):
-                dpg.set_value("firmware_upload_status", "Downloading...")
-            
-            # Download with timeout
-            response = requests.get(firmware_url, timeout=30)
-            response.raise_for_status()
-            
-            firmware_data = response.content
-            firmware_size = len(firmware_data)
-            self.update_osc_log(f"✅ Downloaded firmware ({firmware_size} bytes)")
-            
+                dpg.set_value("firmware_upload_status", "Relaying to receivers...")
             if dpg.does_item_exist("firmware_upload_progress"):
-                dpg.set_value("firmware_upload_progress", 0.1)
-            
-            # Step 2: Send OTA_BEGIN
+                dpg.set_value("firmware_upload_progress", 0.0)
+        
+        except requests.exceptions.RequestException as e:
+            self.update_osc_log(f"❌ Download failed: {str(e)}")
             if dpg.does_item_exist("firmware_upload_status"):
-                dpg.set_value("firmware_upload_status", "Starting OTA update...")
-            
-            self.update_osc_log("Starting OTA update...")
-            result = self.output_manager.send_ota_begin(firmware_size)
-            
-            if not result or not result[0]:
-                raise Exception("Failed to send OTA_BEGIN")
-            
-            time.sleep(0.2)  # Give device time to prepare
-            
+                dpg.set_value("firmware_upload_status", "Download failed - check network")
+                dpg.configure_item("firmware_upload_status", color=(255, 0, 0))
             if dpg.does_item_exist("firmware_upload_progress"):
-                dpg.set_value("firmware_upload_progress", 0.15)
-            
-            # Step 3: Send firmware data in chunks
+                dpg.configure_item("firmware_upload_progress", show=False)
+        
+        except Exception as e:
+            self.update_osc_log(f"❌ Mesh OTA failed: {str(e)}")
             if dpg.does_item_exist("firmware_upload_status"):
-                dpg.set_value("firmware_upload_status", "Uploading firmware...")
-            
-            self.update_osc_log("Uploading firmware data...")
-            
-            # Use smaller chunks to avoid buffer overflow
-            # 100 bytes raw -> ~115 bytes encoded + headers = ~120 bytes total SysEx message
-            chunk_size = 100
-            sent_bytes = 0
-            chunk_count = 0
-            
-            # Conservative timing to avoid USB buffer overflow
-            # ESP32 needs time to decode, write to flash, and process
-            chunk_delay = 0.025  # 25ms per chunk
-            
-            for i in range(0, firmware_size, chunk_size):
-                chunk = firmware_data[i:i+chunk_size]
-                result = self.output_manager.send_ota_data(chunk)
-                
-                if not result or not result[0]:
-                    raise Exception(f"Failed to send OTA_DATA at offset {i}")
-                
-                sent_bytes += len(chunk)
-                chunk_count += 1
-                progress = 0.15 + (sent_bytes / firmware_size) * 0.75  # 15% to 90%
-                
-                if dpg.does_item_exist("firmware_upload_progress"):
-                    dpg.set_value("firmware_upload_progress", progress)
-                
-                # Log progress every 10%
-                percent = (sent_bytes * 100) // firmware_size
-                if percent % 10 == 0 and sent_bytes > 0:
-                    self.update_osc_log(f"  Progress: {percent}% ({sent_bytes}/{firmware_size} bytes, {chunk_delay*1000:.0f}ms/chunk)")
-                
-                # Every 100 chunks, give device extra time for flash writes
-                if chunk_count % 100 == 0:
-                    time.sleep(0.15)  # 150ms pause
-                else:
-                    time.sleep(chunk_delay)
-            
-            # Log final byte count
-            self.update_osc_log(f"✅ Sent all {sent_bytes} bytes ({chunk_count} chunks)")
-            
-            # Wait for device to finish writing all buffered data to flash
-            self.update_osc_log("Waiting for device to finish writing to flash...")
-            time.sleep(2)
-            
+                dpg.set_value("firmware_upload_status", str(e))
+                dpg.configure_item("firmware_upload_status", color=(255, 0, 0))
             if dpg.does_item_exist("firmware_upload_progress"):
-                dpg.set_value("firmware_upload_progress", 0.9)
-            
-            # Step 4: Send OTA_END
-            if dpg.does_item_exist("firmware_upload_status"):
-                dpg.set_value("firmware_upload_status", "Finalizing update...")
-            
-            self.update_osc_log("Finalizing firmware update...")
-            result = self.output_manager.send_ota_end()
-            
-            if not result or not result[0]:
-                raise Exception("Failed to send OTA_END")
+                dpg.configure_item("firmware_upload_progress", show=False)
+    
+    def _handle_mesh_ota_status(self, data):
+        """Show mesh OTA relay progress reported by the sender"""
+        receivers = data['receivers']
+        chunk_count = max(1, data['chunk_count'])
+        done = sum(1 for r in receivers if r['state_name'] == 'DONE')
+        failed = sum(1 for r in receivers if r['state_name'] == 'FAILED')
+        
+        if data['phase_name'] != self.last_mesh_ota_phase:
+            self.last_mesh_ota_phase = data['phase_name']
+            self.update_osc_log(f"Mesh OTA: {data['phase_name']} ({len(receivers)} receiver(s), round {data['round']})")
+        
+        if receivers and dpg.does_item_exist("firmware_upload_progress"):
+            progress = sum(min(r['received'], chunk_count) for r in receivers) / (chunk_count * len(receivers))
+            dpg.set_value("firmware_upload_progress", progress)
+        
+        if dpg.does_item_exist("firmware_upload_status"):
+            if data['phase_name'] == 'DONE' or data['phase_name'] == 'FAILED':
+                color = (0, 255, 0) if failed == 0 and done > 0 else (255, 0, 0)
+                dpg.set_value("firmware_upload_status",
+                              f"Mesh OTA {data['phase_name']}: {done} updated, {failed} failed - receivers rebooting")
+                dpg.configure_item("firmware_upload_status", color=color)
+                for r in receivers:
+                    self.update_osc_log(f"  {r['mac']}: {r['state_name']} ({r['received']}/{chunk_count} chunks)")
+                self.last_mesh_ota_phase = None
+            else:
+                dpg.set_value("firmware_upload_status",
+                              f"Mesh OTA {data['phase_name']}: {done}/{len(receivers)} receiver(s) done")
+    
+    def _upgrade_firmware_thread(self):
+        """Background thread for firmware upgrade via OTA"""
+        firmware_file = None
+        try:
+            # Step 1: Download firmware from GitHub
+            firmware_data = self._download_firmware()
             
-            if dpg.does_item_exist("firmware_upload_progress"):
-                dpg.set_value("firmware_upload_progress", 0.95)
+            # Step 2-4: Upload with windowed OTA v2, falling back to the
+            # unacknowledged v1 protocol for firmware that does not know it
+            if not self._upload_firmware_v2(firmware_data):
+                self.update_osc_log("Nowde did not answer OTA2_BEGIN - using legacy OTA")
+                self._upload_firmware_v1(firmware_data)
             
             # Step 5: Device will reboot automatically
             if dpg.does_item_exist("firmware_upload_status"):
@@ -1984,6 +2447,200 @@ class MilluBridge:
             time.sleep(1)
             self.refresh_midi_devices()
     
+    def _wait_ota_ack(self, timeout):
+        """Return the next OTA_ACK from the Nowde, or None on timeout"""
+        try:
+            return self.ota_ack_queue.get(timeout=timeout)
+        except queue.Empty:
+            return None
+    
+    def _upload_firmware_v2(self, firmware_data, target=0):
+        """Windowed OTA: go-back-N over sequence-numbered, CRC-checked chunks.
+        
+        Returns False if the Nowde does not answer OTA2_BEGIN (older firmware),
+        raises on any other failure.
+        """
+        window = 16         # Chunks in flight (16 x 192B = 3KB, < one flash buffer)
+        ack_timeout = 1.0   # Resend from the last ACKed chunk after this long
+        max_retries = 10
+        
+        firmware_size = len(firmware_data)
+        chunk_size = self.output_manager.OTA2_CHUNK_SIZE
+        chunks = [firmware_data[i:i + chunk_size] for i in range(0, firmware_size, chunk_size)]
+        
+        # Drop ACKs left over from a previous attempt
+        while not self.ota_ack_queue.empty():
+            self.ota_ack_queue.get_nowait()
+        
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Starting OTA update...")
+        self.update_osc_log("Starting OTA v2 update...")
+        
+        result = self.output_manager.send_ota2_begin(firmware_size, hashlib.sha256(firmware_data).digest(), target)
+        if not result or not result[0]:
+            raise Exception("Failed to send OTA2_BEGIN")
+        
+        # Update.begin erases nothing up front, so READY comes back quickly
+        ack = self._wait_ota_ack(2.0)
+        if ack is None:
+            return False
+        if ack['status_name'] != 'READY':
+            raise Exception(f"OTA2_BEGIN rejected: {ack['status_name']}")
+        
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.set_value("firmware_upload_progress", 0.15)
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Uploading firmware...")
+        self.update_osc_log(f"Uploading {len(chunks)} chunks (window {window})...")
+        
+        start_time = time.time()
+        base = 0          # Oldest unacknowledged chunk
+        next_to_send = 0
+        retries = 0
+        resends = 0
+        last_percent = -1
+        
+        while base < len(chunks):
+            while next_to_send < len(chunks) and next_to_send < base + window:
+                self.output_manager.send_ota2_data(next_to_send, chunks[next_to_send])
+                next_to_send += 1
+            
+            ack = self._wait_ota_ack(ack_timeout)
+            if ack is None:
+                retries += 1
+                if retries > max_retries:
+                    raise Exception(f"No OTA_ACK after {max_retries} retries at chunk {base}")
+                resends += next_to_send - base
+                next_to_send = base
+                continue
+            
+            status = ack['status_name']
+            if status in ('ACK', 'NACK'):
+                retries = 0
+                base = max(base, ack['next_seq'])
+                if status == 'NACK':
+                    resends += max(0, next_to_send - base)
+                    next_to_send = base
+                else:
+                    next_to_send = max(next_to_send, base)
+            else:
+                raise Exception(f"Nowde aborted OTA: {status}")
+            
+            sent_bytes = min(base * chunk_size, firmware_size)
+            if dpg.does_item_exist("firmware_upload_progress"):
+                dpg.set_value("firmware_upload_progress", 0.15 + (sent_bytes / firmware_size) * 0.75)
+            percent = (sent_bytes * 100) // firmware_size
+            if percent // 10 != last_percent // 10:
+                self.update_osc_log(f"  Progress: {percent}% ({sent_bytes}/{firmware_size} bytes)")
+            last_percent = percent
+        
+        elapsed = time.time() - start_time
+        rate = firmware_size / elapsed / 1024 if elapsed > 0 else 0
+        self.update_osc_log(f"✅ Sent {firmware_size} bytes in {elapsed:.1f}s ({rate:.1f} KB/s, {resends} resent chunks)")
+        
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.set_value("firmware_upload_progress", 0.9)
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Verifying image...")
+        self.update_osc_log("Verifying firmware image (SHA-256)...")
+        
+        result = self.output_manager.send_ota2_end()
+        if not result or not result[0]:
+            raise Exception("Failed to send OTA2_END")
+        
+        ack = self._wait_ota_ack(5.0)
+        if ack is None:
+            raise Exception("No answer to OTA2_END")
+        if ack['status_name'] != 'COMPLETE':
+            raise Exception(f"Image rejected: {ack['status_name']}")
+        
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.set_value("firmware_upload_progress", 0.95)
+        return True
+    
+    def _upload_firmware_v1(self, firmware_data):
+        """Legacy OTA: fixed-rate, unacknowledged 100-byte chunks"""
+        firmware_size = len(firmware_data)
+        
+        # Step 2: Send OTA_BEGIN
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Starting OTA update...")
+        
+        self.update_osc_log("Starting OTA update...")
+        result = self.output_manager.send_ota_begin(firmware_size)
+        
+        if not result or not result[0]:
+            raise Exception("Failed to send OTA_BEGIN")
+        
+        time.sleep(0.2)  # Give device time to prepare
+        
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.set_value("firmware_upload_progress", 0.15)
+        
+        # Step 3: Send firmware data in chunks
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Uploading firmware...")
+        
+        self.update_osc_log("Uploading firmware data...")
+        
+        # Use smaller chunks to avoid buffer overflow
+        # 100 bytes raw -> ~115 bytes encoded + headers = ~120 bytes total SysEx message
+        chunk_size = 100
+        sent_bytes = 0
+        chunk_count = 0
+        
+        # Conservative timing to avoid USB buffer overflow
+        # ESP32 needs time to decode, write to flash, and process
+        chunk_delay = 0.025  # 25ms per chunk
+        
+        for i in range(0, firmware_size, chunk_size):
+            chunk = firmware_data[i:i+chunk_size]
+            result = self.output_manager.send_ota_data(chunk)
+            
+            if not result or not result[0]:
+                raise Exception(f"Failed to send OTA_DATA at offset {i}")
+            
+            sent_bytes += len(chunk)
+            chunk_count += 1
+            progress = 0.15 + (sent_bytes / firmware_size) * 0.75  # 15% to 90%
+            
+            if dpg.does_item_exist("firmware_upload_progress"):
+                dpg.set_value("firmware_upload_progress", progress)
+            
+            # Log progress every 10%
+            percent = (sent_bytes * 100) // firmware_size
+            if percent % 10 == 0 and sent_bytes > 0:
+                self.update_osc_log(f"  Progress: {percent}% ({sent_bytes}/{firmware_size} bytes, {chunk_delay*1000:.0f}ms/chunk)")
+            
+            # Every 100 chunks, give device extra time for flash writes
+            if chunk_count % 100 == 0:
+                time.sleep(0.15)  # 150ms pause
+            else:
+                time.sleep(chunk_delay)
+        
+        # Log final byte count
+        self.update_osc_log(f"✅ Sent all {sent_bytes} bytes ({chunk_count} chunks)")
+        
+        # Wait for device to finish writing all buffered data to flash
+        self.update_osc_log("Waiting for device to finish writing to flash...")
+        time.sleep(2)
+        
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.set_value("firmware_upload_progress", 0.9)
+        
+        # Step 4: Send OTA_END
+        if dpg.does_item_exist("firmware_upload_status"):
+            dpg.set_value("firmware_upload_status", "Finalizing update...")
+        
+        self.update_osc_log("Finalizing firmware update...")
+        result = self.output_manager.send_ota_end()
+        
+        if not result or not result[0]:
+            raise Exception("Failed to send OTA_END")
+        
+        if dpg.does_item_exist("firmware_upload_progress"):
+            dpg.set_value("firmware_upload_progress", 0.95)
+    
     def on_osc_settings_changed(self, sender, app_data):
         """Callback when OSC settings are changed"""
         try:
@@ -2130,8 +2787,9 @@ class MilluBridge:
             # Send sync messages to all Remote Nowdes in simulation mode
             if self.current_nowde_device and self.output_manager.current_port:
                 position_ms = int(self.simulation_clock_position * 1000)
+                sim_layers = {}  # {layer_name: (media_index, state)} - one entry per layer
                 
-                for mac, nowde in self.remote_nowdes.items():
+                for mac, nowde in list(self.remote_nowdes.items()):
                     # Skip disconnected/missing devices
                     if nowde.get('last_seen_ms', 99999) > 10000:
                         continue
@@ -2157,13 +2815,22 @@ class MilluBridge:
                         except ValueError:
                             continue
                     
-                    # Send media sync (simulation takes priority over real OSC for this layer)
-                    self.output_manager.send_media_sync(
-                        layer_name=layer_name,
-                        media_index=media_index,
-                        position_ms=position_ms,
-                        state=state
-                    )
+                    sim_layers[layer_name] = (media_index, state)
+                
+                # Send media sync (simulation takes priority over real OSC for this layer)
+                if self.media_sync.batch_enabled:
+                    self.output_manager.send_media_sync_batch([
+                        {'layer_name': name, 'media_index': index, 'position_ms': position_ms, 'state': state}
+                        for name, (index, state) in sim_layers.items()
+                    ])
+                else:
+                    for name, (index, state) in sim_layers.items():
+                        self.output_manager.send_media_sync(
+                            layer_name=name,
+                            media_index=index,
+                            position_ms=position_ms,
+                            state=state
+                        )
             
             # Sleep for throttle interval
             time.sleep(self.sync_settings['throttle_interval'])
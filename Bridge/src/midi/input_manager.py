@@ -47,8 +47,37 @@ class InputManager:
         self.SYSEX_CMD_HELLO = 0x20
         self.SYSEX_CMD_CONFIG_STATE = 0x21
         self.SYSEX_CMD_RUNNING_STATE = 0x22
+        self.SYSEX_CMD_OTA_ACK = 0x23
+        self.SYSEX_CMD_METRICS = 0x24
+        self.SYSEX_CMD_MESH_OTA_STATUS = 0x25
+        self.SYSEX_CMD_RUNNING_STATE_DELTA = 0x26
+        self.SYSEX_CMD_BENCHMARK_RESULT = 0x27
+        self.SYSEX_CMD_CHANNEL_SURVEY_REPORT = 0x28
+        self.SYSEX_CMD_DIAGNOSTICS = 0x29
+        self.SYSEX_CMD_PHANTOM_REPORT = 0x2A
         self.SYSEX_CMD_ERROR_REPORT = 0x30
         
+        # OTA_ACK status codes (matching OTA_STATUS_* in firmware)
+        self.OTA_STATUS_NAMES = {
+            0x00: "ACK",
+            0x01: "NACK",
+            0x02: "READY",
+            0x03: "COMPLETE",
+            0x10: "ERR_BEGIN",
+            0x11: "ERR_FLASH",
+            0x12: "ERR_SIZE",
+            0x13: "ERR_HASH",
+            0x14: "ERR_STATE"
+        }
+        
+        # Mesh OTA relay phases and receiver states (matching mesh_ota.cpp)
+        self.MESH_OTA_PHASE_NAMES = {
+            0: "IDLE", 1: "JOIN", 2: "BROADCAST", 3: "POLL", 4: "REPAIR", 5: "DONE", 6: "FAILED"
+        }
+        self.MESH_OTA_RX_STATE_NAMES = {
+            0: "IDLE", 1: "ERASING", 2: "RECEIVING", 3: "DONE", 4: "FAILED"
+        }
+        
         # SysEx parsing state
         self.sysex_buffer = []
         self.in_sysex = False
@@ -167,6 +196,49 @@ class InputManager:
             if self.sysex_callback and running_data:
                 self.sysex_callback('running_state', running_data)
         
+        elif command == self.SYSEX_CMD_RUNNING_STATE_DELTA:
+            delta_data, formatted_msg = self._parse_running_state_delta(sysex_data)
+            if self.sysex_callback and delta_data:
+                self.sysex_callback('running_state_delta', delta_data)
+        
+        elif command == self.SYSEX_CMD_OTA_ACK:
+            # Not logged: sent every few chunks during a firmware upload
+            ack_data, _ = self._parse_ota_ack(sysex_data)
+            if self.sysex_callback and ack_data:
+                self.sysex_callback('ota_ack', ack_data)
+        
+        elif command == self.SYSEX_CMD_METRICS:
+            # Not logged: one message per Nowde every second
+            metrics_data, _ = self._parse_metrics(sysex_data)
+            if self.sysex_callback and metrics_data:
+                self.sysex_callback('metrics', metrics_data)
+        
+        elif command == self.SYSEX_CMD_MESH_OTA_STATUS:
+            status_data, formatted_msg = self._parse_mesh_ota_status(sysex_data)
+            if self.sysex_callback and status_data:
+                self.sysex_callback('mesh_ota_status', status_data)
+        
+        elif command == self.SYSEX_CMD_BENCHMARK_RESULT:
+            result_data, formatted_msg = self._parse_benchmark_result(sysex_data)
+            if self.sysex_callback and result_data:
+                self.sysex_callback('benchmark_result', result_data)
+        
+        elif command == self.SYSEX_CMD_CHANNEL_SURVEY_REPORT:
+            survey_data, formatted_msg = self._parse_channel_survey_report(sysex_data)
+            if self.sysex_callback and survey_data:
+                self.sysex_callback('channel_survey', survey_data)
+        
+        elif command == self.SYSEX_CMD_DIAGNOSTICS:
+            diag_data, formatted_msg = self._parse_diagnostics(sysex_data)
+            if self.sysex_callback and diag_data:
+                self.sysex_callback('diagnostics', diag_data)
+        
+        elif command == self.SYSEX_CMD_PHANTOM_REPORT:
+            # Not logged: one report every two seconds while phantoms run
+            report_data, _ = self._parse_phantom_report(sysex_data)
+            if self.sysex_callback and report_data:
+                self.sysex_callback('phantom_report', report_data)
+        
         elif command == self.SYSEX_CMD_ERROR_REPORT:
             error_data, formatted_msg = self._parse_error_report(sysex_data)
             if self.sysex_callback and error_data:
@@ -233,6 +305,263 @@ class InputManager:
         formatted = f"SysEx: HELLO - Version: {version_str}, Uptime: {uptime_ms}ms, Boot: {boot_reason_str}"
         return hello_data, formatted
     
+    def _parse_ota_ack(self, sysex_data):
+        """Parse OTA_ACK SysEx message (F0 7D 23 [status] [nextSeq(3 x 7-bit)] F7)"""
+        if len(sysex_data) < 8:
+            return None, "SysEx: OTA_ACK (invalid format)"
+        
+        status = sysex_data[3]
+        next_seq = (sysex_data[4] << 14) | (sysex_data[5] << 7) | sysex_data[6]
+        status_name = self.OTA_STATUS_NAMES.get(status, f"UNKNOWN_0x{status:02X}")
+        
+        ack = {
+            'status': status,
+            'status_name': status_name,
+            'next_seq': next_seq
+        }
+        return ack, f"SysEx: OTA_ACK - {status_name}, next seq {next_seq}"
+    
+    # Names by position, matching MetricCounter / MetricHistogram in nowde_config.h.
+    # Newer firmware may append entries; those are kept under their index.
+    METRIC_COUNTER_NAMES = [
+        'usb_sysex_rx', 'espnow_tx_ok', 'espnow_tx_fail', 'sync_tx', 'sync_rx',
+        'sync_corrected', 'discard_desync', 'discard_sender', 'discard_malformed',
+        'rx_queue_dropped', 'link_lost', 'rf_sim_overflow', 'usb_tx_dropped',
+        'sync_recovered', 'sync_suppressed', 'channel_switch', 'espnow_tx_coalesced',
+        'espnow_tx_dropped', 'mtc_qf_late', 'usb_tx_truncated'
+    ]
+    METRIC_HISTOGRAM_NAMES = ['usb_to_espnow', 'rx_to_mtc', 'sync_delta']
+    METRIC_HIST_BASE_US = 64
+    
+    def _parse_metrics(self, sysex_data):
+        """Parse METRICS SysEx message
+        Format: F0 7D 24 [counterCount] [histCount] [bucketCount] [source(0=self, 1=receiver)]
+                [mac(6) uptimeMs(4) counters(4 each) buckets(2 each), 7-bit encoded] F7
+        Bucket 0 counts samples < 64 us, bucket i samples in [64 << (i-1), 64 << i) us.
+        """
+        if len(sysex_data) < 8:
+            return None, "SysEx: METRICS (invalid format)"
+        
+        counter_count = sysex_data[3]
+        hist_count = sysex_data[4]
+        bucket_count = sysex_data[5]
+        source = sysex_data[6]
+        raw = self._decode_7bit(sysex_data[7:-1])
+        needed = 10 + 4 * counter_count + 2 * hist_count * bucket_count
+        if len(raw) < needed:
+            return None, "SysEx: METRICS (truncated)"
+        
+        idx = 10
+        counters = {}
+        for i in range(counter_count):
+            name = self.METRIC_COUNTER_NAMES[i] if i < len(self.METRIC_COUNTER_NAMES) else f'counter_{i}'
+            counters[name] = int.from_bytes(bytes(raw[idx:idx + 4]), 'big')
+            idx += 4
+        
+        histograms = {}
+        for h in range(hist_count):
+            name = self.METRIC_HISTOGRAM_NAMES[h] if h < len(self.METRIC_HISTOGRAM_NAMES) else f'histogram_{h}'
+            buckets = []
+            for _ in range(bucket_count):
+                buckets.append((raw[idx] << 8) | raw[idx + 1])
+                idx += 2
+            histograms[name] = buckets
+        
+        metrics = {
+            'source': 'receiver' if source == 1 else 'self',
+            'mac': ':'.join(f'{b:02X}' for b in raw[0:6]),
+            'uptime_ms': int.from_bytes(bytes(raw[6:10]), 'big'),
+            'counters': counters,
+            'histograms': histograms,
+            'bucket_base_us': self.METRIC_HIST_BASE_US
+        }
+        return metrics, f"SysEx: METRICS - {metrics['mac']} ({metrics['source']})"
+    
+    # (name, meaning of param), matching BenchmarkId in nowde_config.h
+    BENCHMARK_NAMES = [
+        ('codec_decode', 'encoded bytes'),
+        ('codec_encode', 'raw bytes'),
+        ('sysex_parse', 'layers'),
+        ('running_state', 'receivers'),
+        ('mtc_error', 'max RF delay ms'),
+    ]
+    
+    def _parse_benchmark_result(self, sysex_data):
+        """Parse BENCHMARK_RESULT SysEx message
+        Format: F0 7D 27 [benchmarkId] [param(2) samples(2) minNs(4) avgNs(4) maxNs(4), encoded:19] F7
+        """
+        if len(sysex_data) < 4 + 19 + 1:
+            return None, "SysEx: BENCHMARK_RESULT (invalid format)"
+        
+        bench_id = sysex_data[3]
+        raw = self._decode_7bit(sysex_data[4:4 + 19])
+        if bench_id < len(self.BENCHMARK_NAMES):
+            name, param_name = self.BENCHMARK_NAMES[bench_id]
+        else:
+            name, param_name = f'benchmark_{bench_id}', 'param'
+        
+        result = {
+            'id': bench_id,
+            'name': name,
+            'param': int.from_bytes(bytes(raw[0:2]), 'big'),
+            'param_name': param_name,
+            'samples': int.from_bytes(bytes(raw[2:4]), 'big'),
+            'min_ns': int.from_bytes(bytes(raw[4:8]), 'big'),
+            'avg_ns': int.from_bytes(bytes(raw[8:12]), 'big'),
+            'max_ns': int.from_bytes(bytes(raw[12:16]), 'big')
+        }
+        return result, f"SysEx: BENCHMARK_RESULT - {name}"
+    
+    def _parse_channel_survey_report(self, sysex_data):
+        """Parse CHANNEL_SURVEY_REPORT SysEx message
+        Format: F0 7D 28 [current] [chosen(0 = stay)] [lossPercent] [count]
+                count x ([channel] [apCount] [-interferenceDbm]) F7
+        """
+        if len(sysex_data) < 8:
+            return None, "SysEx: CHANNEL_SURVEY_REPORT (invalid format)"
+        
+        count = sysex_data[6]
+        if len(sysex_data) < 7 + count * 3 + 1:
+            return None, "SysEx: CHANNEL_SURVEY_REPORT (truncated)"
+        
+        channels = []
+        for i in range(count):
+            offset = 7 + i * 3
+            channels.append({
+                'channel': sysex_data[offset],
+                'ap_count': sysex_data[offset + 1],
+                'interference_dbm': -sysex_data[offset + 2]
+            })
+        
+        survey = {
+            'current': sysex_data[3],
+            'chosen': sysex_data[4],
+            'loss_percent': sysex_data[5],
+            'channels': channels
+        }
+        return survey, f"SysEx: CHANNEL_SURVEY_REPORT - channel {survey['current']}"
+    
+    # DIAGNOSTICS task IDs (TASKS in diagnostics.cpp)
+    DIAGNOSTICS_TASK_NAMES = ['MIDI_Task', 'ESPNOW_Task', 'Log_Flush', 'Profile_Store',
+                              'OTA_Flash', 'loopTask', 'esp_timer']
+    
+    def _parse_diagnostics(self, sysex_data):
+        """Parse DIAGNOSTICS SysEx message
+        Format: F0 7D 29 [taskCount] [heapFree(4) heapMinFree(4) receiverEntryBytes(2) receiverSlots(2)
+                senderEntryBytes(2) senderSlots(2) taskCount x (taskId(1) stackSize(2) stackFreeMin(2)),
+                encoded] F7
+        """
+        if len(sysex_data) < 5:
+            return None, "SysEx: DIAGNOSTICS (invalid format)"
+        
+        task_count = sysex_data[3]
+        raw_len = 16 + task_count * 5
+        encoded_len = (raw_len * 8 + 6) // 7
+        if len(sysex_data) < 4 + encoded_len + 1:
+            return None, "SysEx: DIAGNOSTICS (truncated)"
+        
+        raw = self._decode_7bit(sysex_data[4:4 + encoded_len])
+        tasks = []
+        for i in range(task_count):
+            offset = 16 + i * 5
+            task_id = raw[offset]
+            if task_id < len(self.DIAGNOSTICS_TASK_NAMES):
+                name = self.DIAGNOSTICS_TASK_NAMES[task_id]
+            else:
+                name = f'task_{task_id}'
+            tasks.append({
+                'id': task_id,
+                'name': name,
+                'stack_size': int.from_bytes(bytes(raw[offset + 1:offset + 3]), 'big'),
+                'stack_free_min': int.from_bytes(bytes(raw[offset + 3:offset + 5]), 'big')
+            })
+        
+        diagnostics = {
+            'heap_free': int.from_bytes(bytes(raw[0:4]), 'big'),
+            'heap_min_free': int.from_bytes(bytes(raw[4:8]), 'big'),
+            'receiver_entry_bytes': int.from_bytes(bytes(raw[8:10]), 'big'),
+            'receiver_slots': int.from_bytes(bytes(raw[10:12]), 'big'),
+            'sender_entry_bytes': int.from_bytes(bytes(raw[12:14]), 'big'),
+            'sender_slots': int.from_bytes(bytes(raw[14:16]), 'big'),
+            'tasks': tasks
+        }
+        return diagnostics, f"SysEx: DIAGNOSTICS - {task_count} task(s)"
+    
+    def _parse_phantom_report(self, sysex_data):
+        """Parse PHANTOM_REPORT SysEx message
+        Format: F0 7D 2A [phantomCount] [running]
+                phantomCount x [index(1) layerId(1) expected(4) arrived(4) latencyAvgUs(4) latencyMaxUs(4),
+                encoded:21] F7
+        """
+        if len(sysex_data) < 6:
+            return None, "SysEx: PHANTOM_REPORT (invalid format)"
+        
+        count = sysex_data[3]
+        if len(sysex_data) < 5 + count * 21 + 1:
+            return None, "SysEx: PHANTOM_REPORT (truncated)"
+        
+        phantoms = []
+        for i in range(count):
+            offset = 5 + i * 21
+            raw = self._decode_7bit(sysex_data[offset:offset + 21])
+            expected = int.from_bytes(bytes(raw[2:6]), 'big')
+            arrived = int.from_bytes(bytes(raw[6:10]), 'big')
+            phantoms.append({
+                'index': raw[0],
+                'layer_id': raw[1],
+                'expected': expected,
+                'arrived': arrived,
+                'lost': max(0, expected - arrived),
+                'latency_avg_us': int.from_bytes(bytes(raw[10:14]), 'big'),
+                'latency_max_us': int.from_bytes(bytes(raw[14:18]), 'big')
+            })
+        
+        report = {
+            'running': bool(sysex_data[4]),
+            'phantoms': phantoms
+        }
+        return report, f"SysEx: PHANTOM_REPORT - {count} phantom(s)"
+    
+    def _parse_mesh_ota_status(self, sysex_data):
+        """Parse MESH_OTA_STATUS SysEx message
+        Format: F0 7D 25 [phase] [round] [chunkCount(3 x 7-bit)] [participants]
+                per participant: [mac(6, encoded:7)] [state] [received(3 x 7-bit)] F7
+        """
+        if len(sysex_data) < 10:
+            return None, "SysEx: MESH_OTA_STATUS (invalid format)"
+        
+        phase = sysex_data[3]
+        repair_round = sysex_data[4]
+        chunk_count = (sysex_data[5] << 14) | (sysex_data[6] << 7) | sysex_data[7]
+        count = sysex_data[8]
+        
+        idx = 9
+        receivers = []
+        for _ in range(count):
+            if idx + 11 > len(sysex_data) - 1:
+                return None, "SysEx: MESH_OTA_STATUS (truncated receiver block)"
+            mac_bytes = self._decode_7bit(sysex_data[idx:idx + 7])
+            state = sysex_data[idx + 7]
+            received = (sysex_data[idx + 8] << 14) | (sysex_data[idx + 9] << 7) | sysex_data[idx + 10]
+            receivers.append({
+                'mac': ':'.join(f'{b:02X}' for b in mac_bytes[:6]),
+                'state': state,
+                'state_name': self.MESH_OTA_RX_STATE_NAMES.get(state, f"UNKNOWN_{state}"),
+                'received': received
+            })
+            idx += 11
+        
+        phase_name = self.MESH_OTA_PHASE_NAMES.get(phase, f"UNKNOWN_{phase}")
+        status = {
+            'phase': phase,
+            'phase_name': phase_name,
+            'round': repair_round,
+            'chunk_count': chunk_count,
+            'receivers': receivers
+        }
+        done = sum(1 for r in receivers if r['state_name'] == 'DONE')
+        return status, f"SysEx: MESH_OTA_STATUS - {phase_name}, round {repair_round}, {done}/{len(receivers)} done"
+    
     def _parse_config_state(self, sysex_data):
         """Parse CONFIG_STATE SysEx message (F0 7D 20 [rfSimEnabled] [rfSimMaxDelayHi(7-bit)] [rfSimMaxDelayLo(7-bit)] F7)"""
         if len(sysex_data) < 7:
@@ -248,6 +577,15 @@ class InputManager:
         }
         
         formatted = f"SysEx: CONFIG_STATE - RF Sim: {'ON' if rf_sim_enabled else 'OFF'}, Max Delay: {rf_sim_max_delay_ms}ms"
+        
+        # Impairment model, sent by newer firmware only
+        if len(sysex_data) >= 12:
+            config['rf_simulation_loss_percent'] = sysex_data[6]
+            config['rf_simulation_reorder_percent'] = sysex_data[7]
+            config['rf_simulation_outage_per_mille'] = sysex_data[8]
+            config['rf_simulation_outage_ms'] = ((sysex_data[9] & 0x7F) << 7) | (sysex_data[10] & 0x7F)
+            formatted += (f", Loss: {sysex_data[6]}%, Reorder: {sysex_data[7]}%, "
+                          f"Outage: {sysex_data[8]}/1000 x {config['rf_simulation_outage_ms']}ms")
         return config, formatted
     
     def _parse_running_state(self, sysex_data):
@@ -255,7 +593,11 @@ class InputManager:
         Format: F0 7D 22 [uptime(4,encoded:5)] [meshSynced(1)] [totalReceivers(1)]
                 [chunkIndex(1)] [chunkCount(1)] [chunkReceiverCount(1)]
                 [receiver_data_chunk...] F7
-        Each receiver block is 36 bytes raw (42 bytes encoded)."""
+        Each receiver block is 36 bytes raw (42 bytes encoded), optionally followed
+        by an 11-byte sync estimator report (13 bytes encoded), a 7-byte clock
+        report (8 bytes encoded), an 11-byte link report (13 bytes encoded) and a
+        10-byte TX report (12 bytes encoded). The block size is
+        derived from the message length so older firmware still parses."""
         if len(sysex_data) < 14:
             return None, "SysEx: RUNNING_STATE (invalid format)"
         
@@ -300,54 +642,17 @@ class InputManager:
         
         receivers = []
         
-        # Parse each receiver (42 bytes encoded -> 36 bytes decoded)
+        block_len = 42
+        if chunk_receiver_count > 0:
+            block_len = max(42, (len(sysex_data) - 1 - idx) // chunk_receiver_count)
+        
+        # Parse each receiver (42 bytes encoded -> 36 bytes decoded, + extensions)
         for _ in range(chunk_receiver_count):
-            if idx + 42 > len(sysex_data) - 1:  # -1 for SYSEX_END
+            receiver = self._parse_receiver_block(sysex_data, idx, block_len)
+            if receiver is None:
                 break
-            
-            # Decode receiver data (42 bytes encoded -> 36 bytes decoded)
-            receiver_encoded = sysex_data[idx:idx+42]
-            receiver_decoded = self._decode_7bit(receiver_encoded)
-            
-            if len(receiver_decoded) < 36:
-                break
-            
-            # MAC (6 bytes)
-            mac_bytes = receiver_decoded[0:6]
-            mac_str = ':'.join(f'{b:02X}' for b in mac_bytes)
-            
-            # Layer (16 bytes)
-            layer_bytes = receiver_decoded[6:22]
-            layer_str = bytes(layer_bytes).decode('ascii', errors='ignore').rstrip('\x00')
-            
-            # Version (8 bytes)
-            version_bytes = receiver_decoded[22:30]
-            version_str = bytes(version_bytes).decode('ascii', errors='ignore').rstrip('\x00')
-            
-            # Last seen (4 bytes, milliseconds ago)
-            last_seen_ms = (receiver_decoded[30] << 24) | (receiver_decoded[31] << 16) | (receiver_decoded[32] << 8) | receiver_decoded[33]
-            
-            # Active (1 byte)
-            active = receiver_decoded[34] != 0
-            
-            # Media index (1 byte) - current playing media index (0 = stopped)
-            media_index = receiver_decoded[35]
-            
-            # Generate UUID from last 3 bytes of MAC
-            uuid = mac_str[-8:].replace(':', '')
-            
-            receivers.append({
-                'mac': mac_str,
-                'uuid': uuid,
-                'layer': layer_str,
-                'version': version_str,
-                'last_seen_ms': last_seen_ms,
-                'active': active,
-                'media_index': media_index,
-                'name': f"Nowde-{uuid}"
-            })
-            
-            idx += 42
+            receivers.append(receiver)
+            idx += block_len
         
         running_state = {
             'uptime_ms': uptime_ms,
@@ -369,6 +674,185 @@ class InputManager:
         
         return running_state, formatted
     
+    def _parse_receiver_block(self, sysex_data, idx, block_len):
+        """Parse one RUNNING_STATE receiver block starting at idx (None if truncated).
+        36 bytes raw (42 encoded), then block_len - 42 bytes of report extensions."""
+        if idx + 42 > len(sysex_data) - 1:  # -1 for SYSEX_END
+            return None
+        
+        # Decode receiver data (42 bytes encoded -> 36 bytes decoded)
+        receiver_decoded = self._decode_7bit(sysex_data[idx:idx+42])
+        if len(receiver_decoded) < 36:
+            return None
+        
+        # MAC (6 bytes)
+        mac_str = ':'.join(f'{b:02X}' for b in receiver_decoded[0:6])
+        
+        # Layer (16 bytes)
+        layer_str = bytes(receiver_decoded[6:22]).decode('ascii', errors='ignore').rstrip('\x00')
+        
+        # Version (8 bytes)
+        version_str = bytes(receiver_decoded[22:30]).decode('ascii', errors='ignore').rstrip('\x00')
+        
+        # Last seen (4 bytes, milliseconds ago)
+        last_seen_ms = (receiver_decoded[30] << 24) | (receiver_decoded[31] << 16) | (receiver_decoded[32] << 8) | receiver_decoded[33]
+        
+        # Active (1 byte)
+        active = receiver_decoded[34] != 0
+        
+        # Media index (1 byte) - current playing media index (0 = stopped)
+        media_index = receiver_decoded[35]
+        
+        # Generate UUID from last 3 bytes of MAC
+        uuid = mac_str[-8:].replace(':', '')
+        
+        receiver = {
+            'mac': mac_str,
+            'uuid': uuid,
+            'layer': layer_str,
+            'version': version_str,
+            'last_seen_ms': last_seen_ms,
+            'active': active,
+            'media_index': media_index,
+            'name': f"Nowde-{uuid}"
+        }
+        receiver.update(self._parse_receiver_reports(sysex_data, idx + 42, block_len - 42))
+        return receiver
+    
+    def _parse_receiver_reports(self, sysex_data, idx, available):
+        """Parse the optional report extensions of a receiver block.
+        Sync estimator (11 bytes raw, 13 encoded), clock (7 raw, 8 encoded),
+        link (11 raw, 13 encoded) and TX (10 raw, 12 encoded), each present only
+        if `available` covers it."""
+        reports = {}
+        
+        def s16(hi, lo):
+            value = (hi << 8) | lo
+            return value - 0x10000 if value & 0x8000 else value
+        
+        def s8(value):
+            return value - 0x100 if value & 0x80 else value
+        
+        if available >= 13:
+            sync = self._decode_7bit(sysex_data[idx:idx+13])
+            if len(sync) >= 11:
+                reports['sync'] = {
+                    'locked': bool(sync[0] & 0x01),
+                    'tracking': bool(sync[0] & 0x02),
+                    'error_ms': s16(sync[1], sync[2]) / 10.0,
+                    'jitter_ms': ((sync[3] << 8) | sync[4]) / 10.0,
+                    'rate_ppm': s16(sync[5], sync[6]),
+                    'outliers': (sync[7] << 8) | sync[8],
+                    'jumps': (sync[9] << 8) | sync[10],
+                }
+        
+        if available >= 13 + 8:
+            clock = self._decode_7bit(sysex_data[idx+13:idx+21])
+            if len(clock) >= 7:
+                reports['clock'] = {
+                    'mesh_synced': bool(clock[0] & 0x01),
+                    'offset_valid': bool(clock[0] & 0x02),
+                    'sender_offset_ms': s16(clock[1], clock[2]),
+                    'desync_corrected': (clock[3] << 8) | clock[4],
+                    'desync_discarded': (clock[5] << 8) | clock[6],
+                }
+        
+        # Link report: RSSI both ways, sync window counts
+        if available >= 13 + 8 + 13:
+            link = self._decode_7bit(sysex_data[idx+21:idx+34])
+            if len(link) >= 11:
+                reports['link'] = {
+                    'rssi_avg_dbm': s8(link[0]),
+                    'rssi_min_dbm': s8(link[1]),
+                    'sync_received': (link[2] << 8) | link[3],
+                    'sync_discarded': (link[4] << 8) | link[5],
+                    'link_lost': (link[6] << 8) | link[7],
+                    'window_ms': (link[8] << 8) | link[9],
+                    'uplink_rssi_dbm': s8(link[10]),
+                }
+        
+        # TX report: the sender's delivery counters towards this receiver
+        if available >= 13 + 8 + 13 + 12:
+            tx = self._decode_7bit(sysex_data[idx+34:idx+46])
+            if len(tx) >= 10:
+                reports['tx'] = {
+                    'delivered': int.from_bytes(bytes(tx[0:4]), 'big'),
+                    'failed': int.from_bytes(bytes(tx[4:8]), 'big'),
+                    'dropped': (tx[8] << 8) | tx[9],
+                }
+        
+        return reports
+    
+    def _parse_running_state_delta(self, sysex_data):
+        """Parse RUNNING_STATE_DELTA SysEx message (subscription mode).
+        Format: F0 7D 26 [uptime(4,encoded:5)] [meshSynced] [flags] [seq] [totalReceivers]
+                [opCount] ops... F7
+        Ops: 01 JOIN [slot] [receiver block, 88 bytes]
+             02 UPDATE [slot] [lastSeen(4) mediaIndex(1), encoded:6] [reports, 46 bytes]
+             03 LEAVE [slot]
+        flags bit 0 (RESET): forget all slots before applying the ops,
+        flags bit 1 (MORE): further messages of the same pass follow."""
+        if len(sysex_data) < 14:
+            return None, "SysEx: RUNNING_STATE_DELTA (invalid format)"
+        
+        uptime_decoded = self._decode_7bit(sysex_data[3:8])
+        if len(uptime_decoded) < 4:
+            return None, "SysEx: RUNNING_STATE_DELTA (invalid uptime)"
+        uptime_ms = int.from_bytes(bytes(uptime_decoded[:4]), 'big')
+        
+        mesh_synced = sysex_data[8] != 0
+        flags = sysex_data[9]
+        seq = sysex_data[10]
+        total_receivers = sysex_data[11]
+        op_count = sysex_data[12]
+        
+        idx = 13
+        end = len(sysex_data) - 1
+        ops = []
+        for _ in range(op_count):
+            if idx + 2 > end:
+                return None, "SysEx: RUNNING_STATE_DELTA (truncated op)"
+            code = sysex_data[idx]
+            slot = sysex_data[idx + 1]
+            idx += 2
+            
+            if code == 0x01:
+                receiver = self._parse_receiver_block(sysex_data, idx, 88)
+                if receiver is None or idx + 88 > end:
+                    return None, "SysEx: RUNNING_STATE_DELTA (truncated JOIN)"
+                ops.append({'op': 'join', 'slot': slot, 'receiver': receiver})
+                idx += 88
+            elif code == 0x02:
+                if idx + 52 > end:
+                    return None, "SysEx: RUNNING_STATE_DELTA (truncated UPDATE)"
+                head = self._decode_7bit(sysex_data[idx:idx+6])
+                fields = {
+                    'last_seen_ms': int.from_bytes(bytes(head[:4]), 'big'),
+                    'media_index': head[4],
+                }
+                fields.update(self._parse_receiver_reports(sysex_data, idx + 6, 46))
+                ops.append({'op': 'update', 'slot': slot, 'fields': fields})
+                idx += 52
+            elif code == 0x03:
+                ops.append({'op': 'leave', 'slot': slot})
+            else:
+                return None, f"SysEx: RUNNING_STATE_DELTA (unknown op 0x{code:02X})"
+        
+        delta = {
+            'uptime_ms': uptime_ms,
+            'uptime_s': uptime_ms / 1000.0,
+            'mesh_synced': mesh_synced,
+            'reset': bool(flags & 0x01),
+            'more': bool(flags & 0x02),
+            'seq': seq,
+            'total_receivers': total_receivers,
+            'ops': ops
+        }
+        if not ops:
+            return delta, None  # Heartbeat: not logged
+        summary = ', '.join(f"{op['op']} {op['slot']}" for op in ops)
+        return delta, f"SysEx: RUNNING_STATE_DELTA #{seq}{' RESET' if delta['reset'] else ''} - {summary}"
+    
     def _parse_error_report(self, sysex_data):
         """Parse ERROR_REPORT SysEx message (F0 7D 30 [errorCode] [contextLength] [context...] F7)"""
         if len(sysex_data) < 6:  # Minimum: F0 7D 30 + code + length + F7
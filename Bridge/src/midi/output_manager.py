@@ -15,6 +15,7 @@
 # along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 import rtmidi
+import zlib
 
 
 class OutputManager:
@@ -35,10 +36,39 @@ class OutputManager:
         self.SYSEX_CMD_OTA_BEGIN = 0x05
         self.SYSEX_CMD_OTA_DATA = 0x06
         self.SYSEX_CMD_OTA_END = 0x07
+        self.SYSEX_CMD_OTA2_BEGIN = 0x08
+        self.SYSEX_CMD_OTA2_DATA = 0x09
+        self.SYSEX_CMD_OTA2_END = 0x0A
+        self.SYSEX_CMD_RUN_BENCHMARK = 0x0B
+        self.SYSEX_CMD_SUBSCRIBE_RUNNING_STATE = 0x0C
+        self.SYSEX_CMD_CHANNEL_SURVEY = 0x0D
+        self.SYSEX_CMD_QUERY_DIAGNOSTICS = 0x0E
+        self.SYSEX_CMD_PHANTOM_RECEIVERS = 0x0F
+        
+        # PHANTOM_RECEIVERS limits (PHANTOM_* in nowde_config.h)
+        self.PHANTOM_MAX_RECEIVERS = 48
+        self.PHANTOM_MAX_LAYERS = 8
+        
+        # CHANNEL_SURVEY modes (CHANNEL_SURVEY_* in nowde_config.h)
+        self.CHANNEL_SURVEY_REPORT_ONLY = 0
+        self.CHANNEL_SURVEY_AUTO = 1
+        self.CHANNEL_SURVEY_FORCE = 2
+        
+        # OTA v2 payload bytes per chunk (matches OTA2_CHUNK_SIZE in firmware)
+        self.OTA2_CHUNK_SIZE = 192
+        
+        # OTA2_BEGIN target (matches OTA_TARGET_* in firmware)
+        self.OTA_TARGET_SELF = 0  # Update the USB-connected Nowde
+        self.OTA_TARGET_MESH = 1  # Relay to receivers over ESP-NOW only
+        self.OTA_TARGET_BOTH = 2  # Relay, then update the sender too
         
         # Bridge → Receivers via Sender (0x10-0x1F)
         self.SYSEX_CMD_MEDIA_SYNC = 0x10
         self.SYSEX_CMD_CHANGE_RECEIVER_LAYER = 0x11
+        self.SYSEX_CMD_MEDIA_SYNC_BATCH = 0x12
+        
+        # Max layers per MEDIA_SYNC_BATCH (matches MEDIA_SYNC_BATCH_MAX_LAYERS in firmware)
+        self.MEDIA_SYNC_BATCH_MAX_LAYERS = 10
         
         # Nowde → Bridge Responses (0x20-0x3F)
         self.SYSEX_CMD_CONFIG_STATE = 0x20
@@ -129,12 +159,17 @@ class OutputManager:
         print("Sent QUERY_CONFIG SysEx")
         return (True, self.format_sysex_message(message))
     
-    def send_push_full_config(self, rf_sim_enabled, rf_sim_max_delay_ms):
+    def send_push_full_config(self, rf_sim_enabled, rf_sim_max_delay_ms, loss_percent=0,
+                              reorder_percent=0, outage_per_mille=0, outage_ms=0):
         """Send PUSH_FULL_CONFIG to apply configuration to sender
         
         Args:
             rf_sim_enabled: Boolean - enable RF simulation
             rf_sim_max_delay_ms: Int - maximum delay in milliseconds (0-16383)
+            loss_percent: Int - share of sync frames dropped (0-100)
+            reorder_percent: Int - share of sync frames held back past later ones (0-100)
+            outage_per_mille: Int - chance per frame (0-127 per 1000) of starting an outage
+            outage_ms: Int - length of an outage in milliseconds (0-16383)
         """
         if not self.current_port:
             return False
@@ -145,10 +180,17 @@ class OutputManager:
         delay_hi = (rf_sim_max_delay_ms >> 7) & 0x7F  # Upper 7 bits
         delay_lo = rf_sim_max_delay_ms & 0x7F          # Lower 7 bits
         
+        # Impairment model: [loss%] [reorder%] [outagePerMille] [outageMsHi] [outageMsLo]
+        impairments = [min(max(int(loss_percent), 0), 100),
+                       min(max(int(reorder_percent), 0), 100),
+                       min(max(int(outage_per_mille), 0), 127),
+                       (outage_ms >> 7) & 0x7F, outage_ms & 0x7F]
+        
         message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, 
-                   self.SYSEX_CMD_PUSH_FULL_CONFIG, enabled_byte, delay_hi, delay_lo, self.SYSEX_END]
+                   self.SYSEX_CMD_PUSH_FULL_CONFIG, enabled_byte, delay_hi, delay_lo] + impairments + [self.SYSEX_END]
         self.midi_out.send_message(message)
-        print(f"Sent PUSH_FULL_CONFIG: RF Sim={'ON' if rf_sim_enabled else 'OFF'}, MaxDelay={rf_sim_max_delay_ms}ms")
+        print(f"Sent PUSH_FULL_CONFIG: RF Sim={'ON' if rf_sim_enabled else 'OFF'}, MaxDelay={rf_sim_max_delay_ms}ms, "
+              f"Loss={impairments[0]}%, Reorder={impairments[1]}%, Outage={impairments[2]}/1000 x {outage_ms}ms")
         return (True, self.format_sysex_message(message))
     
     def send_query_running_state(self):
@@ -163,6 +205,85 @@ class OutputManager:
         # print("Sent QUERY_RUNNING_STATE SysEx")
         return (True, self.format_sysex_message(message))
     
+    def send_subscribe_running_state(self, enable=True):
+        """Ask the sender to push RUNNING_STATE_DELTA on changes (or stop doing so)"""
+        if not self.current_port:
+            return False
+        
+        # F0 7D 0C [enable] F7
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID,
+                   self.SYSEX_CMD_SUBSCRIBE_RUNNING_STATE, 1 if enable else 0, self.SYSEX_END]
+        self.midi_out.send_message(message)
+        return (True, self.format_sysex_message(message))
+    
+    def send_run_benchmark(self, test_mask=None):
+        """Ask the sender to run its on-device benchmarks (all of them by default).
+        Each one answers with a BENCHMARK_RESULT."""
+        if not self.current_port:
+            return False
+        
+        # F0 7D 0B [testMask] F7 (mask omitted = all)
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, self.SYSEX_CMD_RUN_BENCHMARK]
+        if test_mask is not None:
+            message.append(test_mask & 0x7F)
+        message.append(self.SYSEX_END)
+        self.midi_out.send_message(message)
+        return (True, self.format_sysex_message(message))
+    
+    def send_query_diagnostics(self):
+        """Ask the connected Nowde for heap, table and task stack usage (answered by DIAGNOSTICS)"""
+        if not self.current_port:
+            return False
+        
+        # F0 7D 0E F7
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, self.SYSEX_CMD_QUERY_DIAGNOSTICS,
+                   self.SYSEX_END]
+        self.midi_out.send_message(message)
+        return (True, self.format_sysex_message(message))
+    
+    def send_phantom_receivers(self, count, layers=()):
+        """Make the sender emulate `count` receivers spread over `layers` (load test,
+        answered by PHANTOM_REPORT). count 0 stops them."""
+        if not self.current_port:
+            return False
+        
+        # F0 7D 0F [count] [layerCount] layerCount x [layer(16)] F7
+        count = max(0, min(int(count), self.PHANTOM_MAX_RECEIVERS))
+        layers = list(layers)[:self.PHANTOM_MAX_LAYERS]
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, self.SYSEX_CMD_PHANTOM_RECEIVERS,
+                   count, len(layers)]
+        for layer in layers:
+            layer_bytes = layer.encode('ascii', errors='ignore')[:15]
+            message.extend(b & 0x7F for b in layer_bytes)
+            message.extend([0] * (16 - len(layer_bytes)))
+        message.append(self.SYSEX_END)
+        self.midi_out.send_message(message)
+        return (True, self.format_sysex_message(message))
+    
+    def send_channel_survey(self, auto_switch=True):
+        """Ask the sender to survey the WiFi channels (answered by CHANNEL_SURVEY_REPORT).
+        With auto_switch, the sender moves the mesh to a clearly better channel."""
+        if not self.current_port:
+            return False
+        
+        # F0 7D 0D [mode] F7
+        mode = self.CHANNEL_SURVEY_AUTO if auto_switch else self.CHANNEL_SURVEY_REPORT_ONLY
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, self.SYSEX_CMD_CHANNEL_SURVEY,
+                   mode, self.SYSEX_END]
+        self.midi_out.send_message(message)
+        return (True, self.format_sysex_message(message))
+    
+    def send_channel_force(self, channel):
+        """Move the sender and its receivers to a given channel (coordinated switch)"""
+        if not self.current_port:
+            return False
+        
+        # F0 7D 0D [mode=2] [channel] F7
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, self.SYSEX_CMD_CHANNEL_SURVEY,
+                   self.CHANNEL_SURVEY_FORCE, channel & 0x7F, self.SYSEX_END]
+        self.midi_out.send_message(message)
+        return (True, self.format_sysex_message(message))
+    
     def send_enter_bootloader(self):
         """Send ENTER_BOOTLOADER command to trigger firmware update mode (DEPRECATED - use OTA)"""
         if not self.current_port:
@@ -231,6 +352,58 @@ class OutputManager:
         print("Sent OTA_END")
         return (True, "OTA END")
     
+    def send_ota2_begin(self, firmware_size, sha256_digest, target=0):
+        """Send OTA2_BEGIN to start a windowed firmware update
+        
+        Args:
+            firmware_size: Size of firmware in bytes (uint32)
+            sha256_digest: 32-byte SHA-256 of the whole image
+            target: OTA_TARGET_SELF, OTA_TARGET_MESH or OTA_TARGET_BOTH
+        """
+        if not self.current_port:
+            return False, "No MIDI port open"
+        
+        raw = list(firmware_size.to_bytes(4, 'big')) + list(sha256_digest)
+        
+        # F0 7D 08 [size(4) + sha256(32), encoded:42] [target] F7
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID,
+                   self.SYSEX_CMD_OTA2_BEGIN] + self.encode_7bit(raw) + [target & 0x7F, self.SYSEX_END]
+        self.midi_out.send_message(message)
+        print(f"Sent OTA2_BEGIN: {firmware_size} bytes, target {target}")
+        return (True, f"OTA2 BEGIN: {firmware_size} bytes, target {target}")
+    
+    def send_ota2_data(self, seq, data_chunk):
+        """Send one sequence-numbered OTA2_DATA chunk with its CRC32
+        
+        Args:
+            seq: Chunk sequence number (21-bit)
+            data_chunk: Up to OTA2_CHUNK_SIZE bytes of firmware
+        """
+        if not self.current_port:
+            return False, "No MIDI port open"
+        
+        crc = zlib.crc32(data_chunk) & 0xFFFFFFFF
+        raw = list(data_chunk) + list(crc.to_bytes(4, 'big'))
+        
+        # F0 7D 09 [seq(3 x 7-bit)] [payload + crc32, encoded] F7
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, self.SYSEX_CMD_OTA2_DATA,
+                   (seq >> 14) & 0x7F, (seq >> 7) & 0x7F, seq & 0x7F] + \
+                  self.encode_7bit(raw) + [self.SYSEX_END]
+        self.midi_out.send_message(message)
+        return (True, f"OTA2 DATA: seq {seq}, {len(data_chunk)} bytes")
+    
+    def send_ota2_end(self):
+        """Send OTA2_END to verify and apply the uploaded image"""
+        if not self.current_port:
+            return False, "No MIDI port open"
+        
+        # F0 7D 0A F7
+        message = [self.SYSEX_START, self.SYSEX_MANUFACTURER_ID,
+                   self.SYSEX_CMD_OTA2_END, self.SYSEX_END]
+        self.midi_out.send_message(message)
+        print("Sent OTA2_END")
+        return (True, "OTA2 END")
+    
     def send_change_receiver_layer(self, mac_address, layer_name):
         """Send 'Change Receiver Layer' SysEx message to update a specific receiver's layer
         
@@ -286,6 +459,49 @@ class OutputManager:
         if not self.current_port:
             return False
         
+        message = ([self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, 
+                   self.SYSEX_CMD_MEDIA_SYNC] + 
+                   self._encode_media_sync_entry(layer_name, media_index, position_ms, state) + 
+                   [self.SYSEX_END])
+        
+        self.midi_out.send_message(message)
+        # Don't print every sync message to avoid spam
+        return (True, self.format_sysex_message(message))
+    
+    def send_media_sync_batch(self, entries):
+        """Send 'Media Sync Batch' SysEx message carrying several layers at once
+        
+        The sender stamps all layers with a single mesh timestamp and forwards them
+        as one ESP-NOW frame. Lists longer than MEDIA_SYNC_BATCH_MAX_LAYERS are split.
+        
+        Packet format:
+        F0 7D 12 [count(1)] count x ([layer_name(16)] [media_index(1)] [position_ms_encoded(5)] [state(1)]) F7
+        
+        Args:
+            entries: List of dicts with layer_name, media_index, position_ms, state
+        """
+        if not self.current_port or not entries:
+            return False
+        
+        max_layers = self.MEDIA_SYNC_BATCH_MAX_LAYERS
+        message = None
+        for start in range(0, len(entries), max_layers):
+            group = entries[start:start + max_layers]
+            payload = []
+            for entry in group:
+                payload += self._encode_media_sync_entry(entry['layer_name'], entry['media_index'],
+                                                         entry['position_ms'], entry['state'])
+            
+            message = ([self.SYSEX_START, self.SYSEX_MANUFACTURER_ID,
+                        self.SYSEX_CMD_MEDIA_SYNC_BATCH, len(group)] +
+                       payload +
+                       [self.SYSEX_END])
+            self.midi_out.send_message(message)
+        
+        return (True, self.format_sysex_message(message))
+    
+    def _encode_media_sync_entry(self, layer_name, media_index, position_ms, state):
+        """Encode one layer state: [layer_name(16)] [media_index(1)] [position_ms_encoded(5)] [state(1)]"""
         # Pad or truncate layer name to exactly 16 bytes
         layer_bytes = (layer_name[:16] + '\x00' * 16)[:16].encode('ascii')
         
@@ -304,17 +520,7 @@ class OutputManager:
         ]
         position_bytes_encoded = self.encode_7bit(position_bytes_raw)
         
-        message = ([self.SYSEX_START, self.SYSEX_MANUFACTURER_ID, 
-                   self.SYSEX_CMD_MEDIA_SYNC] + 
-                   list(layer_bytes) + 
-                   [media_index] + 
-                   position_bytes_encoded + 
-                   [state_byte] + 
-                   [self.SYSEX_END])
-        
-        self.midi_out.send_message(message)
-        # Don't print every sync message to avoid spam
-        return (True, self.format_sysex_message(message))
+        return list(layer_bytes) + [media_index] + position_bytes_encoded + [state_byte]
     
     def format_sysex_message(self, message):
         """Format SysEx message for human-readable logging"""
@@ -333,7 +539,11 @@ class OutputManager:
         elif cmd == self.SYSEX_CMD_PUSH_FULL_CONFIG:
             if len(message) >= 7:
                 rf_sim = "ON" if message[3] != 0 else "OFF"
-                max_delay = (message[4] << 8) | message[5]
+                max_delay = (message[4] << 7) | message[5]
+                if len(message) >= 12:
+                    outage_ms = (message[9] << 7) | message[10]
+                    return (f"SysEx: PUSH_FULL_CONFIG RF={rf_sim}, MaxDelay={max_delay}ms, Loss={message[6]}%, "
+                            f"Reorder={message[7]}%, Outage={message[8]}/1000 x {outage_ms}ms")
                 return f"SysEx: PUSH_FULL_CONFIG RF={rf_sim}, MaxDelay={max_delay}ms"
             else:
                 hex_str = ' '.join(f'{b:02X}' for b in message)
@@ -342,6 +552,16 @@ class OutputManager:
         elif cmd == self.SYSEX_CMD_QUERY_RUNNING_STATE:
             return "SysEx: QUERY_RUNNING_STATE (F0 7D 03 F7)"
         
+        elif cmd == self.SYSEX_CMD_RUN_BENCHMARK:
+            mask = f"0x{message[3]:02X}" if len(message) >= 5 else "all"
+            return f"SysEx: RUN_BENCHMARK (tests={mask})"
+        
+        elif cmd == self.SYSEX_CMD_CHANNEL_SURVEY:
+            mode = message[3] if len(message) >= 5 else -1
+            if mode == self.CHANNEL_SURVEY_FORCE and len(message) >= 6:
+                return f"SysEx: CHANNEL_SURVEY (force channel {message[4]})"
+            return f"SysEx: CHANNEL_SURVEY ({'auto' if mode == self.CHANNEL_SURVEY_AUTO else 'report only'})"
+        
         elif cmd == self.SYSEX_CMD_CHANGE_RECEIVER_LAYER:
             # Extract MAC and layer name
             # Format: F0 7D 04 [MAC(6)] [Layer(16)] F7
@@ -381,6 +601,19 @@ class OutputManager:
                 hex_str = ' '.join(f'{b:02X}' for b in message)
                 return f"SysEx: Media Sync (malformed) ({hex_str})"
         
+        elif cmd == self.SYSEX_CMD_MEDIA_SYNC_BATCH:
+            if len(message) >= 5:
+                count = message[3]
+                layer_names = []
+                for i in range(count):
+                    start = 4 + i * 23
+                    layer_bytes = message[start:start + 16]
+                    layer_names.append(bytes(layer_bytes).decode('ascii', errors='ignore').rstrip('\x00'))
+                return f"SysEx: Media Sync Batch {count} layer(s): {', '.join(layer_names)}"
+            else:
+                hex_str = ' '.join(f'{b:02X}' for b in message)
+                return f"SysEx: Media Sync Batch (malformed) ({hex_str})"
+        
         else:
             hex_str = ' '.join(f'{b:02X}' for b in message)
             return f"SysEx (CMD 0x{cmd:02X}): {hex_str}"
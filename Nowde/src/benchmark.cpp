@@ -0,0 +1,237 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <esp_cpu.h>
+
+#include "midi.h"
+#include "mtc.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "sync_estimator.h"
+#include "sysex.h"
+#include "sysex_stream.h"
+
+namespace {
+
+constexpr uint32_t QF_INTERVAL_US = 1000000 / (MTC_FRAMERATE * 4);
+constexpr size_t MAX_SIM_PENDING = BENCHMARK_SIM_MAX_DELAY_MS / BENCHMARK_SIM_SAMPLE_INTERVAL_MS + 2;
+constexpr size_t BATCH_ENTRY_LEN = MAX_LAYER_LENGTH + 1 + 5 + 1;
+constexpr size_t BATCH_MESSAGE_LEN = 4 + MEDIA_SYNC_BATCH_MAX_LAYERS * BATCH_ENTRY_LEN + 1;
+
+// Static: the MIDI task stack is small
+uint8_t rawChunk[OTA2_CHUNK_SIZE + 4];
+uint8_t encodedChunk[encoded7bitSize(sizeof(rawChunk))];
+uint8_t batchMessage[BATCH_MESSAGE_LEN];
+
+uint32_t cyclesToNs(uint32_t cycles) {
+  return static_cast<uint32_t>(static_cast<uint64_t>(cycles) * 1000 / getCpuFrequencyMhz());
+}
+
+template <typename Fn>
+void timeRuns(BenchmarkStats* stats, uint16_t runs, Fn fn) {
+  for (uint16_t i = 0; i < runs; i++) {
+    uint32_t start = esp_cpu_get_cycle_count();
+    fn();
+    stats->add(cyclesToNs(esp_cpu_get_cycle_count() - start));
+  }
+}
+
+void sendResult(uint8_t id, uint16_t param, const BenchmarkStats& stats) {
+  uint32_t avgNs = stats.avgNs();
+  LOG_INFO(LOG_CAT_CORE, "[BENCH] #%u param=%u n=%u min=%lu avg=%lu max=%lu ns\r\n",
+           id, param, stats.samples, stats.samples ? stats.minNs : 0, avgNs, stats.maxNs);
+
+  midiSysexBegin(SYSEX_CMD_BENCHMARK_RESULT);
+  midiSysexByte(id);
+  midiSysexEncodeU16(param);
+  midiSysexEncodeU16(stats.samples);
+  midiSysexEncodeU32(stats.samples ? stats.minNs : 0);
+  midiSysexEncodeU32(avgNs);
+  midiSysexEncodeU32(stats.maxNs);
+  midiSysexEnd();
+}
+
+// Layer names nobody registers, so the parse runs in full but nothing is sent
+void buildBatchMessage() {
+  size_t idx = 0;
+  batchMessage[idx++] = SYSEX_START;
+  batchMessage[idx++] = SYSEX_MANUFACTURER_ID;
+  batchMessage[idx++] = SYSEX_CMD_MEDIA_SYNC_BATCH;
+  batchMessage[idx++] = MEDIA_SYNC_BATCH_MAX_LAYERS;
+  for (uint8_t i = 0; i < MEDIA_SYNC_BATCH_MAX_LAYERS; i++) {
+    memset(&batchMessage[idx], 0, MAX_LAYER_LENGTH);
+    snprintf(reinterpret_cast<char*>(&batchMessage[idx]), MAX_LAYER_LENGTH, "~bench%u", i);
+    idx += MAX_LAYER_LENGTH;
+    batchMessage[idx++] = i + 1;
+    const uint8_t position[4] = {0x00, 0x12, 0xD6, 0x87};
+    encode7bitFixed<4>(position, &batchMessage[idx]);
+    idx += 5;
+    batchMessage[idx++] = 1;
+  }
+  batchMessage[idx] = SYSEX_END;
+}
+
+uint32_t nextRandom(uint32_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+}  // namespace
+
+void BenchmarkStats::add(uint32_t ns) {
+  minNs = std::min(minNs, ns);
+  maxNs = std::max(maxNs, ns);
+  sumNs += ns;
+  samples++;
+}
+
+uint32_t BenchmarkStats::avgNs() const {
+  return samples ? static_cast<uint32_t>(sumNs / samples) : 0;
+}
+
+BenchmarkStats benchmarkCodecDecode(uint16_t* param) {
+  for (size_t i = 0; i < sizeof(rawChunk); i++) {
+    rawChunk[i] = static_cast<uint8_t>(i * 167 + 13);
+  }
+  int encodedLen = encode7bit(rawChunk, sizeof(rawChunk), encodedChunk);
+
+  BenchmarkStats stats;
+  timeRuns(&stats, BENCHMARK_ITERATIONS, [&] { decode7bit(encodedChunk, encodedLen, rawChunk); });
+  *param = static_cast<uint16_t>(encodedLen);
+  return stats;
+}
+
+BenchmarkStats benchmarkCodecEncode(uint16_t* param) {
+  for (size_t i = 0; i < sizeof(rawChunk); i++) {
+    rawChunk[i] = static_cast<uint8_t>(i * 167 + 13);
+  }
+
+  BenchmarkStats stats;
+  timeRuns(&stats, BENCHMARK_ITERATIONS, [] { encode7bit(rawChunk, sizeof(rawChunk), encodedChunk); });
+  *param = sizeof(rawChunk);
+  return stats;
+}
+
+BenchmarkStats benchmarkSysexParse(uint16_t* param) {
+  buildBatchMessage();
+  const SysexStreamHandler* handler = sysexStreamHandlerFor(SYSEX_CMD_MEDIA_SYNC_BATCH);
+
+  BenchmarkStats stats;
+  timeRuns(&stats, BENCHMARK_ITERATIONS, [&] { sysexStreamReplay(handler, batchMessage, sizeof(batchMessage)); });
+  *param = MEDIA_SYNC_BATCH_MAX_LAYERS;
+  return stats;
+}
+
+BenchmarkStats benchmarkRunningState(uint16_t* param) {
+  uint16_t receivers = 0;
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    if (receiverTable[i].active && receiverTable[i].connected) {
+      receivers++;
+    }
+  }
+
+  BenchmarkStats stats;
+  timeRuns(&stats, BENCHMARK_RUNNING_STATE_RUNS, [] { sendRunningStateNow(); });
+  *param = receivers;
+  return stats;
+}
+
+// 1x playback: the sender stamps a sample every BENCHMARK_SIM_SAMPLE_INTERVAL_MS
+// (position off by up to BENCHMARK_SIM_POSITION_JITTER_MS, as reported by the
+// media server) and each one arrives random(0, max delay) later, so samples can
+// be late and out of order exactly as with the RF simulation queue. The
+// estimate is checked against the true position at every quarter-frame instant.
+BenchmarkStats benchmarkMtcError(uint16_t maxDelayMs) {
+  struct Pending {
+    uint32_t arrival;
+    uint32_t stamp;
+    uint32_t positionMs;
+  };
+  static Pending pending[MAX_SIM_PENDING];
+  size_t pendingCount = 0;
+
+  uint32_t maxDelay = std::min<uint32_t>(maxDelayMs, BENCHMARK_SIM_MAX_DELAY_MS);
+  uint32_t rng = 0x2545F491;  // Fixed seed: runs are comparable across builds
+  constexpr uint32_t base = 1000000;  // Mesh time at which playback starts
+  constexpr uint32_t startPositionMs = 60000;
+  uint32_t nextStamp = base;
+  bool started = false;
+  BenchmarkStats stats;
+
+  for (uint32_t tUs = 0; tUs <= BENCHMARK_SIM_DURATION_MS * 1000; tUs += QF_INTERVAL_US) {
+    uint32_t now = base + tUs / 1000;
+
+    while (nextStamp <= now && pendingCount < MAX_SIM_PENDING) {
+      uint32_t delay = nextRandom(&rng) % (maxDelay + 1);
+      int32_t jitter = static_cast<int32_t>(nextRandom(&rng) % (2 * BENCHMARK_SIM_POSITION_JITTER_MS + 1)) -
+                       BENCHMARK_SIM_POSITION_JITTER_MS;
+      pending[pendingCount++] = {nextStamp + delay, nextStamp, nextStamp - base + startPositionMs + jitter};
+      nextStamp += BENCHMARK_SIM_SAMPLE_INTERVAL_MS;
+    }
+
+    // Deliver everything that has arrived, earliest arrival first
+    for (;;) {
+      int next = -1;
+      for (size_t i = 0; i < pendingCount; i++) {
+        if (pending[i].arrival <= now && (next < 0 || pending[i].arrival < pending[next].arrival)) {
+          next = static_cast<int>(i);
+        }
+      }
+      if (next < 0) {
+        break;
+      }
+      const Pending& sample = pending[next];
+      if (!started) {
+        syncEstimatorReset(sample.positionMs, sample.stamp);
+        started = true;
+      } else {
+        syncEstimatorUpdate(sample.positionMs, sample.stamp);
+      }
+      pending[next] = pending[--pendingCount];
+    }
+
+    if (started) {
+      int32_t errorMs = static_cast<int32_t>(syncEstimatorPosition(now) - (now - base + startPositionMs));
+      stats.add(std::min<uint32_t>(abs(errorMs), 4000) * 1000000);
+    }
+  }
+
+  syncEstimatorHold();
+  return stats;
+}
+
+
+void benchmarkRun(uint8_t mask) {
+  LOG_INFO(LOG_CAT_CORE, "[BENCH] Running benchmarks (mask 0x%02X) at %lu MHz\r\n", mask, getCpuFrequencyMhz());
+
+  uint16_t param = 0;
+  if (mask & (1 << BENCH_CODEC_DECODE)) {
+    BenchmarkStats stats = benchmarkCodecDecode(&param);
+    sendResult(BENCH_CODEC_DECODE, param, stats);
+  }
+  if (mask & (1 << BENCH_CODEC_ENCODE)) {
+    BenchmarkStats stats = benchmarkCodecEncode(&param);
+    sendResult(BENCH_CODEC_ENCODE, param, stats);
+  }
+  if (mask & (1 << BENCH_SYSEX_PARSE)) {
+    BenchmarkStats stats = benchmarkSysexParse(&param);
+    sendResult(BENCH_SYSEX_PARSE, param, stats);
+  }
+  if (mask & (1 << BENCH_RUNNING_STATE)) {
+    BenchmarkStats stats = benchmarkRunningState(&param);
+    sendResult(BENCH_RUNNING_STATE, param, stats);
+  }
+  if (mask & (1 << BENCH_MTC_ERROR)) {
+    if (mtcRunning()) {
+      LOG_WARN(LOG_CAT_CORE, "[BENCH] MTC running, skipping estimator simulation\r\n");
+    } else {
+      uint16_t maxDelay = std::min<uint16_t>(rfSimMaxDelayMs, BENCHMARK_SIM_MAX_DELAY_MS);
+      sendResult(BENCH_MTC_ERROR, maxDelay, benchmarkMtcError(maxDelay));
+    }
+  }
+}
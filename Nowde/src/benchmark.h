@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+// On-device benchmarks, run on request from the Bridge (RUN_BENCHMARK) so
+// performance regressions show up on real hardware before a fleet update:
+// 7-bit codec and SysEx parse cost, RUNNING_STATE serialization against the
+// current receiver count, and the MTC position error of the sync estimator
+// under the RF simulation delay model (rfSimMaxDelayMs).
+// Each selected benchmark answers with one BENCHMARK_RESULT (nowde_config.h).
+// Runs synchronously in the MIDI task; the MTC simulation is skipped while
+// this Nowde is generating MTC itself, since it drives the shared estimator.
+void benchmarkRun(uint8_t mask);
+
+struct BenchmarkStats {
+  uint32_t minNs = UINT32_MAX;
+  uint32_t maxNs = 0;
+  uint64_t sumNs = 0;
+  uint16_t samples = 0;
+
+  void add(uint32_t ns);
+  uint32_t avgNs() const;
+};
+
+// The measurements behind benchmarkRun(). The native test environment runs
+// them on the host too (test/test_host_bench); param is what BENCHMARK_RESULT
+// reports for each (nowde_config.h).
+BenchmarkStats benchmarkCodecDecode(uint16_t* param);
+BenchmarkStats benchmarkCodecEncode(uint16_t* param);
+BenchmarkStats benchmarkSysexParse(uint16_t* param);
+// RUNNING_STATE for the receivers currently in the table
+BenchmarkStats benchmarkRunningState(uint16_t* param);
+// Error samples are in ms * 10^6 so they share the ns fields. Drives the
+// shared sync estimator: not while MTC is running.
+BenchmarkStats benchmarkMtcError(uint16_t maxDelayMs);
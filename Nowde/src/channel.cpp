@@ -0,0 +1,296 @@
+#include "channel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <WiFi.h>
+#include <esp_wifi.h>
+
+#include "metrics.h"
+#include "midi.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "scheduler.h"
+#include "storage.h"
+
+namespace {
+
+constexpr uint8_t REQUEST_NONE = 0xFF;
+constexpr int8_t NOISE_FLOOR_DBM = -100;
+
+// Share of an AP's power seen on a channel |delta| steps away (20 MHz wide
+// channels, 5 MHz apart: nothing left at 5 steps)
+constexpr float OVERLAP[] = {1.0f, 0.8f, 0.5f, 0.2f, 0.05f};
+constexpr int OVERLAP_STEPS = sizeof(OVERLAP) / sizeof(OVERLAP[0]);
+
+uint8_t currentChannel = CHANNEL_DEFAULT;
+
+// Set by channelRequest (MIDI task), picked up by channelTick
+volatile uint8_t requestMode = REQUEST_NONE;
+volatile uint8_t requestChannel = 0;
+
+bool surveyRunning = false;
+bool surveyApply = false;
+uint32_t lossTxOk = 0;  // metrics counters at the previous survey
+uint32_t lossTxFail = 0;
+
+// Coordinated switch in progress (announced by us, or by our sender)
+uint8_t nextChannel = 0;
+uint32_t switchAtMesh = 0;
+uint32_t switchAtMs = 0;
+
+// Receiver re-acquire
+uint32_t lastBeaconMs = 0;
+bool scanning = false;
+uint32_t hopAtMs = 0;
+
+bool validChannel(uint8_t channel) {
+  return channel >= 1 && channel <= CHANNEL_MAX;
+}
+
+bool applyChannel(uint8_t channel, bool persist) {
+  if (esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_ESPNOW, "[CHANNEL] Failed to switch to channel %d\r\n", channel);
+    return false;
+  }
+  if (channel != currentChannel) {
+    metricsCount(METRIC_CHANNEL_SWITCH);
+  }
+  currentChannel = channel;
+  if (persist) {
+    profileSetChannel(channel);
+  }
+  return true;
+}
+
+// Sender: everyone moves at the same mesh instant, announced in the next beacons
+void announceSwitch(uint8_t channel, uint32_t now) {
+  nextChannel = channel;
+  switchAtMesh = meshClock.meshMillis() + CHANNEL_SWITCH_LEAD_MS;
+  switchAtMs = now + CHANNEL_SWITCH_LEAD_MS;
+  schedulerArm(SCHED_SENDER_BEACON, now);
+  LOG_INFO(LOG_CAT_ESPNOW, "[CHANNEL] Switching %d -> %d in %lu ms\r\n",
+           currentChannel, channel, static_cast<uint32_t>(CHANNEL_SWITCH_LEAD_MS));
+}
+
+// Unicast loss (ESP-NOW acks) on the current channel since the previous survey
+uint8_t currentLossPercent() {
+  uint32_t ok = metricsCounter(METRIC_ESPNOW_TX_OK);
+  uint32_t fail = metricsCounter(METRIC_ESPNOW_TX_FAIL);
+  uint32_t sent = (ok - lossTxOk) + (fail - lossTxFail);
+  uint32_t failed = fail - lossTxFail;
+  lossTxOk = ok;
+  lossTxFail = fail;
+  return sent >= 20 ? static_cast<uint8_t>(failed * 100 / sent) : 0;
+}
+
+void startSurvey(bool apply) {
+  // Passive, so the scan itself puts nothing on the air
+  int16_t result = WiFi.scanNetworks(true, true, true, CHANNEL_SURVEY_DWELL_MS);
+  if (result == WIFI_SCAN_FAILED) {
+    LOG_ERROR(LOG_CAT_ESPNOW, "[CHANNEL] Survey scan failed to start\r\n");
+    return;
+  }
+  surveyRunning = true;
+  surveyApply = apply;
+  LOG_INFO(LOG_CAT_ESPNOW, "[CHANNEL] Survey started on channel %d\r\n", currentChannel);
+}
+
+// F0 7D 28 [current] [chosen(0 = stay)] [lossPercent] [count]
+//          count x ([channel] [apCount] [-interferenceDbm]) F7
+void sendSurveyReport(const uint8_t* apCount, const int8_t* interferenceDbm, uint8_t chosen, uint8_t lossPercent) {
+  midiSysexBegin(SYSEX_CMD_CHANNEL_SURVEY_REPORT);
+  midiSysexByte(currentChannel);
+  midiSysexByte(chosen);
+  midiSysexByte(std::min<uint8_t>(lossPercent, 100));
+  midiSysexByte(CHANNEL_MAX);
+  for (uint8_t channel = 1; channel <= CHANNEL_MAX; channel++) {
+    midiSysexByte(channel);
+    midiSysexByte(std::min<uint8_t>(apCount[channel], 127));
+    midiSysexByte(static_cast<uint8_t>(-interferenceDbm[channel]));
+  }
+  midiSysexEnd();
+}
+
+void finishSurvey(int16_t networkCount, uint32_t now) {
+  float interferenceMw[CHANNEL_MAX + 1] = {};
+  uint8_t apCount[CHANNEL_MAX + 1] = {};
+
+  for (int16_t i = 0; i < networkCount; i++) {
+    int channel = WiFi.channel(i);
+    float mw = powf(10.0f, WiFi.RSSI(i) / 10.0f);
+    if (validChannel(channel)) {
+      apCount[channel]++;
+    }
+    for (int c = 1; c <= CHANNEL_MAX; c++) {
+      int delta = abs(c - channel);
+      if (delta < OVERLAP_STEPS) {
+        interferenceMw[c] += mw * OVERLAP[delta];
+      }
+    }
+  }
+  WiFi.scanDelete();
+
+  int8_t interferenceDbm[CHANNEL_MAX + 1];
+  for (int c = 1; c <= CHANNEL_MAX; c++) {
+    float dbm = interferenceMw[c] > 0 ? 10.0f * log10f(interferenceMw[c]) : NOISE_FLOOR_DBM;
+    interferenceDbm[c] = static_cast<int8_t>(std::max<float>(NOISE_FLOOR_DBM, std::min<float>(0, dbm)));
+  }
+
+  // With heavy loss here the current channel is out even if the scan finds it quiet
+  // (non-WiFi interference does not show up as APs)
+  uint8_t lossPercent = currentLossPercent();
+  bool leaveCurrent = lossPercent > CHANNEL_LOSS_SWITCH_PERCENT;
+  uint8_t best = 0;
+  for (uint8_t c = 1; c <= CHANNEL_MAX; c++) {
+    if (leaveCurrent && c == currentChannel) {
+      continue;
+    }
+    if (best == 0 || interferenceDbm[c] < interferenceDbm[best]) {
+      best = c;
+    }
+  }
+
+  uint8_t chosen = 0;
+  if (best != currentChannel &&
+      (leaveCurrent || interferenceDbm[currentChannel] - interferenceDbm[best] >= CHANNEL_SWITCH_MARGIN_DB)) {
+    chosen = best;
+  }
+
+  LOG_INFO(LOG_CAT_ESPNOW, "[CHANNEL] Survey: %d AP(s), channel %d at %d dBm (loss %d%%), best %d at %d dBm\r\n",
+           networkCount, currentChannel, interferenceDbm[currentChannel], lossPercent, best, interferenceDbm[best]);
+  sendSurveyReport(apCount, interferenceDbm, surveyApply ? chosen : 0, lossPercent);
+  if (surveyApply && chosen != 0) {
+    announceSwitch(chosen, now);
+  }
+}
+
+void pollSurvey(uint32_t now) {
+  int16_t result = WiFi.scanComplete();
+  if (result == WIFI_SCAN_RUNNING) {
+    return;
+  }
+  surveyRunning = false;
+  if (result < 0) {
+    LOG_ERROR(LOG_CAT_ESPNOW, "[CHANNEL] Survey scan failed\r\n");
+    return;
+  }
+  finishSurvey(result, now);
+}
+
+// Receiver with no sender left: try the other channels in turn
+void checkReacquire(uint32_t now) {
+  if (countActiveSenders() > 0) {
+    scanning = false;
+    return;
+  }
+  if (!scanning) {
+    if ((now - lastBeaconMs) < CHANNEL_REACQUIRE_MS) {
+      return;
+    }
+    scanning = true;
+    hopAtMs = now;
+    LOG_WARN(LOG_CAT_RECEIVER, "[CHANNEL] No sender for %lu ms, scanning channels\r\n",
+             static_cast<uint32_t>(CHANNEL_REACQUIRE_MS));
+  }
+  if (static_cast<int32_t>(now - hopAtMs) >= 0) {
+    applyChannel(currentChannel % CHANNEL_MAX + 1, false);
+    hopAtMs = now + CHANNEL_SCAN_DWELL_MS;
+  }
+}
+
+}  // namespace
+
+void channelInit() {
+  uint8_t saved = profileGet().channel;
+  currentChannel = validChannel(saved) ? saved : CHANNEL_DEFAULT;
+  if (esp_wifi_set_channel(currentChannel, WIFI_SECOND_CHAN_NONE) == ESP_OK) {
+    LOG_INFO(LOG_CAT_CORE, "[INIT] ESP-NOW channel %d\r\n", currentChannel);
+  } else {
+    LOG_ERROR(LOG_CAT_CORE, "[ERROR] Failed to set ESP-NOW channel %d\r\n", currentChannel);
+  }
+}
+
+uint8_t channelCurrent() {
+  return currentChannel;
+}
+
+void channelRequest(uint8_t mode, uint8_t channel) {
+  requestChannel = channel;
+  requestMode = mode;
+  schedulerArm(SCHED_CHANNEL, millis());
+}
+
+void channelTick(uint32_t now) {
+  if (nextChannel != 0 && static_cast<int32_t>(now - switchAtMs) >= 0) {
+    LOG_INFO(LOG_CAT_ESPNOW, "[CHANNEL] Now on channel %d\r\n", nextChannel);
+    applyChannel(nextChannel, true);
+    nextChannel = 0;
+  }
+
+  uint8_t mode = requestMode;
+  if (mode != REQUEST_NONE && senderModeEnabled && !surveyRunning && nextChannel == 0) {
+    requestMode = REQUEST_NONE;
+    if (mode == CHANNEL_SURVEY_FORCE) {
+      if (validChannel(requestChannel) && requestChannel != currentChannel) {
+        announceSwitch(requestChannel, now);
+      }
+    } else {
+      startSurvey(mode == CHANNEL_SURVEY_AUTO);
+    }
+  }
+
+  if (surveyRunning) {
+    pollSurvey(now);
+  }
+
+  // A sender owns its channel: only pure receivers go looking
+  if (receiverModeEnabled && !senderModeEnabled) {
+    checkReacquire(now);
+  }
+
+  uint32_t due = now + CHANNEL_TICK_MS;
+  if (nextChannel != 0 && static_cast<int32_t>(switchAtMs - due) < 0) {
+    due = switchAtMs;
+  }
+  schedulerArm(SCHED_CHANNEL, due);
+}
+
+size_t channelAppendBeaconInfo(uint8_t* frame, size_t frameLen) {
+  ChannelInfo info;
+  info.channel = currentChannel;
+  info.nextChannel = nextChannel;
+  info.switchAtMesh = switchAtMesh;
+  memcpy(frame + frameLen, &info, sizeof(info));
+  return frameLen + sizeof(info);
+}
+
+int channelHandleBeacon(const uint8_t* ext, int extLen) {
+  uint32_t now = millis();
+  lastBeaconMs = now;
+  if (scanning) {
+    scanning = false;
+    profileSetChannel(currentChannel);
+    LOG_INFO(LOG_CAT_RECEIVER, "[CHANNEL] Sender found on channel %d\r\n", currentChannel);
+  }
+
+  if (extLen < static_cast<int>(sizeof(ChannelInfo)) || ext[0] != CHANNEL_INFO_MAGIC) {
+    return 0;
+  }
+
+  ChannelInfo info;
+  memcpy(&info, ext, sizeof(info));
+  if (!senderModeEnabled && validChannel(info.nextChannel) && info.nextChannel != currentChannel &&
+      info.nextChannel != nextChannel) {
+    // Deadline in our time base; mesh clocks agree to a few ms
+    int32_t leadMs = static_cast<int32_t>(info.switchAtMesh - meshClock.meshMillis());
+    leadMs = std::max<int32_t>(0, std::min<int32_t>(leadMs, 2 * CHANNEL_SWITCH_LEAD_MS));
+    nextChannel = info.nextChannel;
+    switchAtMs = now + leadMs;
+    schedulerArmEarliest(SCHED_CHANNEL, switchAtMs);
+    LOG_INFO(LOG_CAT_RECEIVER, "[CHANNEL] Sender moves to channel %d in %ld ms\r\n", nextChannel, leadMs);
+  }
+  return sizeof(ChannelInfo);
+}
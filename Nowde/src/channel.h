@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ESP-NOW home channel management.
+// Peers are registered with channel 0, i.e. "the current home channel", so
+// moving the radio moves every peer with it.
+//  - Sender: surveys interference (passive WiFi scan, APs weighted by RSSI and
+//    channel overlap) plus its own unicast loss, when sender mode starts and on
+//    SYSEX_CMD_CHANNEL_SURVEY. A clearly better channel is announced in every
+//    SenderBeacon (ChannelInfo) CHANNEL_SWITCH_LEAD_MS ahead; sender and
+//    receivers switch at the same mesh-clock deadline.
+//  - Receiver: follows announced switches; after CHANNEL_REACQUIRE_MS without
+//    any sender it hops channels (CHANNEL_SCAN_DWELL_MS each) until a beacon is
+//    heard again. The channel in use is persisted on both sides.
+// Everything except channelRequest runs on the ESP-NOW task.
+
+// setup(), after esp_now_init: move to the saved channel
+void channelInit();
+uint8_t channelCurrent();
+
+// Any task (Bridge command): CHANNEL_SURVEY_* mode, channel for CHANNEL_SURVEY_FORCE
+void channelRequest(uint8_t mode, uint8_t channel);
+
+// SCHED_CHANNEL: survey polling, switch deadline, re-acquire scan
+void channelTick(uint32_t now);
+
+// Sender: append our ChannelInfo after a beacon's layer entries; returns the new length
+size_t channelAppendBeaconInfo(uint8_t* frame, size_t frameLen);
+// Receiver: a sender beacon was heard; ext is what follows its layer entries.
+// Returns the ChannelInfo bytes consumed (0 when the beacon has none).
+int channelHandleBeacon(const uint8_t* ext, int extLen);
@@ -0,0 +1,87 @@
+#include "diagnostics.h"
+
+#include <algorithm>
+
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "midi.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+
+namespace {
+
+struct TaskInfo {
+  const char* name;    // FreeRTOS task name (xTaskGetHandle)
+  uint16_t stackSize;  // Bytes given at creation, 0 = unknown here
+};
+
+// Position is the task ID on the wire (append only: the Bridge names them by it)
+const TaskInfo TASKS[] = {
+  {"MIDI_Task", MIDI_TASK_STACK_SIZE},
+  {"ESPNOW_Task", ESPNOW_TASK_STACK_SIZE},
+  {"Log_Flush", LOG_TASK_STACK_SIZE},
+  {"Profile_Store", PROFILE_TASK_STACK_SIZE},
+  {"OTA_Flash", OTA_FLASH_TASK_STACK_SIZE},  // Only while an OTA runs
+  {"loopTask", LOOP_TASK_STACK_SIZE},        // Arduino setup()/loop()
+#ifdef CONFIG_ESP_TIMER_TASK_STACK_SIZE
+  {"esp_timer", CONFIG_ESP_TIMER_TASK_STACK_SIZE},
+#else
+  {"esp_timer", 0},
+#endif
+};
+constexpr uint8_t TASK_COUNT = sizeof(TASKS) / sizeof(TASKS[0]);
+
+}  // namespace
+
+void diagnosticsSend() {
+  // Format: F0 7D 29 [taskCount] [heapFree(4) heapMinFree(4)
+  //   receiverEntryBytes(2) receiverSlots(2) senderEntryBytes(2) senderSlots(2)
+  //   taskCount x (taskId(1) stackSize(2) stackFreeMin(2)), encoded] F7
+  // Tasks that do not exist right now are left out.
+  uint16_t freeMin[TASK_COUNT];
+  bool exists[TASK_COUNT];
+  uint8_t present = 0;
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    TaskHandle_t handle = xTaskGetHandle(TASKS[i].name);
+    exists[i] = handle != nullptr;
+    freeMin[i] = exists[i] ? static_cast<uint16_t>(std::min<UBaseType_t>(uxTaskGetStackHighWaterMark(handle), 0xFFFF))
+                           : 0;
+    if (exists[i]) {
+      present++;
+    }
+  }
+
+  uint32_t heapFree = esp_get_free_heap_size();
+  uint32_t heapMinFree = esp_get_minimum_free_heap_size();
+
+  midiSysexBegin(SYSEX_CMD_DIAGNOSTICS);
+  midiSysexByte(present);
+  midiSysexEncodeU32(heapFree);
+  midiSysexEncodeU32(heapMinFree);
+  midiSysexEncodeU16(sizeof(ReceiverEntry));
+  midiSysexEncodeU16(MAX_RECEIVERS);
+  midiSysexEncodeU16(sizeof(SenderEntry));
+  midiSysexEncodeU16(MAX_SENDERS);
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    if (exists[i]) {
+      midiSysexEncode(&i, 1);
+      midiSysexEncodeU16(TASKS[i].stackSize);
+      midiSysexEncodeU16(freeMin[i]);
+    }
+  }
+  midiSysexEnd();
+
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    if (exists[i]) {
+      LOG_INFO(LOG_CAT_CORE, "[DIAG] %s: %u of %u stack bytes never used\r\n",
+               TASKS[i].name, freeMin[i], TASKS[i].stackSize);
+    }
+  }
+
+  LOG_INFO(LOG_CAT_CORE, "[DIAG] Heap free %lu (min %lu), tables %u + %u bytes\r\n",
+           heapFree, heapMinFree, static_cast<unsigned>(sizeof(receiverTable)),
+           static_cast<unsigned>(sizeof(senderTable)));
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Memory diagnostics, on request from the Bridge (QUERY_DIAGNOSTICS): free
+// heap and its low-water mark, the footprint of the peer tables, and the stack
+// high-water mark (uxTaskGetStackHighWaterMark, bytes on ESP-IDF) of every
+// task we run, so stack sizes can be trimmed against measured headroom.
+// Marks are the least free stack since boot: read them after the device went
+// through a show (sync, OTA, benchmark), not right after boot.
+// Answers with one DIAGNOSTICS message (nowde_config.h); MIDI task.
+void diagnosticsSend();
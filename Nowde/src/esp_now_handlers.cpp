@@ -2,62 +2,105 @@
 
 #include <cstring>
 
+#include "espnow_tx.h"
+#include "mesh_ota.h"
+#include "metrics.h"
 #include "nowde_config.h"
+#include "nowde_log.h"
 #include "nowde_state.h"
 #include "receiver_mode.h"
+#include "rx_queue.h"
 #include "sender_mode.h"
 #include "sysex.h"
 
 void onDataSent(const esp_now_send_info_t* info, esp_now_send_status_t status) {
-  (void)info;
-  (void)status;
+  bool delivered = status == ESP_NOW_SEND_SUCCESS;
+  metricsCount(delivered ? METRIC_ESPNOW_TX_OK : METRIC_ESPNOW_TX_FAIL);
+  espnowTxOnSent(info ? info->des_addr : nullptr, delivered);
 }
 
+// Runs in the WiFi driver task: keep it to the mesh clock hook and a ring copy
 void onDataRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
   if (len < 1) {
     return;
   }
 
+  // Mesh clock needs the receive instant, so its frames are handled right here
   if (meshClock.handleReceive(info->src_addr, data, len)) {
     return;
   }
 
+  rxQueuePush(info, data, len);
+}
+
+static void processRxFrame(const RxFrame& frame) {
+  const uint8_t* data = frame.data;
+  int len = frame.length;
   uint8_t msgType = data[0];
 
   if (msgType == SYSEX_START) {
-    DEBUG_SERIAL.println("\n[ESP-NOW RX] SysEx message received");
-    DEBUG_SERIAL.print("  From: ");
-    for (int j = 0; j < 6; j++) {
-      DEBUG_SERIAL.printf("%02X", info->src_addr[j]);
-      if (j < 5) {
-        DEBUG_SERIAL.print(":");
+    LOG_INFO(LOG_CAT_ESPNOW, "[ESP-NOW RX] SysEx message (%d bytes) from " LOG_MAC_FMT "\r\n",
+             len, LOG_MAC_ARGS(frame.srcMac));
+    if (LOG_ENABLED(DEBUG, LOG_CAT_ESPNOW)) {
+      DEBUG_SERIAL.print("  Data: ");
+      for (int j = 0; j < len; j++) {
+        DEBUG_SERIAL.printf("%02X ", data[j]);
       }
+      DEBUG_SERIAL.println();
     }
-    DEBUG_SERIAL.println();
-    DEBUG_SERIAL.print("  Data: ");
-    for (int j = 0; j < len; j++) {
-      DEBUG_SERIAL.printf("%02X ", data[j]);
-    }
-    DEBUG_SERIAL.printf("(%d bytes)\r\n", len);
 
-    handleSysExMessage(data, static_cast<uint8_t>(len));
+    handleRelayedSysExMessage(data, static_cast<size_t>(len));
     return;
   }
 
+  if (receiverModeEnabled) {
+    noteSenderRssi(frame.srcMac, frame.rssi);
+  }
+
   switch (msgType) {
     case ESPNOW_MSG_SENDER_BEACON:
-      handleSenderBeacon(info);
+      handleSenderBeacon(frame.srcMac, data, len, frame.rxTimeUs);
       break;
 
     case ESPNOW_MSG_RECEIVER_INFO:
       if (senderModeEnabled) {
-        handleReceiverInfo(info, data, len);
+        handleReceiverInfo(frame.srcMac, data, len, frame.rssi);
       }
       break;
 
     case ESPNOW_MSG_MEDIA_SYNC:
       if (receiverModeEnabled) {
-        processMediaSyncPacket(data, len);
+        processMediaSyncPacket(frame.srcMac, data, len, frame.rxTimeUs);
+      }
+      break;
+
+    case ESPNOW_MSG_MEDIA_SYNC_BATCH:
+      if (receiverModeEnabled) {
+        processMediaSyncBatchPacket(frame.srcMac, data, len, frame.rxTimeUs);
+      }
+      break;
+
+    case ESPNOW_MSG_OTA_ANNOUNCE:
+      if (receiverModeEnabled) {
+        handleMeshOtaAnnounce(frame.srcMac, data, len);
+      }
+      break;
+
+    case ESPNOW_MSG_OTA_CHUNK:
+      if (receiverModeEnabled) {
+        handleMeshOtaChunk(data, len);
+      }
+      break;
+
+    case ESPNOW_MSG_OTA_STATUS:
+      if (senderModeEnabled) {
+        handleMeshOtaStatus(frame.srcMac, data, len);
+      }
+      break;
+
+    case ESPNOW_MSG_METRICS:
+      if (senderModeEnabled) {
+        handleReceiverMetrics(frame.srcMac, data, len);
       }
       break;
 
@@ -65,3 +108,10 @@ void onDataRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
       break;
   }
 }
+
+void processRxQueue() {
+  while (const RxFrame* frame = rxQueuePeek()) {
+    processRxFrame(*frame);
+    rxQueueRelease();
+  }
+}
@@ -4,3 +4,6 @@
 
 void onDataSent(const esp_now_send_info_t* info, esp_now_send_status_t status);
 void onDataRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+
+// Drains frames queued by onDataRecv; call from the ESP-NOW task only
+void processRxQueue();
@@ -0,0 +1,364 @@
+#include "espnow_tx.h"
+
+#include <esp_now.h>
+#include <cstring>
+
+#include "metrics.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "peer_table.h"
+#include "phantom.h"
+#include "scheduler.h"
+
+#ifdef ESPNOW_TX_WRAP_SEND
+// With -Wl,--wrap=esp_now_send every other caller lands in __wrap_esp_now_send
+extern "C" esp_err_t __real_esp_now_send(const uint8_t* peerAddr, const uint8_t* data, size_t len);
+#endif
+
+namespace {
+
+constexpr int8_t NONE = -1;
+
+esp_err_t driverSend(const uint8_t* mac, const uint8_t* data, size_t len) {
+#ifdef ESPNOW_TX_WRAP_SEND
+  return __real_esp_now_send(mac, data, len);
+#else
+  return esp_now_send(mac, data, len);
+#endif
+}
+
+struct QueuedFrame {
+  uint8_t mac[6];
+  uint8_t length;
+  uint8_t coalesceKey;  // 0 = never replaced
+  int8_t next;          // FIFO link, or free list link
+  int8_t peer;          // TxPeer slot, NONE if the table was full
+  uint8_t data[ESP_NOW_MAX_DATA_LEN];
+};
+
+struct TxPeer {
+  uint8_t mac[6];
+  bool used;
+  uint8_t queued;  // Frames of this peer in the pool
+  uint32_t lastUsedMs;
+  TxReport report;
+};
+
+enum Outcome : uint8_t {
+  OUTCOME_SENT = 0,   // Handed to the driver
+  OUTCOME_QUEUED,     // Waiting in the pool (or requeued after NO_MEM)
+  OUTCOME_COALESCED,  // Replaced an older queued frame
+  OUTCOME_DROPPED     // Peer queue or pool full, or send error
+};
+
+// Everything below is shared by all senders and the send callback
+portMUX_TYPE txMux = portMUX_INITIALIZER_UNLOCKED;
+QueuedFrame pool[ESPNOW_TX_POOL_SLOTS];
+TxPeer peers[ESPNOW_TX_PEERS];
+int8_t queueHead = NONE;
+int8_t queueTail = NONE;
+int8_t freeHead = NONE;
+uint8_t inflight = 0;
+uint32_t lastActivityMs = 0;  // Last callback, or first send into an idle driver
+
+static_assert(ESPNOW_TX_POOL_SLOTS <= 127, "pool indexes are int8_t");
+static_assert(ESPNOW_TX_PEERS <= 127, "peer indexes are int8_t");
+
+void countDropped(TxReport& report) {
+  if (report.dropped != 0xFFFF) {
+    report.dropped++;
+  }
+}
+
+// Slot for a MAC; with create, a free slot or the least recently used one
+// without queued frames. NONE when neither exists.
+int8_t findPeerLocked(const uint8_t* mac, bool create) {
+  int8_t victim = NONE;
+  for (int8_t i = 0; i < ESPNOW_TX_PEERS; i++) {
+    TxPeer& peer = peers[i];
+    if (peer.used && macEqual(peer.mac, mac)) {
+      return i;
+    }
+    if (!create || peer.queued > 0) {
+      continue;
+    }
+    if (victim == NONE || (peers[victim].used && (!peer.used ||
+        static_cast<int32_t>(peer.lastUsedMs - peers[victim].lastUsedMs) < 0))) {
+      victim = i;
+    }
+  }
+  if (victim != NONE) {
+    TxPeer& peer = peers[victim];
+    memcpy(peer.mac, mac, 6);
+    peer.used = true;
+    peer.queued = 0;
+    peer.report = {};
+  }
+  return victim;
+}
+
+Outcome enqueueLocked(const uint8_t* mac, const uint8_t* data, size_t len, uint8_t coalesceKey, bool front) {
+  int8_t peer = findPeerLocked(mac, true);
+  if (peer != NONE) {
+    peers[peer].lastUsedMs = millis();
+  }
+
+  if (coalesceKey != 0) {
+    for (int8_t i = queueHead; i != NONE; i = pool[i].next) {
+      QueuedFrame& queued = pool[i];
+      if (queued.coalesceKey == coalesceKey && macEqual(queued.mac, mac)) {
+        // The replaced frame is older when the new one arrives from a sender;
+        // a requeued frame (front) is the older one and simply goes away
+        if (!front) {
+          memcpy(queued.data, data, len);
+          queued.length = static_cast<uint8_t>(len);
+        }
+        if (peer != NONE) {
+          countDropped(peers[peer].report);
+        }
+        return OUTCOME_COALESCED;
+      }
+    }
+  }
+
+  if (freeHead == NONE || (peer != NONE && peers[peer].queued >= ESPNOW_TX_PEER_DEPTH)) {
+    if (peer != NONE) {
+      countDropped(peers[peer].report);
+    }
+    return OUTCOME_DROPPED;
+  }
+
+  int8_t index = freeHead;
+  QueuedFrame& frame = pool[index];
+  freeHead = frame.next;
+  memcpy(frame.mac, mac, 6);
+  memcpy(frame.data, data, len);
+  frame.length = static_cast<uint8_t>(len);
+  frame.coalesceKey = coalesceKey;
+  frame.peer = peer;
+  if (peer != NONE) {
+    peers[peer].queued++;
+  }
+
+  if (front) {
+    frame.next = queueHead;
+    queueHead = index;
+    if (queueTail == NONE) {
+      queueTail = index;
+    }
+  } else {
+    frame.next = NONE;
+    if (queueTail == NONE) {
+      queueHead = index;
+    } else {
+      pool[queueTail].next = index;
+    }
+    queueTail = index;
+  }
+  return OUTCOME_QUEUED;
+}
+
+void countOutcome(Outcome outcome) {
+  if (outcome == OUTCOME_COALESCED) {
+    metricsCount(METRIC_ESPNOW_TX_COALESCED);
+  } else if (outcome == OUTCOME_DROPPED) {
+    metricsCount(METRIC_ESPNOW_TX_DROPPED);
+  }
+}
+
+// One in-flight slot is already reserved for this frame
+Outcome transmit(const uint8_t* mac, const uint8_t* data, size_t len, uint8_t coalesceKey) {
+  ensureEspNowPeer(mac);
+  esp_err_t err = driverSend(mac, data, len);
+  if (err == ESP_OK) {
+    phantomOnAir(mac, data, len);
+    return OUTCOME_SENT;
+  }
+
+  Outcome outcome;
+  portENTER_CRITICAL(&txMux);
+  inflight--;
+  if (err == ESP_ERR_ESPNOW_NO_MEM) {
+    // Driver queue full: keep the frame at the front for the next pump
+    outcome = enqueueLocked(mac, data, len, coalesceKey, true);
+  } else {
+    int8_t peer = findPeerLocked(mac, false);
+    if (peer != NONE) {
+      peers[peer].report.failed++;
+    }
+    outcome = OUTCOME_DROPPED;
+  }
+  portEXIT_CRITICAL(&txMux);
+
+  countOutcome(outcome);
+  if (err != ESP_ERR_ESPNOW_NO_MEM) {
+    LOG_DEFER(WARN, LOG_CAT_ESPNOW, "[ESP-NOW TX] Send error %d\r\n", static_cast<int>(err));
+  }
+  return outcome == OUTCOME_DROPPED ? OUTCOME_DROPPED : OUTCOME_QUEUED;
+}
+
+}  // namespace
+
+void espnowTxInit() {
+  portENTER_CRITICAL(&txMux);
+  for (int8_t i = 0; i < ESPNOW_TX_POOL_SLOTS; i++) {
+    pool[i].next = (i + 1 < ESPNOW_TX_POOL_SLOTS) ? i + 1 : NONE;
+  }
+  freeHead = 0;
+  queueHead = NONE;
+  queueTail = NONE;
+  inflight = 0;
+  for (TxPeer& peer : peers) {
+    peer.used = false;
+    peer.queued = 0;
+  }
+  portEXIT_CRITICAL(&txMux);
+}
+
+bool espnowTxSend(const uint8_t* mac, const void* data, size_t len, uint8_t coalesceKey) {
+  if (len == 0 || len > ESP_NOW_MAX_DATA_LEN) {
+    metricsCount(METRIC_ESPNOW_TX_DROPPED);
+    return false;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  if (phantomIsMac(mac)) {
+    phantomOnAir(mac, bytes, len);  // Emulated receiver (phantom.h): never goes on the air
+    return true;
+  }
+
+  bool direct = false;
+  Outcome outcome = OUTCOME_QUEUED;
+  portENTER_CRITICAL(&txMux);
+  if (queueHead == NONE && inflight < ESPNOW_TX_MAX_INFLIGHT) {
+    // Nothing waiting: straight to the driver, no copy
+    if (inflight == 0) {
+      lastActivityMs = millis();
+    }
+    inflight++;
+    direct = true;
+    int8_t peer = findPeerLocked(mac, true);
+    if (peer != NONE) {
+      peers[peer].lastUsedMs = millis();
+    }
+  } else {
+    outcome = enqueueLocked(mac, bytes, len, coalesceKey, false);
+  }
+  portEXIT_CRITICAL(&txMux);
+
+  if (direct) {
+    outcome = transmit(mac, bytes, len, coalesceKey);
+  } else {
+    countOutcome(outcome);
+  }
+  if (outcome == OUTCOME_QUEUED) {
+    schedulerWake();
+  }
+  return outcome != OUTCOME_DROPPED;
+}
+
+esp_err_t espnowTxSendExternal(const uint8_t* mac, const uint8_t* data, size_t len) {
+  // Counted before the send: the callback may run before esp_now_send returns
+  portENTER_CRITICAL(&txMux);
+  if (inflight == 0) {
+    lastActivityMs = millis();
+  }
+  inflight++;
+  portEXIT_CRITICAL(&txMux);
+
+  esp_err_t err = driverSend(mac, data, len);
+  if (err != ESP_OK) {
+    portENTER_CRITICAL(&txMux);
+    if (inflight > 0) {
+      inflight--;
+    }
+    portEXIT_CRITICAL(&txMux);
+  }
+  return err;
+}
+
+#ifdef ESPNOW_TX_WRAP_SEND
+extern "C" esp_err_t __wrap_esp_now_send(const uint8_t* peerAddr, const uint8_t* data, size_t len) {
+  return espnowTxSendExternal(peerAddr, data, len);
+}
+#endif
+
+void espnowTxOnSent(const uint8_t* mac, bool delivered) {
+  bool pending;
+  portENTER_CRITICAL(&txMux);
+  // Every callback is for a frame counted in; zero only after a lost-callback reset
+  if (inflight > 0) {
+    inflight--;
+  }
+  lastActivityMs = millis();
+  if (mac) {
+    int8_t peer = findPeerLocked(mac, false);
+    if (peer != NONE) {
+      if (delivered) {
+        peers[peer].report.delivered++;
+      } else {
+        peers[peer].report.failed++;
+      }
+    }
+  }
+  pending = queueHead != NONE;
+  portEXIT_CRITICAL(&txMux);
+
+  if (pending) {
+    schedulerWake();
+  }
+}
+
+TickType_t espnowTxPump() {
+  static QueuedFrame frame;  // ESP-NOW task only; kept off its stack
+  bool lostCallbacks = false;
+
+  for (;;) {
+    portENTER_CRITICAL(&txMux);
+    if (queueHead == NONE) {
+      portEXIT_CRITICAL(&txMux);
+      return portMAX_DELAY;
+    }
+    uint32_t now = millis();
+    if (inflight >= ESPNOW_TX_MAX_INFLIGHT) {
+      if (now - lastActivityMs < ESPNOW_TX_INFLIGHT_TIMEOUT_MS) {
+        portEXIT_CRITICAL(&txMux);
+        return pdMS_TO_TICKS(ESPNOW_TX_INFLIGHT_TIMEOUT_MS);  // A callback wakes us sooner
+      }
+      inflight = 0;
+      lostCallbacks = true;
+    }
+
+    int8_t index = queueHead;
+    frame = pool[index];
+    queueHead = frame.next;
+    if (queueHead == NONE) {
+      queueTail = NONE;
+    }
+    pool[index].next = freeHead;
+    freeHead = index;
+    if (frame.peer != NONE && peers[frame.peer].queued > 0) {
+      peers[frame.peer].queued--;
+    }
+    if (inflight == 0) {
+      lastActivityMs = now;
+    }
+    inflight++;
+    portEXIT_CRITICAL(&txMux);
+
+    if (lostCallbacks) {
+      LOG_DEFER(WARN, LOG_CAT_ESPNOW, "[ESP-NOW TX] No send callback for %lu ms, in-flight count reset\r\n",
+                static_cast<uint32_t>(ESPNOW_TX_INFLIGHT_TIMEOUT_MS));
+      lostCallbacks = false;
+    }
+    if (transmit(frame.mac, frame.data, frame.length, frame.coalesceKey) == OUTCOME_QUEUED) {
+      return 1;  // Driver queue full, retry on the next tick
+    }
+  }
+}
+
+void espnowTxPeerReport(const uint8_t* mac, TxReport* out) {
+  portENTER_CRITICAL(&txMux);
+  int8_t peer = findPeerLocked(mac, false);
+  *out = peer != NONE ? peers[peer].report : TxReport{};
+  portEXIT_CRITICAL(&txMux);
+}
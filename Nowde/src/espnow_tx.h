@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+#include "nowde_config.h"
+
+// ESP-NOW transmit path. Every frame we send goes through espnowTxSend():
+//  - up to ESPNOW_TX_MAX_INFLIGHT frames are handed to the driver at once,
+//    counted back by the send callback; the rest (and anything the driver
+//    refuses with ESP_ERR_ESPNOW_NO_MEM) waits in a shared pool, at most
+//    ESPNOW_TX_PEER_DEPTH frames per peer, and is sent in order by the ESP-NOW
+//    task as callbacks free the budget
+//  - a frame with a coalesce key replaces a queued frame with the same peer and
+//    key instead of queueing behind it: sync frames use their layer ID, since
+//    only the newest position of a layer is worth sending
+//  - delivered / failed / dropped counts are kept per peer (TxReport)
+// Callable from any task. Mesh clock frames bypass the queue (the library calls
+// esp_now_send itself, and they are timestamped) but are counted in flight
+// through espnowTxSendExternal(), so their callbacks never free a slot of ours.
+
+// Coalesce keys: 1..MAX_LAYER_IDS are sync frames of that layer
+constexpr uint8_t ESPNOW_TX_KEY_NONE = 0;
+constexpr uint8_t ESPNOW_TX_KEY_METRICS = 0xFD;
+constexpr uint8_t ESPNOW_TX_KEY_RECEIVER_INFO = 0xFE;
+constexpr uint8_t ESPNOW_TX_KEY_BEACON = 0xFF;
+static_assert(MAX_LAYER_IDS < ESPNOW_TX_KEY_METRICS, "layer IDs collide with coalesce keys");
+
+void espnowTxInit();
+
+// True when the frame was handed to the driver or queued; false when dropped
+bool espnowTxSend(const uint8_t* mac, const void* data, size_t len, uint8_t coalesceKey = ESPNOW_TX_KEY_NONE);
+
+// A frame sent outside espnowTxSend(): straight to the driver, even beyond the
+// budget, but counted in flight until its callback. The firmware links with
+// -Wl,--wrap=esp_now_send (ESPNOW_TX_WRAP_SEND), which routes the mesh clock
+// library's sends here.
+esp_err_t espnowTxSendExternal(const uint8_t* mac, const uint8_t* data, size_t len);
+
+// From the ESP-NOW send callback (WiFi task)
+void espnowTxOnSent(const uint8_t* mac, bool delivered);
+
+// ESP-NOW task: sends queued frames while the in-flight budget allows.
+// Returns the ticks until it wants to run again (portMAX_DELAY when idle).
+TickType_t espnowTxPump();
+
+// Counters towards a peer (zeros if we never sent to it)
+void espnowTxPeerReport(const uint8_t* mac, TxReport* out);
@@ -0,0 +1,114 @@
+#include "layer_registry.h"
+
+#include <freertos/FreeRTOS.h>
+#include <cstring>
+
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "scheduler.h"
+
+namespace {
+
+struct LayerSlot {
+  char name[MAX_LAYER_LENGTH];
+  uint32_t hash;
+  uint32_t releasedAt;  // millis() when refs last dropped to 0
+  uint8_t refs;
+  bool assigned;        // Name/hash valid (kept after release until reused)
+};
+
+// Index i holds ID i + 1
+LayerSlot slots[MAX_LAYER_IDS];
+portMUX_TYPE registryMux = portMUX_INITIALIZER_UNLOCKED;
+
+int findSlot(const char* layer, uint32_t hash) {
+  for (int i = 0; i < MAX_LAYER_IDS; i++) {
+    if (slots[i].assigned && slots[i].hash == hash &&
+        strncmp(slots[i].name, layer, MAX_LAYER_LENGTH) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+uint8_t acquireLayerId(const char* layer) {
+  uint32_t hash = layerHash(layer);
+  bool announce = false;
+
+  portENTER_CRITICAL(&registryMux);
+  int slot = findSlot(layer, hash);
+  if (slot == -1) {
+    // Never-used slot first, else the one released longest ago
+    for (int i = 0; i < MAX_LAYER_IDS; i++) {
+      if (slots[i].refs != 0) {
+        continue;
+      }
+      if (!slots[i].assigned) {
+        slot = i;
+        break;
+      }
+      if (slot == -1 || static_cast<int32_t>(slots[i].releasedAt - slots[slot].releasedAt) < 0) {
+        slot = i;
+      }
+    }
+    if (slot != -1) {
+      strncpy(slots[slot].name, layer, MAX_LAYER_LENGTH);
+      slots[slot].name[MAX_LAYER_LENGTH - 1] = '\0';
+      slots[slot].hash = hash;
+      slots[slot].assigned = true;
+    }
+  }
+  if (slot != -1) {
+    announce = (slots[slot].refs == 0);
+    slots[slot].refs++;
+  }
+  portEXIT_CRITICAL(&registryMux);
+
+  if (slot == -1) {
+    LOG_ERROR(LOG_CAT_SENDER, "[LAYER] Registry full, no ID for layer '%s'\r\n", layer);
+    return LAYER_ID_NONE;
+  }
+
+  // Publish the new mapping now instead of waiting for the next beacon
+  if (announce) {
+    schedulerArm(SCHED_SENDER_BEACON, millis());
+  }
+  return static_cast<uint8_t>(slot + 1);
+}
+
+void releaseLayerId(uint8_t id) {
+  if (id == LAYER_ID_NONE || id > MAX_LAYER_IDS) {
+    return;
+  }
+  portENTER_CRITICAL(&registryMux);
+  LayerSlot& slot = slots[id - 1];
+  if (slot.refs > 0 && --slot.refs == 0) {
+    slot.releasedAt = millis();
+  }
+  portEXIT_CRITICAL(&registryMux);
+}
+
+uint8_t findLayerId(const char* layer) {
+  uint32_t hash = layerHash(layer);
+  portENTER_CRITICAL(&registryMux);
+  int slot = findSlot(layer, hash);
+  bool held = (slot != -1 && slots[slot].refs > 0);
+  portEXIT_CRITICAL(&registryMux);
+  return held ? static_cast<uint8_t>(slot + 1) : LAYER_ID_NONE;
+}
+
+uint8_t fillLayerIdEntries(LayerIdEntry* entries, uint8_t maxEntries) {
+  uint8_t count = 0;
+  portENTER_CRITICAL(&registryMux);
+  for (int i = 0; i < MAX_LAYER_IDS && count < maxEntries; i++) {
+    if (slots[i].refs > 0) {
+      entries[count].id = static_cast<uint8_t>(i + 1);
+      entries[count].layerHash = slots[i].hash;
+      count++;
+    }
+  }
+  portEXIT_CRITICAL(&registryMux);
+  return count;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+#include "nowde_config.h"
+
+// Sender-side map of layer names to 1-byte IDs used on the air.
+// An ID is held by every receiver entry on that layer; it is only handed to a
+// different layer once nobody holds it (oldest released first). The current
+// map rides in every SenderBeacon so receivers can resolve their own layer.
+#define LAYER_ID_NONE 0
+
+// Take a reference on the ID for a layer, assigning one if needed.
+// Returns LAYER_ID_NONE when the registry is full.
+uint8_t acquireLayerId(const char* layer);
+void releaseLayerId(uint8_t id);
+
+// Lookup only; LAYER_ID_NONE when no receiver is on that layer
+uint8_t findLayerId(const char* layer);
+
+// Fill beacon entries for every held ID; returns the entry count
+uint8_t fillLayerIdEntries(LayerIdEntry* entries, uint8_t maxEntries);
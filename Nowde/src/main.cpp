@@ -17,6 +17,7 @@
  */
 
 #include <Arduino.h>
+#include <algorithm>
 #include <USB.h>
 #include <USBMIDI.h>
 #include <WiFi.h>
@@ -28,17 +29,32 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include "channel.h"
 #include "esp_now_handlers.h"
+#include "espnow_tx.h"
+#include "mesh_ota.h"
+#include "metrics.h"
 #include "midi.h"
+#include "mtc.h"
 #include "nowde_config.h"
+#include "nowde_log.h"
 #include "nowde_state.h"
+#include "peer_table.h"
+#include "phantom.h"
 #include "receiver_mode.h"
+#include "rf_sim.h"
+#include "running_state.h"
+#include "rx_queue.h"
+#include "scheduler.h"
 #include "sender_mode.h"
 #include "storage.h"
 #include "sysex.h"
+#include "warm_boot.h"
 
-// Task handles for multi-core operation
-TaskHandle_t midiTaskHandle = NULL;
+// loop() only sleeps, so the Arduino task needs just what setup() uses
+SET_LOOP_TASK_STACK_SIZE(LOOP_TASK_STACK_SIZE);
+
+// Task handle for multi-core operation (the MIDI task lives in midi.cpp)
 TaskHandle_t espnowTaskHandle = NULL;
 
 namespace {
@@ -67,8 +83,7 @@ void configureUsbDescriptors() {
   snprintf(productName, sizeof(productName), "Nowde - %02X%02X%02X", 
            mac[3], mac[4], mac[5]);
   
-  DEBUG_SERIAL.print("[USB] Setting product name: ");
-  DEBUG_SERIAL.println(productName);
+  LOG_INFO(LOG_CAT_USB, "[USB] Setting product name: %s\r\n", productName);
   
   USB.VID(0x303A);
   USB.PID(0x8000);
@@ -84,12 +99,12 @@ void addBroadcastPeer() {
 
   if (!esp_now_is_peer_exist(broadcastAddress)) {
     if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-      DEBUG_SERIAL.println("[ERROR] Failed to add broadcast peer!");
+      LOG_ERROR(LOG_CAT_CORE, "[ERROR] Failed to add broadcast peer!\r\n");
     } else {
-      DEBUG_SERIAL.println("[INIT] Broadcast peer added");
+      LOG_INFO(LOG_CAT_CORE, "[INIT] Broadcast peer added\r\n");
     }
   } else {
-    DEBUG_SERIAL.println("[INIT] Broadcast peer already exists");
+    LOG_INFO(LOG_CAT_CORE, "[INIT] Broadcast peer already exists\r\n");
   }
 }
 
@@ -108,184 +123,254 @@ void logDeviceInfo() {
   DEBUG_SERIAL.println();
 }
 
-}  // namespace
+// Start the periodic timers of a mode the first time we see it enabled.
+// Modes are switched from the MIDI task, which wakes us via schedulerWake().
+void armModeTimers(uint32_t now) {
+  if (senderModeEnabled && !schedulerArmed(SCHED_SENDER_BEACON)) {
+    schedulerArm(SCHED_SENDER_BEACON, now);
+    schedulerArm(SCHED_BRIDGE_REPORT, now + BRIDGE_REPORT_INTERVAL_MS);
+    schedulerArm(SCHED_RECEIVER_TABLE_CLEANUP, now + TABLE_CLEANUP_INTERVAL_MS);
+#if CHANNEL_SURVEY_ON_START
+    channelRequest(CHANNEL_SURVEY_AUTO, 0);
+#endif
+  }
+  if (receiverModeEnabled && !schedulerArmed(SCHED_RECEIVER_BEACON)) {
+    schedulerArm(SCHED_RECEIVER_BEACON, now);
+    schedulerArm(SCHED_SENDER_TABLE_CLEANUP, now + TABLE_CLEANUP_INTERVAL_MS);
+    schedulerArm(SCHED_RECEIVER_METRICS, now + METRICS_SEND_INTERVAL_MS);
+  }
+}
 
-// ============= CORE 0 - MIDI/USB TASK (High Priority) =============
-// Runs on Core 0 to ensure USB MIDI is never blocked by ESP-NOW traffic
-void midiTask(void* parameter) {
-  DEBUG_SERIAL.println("[TASK] MIDI task started on Core 0 (high priority)");
-  
-  for (;;) {
-    midiProcess();  // Handle USB MIDI I/O
-    vTaskDelay(pdMS_TO_TICKS(1));  // 1ms - very responsive for MIDI
+// Track the link-lost deadline from the last sync packet while playing
+void armLinkLostTimer() {
+  if (receiverModeEnabled && mediaSyncState.currentState == 1 && !mediaSyncState.linkLost) {
+    schedulerArm(SCHED_LINK_LOST, mediaSyncState.lastSyncTime + LINK_LOST_TIMEOUT_MS);
+  } else {
+    schedulerCancel(SCHED_LINK_LOST);
   }
 }
 
-// ============= CORE 1 - ESP-NOW/APPLICATION TASK (Normal Priority) =============
-// Runs on Core 1 for all ESP-NOW and application logic
-void espnowTask(void* parameter) {
-  DEBUG_SERIAL.println("[TASK] ESP-NOW task started on Core 1 (normal priority)");
-  
-  unsigned long lastSenderBeacon = 0;
-  unsigned long lastBridgeReport = 0;
-  unsigned long nextReceiverBeacon = 0;
-  
-  for (;;) {
-    unsigned long now = millis();
+void checkLinkLost(uint32_t now) {
+  if (mediaSyncState.currentState != 1 || mediaSyncState.linkLost) {
+    return;
+  }
+  if ((now - mediaSyncState.lastSyncTime) <= LINK_LOST_TIMEOUT_MS) {
+    return;
+  }
+
+  mediaSyncState.linkLost = true;
+  metricsCount(METRIC_LINK_LOST);
+  LOG_WARN(LOG_CAT_RECEIVER, "[MEDIA SYNC] LINK LOST - no sync packets received\r\n");
+
+  if (mediaSyncState.stopOnLinkLost) {
+    LOG_INFO(LOG_CAT_RECEIVER, "[MEDIA SYNC] Stopping MTC clock and sending CC#100=0\r\n");
+    mediaSyncState.currentState = 0;
+    mtcStop(mtcPosition());
+    midiSendCC100(0);
+    mediaSyncState.lastSentIndex = 0;
+    warmBootSave();
+  } else {
+    LOG_INFO(LOG_CAT_RECEIVER, "[MEDIA SYNC] Continuing in freewheel mode indefinitely\r\n");
+  }
+}
 
-    // Sender mode operations
-    if (senderModeEnabled) {
-      if (now - lastSenderBeacon >= SENDER_BEACON_INTERVAL_MS) {
-        lastSenderBeacon = now;
+void runTimer(SchedTimer timer, uint32_t now) {
+  switch (timer) {
+    case SCHED_SENDER_BEACON:
+      if (senderModeEnabled) {
         sendSenderBeacon();
+        schedulerArm(SCHED_SENDER_BEACON, now + SENDER_BEACON_INTERVAL_MS);
       }
+      break;
 
-      cleanupReceiverTable();
-
-      if (now - lastBridgeReport >= BRIDGE_REPORT_INTERVAL_MS) {
-        lastBridgeReport = now;
+    case SCHED_BRIDGE_REPORT:
+      if (senderModeEnabled) {
         reportReceiversToBridge();
+        schedulerArm(SCHED_BRIDGE_REPORT, now + BRIDGE_REPORT_INTERVAL_MS);
       }
-      
-      // Process delayed packets for RF simulation
-      if (rfSimulationEnabled) {
-        for (int i = 0; i < MAX_DELAYED_PACKETS; i++) {
-          if (delayedPackets[i].active && now >= delayedPackets[i].sendTime) {
-            esp_now_send(delayedPackets[i].receiverMac, 
-                        reinterpret_cast<uint8_t*>(&delayedPackets[i].packet), 
-                        sizeof(MediaSyncPacket));
-            delayedPackets[i].active = false;
-          }
-        }
+      break;
+
+    case SCHED_RECEIVER_TABLE_CLEANUP:
+      if (senderModeEnabled) {
+        cleanupReceiverTable();
+        schedulerArm(SCHED_RECEIVER_TABLE_CLEANUP, now + TABLE_CLEANUP_INTERVAL_MS);
       }
-    }
+      break;
 
-    // Receiver mode operations
-    if (receiverModeEnabled) {
-      if (now >= nextReceiverBeacon) {
+    case SCHED_RECEIVER_BEACON:
+      if (receiverModeEnabled) {
         sendReceiverInfo();
-        nextReceiverBeacon = now + RECEIVER_BEACON_INTERVAL_MS + random(0, 200);
+        schedulerArm(SCHED_RECEIVER_BEACON, now + RECEIVER_BEACON_INTERVAL_MS + random(0, 200));
       }
+      break;
 
-      cleanupSenderTable();
-
-      // Check for link lost condition
-      if (mediaSyncState.currentState == 1 && !mediaSyncState.linkLost) {
-        if ((now - mediaSyncState.lastSyncTime) > LINK_LOST_TIMEOUT_MS) {
-          mediaSyncState.linkLost = true;
-          DEBUG_SERIAL.println("[MEDIA SYNC] LINK LOST - no sync packets received");
-          
-          if (mediaSyncState.stopOnLinkLost) {
-            DEBUG_SERIAL.println("[MEDIA SYNC] Stopping MTC clock and sending CC#100=0");
-            mediaSyncState.currentState = 0;
-            midiSendCC100(0);
-            mediaSyncState.lastSentIndex = 0;
-          } else {
-            DEBUG_SERIAL.println("[MEDIA SYNC] Continuing in freewheel mode indefinitely");
-          }
-        }
+    case SCHED_SENDER_TABLE_CLEANUP:
+      if (receiverModeEnabled) {
+        cleanupSenderTable();
+        schedulerArm(SCHED_SENDER_TABLE_CLEANUP, now + TABLE_CLEANUP_INTERVAL_MS);
       }
+      break;
+
+    case SCHED_RUNNING_STATE_PUSH:
+      runningStatePushTick(now);
+      break;
 
-      // Continuous MTC clock generation when playing
-      if (mediaSyncState.currentState == 1) {
-        // Calculate current position based on local clock
-        unsigned long localElapsed = now - mediaSyncState.localClockStartTime;
-        uint32_t currentPositionMs = mediaSyncState.currentPositionMs + localElapsed;
-
-        // Send MTC at configured framerate
-        if (now - mediaSyncState.lastMTCUpdateTime >= (1000 / MTC_FRAMERATE)) {
-          midiSendTimeCode(currentPositionMs);
-          mediaSyncState.lastMTCUpdateTime = now;
-        }
+    case SCHED_RECEIVER_METRICS:
+      if (receiverModeEnabled) {
+        sendReceiverMetrics();
+        schedulerArm(SCHED_RECEIVER_METRICS, now + METRICS_SEND_INTERVAL_MS);
       }
+      break;
+
+    case SCHED_LINK_LOST:
+      checkLinkLost(now);
+      break;
+
+    case SCHED_MESH_OTA_TX:
+      meshOtaSenderTick(now);
+      break;
+
+    case SCHED_MESH_OTA_RX:
+      meshOtaReceiverTick(now);
+      break;
+
+    case SCHED_CHANNEL:
+      channelTick(now);
+      break;
+
+    case SCHED_PHANTOM:
+      phantomTick(now);
+      break;
+
+    case SCHED_MESH_CLOCK:
+      meshClock.loop();
+      if (meshClock.getSyncState() == SyncState::SYNCED) {
+        mtcOnMeshSynced();
+      }
+      schedulerArm(SCHED_MESH_CLOCK, now + MESH_CLOCK_LOOP_INTERVAL_MS);
+      break;
+
+    default:
+      break;
+  }
+}
+
+}  // namespace
+
+// ============= CORE 1 - ESP-NOW/APPLICATION TASK (Normal Priority) =============
+// Runs on Core 1 for all ESP-NOW and application logic
+void espnowTask(void* parameter) {
+  LOG_INFO(LOG_CAT_CORE, "[TASK] ESP-NOW task started on Core 1 (normal priority)\r\n");
+
+  rxQueueSetConsumer(xTaskGetCurrentTaskHandle());
+  schedulerSetTask(xTaskGetCurrentTaskHandle());
+  schedulerArm(SCHED_MESH_CLOCK, millis());
+  schedulerArm(SCHED_CHANNEL, millis() + CHANNEL_TICK_MS);
+
+  for (;;) {
+    // All received frames are processed here, so tables and sync state only change on this task
+    processRxQueue();
+    scheduledActionRun();
+    TickType_t txWait = espnowTxPump();
+
+    uint32_t now = millis();
+    armModeTimers(now);
+    armLinkLostTimer();
+
+    SchedTimer timer;
+    while (schedulerPopDue(now, &timer)) {
+      runTimer(timer, now);
     }
 
-    meshClock.loop();
-    vTaskDelay(pdMS_TO_TICKS(10));  // 10ms - good for ESP-NOW operations
+    // Sleep until the next deadline, or until onDataRecv / onDataSent / another task notifies us
+    ulTaskNotifyTake(pdTRUE, std::min(schedulerTicksUntilNext(millis()), txWait));
   }
 }
 
 void setup() {
   DEBUG_SERIAL.begin(115200);
-  delay(500);
-
+  logInit();
+  schedulerInit();
   printBanner();
 
-  configureUsbDescriptors();
-  USB.begin();
-  DEBUG_SERIAL.println("[INIT] USB initialized");
-
-  midiInit();
-  DEBUG_SERIAL.println("[INIT] USB MIDI initialized");
-  
-  // Wait for USB to fully enumerate before sending HELLO
-  delay(500);
-  
-  // Send HELLO to notify Bridge of boot/reboot
-  sendHello();
+  // Radio first: the mesh clock starts converging and receivers are back on
+  // the air while the host is still enumerating USB. Nothing here waits.
+  peerTableInit();
+  profileLoad();
 
   meshClock.setDebugLog(0);  // LOG_ALL / LOG_SYNC / LOG_BCAST / LOG_RX / 0
   meshClock.begin(false);
-  DEBUG_SERIAL.println("[INIT] Mesh Clock initialized");
-
-  delay(1000);
+  LOG_INFO(LOG_CAT_CORE, "[INIT] Mesh Clock initialized\r\n");
 
   WiFi.mode(WIFI_STA);
   WiFi.disconnect();
-  DEBUG_SERIAL.println("[INIT] WiFi STA mode configured");
+  LOG_INFO(LOG_CAT_CORE, "[INIT] WiFi STA mode configured\r\n");
 
   if (esp_now_init() != ESP_OK) {
-    DEBUG_SERIAL.println("[ERROR] ESP-NOW init failed!");
+    LOG_ERROR(LOG_CAT_CORE, "[ERROR] ESP-NOW init failed!\r\n");
     return;
   }
-  DEBUG_SERIAL.println("[INIT] ESP-NOW initialized");
+  LOG_INFO(LOG_CAT_CORE, "[INIT] ESP-NOW initialized\r\n");
+  channelInit();
+  espnowTxInit();
 
   esp_now_register_send_cb(onDataSent);
   esp_now_register_recv_cb(onDataRecv);
-  DEBUG_SERIAL.println("[INIT] ESP-NOW callbacks registered");
+  LOG_INFO(LOG_CAT_CORE, "[INIT] ESP-NOW callbacks registered\r\n");
 
   addBroadcastPeer();
+
+  // Enumeration runs in the background; the MIDI task sends HELLO once
+  // TinyUSB reports the device mounted
+  configureUsbDescriptors();
+  USB.begin();
+  LOG_INFO(LOG_CAT_CORE, "[INIT] USB initialized\r\n");
+
+  midiInit();
+  mtcInit();
+  rfSimInit();
+  scheduledActionInit(applyScheduledTransition);
+  LOG_INFO(LOG_CAT_CORE, "[INIT] USB MIDI initialized\r\n");
+
   logDeviceInfo();
 
-  String savedLayer = loadLayerFromEEPROM();
-  // Always enable receiver mode with saved layer or default "-"
-  if (savedLayer.length() == 0 || savedLayer == "") {
-    savedLayer = DEFAULT_RECEIVER_LAYER;
-  }
-  
+  // Always enable receiver mode with the saved layer or default "-"
+  DeviceProfile profile = profileGet();
   receiverModeEnabled = true;
-  strncpy(subscribedLayer, savedLayer.c_str(), MAX_LAYER_LENGTH);
+  strncpy(subscribedLayer, profile.layer[0] ? profile.layer : DEFAULT_RECEIVER_LAYER, MAX_LAYER_LENGTH);
   subscribedLayer[MAX_LAYER_LENGTH - 1] = '\0';
-  DEBUG_SERIAL.println("[INIT] Auto-starting receiver mode");
-  DEBUG_SERIAL.print("  Subscribed Layer: ");
-  DEBUG_SERIAL.println(subscribedLayer);
-  DEBUG_SERIAL.println();
-  
-  // Create MIDI task on Core 0 with high priority (configMAX_PRIORITIES - 1)
-  // Stack: 4096 bytes, Priority: 24 (high), Core: 0
-  xTaskCreatePinnedToCore(
-    midiTask,           // Task function
-    "MIDI_Task",        // Task name
-    4096,               // Stack size (bytes)
-    NULL,               // Parameters
-    configMAX_PRIORITIES - 1,  // High priority (24 on ESP32)
-    &midiTaskHandle,    // Task handle
-    0                   // Core 0 - dedicated to USB/MIDI
-  );
-  DEBUG_SERIAL.println("[INIT] MIDI task created on Core 0");
+  mediaSyncState.stopOnLinkLost = (profile.flags & PROFILE_FLAG_STOP_ON_LINK_LOST) != 0;
+  cc100Channel = (profile.cc100Channel >= 1 && profile.cc100Channel <= 16) ? profile.cc100Channel : CC100_DEFAULT_CHANNEL;
+  rfSimulationEnabled = (profile.flags & PROFILE_FLAG_RF_SIMULATION) != 0;
+  rfSimMaxDelayMs = profile.rfSimMaxDelayMs;
+  rfSimLossPercent = profile.rfSimLossPercent;
+  rfSimReorderPercent = profile.rfSimReorderPercent;
+  rfSimOutagePerMille = profile.rfSimOutagePerMille;
+  rfSimOutageMs = profile.rfSimOutageMs;
+  LOG_INFO(LOG_CAT_CORE, "[INIT] Auto-starting receiver mode, subscribed layer: %s\r\n", subscribedLayer);
+
+  // Warm reset mid-show: pick the timecode up where it was
+  warmBootRestore();
+
+  // MIDI task on Core 0 with high priority (configMAX_PRIORITIES - 1)
+  midiStartTask();
+  LOG_INFO(LOG_CAT_CORE, "[INIT] MIDI task created on Core 0\r\n");
   
   // Create ESP-NOW task on Core 1 with normal priority
-  // Stack: 8192 bytes, Priority: 10 (normal), Core: 1
+  // Stack: ESPNOW_TASK_STACK_SIZE, Priority: 10 (normal), Core: 1
   xTaskCreatePinnedToCore(
     espnowTask,         // Task function
     "ESPNOW_Task",      // Task name
-    8192,               // Stack size (bytes) - larger for ESP-NOW operations
+    ESPNOW_TASK_STACK_SIZE,  // Stack size (bytes) - larger for ESP-NOW operations
     NULL,               // Parameters
     10,                 // Normal priority
     &espnowTaskHandle,  // Task handle
     1                   // Core 1 - Arduino default core
   );
-  DEBUG_SERIAL.println("[INIT] ESP-NOW task created on Core 1");
+  LOG_INFO(LOG_CAT_CORE, "[INIT] ESP-NOW task created on Core 1\r\n");
+
+  // Writes the profile back (debounced) from here on
+  profileStartTask();
 }
 
 void loop() {
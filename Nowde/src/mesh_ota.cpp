@@ -0,0 +1,569 @@
+#include "mesh_ota.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <esp_now.h>
+#include <esp_ota_ops.h>
+#include <esp_system.h>
+#include <mbedtls/sha256.h>
+
+#include "espnow_tx.h"
+#include "midi.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "peer_table.h"
+#include "scheduler.h"
+#include "storage.h"
+
+namespace {
+
+constexpr size_t BITMAP_BYTES = MESH_OTA_MAX_CHUNKS / 8;
+constexpr uint8_t MAX_SILENT_POLLS = 5;
+
+inline bool bitGet(const uint8_t* bitmap, uint32_t i) {
+  return bitmap[i >> 3] & (1 << (i & 7));
+}
+
+inline void bitSet(uint8_t* bitmap, uint32_t i) {
+  bitmap[i >> 3] |= (1 << (i & 7));
+}
+
+inline void bitClear(uint8_t* bitmap, uint32_t i) {
+  bitmap[i >> 3] &= ~(1 << (i & 7));
+}
+
+// ---------------- Sender (relay) ----------------
+
+enum RelayPhase : uint8_t {
+  RELAY_IDLE = 0,
+  RELAY_JOIN,    // Announcing, waiting for receivers to erase and report ready
+  RELAY_BLAST,   // First pass over every chunk
+  RELAY_POLL,    // Collecting missing-chunk bitmaps
+  RELAY_REPAIR,  // Re-broadcasting chunks someone reported missing
+  RELAY_DONE,
+  RELAY_FAILED
+};
+
+struct Participant {
+  uint8_t mac[6];
+  uint8_t state;  // MeshOtaRxState reported by the receiver
+  uint16_t received;
+  uint8_t silentPolls;
+  bool replied;
+  bool active;
+};
+
+Participant participants[MAX_RECEIVERS];
+MeshOtaAnnounce relayInfo;
+const esp_partition_t* relayImage = nullptr;
+volatile RelayPhase relayPhase = RELAY_IDLE;
+RelayPhase reportedPhase = RELAY_IDLE;
+uint32_t phaseStart = 0;
+uint32_t nextAnnounce = 0;
+uint32_t lastReport = 0;
+uint32_t cursor = 0;
+uint8_t relayRound = 0;
+bool rebootAfterRelay = false;
+uint8_t needBitmap[BITMAP_BYTES];  // Chunks to re-broadcast in the next repair round
+
+Participant* findParticipant(const uint8_t* mac, bool create) {
+  Participant* freeSlot = nullptr;
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    if (participants[i].active && macEqual(participants[i].mac, mac)) {
+      return &participants[i];
+    }
+    if (!participants[i].active && !freeSlot) {
+      freeSlot = &participants[i];
+    }
+  }
+  if (!create || !freeSlot) {
+    return nullptr;
+  }
+  memset(freeSlot, 0, sizeof(Participant));
+  memcpy(freeSlot->mac, mac, 6);
+  freeSlot->active = true;
+  return freeSlot;
+}
+
+// Format: F0 7D 25 [phase] [round] [chunkCount(3 x 7-bit)] [participants]
+//   per participant: [mac(6, encoded:7)] [state] [received(3 x 7-bit)] F7
+void sendMeshOtaReport() {
+  uint8_t count = 0;
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    if (participants[i].active) {
+      count++;
+    }
+  }
+
+  midiSysexBegin(SYSEX_CMD_MESH_OTA_STATUS);
+  midiSysexByte(relayPhase);
+  midiSysexByte(relayRound);
+  midiSysexByte((relayInfo.chunkCount >> 14) & 0x7F);
+  midiSysexByte((relayInfo.chunkCount >> 7) & 0x7F);
+  midiSysexByte(relayInfo.chunkCount & 0x7F);
+  midiSysexByte(count);
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    const Participant& p = participants[i];
+    if (!p.active) {
+      continue;
+    }
+    midiSysexEncode(p.mac, 6);
+    midiSysexByte(p.state);
+    midiSysexByte((p.received >> 14) & 0x7F);
+    midiSysexByte((p.received >> 7) & 0x7F);
+    midiSysexByte(p.received & 0x7F);
+  }
+  midiSysexEnd();
+}
+
+void enterPhase(RelayPhase phase, uint32_t now) {
+  relayPhase = phase;
+  phaseStart = now;
+  cursor = 0;
+}
+
+void sendAnnounce(uint8_t poll) {
+  relayInfo.poll = poll;
+  espnowTxSend(broadcastAddress, &relayInfo, sizeof(relayInfo));
+}
+
+// Broadcast one chunk; false if the TX queue has no room (retry on the next tick)
+bool sendChunk(uint32_t index) {
+  static uint8_t frame[sizeof(MeshOtaChunkHeader) + MESH_OTA_CHUNK_SIZE];  // ESP-NOW task only
+  MeshOtaChunkHeader header;
+  header.sessionId = relayInfo.sessionId;
+  header.index = static_cast<uint16_t>(index);
+  memcpy(frame, &header, sizeof(header));
+
+  uint32_t offset = index * MESH_OTA_CHUNK_SIZE;
+  uint32_t len = std::min<uint32_t>(MESH_OTA_CHUNK_SIZE, relayInfo.imageSize - offset);
+  if (esp_partition_read(relayImage, offset, &frame[sizeof(header)], len) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_OTA, "[MESH OTA] Flash read failed at chunk %lu\r\n", index);
+    return true;  // Skip it, receivers will report it missing
+  }
+  return espnowTxSend(broadcastAddress, frame, sizeof(header) + len);
+}
+
+bool allParticipantsIn(uint8_t minState) {
+  bool any = false;
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    if (participants[i].active) {
+      any = true;
+      if (participants[i].state < minState) {
+        return false;
+      }
+    }
+  }
+  return any;
+}
+
+void startPoll(uint32_t now) {
+  memset(needBitmap, 0, sizeof(needBitmap));
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    participants[i].replied = false;
+  }
+  enterPhase(RELAY_POLL, now);
+  sendAnnounce(1);
+  schedulerArm(SCHED_MESH_OTA_TX, now + MESH_OTA_POLL_WAIT_MS);
+}
+
+void finishPoll(uint32_t now) {
+  bool anyMissing = false;
+  for (size_t i = 0; i < BITMAP_BYTES && !anyMissing; i++) {
+    anyMissing = needBitmap[i] != 0;
+  }
+
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    Participant& p = participants[i];
+    if (!p.active || p.replied || p.state >= MESH_OTA_RX_DONE) {
+      continue;
+    }
+    if (++p.silentPolls > MAX_SILENT_POLLS) {
+      LOG_WARN(LOG_CAT_OTA, "[MESH OTA] Receiver %02X:%02X:%02X:%02X:%02X:%02X stopped answering\r\n",
+               p.mac[0], p.mac[1], p.mac[2], p.mac[3], p.mac[4], p.mac[5]);
+      p.state = MESH_OTA_RX_FAILED;
+    }
+  }
+
+  if (allParticipantsIn(MESH_OTA_RX_DONE)) {
+    bool anyDone = false;
+    for (int i = 0; i < MAX_RECEIVERS; i++) {
+      anyDone |= participants[i].active && participants[i].state == MESH_OTA_RX_DONE;
+    }
+    enterPhase(anyDone ? RELAY_DONE : RELAY_FAILED, now);
+    schedulerArm(SCHED_MESH_OTA_TX, now);
+    return;
+  }
+
+  // Every poll counts as a round, so receivers stuck before RECEIVING can't hold us forever
+  if (++relayRound > MESH_OTA_MAX_ROUNDS) {
+    LOG_WARN(LOG_CAT_OTA, "[MESH OTA] Too many repair rounds, giving up\r\n");
+    enterPhase(RELAY_FAILED, now);
+    schedulerArm(SCHED_MESH_OTA_TX, now);
+    return;
+  }
+
+  if (!anyMissing) {
+    startPoll(now);  // Someone did not answer yet: ask again
+    return;
+  }
+
+  enterPhase(RELAY_REPAIR, now);
+  schedulerArm(SCHED_MESH_OTA_TX, now);
+}
+
+// ---------------- Receiver ----------------
+
+MeshOtaRxState rxState = MESH_OTA_RX_IDLE;
+MeshOtaAnnounce rxInfo;
+uint8_t rxSenderMac[6];
+const esp_partition_t* rxPartition = nullptr;
+esp_ota_handle_t rxHandle = 0;
+uint8_t rxBitmap[BITMAP_BYTES];  // Chunks already written
+uint32_t rxReceived = 0;
+uint32_t rxLastFrame = 0;
+uint32_t rxRebootAt = 0;
+bool rxStatusPending = false;
+
+void sendRxStatus() {
+  MeshOtaStatus status;
+  status.sessionId = rxInfo.sessionId;
+  status.state = rxState;
+  status.received = static_cast<uint16_t>(rxReceived);
+  memset(status.missing, 0, sizeof(status.missing));
+
+  uint32_t base = 0;
+  if (rxState == MESH_OTA_RX_RECEIVING) {
+    while (base < rxInfo.chunkCount && bitGet(rxBitmap, base)) {
+      base++;
+    }
+    for (uint32_t i = 0; i < MESH_OTA_STATUS_BITMAP_BYTES * 8 && base + i < rxInfo.chunkCount; i++) {
+      if (!bitGet(rxBitmap, base + i)) {
+        bitSet(status.missing, i);
+      }
+    }
+  }
+  status.baseIndex = static_cast<uint16_t>(base);
+
+  espnowTxSend(rxSenderMac, &status, sizeof(status));
+}
+
+void rxAbort() {
+  if (rxState == MESH_OTA_RX_RECEIVING) {
+    esp_ota_abort(rxHandle);
+  }
+  rxState = MESH_OTA_RX_IDLE;
+}
+
+bool rxVerifyImage() {
+  static uint8_t block[1024];
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts(&sha, 0);
+  for (uint32_t offset = 0; offset < rxInfo.imageSize; offset += sizeof(block)) {
+    size_t len = std::min<uint32_t>(sizeof(block), rxInfo.imageSize - offset);
+    if (esp_partition_read(rxPartition, offset, block, len) != ESP_OK) {
+      mbedtls_sha256_free(&sha);
+      return false;
+    }
+    mbedtls_sha256_update(&sha, block, len);
+  }
+  uint8_t hash[32];
+  mbedtls_sha256_finish(&sha, hash);
+  mbedtls_sha256_free(&sha);
+  return memcmp(hash, rxInfo.sha256, sizeof(hash)) == 0;
+}
+
+void rxFinalize(uint32_t now) {
+  bool ok = rxVerifyImage();
+  if (!ok) {
+    LOG_ERROR(LOG_CAT_OTA, "[MESH OTA] SHA-256 mismatch, discarding image\r\n");
+    esp_ota_abort(rxHandle);
+  } else if (esp_ota_end(rxHandle) != ESP_OK || esp_ota_set_boot_partition(rxPartition) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_OTA, "[MESH OTA] Image rejected by esp_ota_end\r\n");
+    ok = false;
+  }
+
+  if (ok) {
+    LOG_INFO(LOG_CAT_OTA, "[MESH OTA] Image verified, rebooting in %d ms\r\n", MESH_OTA_REBOOT_DELAY_MS);
+    rxState = MESH_OTA_RX_DONE;
+    rxRebootAt = now + MESH_OTA_REBOOT_DELAY_MS;
+    schedulerArm(SCHED_MESH_OTA_RX, rxRebootAt);
+  } else {
+    rxState = MESH_OTA_RX_FAILED;
+  }
+  sendRxStatus();
+}
+
+}  // namespace
+
+bool meshOtaRelayActive() {
+  return relayPhase != RELAY_IDLE;
+}
+
+bool meshOtaStartRelay(const esp_partition_t* image, uint32_t imageSize, const uint8_t* sha256, bool rebootWhenDone) {
+  uint32_t chunkCount = (imageSize + MESH_OTA_CHUNK_SIZE - 1) / MESH_OTA_CHUNK_SIZE;
+  if (meshOtaRelayActive() || !image || chunkCount == 0 || chunkCount > MESH_OTA_MAX_CHUNKS) {
+    return false;
+  }
+
+  relayImage = image;
+  relayInfo.sessionId = (static_cast<uint32_t>(sha256[0]) << 24) | (sha256[1] << 16) | (sha256[2] << 8) | sha256[3];
+  relayInfo.imageSize = imageSize;
+  relayInfo.chunkSize = MESH_OTA_CHUNK_SIZE;
+  relayInfo.chunkCount = static_cast<uint16_t>(chunkCount);
+  memcpy(relayInfo.sha256, sha256, sizeof(relayInfo.sha256));
+  memset(participants, 0, sizeof(participants));
+  rebootAfterRelay = rebootWhenDone;
+  relayRound = 0;
+  nextAnnounce = 0;
+
+  LOG_INFO(LOG_CAT_OTA, "[MESH OTA] Relaying %lu bytes (%lu chunks) to receivers\r\n", imageSize, chunkCount);
+
+  uint32_t now = millis();
+  enterPhase(RELAY_JOIN, now);
+  schedulerArm(SCHED_MESH_OTA_TX, now);  // Wakes the ESP-NOW task
+  return true;
+}
+
+void meshOtaSenderTick(uint32_t now) {
+  switch (relayPhase) {
+    case RELAY_JOIN: {
+      if (static_cast<int32_t>(now - nextAnnounce) >= 0) {
+        sendAnnounce(0);
+        nextAnnounce = now + MESH_OTA_ANNOUNCE_INTERVAL_MS;
+      }
+      uint32_t elapsed = now - phaseStart;
+      int joined = 0;
+      for (int i = 0; i < MAX_RECEIVERS; i++) {
+        joined += participants[i].active ? 1 : 0;
+      }
+      bool everyoneReady = joined >= countActiveReceivers() && allParticipantsIn(MESH_OTA_RX_RECEIVING);
+      if ((everyoneReady && elapsed >= 2 * MESH_OTA_ANNOUNCE_INTERVAL_MS) || elapsed >= MESH_OTA_JOIN_TIMEOUT_MS) {
+        if (joined > 0) {
+          LOG_INFO(LOG_CAT_OTA, "[MESH OTA] %d receiver(s) joined, broadcasting image\r\n", joined);
+          enterPhase(RELAY_BLAST, now);
+        } else {
+          LOG_WARN(LOG_CAT_OTA, "[MESH OTA] No receiver joined\r\n");
+          enterPhase(RELAY_FAILED, now);
+        }
+      }
+      schedulerArm(SCHED_MESH_OTA_TX, now + (relayPhase == RELAY_JOIN ? 100 : 0));
+      break;
+    }
+
+    case RELAY_BLAST:
+      if (sendChunk(cursor)) {
+        cursor++;
+      }
+      if (cursor >= relayInfo.chunkCount) {
+        startPoll(now);
+      } else {
+        schedulerArm(SCHED_MESH_OTA_TX, now + MESH_OTA_FRAME_INTERVAL_MS);
+      }
+      break;
+
+    case RELAY_POLL:
+      finishPoll(now);
+      break;
+
+    case RELAY_REPAIR:
+      while (cursor < relayInfo.chunkCount && !bitGet(needBitmap, cursor)) {
+        // Skip whole empty bytes quickly
+        if ((cursor & 7) == 0 && needBitmap[cursor >> 3] == 0) {
+          cursor += 8;
+        } else {
+          cursor++;
+        }
+      }
+      if (cursor >= relayInfo.chunkCount) {
+        startPoll(now);
+      } else {
+        if (sendChunk(cursor)) {
+          bitClear(needBitmap, cursor);
+        }
+        schedulerArm(SCHED_MESH_OTA_TX, now + MESH_OTA_FRAME_INTERVAL_MS);
+      }
+      break;
+
+    case RELAY_DONE:
+    case RELAY_FAILED:
+      LOG_INFO(LOG_CAT_OTA, "[MESH OTA] Relay %s after %d repair round(s)\r\n",
+                relayPhase == RELAY_DONE ? "complete" : "failed", relayRound);
+      sendMeshOtaReport();
+      relayPhase = RELAY_IDLE;
+      reportedPhase = RELAY_IDLE;
+      if (rebootAfterRelay) {
+        LOG_INFO(LOG_CAT_OTA, "[MESH OTA] Rebooting into the new image\r\n");
+        profileFlush();
+        logFlush();
+        DEBUG_SERIAL.flush();
+        delay(1000);
+        esp_restart();
+      }
+      return;
+
+    default:
+      return;
+  }
+
+  // Keep the Bridge informed: on every phase change and once per second
+  if (relayPhase != reportedPhase || now - lastReport >= 1000) {
+    reportedPhase = relayPhase;
+    lastReport = now;
+    sendMeshOtaReport();
+  }
+}
+
+void handleMeshOtaStatus(const uint8_t* srcMac, const uint8_t* data, int len) {
+  if (len < static_cast<int>(sizeof(MeshOtaStatus)) || !meshOtaRelayActive()) {
+    return;
+  }
+  MeshOtaStatus status;
+  memcpy(&status, data, sizeof(status));
+  if (status.sessionId != relayInfo.sessionId) {
+    return;
+  }
+
+  Participant* p = findParticipant(srcMac, relayPhase == RELAY_JOIN || status.state != MESH_OTA_RX_IDLE);
+  if (!p) {
+    return;
+  }
+  p->state = status.state;
+  p->received = status.received;
+  p->replied = true;
+  p->silentPolls = 0;
+
+  if (status.state == MESH_OTA_RX_RECEIVING) {
+    for (uint32_t i = 0; i < MESH_OTA_STATUS_BITMAP_BYTES * 8; i++) {
+      uint32_t index = status.baseIndex + i;
+      if (index >= relayInfo.chunkCount) {
+        break;
+      }
+      if (bitGet(status.missing, i)) {
+        bitSet(needBitmap, index);
+      }
+    }
+  }
+}
+
+void handleMeshOtaAnnounce(const uint8_t* srcMac, const uint8_t* data, int len) {
+  if (len < static_cast<int>(sizeof(MeshOtaAnnounce))) {
+    return;
+  }
+  MeshOtaAnnounce announce;
+  memcpy(&announce, data, sizeof(announce));
+  uint32_t now = millis();
+
+  if (announce.sessionId == rxInfo.sessionId && rxState != MESH_OTA_RX_IDLE) {
+    // Known session: answer the poll after a random delay so receivers don't collide
+    rxLastFrame = now;
+    rxStatusPending = true;
+    schedulerArmEarliest(SCHED_MESH_OTA_RX, now + random(0, MESH_OTA_POLL_WAIT_MS / 2));
+    return;
+  }
+
+  if (announce.chunkSize != MESH_OTA_CHUNK_SIZE || announce.chunkCount > MESH_OTA_MAX_CHUNKS) {
+    return;
+  }
+
+  rxAbort();
+  memcpy(&rxInfo, &announce, sizeof(rxInfo));
+  memcpy(rxSenderMac, srcMac, 6);
+  rxPartition = esp_ota_get_next_update_partition(NULL);
+  rxReceived = 0;
+  memset(rxBitmap, 0, sizeof(rxBitmap));
+
+  LOG_INFO(LOG_CAT_OTA, "[MESH OTA] Joining session %08lX (%lu bytes)\r\n", announce.sessionId, announce.imageSize);
+
+  if (!rxPartition || announce.imageSize > rxPartition->size) {
+    rxState = MESH_OTA_RX_FAILED;
+    sendRxStatus();
+    return;
+  }
+
+  // Tell the sender we're in before the (multi-second) partition erase
+  rxState = MESH_OTA_RX_JOINING;
+  sendRxStatus();
+
+  if (esp_ota_begin(rxPartition, announce.imageSize, &rxHandle) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_OTA, "[MESH OTA] esp_ota_begin failed\r\n");
+    rxState = MESH_OTA_RX_FAILED;
+  } else {
+    rxState = MESH_OTA_RX_RECEIVING;
+  }
+  rxLastFrame = millis();
+  sendRxStatus();
+  schedulerArm(SCHED_MESH_OTA_RX, rxLastFrame + 1000);
+}
+
+void handleMeshOtaChunk(const uint8_t* data, int len) {
+  if (rxState != MESH_OTA_RX_RECEIVING || len <= static_cast<int>(sizeof(MeshOtaChunkHeader))) {
+    return;
+  }
+  MeshOtaChunkHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (header.sessionId != rxInfo.sessionId || header.index >= rxInfo.chunkCount ||
+      bitGet(rxBitmap, header.index)) {
+    return;
+  }
+
+  uint32_t offset = static_cast<uint32_t>(header.index) * MESH_OTA_CHUNK_SIZE;
+  uint32_t expectedLen = std::min<uint32_t>(MESH_OTA_CHUNK_SIZE, rxInfo.imageSize - offset);
+  uint32_t payloadLen = len - sizeof(header);
+  if (payloadLen != expectedLen) {
+    return;
+  }
+
+  if (esp_ota_write_with_offset(rxHandle, &data[sizeof(header)], payloadLen, offset) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_OTA, "[MESH OTA] Flash write failed at chunk %u\r\n", header.index);
+    esp_ota_abort(rxHandle);
+    rxState = MESH_OTA_RX_FAILED;
+    sendRxStatus();
+    return;
+  }
+
+  bitSet(rxBitmap, header.index);
+  rxReceived++;
+  rxLastFrame = millis();
+
+  if (rxReceived == rxInfo.chunkCount) {
+    rxFinalize(rxLastFrame);
+  }
+}
+
+void meshOtaReceiverTick(uint32_t now) {
+  if (rxStatusPending) {
+    rxStatusPending = false;
+    sendRxStatus();
+  }
+
+  switch (rxState) {
+    case MESH_OTA_RX_RECEIVING:
+      if (now - rxLastFrame > MESH_OTA_RX_TIMEOUT_MS) {
+        LOG_WARN(LOG_CAT_OTA, "[MESH OTA] Sender went quiet, aborting\r\n");
+        rxAbort();
+        rxInfo.sessionId = 0;  // Allow joining the same image again
+      } else {
+        schedulerArm(SCHED_MESH_OTA_RX, now + 1000);
+      }
+      break;
+
+    case MESH_OTA_RX_DONE:
+      if (static_cast<int32_t>(now - rxRebootAt) >= 0) {
+        LOG_INFO(LOG_CAT_OTA, "[MESH OTA] Rebooting into the new image\r\n");
+        profileFlush();
+        logFlush();
+        DEBUG_SERIAL.flush();
+        esp_restart();
+      } else {
+        schedulerArm(SCHED_MESH_OTA_RX, rxRebootAt);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+// Mesh OTA: the sender relays an image it already verified (see ota.cpp) to
+// every receiver at once. Chunks are broadcast in one pass, then the sender
+// polls; each receiver answers with a bitmap of the chunks it still misses
+// and only those are re-broadcast (selective repeat) until everyone is done.
+// Receivers write chunks at their offset into their own OTA partition,
+// check the SHA-256 and reboot into the new image.
+
+// Sender side (ESP-NOW task, except meshOtaStartRelay)
+bool meshOtaStartRelay(const esp_partition_t* image, uint32_t imageSize, const uint8_t* sha256, bool rebootWhenDone);
+bool meshOtaRelayActive();
+void meshOtaSenderTick(uint32_t now);
+void handleMeshOtaStatus(const uint8_t* srcMac, const uint8_t* data, int len);
+
+// Receiver side (ESP-NOW task)
+void handleMeshOtaAnnounce(const uint8_t* srcMac, const uint8_t* data, int len);
+void handleMeshOtaChunk(const uint8_t* data, int len);
+void meshOtaReceiverTick(uint32_t now);
@@ -0,0 +1,76 @@
+#include "metrics.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "nowde_state.h"
+#include "rx_queue.h"
+
+namespace {
+
+std::atomic<uint32_t> counters[METRIC_COUNTER_COUNT];
+std::atomic<uint32_t> histograms[METRIC_HIST_COUNT][METRIC_HIST_BUCKETS];
+
+// Written by the ESP-NOW task, read by the MIDI task
+portMUX_TYPE remoteMux = portMUX_INITIALIZER_UNLOCKED;
+struct RemoteMetrics {
+  uint8_t mac[6];
+  bool valid;
+  MetricsSnapshot snapshot;
+};
+RemoteMetrics remote[MAX_RECEIVERS];
+
+uint8_t bucketFor(uint32_t us) {
+  uint8_t bucket = 0;
+  uint32_t bound = METRIC_HIST_BASE_US;
+  while (us >= bound && bucket < METRIC_HIST_BUCKETS - 1) {
+    bucket++;
+    bound <<= 1;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+void metricsCount(MetricCounter counter, uint32_t amount) {
+  counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void metricsRecordUs(MetricHistogram histogram, uint32_t us) {
+  histograms[histogram][bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t metricsCounter(MetricCounter counter) {
+  return counters[counter].load(std::memory_order_relaxed);
+}
+
+void metricsSnapshot(MetricsSnapshot* out) {
+  out->uptimeMs = millis();
+  for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+    out->counters[i] = counters[i].load(std::memory_order_relaxed);
+  }
+  out->counters[METRIC_RX_QUEUE_DROPPED] = rxQueueDropped();
+  for (int h = 0; h < METRIC_HIST_COUNT; h++) {
+    for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+      out->histograms[h][b] = static_cast<uint16_t>(histograms[h][b].load(std::memory_order_relaxed));
+    }
+  }
+}
+
+void metricsStoreRemote(int receiverSlot, const uint8_t* mac, const MetricsSnapshot& snapshot) {
+  portENTER_CRITICAL(&remoteMux);
+  memcpy(remote[receiverSlot].mac, mac, 6);
+  memcpy(&remote[receiverSlot].snapshot, &snapshot, sizeof(snapshot));
+  remote[receiverSlot].valid = true;
+  portEXIT_CRITICAL(&remoteMux);
+}
+
+bool metricsRemote(int receiverSlot, const uint8_t* mac, MetricsSnapshot* out) {
+  portENTER_CRITICAL(&remoteMux);
+  bool found = remote[receiverSlot].valid && macEqual(remote[receiverSlot].mac, mac);
+  if (found) {
+    memcpy(out, &remote[receiverSlot].snapshot, sizeof(*out));
+  }
+  portEXIT_CRITICAL(&remoteMux);
+  return found;
+}
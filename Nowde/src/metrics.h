@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Arduino.h>
+#include "nowde_config.h"
+
+// Hot-path counters and log2 latency histograms. Every update is a single
+// relaxed atomic add, so they can be bumped from any task, the WiFi callbacks
+// or the esp_timer task without locks. Receivers push snapshots to their
+// senders (MetricsPacket); the sender forwards its own and every receiver's
+// snapshot to the Bridge as METRICS SysEx next to RUNNING_STATE.
+void metricsCount(MetricCounter counter, uint32_t amount = 1);
+void metricsRecordUs(MetricHistogram histogram, uint32_t us);
+uint32_t metricsCounter(MetricCounter counter);
+void metricsSnapshot(MetricsSnapshot* out);
+
+// Sender side: latest snapshot per receiver slot, tagged with the receiver MAC
+// so a slot reused by another receiver does not report stale numbers
+void metricsStoreRemote(int receiverSlot, const uint8_t* mac, const MetricsSnapshot& snapshot);
+bool metricsRemote(int receiverSlot, const uint8_t* mac, MetricsSnapshot* out);
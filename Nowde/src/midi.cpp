@@ -1,62 +1,433 @@
 #include "midi.h"
 
+#include <algorithm>
+
+#include <USB.h>
+#include <esp32-hal-tinyusb.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "metrics.h"
 #include "nowde_config.h"
+#include "nowde_log.h"
 #include "nowde_state.h"
 #include "sysex.h"
+#include "sysex_codec.h"
+#include "sysex_stream.h"
 
 namespace {
-constexpr size_t SYSEX_BUFFER_SIZE = 512;  // Large enough for RUNNING_STATE payloads (~350B)
-uint8_t sysexBuffer[SYSEX_BUFFER_SIZE];
-size_t sysexIndex = 0;
-bool inSysex = false;
-bool sysexOverflow = false;
+// Only the MIDI task talks to TinyUSB. Other tasks compose their messages into
+// 48-byte chunks and queue them; the MIDI task writes them out between reads.
+// 48 raw bytes become 16 USB-MIDI event packets = one 64-byte bulk transfer.
+constexpr size_t TX_CHUNK_SIZE = 48;
+
+// A message is queued as START ... END chunks (one chunk for short messages)
+constexpr uint8_t TX_CHUNK_START = 0x01;
+constexpr uint8_t TX_CHUNK_END = 0x02;
+
+struct TxChunk {
+  uint8_t length;
+  uint8_t flags;
+  uint8_t data[TX_CHUNK_SIZE];
+};
+
+TaskHandle_t midiTaskHandle = nullptr;
+QueueHandle_t txQueue = nullptr;
+
+// All USB MIDI output goes through this lock so a SysEx is never interleaved
+// with quarter frames or CC messages from another task.
+SemaphoreHandle_t txLock = nullptr;
+
+// Message writer state (only touched while txLock is held)
+uint8_t txChunk[TX_CHUNK_SIZE];
+size_t txChunkLen = 0;
+bool txChunkStart = false;  // txChunk is the first chunk of its message
+uint8_t encGroup[7];  // Pending 8-bit bytes of the current 7-bit group
+uint8_t encGroupLen = 0;
+bool txDropping = false;  // USB stalled: discard the rest of this message
+
+// Quarter-frame mailbox. The MTC timer runs in the esp_timer task, which also
+// drives the RF simulation wheel and scheduled actions, so it must never wait
+// on txLock (held for a whole multi-chunk SysEx) or on queue room. It posts
+// its byte here instead, and the MIDI task queues it at the next message
+// boundary. One slot: a newer quarter frame replaces one not yet queued.
+portMUX_TYPE qfMux = portMUX_INITIALIZER_UNLOCKED;
+volatile bool qfPending = false;
+uint8_t qfData = 0;
+
+// Chunk being written to the FIFO (MIDI task only)
+TxChunk txPending;
+size_t txPendingPos = 0;
+bool txHasPending = false;
+uint32_t txStalledSinceMs = 0;
+// A message is all or nothing on the wire. Once one of its chunks is lost the
+// rest is skipped (txSkipping), and a SysEx already partly written
+// (txSysexOpen) gets an F7 before the next message (txTerminatorOwed), so the
+// host never reads two messages as one.
+bool txSkipping = false;
+bool txSysexOpen = false;
+bool txTerminatorOwed = false;
+
+bool onMidiTask() {
+  return midiTaskHandle && xTaskGetCurrentTaskHandle() == midiTaskHandle;
+}
+
+// MIDI task: hands queued chunks to TinyUSB, which packs them into event
+// packets and submits them as one transfer. Returns true while data is still
+// waiting for room in the TX FIFO; a chunk that makes no progress for
+// MIDI_TX_TIMEOUT_MS is dropped, with the rest of its message.
+bool txDrain() {
+  for (;;) {
+    if (!txHasPending) {
+      if (xQueueReceive(txQueue, &txPending, 0) != pdTRUE) {
+        return false;
+      }
+      if (txSkipping && !(txPending.flags & TX_CHUNK_START)) {
+        metricsCount(METRIC_USB_TX_DROPPED);
+        continue;
+      }
+      txSkipping = false;
+      txHasPending = true;
+      txPendingPos = 0;
+      txStalledSinceMs = millis();
+      if (txSysexOpen && (txPending.flags & TX_CHUNK_START)) {
+        // Its END chunk was dropped here or never queued (txFlush)
+        metricsCount(METRIC_USB_TX_TRUNCATED);
+        txTerminatorOwed = true;
+      }
+    }
+
+    if (!tud_mounted()) {
+      metricsCount(METRIC_USB_TX_DROPPED);
+      txHasPending = false;
+      txSysexOpen = false;  // The host starts over on mount
+      txTerminatorOwed = false;
+      continue;
+    }
+
+    if (txTerminatorOwed) {
+      const uint8_t terminator = SYSEX_END;
+      if (tud_midi_stream_write(0, &terminator, 1) == 1) {
+        txTerminatorOwed = false;
+        txSysexOpen = false;
+        continue;
+      }
+    } else {
+      uint32_t written = tud_midi_stream_write(0, &txPending.data[txPendingPos],
+                                               txPending.length - txPendingPos);
+      if (written > 0 && txPendingPos == 0 && (txPending.flags & TX_CHUNK_START)) {
+        txSysexOpen = txPending.data[0] == SYSEX_START;
+      }
+      txPendingPos += written;
+      if (txPendingPos >= txPending.length) {
+        if (txPending.flags & TX_CHUNK_END) {
+          txSysexOpen = false;
+        }
+        txHasPending = false;
+        continue;
+      }
+      if (written > 0) {
+        txStalledSinceMs = millis();
+        return true;
+      }
+    }
+
+    if (millis() - txStalledSinceMs >= MIDI_TX_TIMEOUT_MS) {
+      LOG_WARN(LOG_CAT_USB, "[MIDI TX] USB FIFO stalled, dropping chunk\r\n");
+      metricsCount(METRIC_USB_TX_DROPPED);
+      txSkipping = !(txPending.flags & TX_CHUNK_END);
+      txHasPending = false;
+      continue;
+    }
+    return true;
+  }
+}
+
+void txLockTake() {
+  if (!txLock) {
+    return;
+  }
+  if (!onMidiTask()) {
+    xSemaphoreTake(txLock, portMAX_DELAY);
+    return;
+  }
+  // The holder may be waiting for queue room that only we can make
+  while (xSemaphoreTake(txLock, 1) != pdTRUE) {
+    txDrain();
+  }
+}
+
+void txLockGive() {
+  if (txLock) {
+    xSemaphoreGive(txLock);
+  }
+  // A quarter frame posted while we held the lock goes out now
+  if (qfPending && midiTaskHandle && !onMidiTask()) {
+    xTaskNotifyGive(midiTaskHandle);
+  }
+}
+
+// Queues the composed chunk for the MIDI task (end: it closes the message).
+// Messages built on the MIDI task itself (replies to Bridge commands) cannot
+// wait for the queue to drain, so they drain it inline when it is full. Other
+// writers give up on the rest of the message after MIDI_TX_TIMEOUT_MS; the
+// MIDI task then closes what it already sent (txDrain).
+void txFlush(bool end = false) {
+  if (txChunkLen == 0 || txDropping) {
+    txChunkLen = 0;
+    return;
+  }
+
+  TxChunk chunk;
+  chunk.length = static_cast<uint8_t>(txChunkLen);
+  chunk.flags = (txChunkStart ? TX_CHUNK_START : 0) | (end ? TX_CHUNK_END : 0);
+  memcpy(chunk.data, txChunk, txChunkLen);
+  txChunkLen = 0;
+  txChunkStart = false;
+
+  if (onMidiTask()) {
+    while (xQueueSend(txQueue, &chunk, 0) != pdTRUE) {
+      if (txDrain()) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+      }
+    }
+    return;
+  }
+
+  if (xQueueSend(txQueue, &chunk, pdMS_TO_TICKS(MIDI_TX_TIMEOUT_MS)) != pdTRUE) {
+    LOG_DEFER(WARN, LOG_CAT_USB, "[MIDI TX] TX queue full, dropping message\r\n");
+    metricsCount(METRIC_USB_TX_DROPPED);
+    txDropping = true;
+    return;
+  }
+  if (midiTaskHandle) {
+    xTaskNotifyGive(midiTaskHandle);
+  }
+}
+
+// A full chunk is queued when the next byte comes, so the one midiSysexEnd()
+// flushes is never empty and carries the END flag
+void txPut(uint8_t value) {
+  if (txChunkLen == TX_CHUNK_SIZE) {
+    txFlush();
+  }
+  txChunk[txChunkLen++] = value;
+}
+
+// Short channel / system common message as one chunk
+void txShortMessage(const uint8_t* bytes, size_t len) {
+  txLockTake();
+  txDropping = false;
+  memcpy(txChunk, bytes, len);
+  txChunkLen = len;
+  txChunkStart = true;
+  txFlush(true);
+  txLockGive();
+}
+
+// MIDI task: queues the posted quarter frame unless a message is being
+// composed (txLockGive() wakes us when it is done)
+void txEmitQuarterFrame() {
+  if (!qfPending || !txLock || xSemaphoreTake(txLock, 0) != pdTRUE) {
+    return;
+  }
+  TxChunk chunk;
+  chunk.length = 2;
+  chunk.flags = TX_CHUNK_START | TX_CHUNK_END;
+  chunk.data[0] = 0xF1;  // System common, 2 bytes
+  portENTER_CRITICAL(&qfMux);
+  chunk.data[1] = qfData;
+  qfPending = false;
+  portEXIT_CRITICAL(&qfMux);
+  if (xQueueSend(txQueue, &chunk, 0) != pdTRUE) {
+    metricsCount(METRIC_USB_TX_DROPPED);
+  }
+  xSemaphoreGive(txLock);
+}
+
+// USB stack event (Arduino event loop): the host has configured the device
+void usbStartedEvent(void* arg, esp_event_base_t base, int32_t id, void* data) {
+  if (midiTaskHandle) {
+    xTaskNotifyGive(midiTaskHandle);
+  }
+}
+
+// ============= CORE 0 - MIDI/USB TASK (High Priority) =============
+// Pinned away from the ESP-NOW task so USB MIDI is never blocked by radio
+// traffic. Sleeps until TinyUSB has received data, a chunk is queued, a sync
+// burst repeat is due or the device gets mounted; only polls (every tick)
+// while the TX FIFO is full.
+void midiTask(void* parameter) {
+  LOG_INFO(LOG_CAT_CORE, "[TASK] MIDI task started on Core %d (high priority)\r\n", xPortGetCoreID());
+  bool wasMounted = false;
+
+  for (;;) {
+    // HELLO goes out as soon as the host can hear it (boot, or a re-plug)
+    // rather than after a guessed enumeration delay
+    bool mounted = tud_mounted();
+    if (mounted && !wasMounted) {
+      LOG_INFO(LOG_CAT_USB, "[USB] Mounted after %lu ms, sending HELLO\r\n", millis());
+      sendHello();
+    }
+    wasMounted = mounted;
+
+    midiProcess();
+    TickType_t burstWait = sysexServiceSyncBursts();
+    txEmitQuarterFrame();
+    bool txBacklog = txDrain();
+    TickType_t wait = std::min<TickType_t>(pdMS_TO_TICKS(MIDI_TASK_IDLE_WAIT_MS), burstWait);
+    ulTaskNotifyTake(pdTRUE, txBacklog ? 1 : wait);
+  }
+}
+}  // namespace
+
+// TinyUSB callback (TinyUSB task): new MIDI data is waiting in the RX FIFO
+extern "C" void tud_midi_rx_cb(uint8_t itf) {
+  (void)itf;
+  if (midiTaskHandle) {
+    xTaskNotifyGive(midiTaskHandle);
+  }
 }
 
 void midiInit() {
+  txLock = xSemaphoreCreateMutex();
+  txQueue = xQueueCreate(MIDI_TX_QUEUE_DEPTH, sizeof(TxChunk));
   MIDI.begin();
+  USB.onEvent(ARDUINO_USB_STARTED_EVENT, usbStartedEvent);
+}
+
+void midiStartTask() {
+  // Highest priority (configMAX_PRIORITIES - 1); core 1 belongs to the ESP-NOW task.
+  // Output queued before the host mounts the device is dropped by txDrain();
+  // the task sends HELLO on the mount edge.
+  xTaskCreatePinnedToCore(midiTask, "MIDI_Task", MIDI_TASK_STACK_SIZE, NULL,
+                          configMAX_PRIORITIES - 1, &midiTaskHandle, MIDI_TASK_CORE);
 }
 
 void midiSendCC100(uint8_t value) {
-  MIDI.controlChange(100, value, 1);
-  DEBUG_SERIAL.printf("[MIDI TX] CC#100 = %d (channel 1)\r\n", value);
-}
-
-void midiSendTimeCode(uint32_t positionMs) {
-  uint32_t totalFrames = (positionMs * MTC_FRAMERATE) / 1000;
-  uint8_t frames = totalFrames % MTC_FRAMERATE;
-  uint8_t seconds = (totalFrames / MTC_FRAMERATE) % 60;
-  uint8_t minutes = (totalFrames / (MTC_FRAMERATE * 60)) % 60;
-  uint8_t hours = (totalFrames / (MTC_FRAMERATE * 3600)) % 24;
-
-  auto sendQuarterFrame = [&](uint8_t piece, uint8_t nibble) {
-    midiEventPacket_t packet;
-    packet.header = 0x02;
-    packet.byte1 = 0xF1;
-    packet.byte2 = static_cast<uint8_t>((piece << 4) | (nibble & 0x0F));
-    packet.byte3 = 0;
-    midiWritePacket(packet);
+  const uint8_t message[3] = {static_cast<uint8_t>(0xB0 | ((cc100Channel - 1) & 0x0F)), 100,
+                              static_cast<uint8_t>(value & 0x7F)};
+  txShortMessage(message, sizeof(message));
+  LOG_DEFER(INFO, LOG_CAT_USB, "[MIDI TX] CC#100 = %d (channel %d)\r\n", value, cc100Channel);
+}
+
+void midiSysexBeginRaw() {
+  txLockTake();
+  txChunkLen = 0;
+  txChunkStart = true;
+  encGroupLen = 0;
+  txDropping = false;
+  txPut(SYSEX_START);
+}
+
+void midiSysexBegin(uint8_t command) {
+  midiSysexBeginRaw();
+  txPut(SYSEX_MANUFACTURER_ID);
+  txPut(command & 0x7F);
+}
+
+void midiSysexByte(uint8_t value) {
+  midiSysexEncodeFlush();
+  txPut(value & 0x7F);
+}
+
+void midiSysexBytes(const uint8_t* data, size_t len) {
+  midiSysexEncodeFlush();
+  for (size_t i = 0; i < len; i++) {
+    txPut(data[i] & 0x7F);
+  }
+}
+
+// Same layout as encode7bit(): [MSB byte][up to 7 data bytes] per group
+void midiSysexEncodeFlush() {
+  if (encGroupLen == 0) {
+    return;
+  }
+  uint8_t encoded[8];
+  if (encGroupLen == 7) {
+    encode7bitGroup(encGroup, encoded);
+  } else {
+    encode7bitPartial(encGroup, encGroupLen, encoded);
+  }
+  for (uint8_t i = 0; i <= encGroupLen; i++) {
+    txPut(encoded[i]);
+  }
+  encGroupLen = 0;
+}
+
+void midiSysexEncode(const void* data, size_t len) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    encGroup[encGroupLen++] = bytes[i];
+    if (encGroupLen == 7) {
+      midiSysexEncodeFlush();
+    }
+  }
+}
+
+void midiSysexEncodeU32(uint32_t value) {
+  const uint8_t bytes[4] = {
+    static_cast<uint8_t>(value >> 24),
+    static_cast<uint8_t>(value >> 16),
+    static_cast<uint8_t>(value >> 8),
+    static_cast<uint8_t>(value)
   };
+  midiSysexEncode(bytes, sizeof(bytes));
+}
 
-  sendQuarterFrame(0, frames & 0x0F);
-  sendQuarterFrame(1, (frames >> 4) & 0x01);
-  sendQuarterFrame(2, seconds & 0x0F);
-  sendQuarterFrame(3, (seconds >> 4) & 0x03);
-  sendQuarterFrame(4, minutes & 0x0F);
-  sendQuarterFrame(5, (minutes >> 4) & 0x03);
-  sendQuarterFrame(6, hours & 0x0F);
+void midiSysexEncodeU16(uint16_t value) {
+  const uint8_t bytes[2] = {
+    static_cast<uint8_t>(value >> 8),
+    static_cast<uint8_t>(value)
+  };
+  midiSysexEncode(bytes, sizeof(bytes));
+}
 
-  uint8_t framerateCode = 3;
-  sendQuarterFrame(7, ((hours >> 4) & 0x01) | (framerateCode << 1));
+void midiSysexEnd() {
+  midiSysexEncodeFlush();
+  txPut(SYSEX_END);
+  txFlush(true);
+  txLockGive();
+}
 
-  static unsigned long lastMTCLog = 0;
-  if (millis() - lastMTCLog > 5000) {
-    DEBUG_SERIAL.printf("[MIDI TX] MTC: %02d:%02d:%02d:%02d (30fps)\r\n", hours, minutes, seconds, frames);
-    lastMTCLog = millis();
+bool midiSendQuarterFrame(uint8_t data) {
+  portENTER_CRITICAL(&qfMux);
+  bool replaced = qfPending;
+  qfData = data & 0x7F;
+  qfPending = true;
+  portEXIT_CRITICAL(&qfMux);
+  if (midiTaskHandle) {
+    xTaskNotifyGive(midiTaskHandle);
   }
+  return !replaced;
 }
 
-void midiWritePacket(midiEventPacket_t& packet) {
-  MIDI.writePacket(&packet);
+void midiSendFullFrame(uint8_t hours, uint8_t minutes, uint8_t seconds, uint8_t frames) {
+  // Universal real-time SysEx: F0 7F 7F 01 01 hh mm ss ff F7 (hh carries the rate code)
+  const uint8_t body[8] = {
+    0x7F, 0x7F, 0x01, 0x01,
+    static_cast<uint8_t>(((MTC_RATE_CODE & 0x03) << 5) | (hours & 0x1F)),
+    static_cast<uint8_t>(minutes & 0x3F),
+    static_cast<uint8_t>(seconds & 0x3F),
+    static_cast<uint8_t>(frames & 0x1F)
+  };
+
+  midiSysexBeginRaw();
+  midiSysexBytes(body, sizeof(body));
+  midiSysexEnd();
+}
+
+bool midiTxFlush(uint32_t timeoutMs) {
+  uint32_t startMs = millis();
+  while (txDrain()) {
+    if (millis() - startMs >= timeoutMs) {
+      return false;
+    }
+    vTaskDelay(1);
+  }
+  return true;
 }
 
 bool midiReadPacket(midiEventPacket_t* packet) {
@@ -81,47 +452,10 @@ void midiProcess() {
         dataBytes = 3;
       }
 
-      if (dataBytes > 0) {
-        if (packet.byte1 == SYSEX_START) {
-          inSysex = true;
-          sysexIndex = 0;
-        }
-
-        if (inSysex) {
-          const uint8_t bytes[3] = {packet.byte1, packet.byte2, packet.byte3};
-          for (int i = 0; i < dataBytes; i++) {
-            if (sysexIndex < SYSEX_BUFFER_SIZE) {
-              sysexBuffer[sysexIndex++] = bytes[i];
-            } else {
-              sysexOverflow = true;  // Keep reading so we can resync at F7
-            }
-            if (bytes[i] == SYSEX_END) {
-              // Only log SysEx for non-repetitive messages (to reduce clutter)
-              // Skip: MEDIA_SYNC (0x10) sent at 10Hz, QUERY_RUNNING_STATE (0x03) sent at 1Hz
-              // Skip: OTA_DATA (0x06) during firmware updates (thousands of messages)
-              bool isRepetitive = (sysexIndex >= 3 && 
-                                   (sysexBuffer[2] == SYSEX_CMD_MEDIA_SYNC || 
-                                    sysexBuffer[2] == SYSEX_CMD_QUERY_RUNNING_STATE ||
-                                    sysexBuffer[2] == 0x06));  // OTA_DATA
-              if (!isRepetitive && !sysexOverflow) {
-                DEBUG_SERIAL.print("[SYSEX RX] ");
-                for (int j = 0; j < sysexIndex; j++) {
-                  DEBUG_SERIAL.printf("%02X ", sysexBuffer[j]);
-                }
-                DEBUG_SERIAL.printf("(%d bytes)\r\n", sysexIndex);
-              }
-              if (sysexOverflow) {
-                DEBUG_SERIAL.printf("[SYSEX RX] WARNING: SysEx overflow (len>%d), discarding message\r\n", SYSEX_BUFFER_SIZE);
-              } else {
-                handleSysExMessage(sysexBuffer, sysexIndex);
-              }
-              inSysex = false;
-              sysexIndex = 0;
-              sysexOverflow = false;
-              break;
-            }
-          }
-        }
+      // Framing, including resync on a stray F0, is up to the stream parser
+      const uint8_t bytes[3] = {packet.byte1, packet.byte2, packet.byte3};
+      for (int i = 0; i < dataBytes; i++) {
+        sysexStreamByte(bytes[i]);
       }
     }
   }
@@ -3,9 +3,32 @@
 #include <Arduino.h>
 #include <USBMIDI.h>
 
+// The MIDI task (midi.cpp) owns USB: it reads and parses incoming SysEx and
+// writes all output. The send functions below may be called from any task;
+// they queue their bytes for it.
 void midiInit();
+void midiStartTask();
 void midiSendCC100(uint8_t value);
-void midiSendTimeCode(uint32_t positionMs);
+// Never blocks (esp_timer task): posted to a one-slot mailbox for the MIDI task.
+// False when it replaced a quarter frame that had not been queued yet.
+bool midiSendQuarterFrame(uint8_t data);
+void midiSendFullFrame(uint8_t hours, uint8_t minutes, uint8_t seconds, uint8_t frames);
 void midiProcess();
-void midiWritePacket(midiEventPacket_t& packet);
+// MIDI task only: hands everything queued so far to TinyUSB, for output that
+// must reach the host before a reboot. False if USB did not take it in time.
+bool midiTxFlush(uint32_t timeoutMs);
 bool midiReadPacket(midiEventPacket_t* packet);
+
+// Streaming SysEx writer. Bytes go into a 48-byte TX chunk that is queued for
+// the MIDI task and handed to TinyUSB in bulk; 7-bit encoding happens on the
+// fly. Begin takes the MIDI TX lock and End releases it, so one message is
+// always queued (and sent) contiguously.
+void midiSysexBegin(uint8_t command);  // F0 7D command
+void midiSysexBeginRaw();              // F0 only (universal messages)
+void midiSysexByte(uint8_t value);     // Raw 7-bit byte
+void midiSysexBytes(const uint8_t* data, size_t len);
+void midiSysexEncode(const void* data, size_t len);  // Appends to the current 7-bit group
+void midiSysexEncodeU16(uint16_t value);             // Big-endian, encoded
+void midiSysexEncodeU32(uint32_t value);             // Big-endian, encoded
+void midiSysexEncodeFlush();  // Closes the current group (raw bytes and End do this too)
+void midiSysexEnd();          // F7, flush, release lock
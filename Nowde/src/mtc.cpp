@@ -0,0 +1,225 @@
+#include "mtc.h"
+
+#include <esp_timer.h>
+
+#include "metrics.h"
+#include "midi.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "sync_estimator.h"
+
+namespace {
+
+constexpr uint64_t QUARTER_FRAME_INTERVAL_US = 1000000ULL / (MTC_FRAMERATE * 4);
+
+esp_timer_handle_t quarterFrameTimer = nullptr;
+
+// While running, the position comes from the sync estimator; stoppedPositionMs
+// is what the slave was last located to after a stop.
+volatile uint32_t stoppedPositionMs = 0;
+volatile bool running = false;
+volatile bool restartCycle = false;  // Set on start/seek: next QF is piece 0 again
+volatile uint32_t pendingSampleRxUs = 0;  // 0 = no sample waiting for its first QF
+
+// A warm-boot resume runs before the mesh clock has converged, so its estimate
+// is anchored on millis() until mtcOnMeshSynced(). timebaseMux keeps the flag
+// and the estimator anchor consistent for the esp_timer reader.
+portMUX_TYPE timebaseMux = portMUX_INITIALIZER_UNLOCKED;
+bool localTimebase = false;
+
+// Quarter-frame sequencer state (esp_timer task only)
+uint8_t nextPiece = 0;
+uint32_t lastTickUs = 0;
+uint8_t latched[4] = {0};  // frames, seconds, minutes, hours of the current 8-piece cycle
+
+uint32_t positionNow() {
+  uint32_t localNow = millis();
+  uint32_t meshNow = meshClock.meshMillis();
+  portENTER_CRITICAL(&timebaseMux);
+  uint32_t position = syncEstimatorPosition(localTimebase ? localNow : meshNow);
+  portEXIT_CRITICAL(&timebaseMux);
+  return position;
+}
+
+void anchor(uint32_t positionMs, uint32_t time, bool local) {
+  portENTER_CRITICAL(&timebaseMux);
+  syncEstimatorReset(positionMs, time);
+  localTimebase = local;
+  portEXIT_CRITICAL(&timebaseMux);
+}
+
+void splitTimecode(uint32_t positionMs, uint8_t out[4]) {
+  uint32_t totalFrames = static_cast<uint32_t>((static_cast<uint64_t>(positionMs) * MTC_FRAMERATE) / 1000);
+  out[0] = totalFrames % MTC_FRAMERATE;
+  out[1] = (totalFrames / MTC_FRAMERATE) % 60;
+  out[2] = (totalFrames / (MTC_FRAMERATE * 60)) % 60;
+  out[3] = (totalFrames / (MTC_FRAMERATE * 3600)) % 24;
+}
+
+// Full-frame locate so the slave jumps immediately instead of waiting 2 frames for QFs
+void sendLocate(uint32_t positionMs) {
+  uint8_t tc[4];
+  splitTimecode(positionMs, tc);
+  midiSendFullFrame(tc[3], tc[2], tc[1], tc[0]);
+}
+
+void onQuarterFrameTimer(void* arg) {
+  (void)arg;
+  if (!running) {
+    return;
+  }
+
+  // The timer skips ticks it could not run on time (skip_unhandled_events):
+  // a gap of 1.5 intervals or more means at least one quarter frame was late.
+  // Not checked across a start or seek.
+  uint32_t tickUs = static_cast<uint32_t>(esp_timer_get_time());
+  if (restartCycle) {
+    restartCycle = false;
+    nextPiece = 0;
+  } else if (tickUs - lastTickUs >= QUARTER_FRAME_INTERVAL_US * 3 / 2) {
+    metricsCount(METRIC_MTC_QF_LATE);
+  }
+  lastTickUs = tickUs;
+
+  // Latch the timecode at piece 0; pieces 1-7 carry the rest of the same timecode
+  if (nextPiece == 0) {
+    splitTimecode(positionNow(), latched);
+
+    static unsigned long lastMTCLog = 0;
+    if (millis() - lastMTCLog > 5000) {
+      LOG_DEFER(INFO, LOG_CAT_USB, "[MIDI TX] MTC: %02d:%02d:%02d:%02d (30fps)\r\n",
+                latched[3], latched[2], latched[1], latched[0]);
+      lastMTCLog = millis();
+    }
+  }
+
+  uint8_t frames = latched[0];
+  uint8_t seconds = latched[1];
+  uint8_t minutes = latched[2];
+  uint8_t hours = latched[3];
+
+  uint8_t nibble = 0;
+  switch (nextPiece) {
+    case 0: nibble = frames & 0x0F; break;
+    case 1: nibble = (frames >> 4) & 0x01; break;
+    case 2: nibble = seconds & 0x0F; break;
+    case 3: nibble = (seconds >> 4) & 0x03; break;
+    case 4: nibble = minutes & 0x0F; break;
+    case 5: nibble = (minutes >> 4) & 0x03; break;
+    case 6: nibble = hours & 0x0F; break;
+    case 7: nibble = ((hours >> 4) & 0x01) | (MTC_RATE_CODE << 1); break;
+  }
+
+  if (!midiSendQuarterFrame(static_cast<uint8_t>((nextPiece << 4) | (nibble & 0x0F)))) {
+    metricsCount(METRIC_MTC_QF_LATE);  // The previous one never reached the TX queue
+  }
+  nextPiece = (nextPiece + 1) & 0x07;
+
+  uint32_t sampleRxUs = pendingSampleRxUs;
+  if (sampleRxUs != 0) {
+    pendingSampleRxUs = 0;
+    metricsRecordUs(METRIC_HIST_RX_TO_MTC, static_cast<uint32_t>(esp_timer_get_time()) - sampleRxUs);
+  }
+}
+
+void start(uint32_t positionMs, uint32_t time, bool local) {
+  if (!quarterFrameTimer) {
+    return;
+  }
+
+  anchor(positionMs, time, local);
+  restartCycle = true;
+  sendLocate(positionNow());
+
+  if (!running) {
+    running = true;
+    esp_timer_start_periodic(quarterFrameTimer, QUARTER_FRAME_INTERVAL_US);
+    LOG_INFO(LOG_CAT_USB, "[MTC] Started at %lu ms (QF every %llu us)\r\n", positionMs, QUARTER_FRAME_INTERVAL_US);
+  }
+}
+
+}  // namespace
+
+void mtcInit() {
+  esp_timer_create_args_t args = {};
+  args.callback = onQuarterFrameTimer;
+  args.arg = nullptr;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "mtc_qf";
+  args.skip_unhandled_events = true;  // Never burst to catch up - a late QF is better than a pile-up
+
+  if (esp_timer_create(&args, &quarterFrameTimer) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_USB, "[ERROR] MTC timer creation failed!\r\n");
+    quarterFrameTimer = nullptr;
+  }
+}
+
+void mtcStart(uint32_t positionMs, uint32_t meshTime) {
+  start(positionMs, meshTime, false);
+}
+
+void mtcResume(uint32_t positionMs) {
+  start(positionMs, millis(), true);
+}
+
+void mtcOnMeshSynced() {
+  if (!localTimebase) {
+    return;
+  }
+  // Carry the free-running position over to the mesh time base, then drop the
+  // tracking state: the resumed estimate was never confirmed by a live packet,
+  // so the first one must re-anchor rather than face the outlier gate
+  uint32_t positionMs = positionNow();
+  anchor(positionMs, meshClock.meshMillis(), false);
+  syncEstimatorHold();
+  LOG_INFO(LOG_CAT_USB, "[MTC] Mesh clock synced, resumed playback moved to mesh time at %lu ms\r\n", positionMs);
+}
+
+void mtcUpdate(uint32_t positionMs, uint32_t meshTime) {
+  // A live packet before the mesh clock synced replaces a warm-boot resume outright
+  if (!running || localTimebase) {
+    mtcStart(positionMs, meshTime);
+    return;
+  }
+
+  int32_t error = static_cast<int32_t>(positionMs - syncEstimatorPosition(meshTime));
+  if (syncEstimatorUpdate(positionMs, meshTime) == SYNC_EST_JUMPED) {
+    // Seek: relocate the slave and restart the QF cycle at the new position
+    uint32_t now = positionNow();
+    restartCycle = true;
+    sendLocate(now);
+    LOG_INFO(LOG_CAT_USB, "[MTC] Relocate to %lu ms (jump %ld ms)\r\n", now, error);
+  }
+}
+
+void mtcNoteSampleRx(uint32_t rxTimeUs) {
+  pendingSampleRxUs = rxTimeUs != 0 ? rxTimeUs : 1;
+}
+
+void mtcStop(uint32_t positionMs) {
+  if (running) {
+    running = false;
+    if (quarterFrameTimer) {
+      esp_timer_stop(quarterFrameTimer);
+    }
+    LOG_INFO(LOG_CAT_USB, "[MTC] Stopped at %lu ms\r\n", positionMs);
+  }
+
+  syncEstimatorHold();
+  localTimebase = false;
+  stoppedPositionMs = positionMs;
+  restartCycle = true;
+  sendLocate(positionMs);
+}
+
+bool mtcRunning() {
+  return running;
+}
+
+uint32_t mtcPosition() {
+  if (!running) {
+    return stoppedPositionMs;
+  }
+  return positionNow();
+}
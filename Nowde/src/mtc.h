@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Arduino.h>
+
+// MIDI Time Code generator driven by a high-resolution esp_timer.
+// Sends one quarter frame every 1/4 frame, with the timecode read from the
+// sync estimator at meshClock.meshMillis() so the output follows the mesh
+// rather than millis(), and packet jitter is smoothed instead of stepped.
+// mtcStart/mtcUpdate take a position stamped by the sender at meshTime.
+void mtcInit();
+void mtcStart(uint32_t positionMs, uint32_t meshTime);
+void mtcUpdate(uint32_t positionMs, uint32_t meshTime);
+// Warm-boot resume: runs on millis() until the mesh clock syncs
+void mtcResume(uint32_t positionMs);
+// ESP-NOW task, while the mesh clock is SYNCED: moves a resume onto mesh time
+void mtcOnMeshSynced();
+void mtcStop(uint32_t positionMs);
+// Sync sample received off the air at rxTimeUs (esp_timer): the next quarter
+// frame records the RX -> MTC latency (METRIC_HIST_RX_TO_MTC)
+void mtcNoteSampleRx(uint32_t rxTimeUs);
+bool mtcRunning();
+uint32_t mtcPosition();
@@ -7,20 +7,93 @@
 #define MAX_LAYER_LENGTH 16
 #define MAX_VERSION_LENGTH 8
 #define MAX_SENDERS 10
-#define MAX_RECEIVERS 10
+#define MAX_RECEIVERS 48
+#define SENDER_INDEX_SIZE 32    // MAC hash cells for senderTable (power of two, >= 2x MAX_SENDERS)
+#define RECEIVER_INDEX_SIZE 128 // MAC hash cells for receiverTable (power of two, >= 2x MAX_RECEIVERS)
+#define ESPNOW_MAX_UNICAST_PEERS 19  // ESP-NOW peer limit (20) minus the broadcast peer
+#define MAX_LAYER_IDS 32        // Sender layer registry size (IDs 1..MAX_LAYER_IDS on the air)
 #define RECEIVER_TIMEOUT_MS 5000
 #define SENDER_TIMEOUT_MS 5000
 #define RECEIVER_BEACON_INTERVAL_MS 1000
 #define SENDER_BEACON_INTERVAL_MS 1000
 #define BRIDGE_REPORT_INTERVAL_MS 500
 #define DEFAULT_RECEIVER_LAYER "-"
+#define RX_QUEUE_SIZE 16  // ESP-NOW RX ring depth (power of two)
+#define TABLE_CLEANUP_INTERVAL_MS 500  // Sender/receiver table timeout checks
+#define MESH_CLOCK_LOOP_INTERVAL_MS 100  // meshClock.loop() cadence (was every 10ms tick)
 
 // ============= MEDIA SYNC CONFIGURATION =============
 // Interval for repeating CC#100 while playing (0 = disable auto-repeat)
 #define CC100_REPEAT_INTERVAL_MS 1000
+// Send one broadcast MediaSyncPacket per layer instead of one unicast per receiver
+// (receivers filter on layer). Set to 0 to restore per-receiver unicast.
+#define MEDIA_SYNC_BROADCAST 1
+// Sync frames and sender beacons repeat the sender's last N layer transitions
+// (play/stop or media index change) so a receiver that lost the frame carrying
+// one applies it from the next frame it hears (see sync_redundancy.h).
+// 0 disables the trailer; receivers accept frames with or without it.
+#ifndef MEDIA_SYNC_REDUNDANCY_DEPTH
+#define MEDIA_SYNC_REDUNDANCY_DEPTH 3
+#endif
+
+// Sender-side rate control (see sync_rate.h). A state or media index change, or
+// a position jump beyond SYNC_DISCONTINUITY_MS, is sent right away and repeated
+// SYNC_BURST_REPEATS times SYNC_BURST_SPACING_MS apart. Unchanged frames for a
+// layer whose receivers all report lock (or that is stopped) are forwarded at
+// most every SYNC_STEADY_INTERVAL_MS; 0 forwards everything the Bridge sends.
+#define SYNC_BURST_REPEATS 2
+#define SYNC_BURST_SPACING_MS 5
+#define SYNC_BURST_SLOTS 4  // Layers bursting at the same time
+#define SYNC_DISCONTINUITY_MS 250
+#define SYNC_STEADY_INTERVAL_MS 500
+
+// Frame-accurate transport changes (scheduled_action.h). The sender stamps each
+// layer transition (play/stop, media index) with an execution time
+// SYNC_ACTION_LEAD_MS ahead, carried in the redundancy trailer; receivers hold
+// the layer until that mesh instant and apply it from a timer, so they all cut
+// together whatever order their frames arrived in. 0 applies transitions on
+// arrival. Needs MEDIA_SYNC_REDUNDANCY_DEPTH > 0.
+#define SYNC_ACTION_LEAD_MS 50
+// Execution times further ahead than this are not trusted (clock step) and
+// applied at once
+#define SYNC_ACTION_MAX_HOLD_MS 250
+#define SCHEDULED_ACTION_SLOTS 4  // Pending actions (one per sender and layer)
+
+// ============= ESP-NOW TX (espnow_tx.h) =============
+// Frames handed to the driver and not yet confirmed by the send callback;
+// beyond this (or on ESP_ERR_ESPNOW_NO_MEM) frames wait in our own queue
+#define ESPNOW_TX_MAX_INFLIGHT 6
+#define ESPNOW_TX_POOL_SLOTS 24    // Queued frames, all peers together
+#define ESPNOW_TX_PEER_DEPTH 4     // Queued frames per peer (a dead peer cannot fill the pool)
+#define ESPNOW_TX_PEERS 64         // Peers with TX counters (receivers + senders + broadcast)
+// Send callbacks lost (driver reset, channel switch): give the in-flight
+// budget back after this long without one
+#define ESPNOW_TX_INFLIGHT_TIMEOUT_MS 100
 
 // ============= LOGGING CONFIGURATION =============
+// Levels and categories are in nowde_log.h
 #define DEBUG_SERIAL Serial
+#define LOG_DEFER_SLOTS 32        // Deferred log ring (power of two)
+#define LOG_FLUSH_INTERVAL_MS 50  // How often the flush task prints the ring
+
+// ============= USB MIDI TASK =============
+// Max time to wait for room in the USB MIDI TX FIFO (or TX queue) before dropping a SysEx
+#define MIDI_TX_TIMEOUT_MS 20
+// TX chunks (48 bytes each) queued for the MIDI task; longer output makes the
+// writer wait for the MIDI task (up to MIDI_TX_TIMEOUT_MS per chunk)
+#define MIDI_TX_QUEUE_DEPTH 16
+// The MIDI task sleeps until TinyUSB reports RX or a TX chunk is queued; this
+// bounds the sleep in case a notification is missed
+#define MIDI_TASK_IDLE_WAIT_MS 50
+// Max time to get queued replies (OTA COMPLETE) to USB before a reboot
+#define OTA_REBOOT_FLUSH_MS 500
+#define MIDI_TASK_CORE 0
+#define MIDI_TASK_STACK_SIZE 4096
+#define ESPNOW_TASK_STACK_SIZE 8192
+#define LOG_TASK_STACK_SIZE 3072
+#define OTA_FLASH_TASK_STACK_SIZE 4096
+// Arduino loopTask: runs setup(), then loop() only sleeps (core default 8192)
+#define LOOP_TASK_STACK_SIZE 4096
 
 // ============= MESH CLOCK SYNC =============
 #define TRANSMISSION_DELAY_US 1300
@@ -29,6 +102,8 @@
 #define SYSEX_START 0xF0
 #define SYSEX_END 0xF7
 #define SYSEX_MANUFACTURER_ID 0x7D
+// Largest buffered (non-streamed) message, see sysex_stream.h; RUNNING_STATE is ~350B
+#define SYSEX_STREAM_BUFFER_SIZE 512
 
 // Bridge → Nowde Direct (0x01-0x0F)
 #define SYSEX_CMD_QUERY_CONFIG 0x01
@@ -38,18 +113,93 @@
 #define SYSEX_CMD_OTA_BEGIN 0x05
 #define SYSEX_CMD_OTA_DATA 0x06
 #define SYSEX_CMD_OTA_END 0x07
+#define SYSEX_CMD_OTA2_BEGIN 0x08  // Windowed OTA (see ota.h)
+#define SYSEX_CMD_OTA2_DATA 0x09
+#define SYSEX_CMD_OTA2_END 0x0A
+#define SYSEX_CMD_RUN_BENCHMARK 0x0B  // [testMask(1), optional]: on-device benchmarks (see benchmark.h)
+#define SYSEX_CMD_SUBSCRIBE_RUNNING_STATE 0x0C  // [enable(1)]: push RUNNING_STATE_DELTA instead of polling
+#define SYSEX_CMD_CHANNEL_SURVEY 0x0D  // [mode(1)] [channel(1), CHANNEL_SURVEY_FORCE only] (see channel.h)
+#define SYSEX_CMD_QUERY_DIAGNOSTICS 0x0E  // Answered by DIAGNOSTICS (see diagnostics.h)
+#define SYSEX_CMD_PHANTOM_RECEIVERS 0x0F  // [count(1)] [layerCount(1)] [layer(16)]...: load test (see phantom.h)
 
 // Bridge → Receivers via Sender (0x10-0x1F)
 #define SYSEX_CMD_MEDIA_SYNC 0x10
 #define SYSEX_CMD_CHANGE_RECEIVER_LAYER 0x11
+#define SYSEX_CMD_MEDIA_SYNC_BATCH 0x12
 
 // Nowde → Bridge Responses (0x20-0x3F)
 #define SYSEX_CMD_HELLO 0x20
 #define SYSEX_CMD_CONFIG_STATE 0x21
 #define SYSEX_CMD_RUNNING_STATE 0x22
 #define SYSEX_CMD_OTA_ACK 0x23
+#define SYSEX_CMD_METRICS 0x24  // Counters + latency histograms (see metrics.h)
+#define SYSEX_CMD_MESH_OTA_STATUS 0x25
+#define SYSEX_CMD_RUNNING_STATE_DELTA 0x26  // Subscribed receiver table changes (see running_state.h)
+#define SYSEX_CMD_BENCHMARK_RESULT 0x27     // One per benchmark run
+#define SYSEX_CMD_CHANNEL_SURVEY_REPORT 0x28  // Per-channel interference after a survey
+#define SYSEX_CMD_DIAGNOSTICS 0x29            // Heap, table footprint and task stack high-water marks
+#define SYSEX_CMD_PHANTOM_REPORT 0x2A         // Per phantom receiver sync arrival and latency
 #define SYSEX_CMD_ERROR_REPORT 0x30
 
+// RUNNING_STATE_DELTA: F0 7D 26 [uptimeMs(4,encoded:5)] [meshSynced(1)] [flags(1)] [seq(1)]
+//   [totalReceivers(1)] [opCount(1)] ops... F7, seq counts messages modulo 128
+#define RUNNING_STATE_DELTA_FLAG_RESET 0x01  // Drop every slot before applying the ops
+#define RUNNING_STATE_DELTA_FLAG_MORE 0x02   // More messages of the same pass follow
+#define RUNNING_STATE_OP_JOIN 0x01    // [slot] [receiver block, encoded:76]
+#define RUNNING_STATE_OP_UPDATE 0x02  // [slot] [lastSeen(4) mediaIndex(1), encoded:6] [reports, encoded:34]
+#define RUNNING_STATE_OP_LEAVE 0x03   // [slot]
+
+// BENCHMARK_RESULT: F0 7D 27 [benchmarkId] [param(2) samples(2) minNs(4) avgNs(4) maxNs(4), encoded:19] F7
+enum BenchmarkId : uint8_t {
+  BENCH_CODEC_DECODE = 0,  // decode7bit of one encoded OTA2 chunk (param: encoded bytes)
+  BENCH_CODEC_ENCODE,      // encode7bit of one OTA2 chunk (param: raw bytes)
+  BENCH_SYSEX_PARSE,       // MEDIA_SYNC_BATCH through its stream handler (param: layers)
+  BENCH_RUNNING_STATE,     // sendRunningState(), USB transfer included (param: receivers)
+  BENCH_MTC_ERROR,         // |estimate - truth| at each simulated QF (param: max RF delay ms)
+  BENCH_COUNT
+};
+#define BENCHMARK_ALL_MASK ((1 << BENCH_COUNT) - 1)
+#define BENCHMARK_ITERATIONS 200        // Timed runs per micro-benchmark
+#define BENCHMARK_RUNNING_STATE_RUNS 10  // Each one is a full USB message
+#define BENCHMARK_SIM_DURATION_MS 30000  // Simulated playback for BENCH_MTC_ERROR
+#define BENCHMARK_SIM_SAMPLE_INTERVAL_MS 100  // Bridge MEDIA_SYNC rate
+#define BENCHMARK_SIM_MAX_DELAY_MS 6000  // Clamp for rfSimMaxDelayMs (bounds in-flight samples)
+#define BENCHMARK_SIM_POSITION_JITTER_MS 10   // +/- noise on reported positions (Millumin OSC)
+
+// OTA_ACK status codes (F0 7D 23 [status] [nextSeq(3 x 7-bit)] F7)
+#define OTA_STATUS_ACK 0x00       // All chunks before nextSeq received
+#define OTA_STATUS_NACK 0x01      // Resend starting at nextSeq
+#define OTA_STATUS_READY 0x02     // OTA2_BEGIN accepted
+#define OTA_STATUS_COMPLETE 0x03  // Image verified, rebooting
+#define OTA_STATUS_ERR_BEGIN 0x10
+#define OTA_STATUS_ERR_FLASH 0x11
+#define OTA_STATUS_ERR_SIZE 0x12
+#define OTA_STATUS_ERR_HASH 0x13
+#define OTA_STATUS_ERR_STATE 0x14  // No OTA session in progress
+
+// OTA v2 transfer parameters (the Bridge uses the same chunk size)
+#define OTA2_CHUNK_SIZE 192            // Payload bytes per OTA2_DATA (+CRC32 encodes to 224)
+#define OTA2_FLASH_BUFFER_SIZE 4096    // Two of these alternate between USB and flash task
+#define OTA2_ACK_INTERVAL 4            // Cumulative ACK every N in-order chunks
+#define OTA2_BUFFER_WAIT_MS 50         // Max wait for a free flash buffer before NACKing
+
+// OTA2_BEGIN optional target byte
+#define OTA_TARGET_SELF 0   // Update this Nowde only (default)
+#define OTA_TARGET_MESH 1   // Relay to receivers over ESP-NOW, keep running current firmware
+#define OTA_TARGET_BOTH 2   // Relay, then reboot into the new image
+
+// Mesh OTA (sender relays a verified image to receivers over ESP-NOW)
+#define MESH_OTA_CHUNK_SIZE 240          // Image bytes per ESPNOW_MSG_OTA_CHUNK
+#define MESH_OTA_MAX_CHUNKS 32768        // 7.5 MB, larger than any app partition
+#define MESH_OTA_STATUS_BITMAP_BYTES 128 // Missing chunks reported per status (1024)
+#define MESH_OTA_FRAME_INTERVAL_MS 4     // Chunk broadcast pacing
+#define MESH_OTA_ANNOUNCE_INTERVAL_MS 500
+#define MESH_OTA_JOIN_TIMEOUT_MS 20000   // Max wait for receivers to erase their OTA partition
+#define MESH_OTA_POLL_WAIT_MS 400        // Time to collect statuses after a repair poll
+#define MESH_OTA_MAX_ROUNDS 50          // Repair polls before giving up
+#define MESH_OTA_RX_TIMEOUT_MS 30000     // Receiver gives up when the sender goes quiet
+#define MESH_OTA_REBOOT_DELAY_MS 3000    // Receiver reboot delay after a verified image
+
 // Error codes for ERROR_REPORT
 #define ERROR_CONFIG_INVALID 0x01
 #define ERROR_SYSEX_PARSE_ERROR 0x02
@@ -62,10 +212,184 @@
 #define ESPNOW_MSG_SENDER_BEACON 0x01
 #define ESPNOW_MSG_RECEIVER_INFO 0x02
 #define ESPNOW_MSG_MEDIA_SYNC 0x03
+#define ESPNOW_MSG_MEDIA_SYNC_BATCH 0x04
+#define ESPNOW_MSG_OTA_ANNOUNCE 0x05  // Sender -> all: mesh OTA session info / repair poll
+#define ESPNOW_MSG_OTA_CHUNK 0x06     // Sender -> all: one image chunk
+#define ESPNOW_MSG_OTA_STATUS 0x07    // Receiver -> sender: progress + missing-chunk bitmap
+#define ESPNOW_MSG_METRICS 0x08       // Receiver -> sender: MetricsSnapshot
+
+// RF simulation link (see rf_sim.h)
+#define RF_SIM_MAX_PACKETS 64       // Frames in flight (10 receivers x 10 Hz x 400 ms = 40)
+#define RF_SIM_TICK_MS 1            // Timing wheel resolution
+#define RF_SIM_WHEEL_SLOTS 256      // Longer delays wrap around the wheel
+#define RF_SIM_REORDER_HOLD_MS 150  // Extra delay of a reordered frame (> one sync interval)
+
+// Phantom receivers, emulated by the sender for load tests (see phantom.h)
+#define PHANTOM_MAX_RECEIVERS MAX_RECEIVERS  // They take real receiverTable slots
+#define PHANTOM_MAX_LAYERS 8                 // Layers in one PHANTOM_RECEIVERS request
+#define PHANTOM_DEFAULT_LAYER "phantom"      // When the request names no layer
+#define PHANTOM_BEACON_JITTER_MS 200         // Added to RECEIVER_BEACON_INTERVAL_MS, as a real receiver does
+#define PHANTOM_REPORT_INTERVAL_MS 2000      // PHANTOM_REPORT cadence while running
+
+// Max layers per MEDIA_SYNC_BATCH. USB input is streamed, so the limit is the
+// ESP-NOW frame (6 + 7 bytes per layer <= 250, checked below)
+#define MEDIA_SYNC_BATCH_MAX_LAYERS 10
+
+// ============= RUNNING STATE SUBSCRIPTION =============
+#define RUNNING_STATE_PUSH_INTERVAL_MS 200  // Change detection cadence while subscribed
+#define RUNNING_STATE_HEARTBEAT_MS 1000     // Empty delta when nothing changed for this long
+#define RUNNING_STATE_REFRESH_MS 5000       // Re-send a receiver's reports at least this often
+#define RUNNING_STATE_STALE_MS 3000         // lastSeen crossing this is a change (Bridge MISSING)
+#define RUNNING_STATE_DELTA_MAX_BYTES 256   // Split ops over several messages past this
+
+// ============= CHANNEL MANAGEMENT =============
+// Every ESP-NOW peer is registered with channel 0 (= the current home channel),
+// so the whole mesh moves with esp_wifi_set_channel (see channel.h)
+#define CHANNEL_DEFAULT 1
+#define CHANNEL_MAX 11                  // Highest channel surveyed or used (allowed in every region)
+#define CHANNEL_SURVEY_DWELL_MS 120     // Passive scan time per channel
+#define CHANNEL_SURVEY_ON_START 1       // Survey and pick a channel when sender mode starts
+#define CHANNEL_SWITCH_MARGIN_DB 6      // Move only for at least this much less interference...
+#define CHANNEL_LOSS_SWITCH_PERCENT 10  // ...or when unicast loss on the current channel is above this
+#define CHANNEL_SWITCH_LEAD_MS 3000     // Announced this long ahead (three beacons)
+#define CHANNEL_TICK_MS 250             // SCHED_CHANNEL cadence: survey polling, re-acquire
+#define CHANNEL_REACQUIRE_MS 8000       // Receiver without any sender this long starts scanning
+#define CHANNEL_SCAN_DWELL_MS 1200      // Time per channel while scanning (> SENDER_BEACON_INTERVAL_MS)
+
+#define CHANNEL_SURVEY_REPORT_ONLY 0  // SYSEX_CMD_CHANNEL_SURVEY modes
+#define CHANNEL_SURVEY_AUTO 1         // Survey, then switch if a channel is clearly better
+#define CHANNEL_SURVEY_FORCE 2        // Switch to the given channel without a survey
+
+// ============= PERSISTENCE =============
+#define PROFILE_VERSION 1
+#define PROFILE_COMMIT_DEBOUNCE_MS 2000  // Quiet time after the last change before the profile is written
+#define PROFILE_TASK_STACK_SIZE 4096
+#define PROFILE_FLAG_RF_SIMULATION 0x01
+#define PROFILE_FLAG_STOP_ON_LINK_LOST 0x02
+
+#define CC100_DEFAULT_CHANNEL 1  // MIDI channel (1-16) for CC#100 output
+
+// ============= METRICS =============
+#define METRICS_SEND_INTERVAL_MS 2000    // Receiver -> sender MetricsPacket cadence
+#define METRICS_REPORT_INTERVAL_MS 1000  // Min spacing of METRICS SysEx bursts to the Bridge
+#define METRIC_HIST_BUCKETS 16           // Bucket 0: < 64 us, bucket i: [64 << (i-1), 64 << i) us
+#define METRIC_HIST_BASE_US 64
+
+// Counters and histograms (append only: the Bridge indexes them by position)
+enum MetricCounter : uint8_t {
+  METRIC_USB_SYSEX_RX = 0,   // SysEx messages received over USB
+  METRIC_ESPNOW_TX_OK,       // onDataSent success
+  METRIC_ESPNOW_TX_FAIL,     // onDataSent failure (unicast not acknowledged)
+  METRIC_SYNC_TX,            // MediaSync / batch frames sent (sender)
+  METRIC_SYNC_RX,            // Sync samples applied (receiver)
+  METRIC_SYNC_CORRECTED,     // Desynced samples rescued with the beacon offset
+  METRIC_DISCARD_DESYNC,     // Dropped: timestamp beyond CLOCK_DESYNC_THRESHOLD_MS
+  METRIC_DISCARD_SENDER,     // Dropped: unknown sender or layer ID not announced yet
+  METRIC_DISCARD_MALFORMED,  // Dropped: truncated sync frame
+  METRIC_RX_QUEUE_DROPPED,   // ESP-NOW RX ring overflows
+  METRIC_LINK_LOST,          // Receiver went LINK_LOST while playing
+  METRIC_RF_SIM_OVERFLOW,    // RF simulation queue full, frame not simulated
+  METRIC_USB_TX_DROPPED,     // USB MIDI TX chunks dropped (queue full, FIFO stalled or unmounted)
+  METRIC_SYNC_RECOVERED,     // Missed transitions applied from a redundancy trailer (receiver)
+  METRIC_SYNC_SUPPRESSED,    // Unchanged layer states not forwarded (steady-state backoff, sender)
+  METRIC_CHANNEL_SWITCH,     // Home channel changes (coordinated switch or re-acquire scan hop)
+  METRIC_ESPNOW_TX_COALESCED,  // Queued sync frames replaced by a newer one for the same peer and layer
+  METRIC_ESPNOW_TX_DROPPED,    // Frames dropped by the TX layer (peer queue or pool full, send error)
+  METRIC_MTC_QF_LATE,          // MTC quarter frames late (timer tick missed) or replaced before reaching USB
+  METRIC_USB_TX_TRUNCATED,     // USB MIDI SysEx cut short by a dropped chunk and closed with an F7
+  METRIC_COUNTER_COUNT
+};
+
+enum MetricHistogram : uint8_t {
+  METRIC_HIST_USB_TO_ESPNOW = 0,  // SysEx start on USB -> esp_now_send (sender)
+  METRIC_HIST_RX_TO_MTC,          // ESP-NOW RX callback -> next MTC quarter frame (receiver)
+  METRIC_HIST_SYNC_DELTA,         // |meshMillis - meshTimestamp| of received sync (receiver)
+  METRIC_HIST_COUNT
+};
 
 // ============= DATA STRUCTURES =============
+// Everything a Nowde keeps across reboots, stored as one NVS blob (storage.h).
+// Bump PROFILE_VERSION when the layout changes: other versions load as defaults.
+struct DeviceProfile {
+  uint8_t version;
+  char layer[MAX_LAYER_LENGTH];  // Subscribed layer (receiver)
+  uint8_t channel;               // ESP-NOW home channel
+  uint8_t cc100Channel;          // MIDI channel of CC#100 output, 1-16
+  uint8_t flags;                 // PROFILE_FLAG_*
+  uint16_t rfSimMaxDelayMs;
+  uint8_t rfSimLossPercent;
+  uint8_t rfSimReorderPercent;
+  uint8_t rfSimOutagePerMille;
+  uint16_t rfSimOutageMs;
+} __attribute__((packed));
+
+// Layer ID assignment published by a sender (receivers match on layerHash())
+struct LayerIdEntry {
+  uint8_t id;
+  uint32_t layerHash;
+} __attribute__((packed));
+
+// Only the first `layerCount` entries are transmitted
 struct SenderBeacon {
   uint8_t type = ESPNOW_MSG_SENDER_BEACON;
+  uint32_t meshTimestamp;  // Sender's meshMillis() at send (per-sender offset estimate)
+  uint8_t layerCount = 0;
+  LayerIdEntry layers[MAX_LAYER_IDS];
+} __attribute__((packed));
+
+static_assert(sizeof(SenderBeacon) <= 250, "SenderBeacon exceeds ESP-NOW payload");
+
+#define CHANNEL_INFO_MAGIC 0xC3
+
+// Beacon extension right after the layer entries (older receivers stop before it)
+struct ChannelInfo {
+  uint8_t magic = CHANNEL_INFO_MAGIC;
+  uint8_t channel;        // Sender's home channel
+  uint8_t nextChannel;    // Coordinated switch target, 0 = none pending
+  uint32_t switchAtMesh;  // Sender meshMillis() at which everyone switches
+} __attribute__((packed));
+
+#define SYNC_EST_FLAG_LOCKED 0x01    // Estimator converged (low jitter, no recent re-anchor)
+#define SYNC_EST_FLAG_TRACKING 0x02  // Estimator anchored to a playing sender
+
+// Receiver position estimator state, reported to the sender and on to the Bridge
+struct SyncEstimatorReport {
+  uint8_t flags;           // SYNC_EST_FLAG_*
+  int16_t errorTenthsMs;   // Error of the last sample against the estimate (0.1 ms)
+  uint16_t jitterTenthsMs; // Smoothed absolute error (0.1 ms)
+  int16_t ratePpm;         // Rate trim applied on top of 1.0
+  uint16_t outliers;       // Rejected samples since boot
+  uint16_t jumps;          // Hard re-anchors (seeks) since boot
+} __attribute__((packed));
+
+#define CLOCK_REPORT_FLAG_MESH_SYNCED 0x01  // Receiver's meshClock reports SYNCED
+#define CLOCK_REPORT_FLAG_OFFSET_VALID 0x02  // Receiver has a beacon offset for this sender
+
+// Receiver's view of its clock against the sender the report is sent to
+struct ClockReport {
+  uint8_t flags;            // CLOCK_REPORT_FLAG_*
+  int16_t senderOffsetMs;   // Sender mesh time minus receiver mesh time
+  uint16_t corrected;       // Desynced sync packets rescued with the offset since boot
+  uint16_t discarded;       // Sync packets dropped for desync since boot
+} __attribute__((packed));
+
+// Receiver link quality, per sender for RSSI and over the last ReceiverInfo
+// interval for the sync counts (position error is in SyncEstimatorReport)
+struct LinkReport {
+  int8_t rssiAvgDbm;       // Mean RSSI of frames from this sender (0 = none heard)
+  int8_t rssiMinDbm;       // Weakest frame from this sender
+  uint16_t syncReceived;   // Sync samples applied in the window
+  uint16_t syncDiscarded;  // Sync frames dropped in the window (any reason)
+  uint16_t linkLost;       // LINK_LOST events since boot
+  uint16_t windowMs;       // Length of the window
+} __attribute__((packed));
+
+// Sender-side TX counters for one peer, since it was first sent to
+// (espnow_tx.h); broadcast frames are always reported as delivered
+struct TxReport {
+  uint32_t delivered;  // Send callback success
+  uint32_t failed;     // Send callback failure (unicast not acknowledged) or send error
+  uint16_t dropped;    // Queue overflow or replaced by a newer sync frame (saturates)
 } __attribute__((packed));
 
 struct ReceiverInfo {
@@ -73,31 +397,156 @@ struct ReceiverInfo {
   char layer[MAX_LAYER_LENGTH];
   char version[MAX_VERSION_LENGTH];
   uint8_t mediaIndex;  // Current playing media index (0 = stopped)
+  SyncEstimatorReport sync;  // Absent from older receivers
+  ClockReport clock;         // Absent from older receivers
+  LinkReport link;           // Absent from older receivers
 } __attribute__((packed));
 
 struct MediaSyncPacket {
   uint8_t type = ESPNOW_MSG_MEDIA_SYNC;
-  char layer[MAX_LAYER_LENGTH];
+  uint8_t layerId;  // Sender's layer ID (see SenderBeacon)
   uint8_t mediaIndex;
   uint32_t positionMs;
   uint8_t state;
   uint32_t meshTimestamp;
 } __attribute__((packed));
 
+// One layer state inside a MediaSyncBatchPacket
+struct MediaSyncBatchEntry {
+  uint8_t layerId;
+  uint8_t mediaIndex;
+  uint32_t positionMs;
+  uint8_t state;
+} __attribute__((packed));
+
+// All active layers in one frame, timestamped at the same mesh instant.
+// Only the first `count` entries are transmitted.
+struct MediaSyncBatchPacket {
+  uint8_t type = ESPNOW_MSG_MEDIA_SYNC_BATCH;
+  uint32_t meshTimestamp;
+  uint8_t count;
+  MediaSyncBatchEntry entries[MEDIA_SYNC_BATCH_MAX_LAYERS];
+} __attribute__((packed));
+
+static_assert(sizeof(MediaSyncBatchPacket) <= 250, "MediaSyncBatchPacket exceeds ESP-NOW payload");
+
+// One layer transition as the sender saw it. `sequence` counts transitions per
+// layer ID, so a receiver can tell a transition it has not applied yet.
+struct SyncTransition {
+  uint8_t layerId;
+  uint8_t sequence;
+  uint8_t mediaIndex;
+  uint8_t state;
+  uint32_t positionMs;
+  uint32_t meshTimestamp;  // Sender's meshMillis() at which receivers apply it (SYNC_ACTION_LEAD_MS
+                           // after it went out); positionMs is the position at that instant
+} __attribute__((packed));
+
+static_assert(SYNC_ACTION_LEAD_MS == 0 || MEDIA_SYNC_REDUNDANCY_DEPTH > 0,
+              "scheduled transitions travel in the redundancy trailer");
+
+#define SYNC_REDUNDANCY_MAGIC 0xA5
+
+// Appended after a MediaSyncPacket, a batch's last entry or a beacon's
+// ChannelInfo; older receivers stop parsing before it. Newest transition first,
+// only the first `count` are transmitted.
+struct SyncRedundancyTrailer {
+  uint8_t magic = SYNC_REDUNDANCY_MAGIC;
+  uint8_t count = 0;
+  SyncTransition transitions[MEDIA_SYNC_REDUNDANCY_DEPTH > 0 ? MEDIA_SYNC_REDUNDANCY_DEPTH : 1];
+} __attribute__((packed));
+
+// Largest sync frame on the air (RF simulation buffers are sized by it)
+constexpr size_t SYNC_FRAME_MAX_LEN = sizeof(MediaSyncBatchPacket) + sizeof(SyncRedundancyTrailer);
+
+static_assert(SYNC_FRAME_MAX_LEN <= 250, "Sync frame with redundancy trailer exceeds ESP-NOW payload");
+static_assert(sizeof(SenderBeacon) + sizeof(ChannelInfo) + sizeof(SyncRedundancyTrailer) <= 250,
+              "SenderBeacon with extensions exceeds ESP-NOW payload");
+
+// Cumulative since boot; histogram buckets wrap at 16 bits (consumers diff them)
+struct MetricsSnapshot {
+  uint32_t uptimeMs;
+  uint32_t counters[METRIC_COUNTER_COUNT];
+  uint16_t histograms[METRIC_HIST_COUNT][METRIC_HIST_BUCKETS];
+} __attribute__((packed));
+
+struct MetricsPacket {
+  uint8_t type = ESPNOW_MSG_METRICS;
+  MetricsSnapshot snapshot;
+} __attribute__((packed));
+
+static_assert(sizeof(MetricsPacket) <= 250, "MetricsPacket exceeds ESP-NOW payload");
+
+// Mesh OTA session announce, also sent as a poll during repair rounds
+struct MeshOtaAnnounce {
+  uint8_t type = ESPNOW_MSG_OTA_ANNOUNCE;
+  uint32_t sessionId;
+  uint32_t imageSize;
+  uint16_t chunkSize;
+  uint16_t chunkCount;
+  uint8_t sha256[32];
+  uint8_t poll;  // 0 = join phase, 1 = repair poll (report missing chunks)
+} __attribute__((packed));
+
+struct MeshOtaChunkHeader {
+  uint8_t type = ESPNOW_MSG_OTA_CHUNK;
+  uint32_t sessionId;
+  uint16_t index;
+} __attribute__((packed));
+
+enum MeshOtaRxState : uint8_t {
+  MESH_OTA_RX_IDLE = 0,
+  MESH_OTA_RX_JOINING,    // Erasing the OTA partition
+  MESH_OTA_RX_RECEIVING,
+  MESH_OTA_RX_DONE,       // Verified, boot partition set
+  MESH_OTA_RX_FAILED
+};
+
+// Selective repeat: bit i set = chunk (baseIndex + i) still missing
+struct MeshOtaStatus {
+  uint8_t type = ESPNOW_MSG_OTA_STATUS;
+  uint32_t sessionId;
+  uint8_t state;
+  uint16_t received;
+  uint16_t baseIndex;
+  uint8_t missing[MESH_OTA_STATUS_BITMAP_BYTES];
+} __attribute__((packed));
+
+static_assert(sizeof(MeshOtaChunkHeader) + MESH_OTA_CHUNK_SIZE <= 250, "Mesh OTA chunk exceeds ESP-NOW payload");
+static_assert(sizeof(MeshOtaStatus) <= 250, "MeshOtaStatus exceeds ESP-NOW payload");
+
+// Table entries are ordered widest field first and keep their flags in
+// bitfields, so per-slot padding stays out of the tables (see DIAGNOSTICS)
 struct SenderEntry {
-  uint8_t mac[6];
   unsigned long lastSeen;
-  bool active;
+  int32_t clockOffsetMs;          // Sender mesh time minus ours, from beacons
+  unsigned long clockOffsetTime;  // millis() of the last offset sample
+  int32_t rssiSum;    // RSSI of frames heard since the last ReceiverInfo
+  uint16_t rssiCount;
+  uint8_t mac[6];
+  uint8_t layerId;  // This sender's ID for subscribedLayer (0 = not announced)
+  int8_t rssiMin;
+  uint8_t transitionSeq;       // Last SyncTransition::sequence seen for our layer
+  bool active : 1;
+  bool clockOffsetValid : 1;
+  bool transitionSeqValid : 1;
 };
 
 struct ReceiverEntry {
+  unsigned long lastSeen;
+  int16_t nextInLayer;   // Next slot in the same layer chain (-1 = end)
+  uint16_t version;      // Firmware major.minor (versionPack), 0 = unknown
   uint8_t mac[6];
   char layer[MAX_LAYER_LENGTH];
-  char version[MAX_VERSION_LENGTH];
-  unsigned long lastSeen;
-  bool active;
-  bool connected;
+  SyncEstimatorReport sync;  // Last estimator report (zero for older receivers)
+  ClockReport clock;         // Last clock report (zero for older receivers)
+  LinkReport link;           // Last link report (zero for older receivers)
+  TxReport tx;               // Our TX counters towards it, refreshed by the table cleanup
+  int8_t uplinkRssiDbm;      // RSSI of this receiver's last ReceiverInfo here
   uint8_t mediaIndex;  // Current playing media index (0 = stopped)
+  uint8_t layerId;       // Registry ID for layer, maintained by peer_table
+  bool active : 1;
+  bool connected : 1;
 };
 
 struct MediaSyncState {
@@ -105,8 +554,6 @@ struct MediaSyncState {
   uint32_t currentPositionMs = 0;
   uint8_t currentState = 0;
   unsigned long lastSyncTime = 0;
-  unsigned long localClockStartTime = 0;  // When local clock started running
-  unsigned long lastMTCUpdateTime = 0;    // Last MTC send time
   bool linkLost = false;
   bool stopOnLinkLost = true;  // Configurable: stop or continue on link lost
   uint8_t lastSentIndex = 255;
@@ -114,5 +561,25 @@ struct MediaSyncState {
 };
 
 constexpr uint8_t MTC_FRAMERATE = 30;
+constexpr uint8_t MTC_RATE_CODE = 3;                // Rate bits in QF piece 7 / full frame: 3 = 30fps non-drop
+constexpr uint32_t MTC_RELOCATE_THRESHOLD_MS = 100;  // Position jump that triggers a full-frame locate
 constexpr uint32_t LINK_LOST_TIMEOUT_MS = 10000;  // 10 seconds - increased tolerance for temporary sync gaps
 constexpr uint32_t CLOCK_DESYNC_THRESHOLD_MS = 200;
+// Correct out-of-threshold MediaSync timestamps with a per-sender clock offset
+// learned from beacons instead of discarding them (0 = always discard)
+#define CLOCK_DESYNC_ADAPTIVE 1
+constexpr uint32_t SENDER_OFFSET_RESET_MS = 50;     // Beacon sample this far off restarts the offset estimate
+constexpr uint32_t SENDER_OFFSET_MAX_AGE_MS = 5000; // Offset unusable without a fresh beacon
+// Keep the last sync state in RTC memory and resume MTC from it after a warm
+// reset (panic, watchdog, brown-out, software reboot) instead of waiting for
+// the next sync packet and the mesh clock (warm_boot.h)
+#define WARM_BOOT_RESUME 1
+
+// Receiver position estimator (sync_estimator.h)
+constexpr uint32_t SYNC_EST_OUTLIER_MIN_MS = 15;        // Smallest outlier gate
+constexpr uint8_t SYNC_EST_OUTLIER_JITTER_MULT = 4;     // Gate = max(min, mult * jitter)
+constexpr uint8_t SYNC_EST_CONFIRM_SAMPLES = 2;         // Consistent rejected samples that force a re-anchor
+constexpr uint32_t SYNC_EST_MAX_SLEW_US = 2000;         // Max phase correction per accepted sample
+constexpr int32_t SYNC_EST_MAX_RATE_PPM = 1000;         // Rate trim limit
+constexpr uint32_t SYNC_EST_LOCK_JITTER_US = 5000;      // Jitter below which the estimator reports lock
+constexpr uint8_t SYNC_EST_LOCK_SAMPLES = 10;           // Accepted samples in a row needed for lock
@@ -0,0 +1,80 @@
+#include "nowde_log.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace {
+
+struct DeferredEntry {
+  const char* format;
+  uintptr_t args[LOG_DEFER_MAX_ARGS];
+};
+
+// Single ring shared by all producers; writers and the flush task only hold
+// logMux long enough to copy one entry
+portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+DeferredEntry ring[LOG_DEFER_SLOTS];
+uint16_t head = 0;  // Next slot to write
+uint16_t tail = 0;  // Next slot to print
+uint32_t dropped = 0;
+
+static_assert((LOG_DEFER_SLOTS & (LOG_DEFER_SLOTS - 1)) == 0, "LOG_DEFER_SLOTS must be a power of two");
+
+void flushTask(void* parameter) {
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(LOG_FLUSH_INTERVAL_MS));
+    logFlush();
+  }
+}
+
+}  // namespace
+
+void logInit() {
+  // Lowest useful priority on the application core: formatting only happens
+  // when nothing else wants the CPU
+  xTaskCreatePinnedToCore(flushTask, "Log_Flush", LOG_TASK_STACK_SIZE, NULL, 1, NULL, 1);
+}
+
+void logDeferPush(const char* format, const uintptr_t* args, uint8_t argCount) {
+  portENTER_CRITICAL_SAFE(&logMux);
+  if (static_cast<uint16_t>(head - tail) >= LOG_DEFER_SLOTS) {
+    dropped++;
+  } else {
+    DeferredEntry& entry = ring[head & (LOG_DEFER_SLOTS - 1)];
+    entry.format = format;
+    for (uint8_t i = 0; i < LOG_DEFER_MAX_ARGS; i++) {
+      entry.args[i] = i < argCount ? args[i] : 0;
+    }
+    head++;
+  }
+  portEXIT_CRITICAL_SAFE(&logMux);
+}
+
+void logFlush() {
+  for (;;) {
+    DeferredEntry entry;
+    uint32_t lost = 0;
+    bool have = false;
+
+    portENTER_CRITICAL(&logMux);
+    if (tail != head) {
+      entry = ring[tail & (LOG_DEFER_SLOTS - 1)];
+      tail++;
+      have = true;
+    } else {
+      lost = dropped;
+      dropped = 0;
+    }
+    portEXIT_CRITICAL(&logMux);
+
+    if (!have) {
+      if (lost > 0) {
+        DEBUG_SERIAL.printf("[LOG] %lu deferred message(s) dropped\r\n", static_cast<unsigned long>(lost));
+      }
+      return;
+    }
+    // Unused trailing arguments are ignored by printf
+    DEBUG_SERIAL.printf(entry.format, entry.args[0], entry.args[1], entry.args[2],
+                        entry.args[3], entry.args[4], entry.args[5]);
+  }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include <type_traits>
+
+#include "nowde_config.h"
+
+// Leveled, per-module logging.
+// NOWDE_LOG_LEVEL and NOWDE_LOG_CATEGORIES are compile-time constants (set them
+// in build_flags to change them): a disabled LOG_xxx() is a constant-false
+// branch, so its format string and printf call are dropped from the binary and
+// its arguments are never evaluated.
+//
+// LOG_xxx() prints right away on DEBUG_SERIAL. LOG_DEFER() only copies a
+// format pointer and up to six word-sized arguments into a ring that a low
+// priority task prints later; use it where a UART printf would add latency
+// (WiFi callbacks, per-packet sync handling). Its format must be a string
+// literal and its arguments integers of at most 32 bits (or static strings for
+// %s: only the pointer is stored).
+
+#define NOWDE_LOG_LEVEL_NONE 0
+#define NOWDE_LOG_LEVEL_ERROR 1
+#define NOWDE_LOG_LEVEL_WARN 2
+#define NOWDE_LOG_LEVEL_INFO 3
+#define NOWDE_LOG_LEVEL_DEBUG 4  // Hex dumps, table dumps, per-message chatter
+
+#ifndef NOWDE_LOG_LEVEL
+#define NOWDE_LOG_LEVEL NOWDE_LOG_LEVEL_INFO
+#endif
+
+// Categories (bitmask)
+#define LOG_CAT_CORE (1u << 0)      // Boot, storage, tasks
+#define LOG_CAT_USB (1u << 1)       // USB MIDI transport
+#define LOG_CAT_SYSEX (1u << 2)     // Bridge protocol
+#define LOG_CAT_ESPNOW (1u << 3)    // Radio RX/TX
+#define LOG_CAT_SENDER (1u << 4)    // Receiver table, beacons (sender side)
+#define LOG_CAT_RECEIVER (1u << 5)  // Sender table, sync (receiver side)
+#define LOG_CAT_OTA (1u << 6)       // USB and mesh OTA
+#define LOG_CAT_ALL 0xFFFFu
+
+#ifndef NOWDE_LOG_CATEGORIES
+#define NOWDE_LOG_CATEGORIES LOG_CAT_ALL
+#endif
+
+constexpr bool logEnabled(uint8_t level, uint32_t category) {
+  return level <= NOWDE_LOG_LEVEL && (category & NOWDE_LOG_CATEGORIES) != 0;
+}
+
+#define NOWDE_LOG(level, category, ...)       \
+  do {                                        \
+    if (logEnabled((level), (category))) {    \
+      DEBUG_SERIAL.printf(__VA_ARGS__);       \
+    }                                         \
+  } while (0)
+
+#define LOG_ERROR(category, ...) NOWDE_LOG(NOWDE_LOG_LEVEL_ERROR, category, __VA_ARGS__)
+#define LOG_WARN(category, ...) NOWDE_LOG(NOWDE_LOG_LEVEL_WARN, category, __VA_ARGS__)
+#define LOG_INFO(category, ...) NOWDE_LOG(NOWDE_LOG_LEVEL_INFO, category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) NOWDE_LOG(NOWDE_LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+
+// For multi-line dumps: if (LOG_ENABLED(DEBUG, LOG_CAT_SYSEX)) { ... }
+#define LOG_ENABLED(level, category) logEnabled(NOWDE_LOG_LEVEL_##level, (category))
+
+// Format and argument list for MAC addresses: LOG_INFO(cat, "MAC " LOG_MAC_FMT "\r\n", LOG_MAC_ARGS(mac))
+#define LOG_MAC_FMT "%02X:%02X:%02X:%02X:%02X:%02X"
+#define LOG_MAC_ARGS(mac) (mac)[0], (mac)[1], (mac)[2], (mac)[3], (mac)[4], (mac)[5]
+
+// ============= DEFERRED LOGGING =============
+#define LOG_DEFER_MAX_ARGS 6
+
+void logInit();    // Starts the flush task
+void logFlush();   // Prints everything deferred so far (flush task, or before a reboot)
+void logDeferPush(const char* format, const uintptr_t* args, uint8_t argCount);
+
+// Arguments are stored as machine words (32 bits on the S3), which is what
+// printf reads back for %d / %u / %lu / %x / %s
+template <typename T>
+inline uintptr_t logDeferArg(T value) {
+  static_assert(sizeof(T) <= sizeof(uintptr_t), "LOG_DEFER arguments must fit in a word");
+  static_assert(!std::is_floating_point<T>::value, "LOG_DEFER cannot carry floats");
+  return (uintptr_t)(value);
+}
+
+template <typename... Args>
+inline void logDefer(const char* format, Args... args) {
+  static_assert(sizeof...(Args) <= LOG_DEFER_MAX_ARGS, "LOG_DEFER takes at most 6 arguments");
+  const uintptr_t packed[sizeof...(Args) + 1] = {logDeferArg(args)..., 0};
+  logDeferPush(format, packed, sizeof...(Args));
+}
+
+#define LOG_DEFER(level, category, ...)                     \
+  do {                                                      \
+    if (logEnabled(NOWDE_LOG_LEVEL_##level, (category))) {  \
+      logDefer(__VA_ARGS__);                                \
+    }                                                       \
+  } while (0)
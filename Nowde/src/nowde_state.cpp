@@ -1,5 +1,7 @@
 #include "nowde_state.h"
 
+#include <algorithm>
+
 USBMIDI MIDI;
 Preferences preferences;
 ESPNowMeshClock meshClock(1000, 0.25, 10000, 5000, 10);
@@ -21,8 +23,12 @@ MediaSyncState mediaSyncState;
 // RF Simulation state
 bool rfSimulationEnabled = false;
 unsigned long rfSimMaxDelayMs = 400; // Default max delay 400ms
+uint8_t rfSimLossPercent = 0;
+uint8_t rfSimReorderPercent = 0;
+uint8_t rfSimOutagePerMille = 0;
+uint16_t rfSimOutageMs = 0;
 
-DelayedMediaSyncPacket delayedPackets[MAX_DELAYED_PACKETS] = {};
+uint8_t cc100Channel = CC100_DEFAULT_CHANNEL;
 
 bool macEqual(const uint8_t* mac1, const uint8_t* mac2) {
   for (int i = 0; i < 6; i++) {
@@ -33,6 +39,42 @@ bool macEqual(const uint8_t* mac1, const uint8_t* mac2) {
   return true;
 }
 
+uint16_t versionPack(const char* text, size_t maxLength) {
+  uint32_t parts[2] = {0, 0};
+  int part = 0;
+  bool digits = false;
+  for (size_t i = 0; i < maxLength && text[i] != '\0'; i++) {
+    char c = text[i];
+    if (c >= '0' && c <= '9') {
+      parts[part] = std::min<uint32_t>(parts[part] * 10 + (c - '0'), 0xFF);
+      digits = true;
+    } else if (c == '.' && part == 0) {
+      part = 1;
+    } else {
+      break;  // Suffixes ("1.2-rc1", "1.2.3") are not kept
+    }
+  }
+  return digits ? static_cast<uint16_t>((parts[0] << 8) | parts[1]) : 0;
+}
+
+void versionFormat(uint16_t version, char* out, size_t size) {
+  if (version == 0) {
+    out[0] = '\0';
+    return;
+  }
+  snprintf(out, size, "%u.%u", version >> 8, version & 0xFF);
+}
+
+// FNV-1a over the NUL-terminated layer name (at most MAX_LAYER_LENGTH chars)
+uint32_t layerHash(const char* layer) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < MAX_LAYER_LENGTH && layer[i] != '\0'; i++) {
+    hash ^= static_cast<uint8_t>(layer[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
 int countActiveSenders() {
   int count = 0;
   for (int i = 0; i < MAX_SENDERS; i++) {
@@ -26,18 +26,19 @@ extern MediaSyncState mediaSyncState;
 // RF Simulation for testing
 extern bool rfSimulationEnabled;
 extern unsigned long rfSimMaxDelayMs;
+extern uint8_t rfSimLossPercent;     // Random loss, 0-100
+extern uint8_t rfSimReorderPercent;  // Frames held back RF_SIM_REORDER_HOLD_MS, 0-100
+extern uint8_t rfSimOutagePerMille;  // Chance per frame to start a burst outage, 0-127
+extern uint16_t rfSimOutageMs;       // Burst outage length
 
-// Delayed packet structure for RF simulation
-struct DelayedMediaSyncPacket {
-  unsigned long sendTime;
-  MediaSyncPacket packet;
-  uint8_t receiverMac[6];
-  bool active;
-};
+extern uint8_t cc100Channel;  // MIDI channel of CC#100 output, 1-16
 
-#define MAX_DELAYED_PACKETS 20
-extern DelayedMediaSyncPacket delayedPackets[MAX_DELAYED_PACKETS];
 
 bool macEqual(const uint8_t* mac1, const uint8_t* mac2);
+// "major.minor[...]" <-> (major << 8) | minor; 0 = unknown. Receiver tables keep
+// the packed form, the wire (ReceiverInfo, RUNNING_STATE) keeps the string.
+uint16_t versionPack(const char* text, size_t maxLength);
+void versionFormat(uint16_t version, char* out, size_t size);
+uint32_t layerHash(const char* layer);
 int countActiveSenders();
 int countActiveReceivers();
@@ -0,0 +1,404 @@
+#include "ota.h"
+
+#include <cstring>
+
+#include <Update.h>
+#include <esp_crc.h>
+#include <esp_ota_ops.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <mbedtls/sha256.h>
+
+#include "mesh_ota.h"
+#include "midi.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "storage.h"
+#include "sysex.h"
+
+namespace {
+
+constexpr uint8_t ENCODED_BEGIN_LEN = encoded7bitSize(36);  // size + sha256
+constexpr size_t MAX_RAW_CHUNK = OTA2_CHUNK_SIZE + 4;  // Payload + CRC32
+// Chunks decode a whole 7-byte group at a time, so keep room for a last full group
+constexpr size_t CHUNK_ROOM = ((MAX_RAW_CHUNK + 6) / 7) * 7;
+
+struct FlashBuffer {
+  uint8_t data[OTA2_FLASH_BUFFER_SIZE];
+  size_t length;
+};
+
+FlashBuffer buffers[2];
+QueueHandle_t freeBuffers = nullptr;  // Indices the MIDI task may fill
+QueueHandle_t fullBuffers = nullptr;  // Indices waiting for the flash task
+TaskHandle_t flashTaskHandle = nullptr;
+volatile bool flashError = false;
+mbedtls_sha256_context shaContext;  // Only updated by the flash task while a session runs
+
+bool sessionActive = false;
+uint32_t totalSize = 0;
+uint32_t receivedSize = 0;
+uint32_t nextSeq = 0;
+uint8_t expectedHash[32];
+int8_t fillIndex = -1;  // Buffer currently being filled, -1 if none
+bool nackPending = false;  // One NACK per gap, until the missing chunk arrives
+uint8_t chunksSinceAck = 0;
+uint32_t startTime = 0;
+uint8_t otaTarget = OTA_TARGET_SELF;
+
+void sendOtaAck(uint8_t status, uint32_t seq) {
+  midiSysexBegin(SYSEX_CMD_OTA_ACK);
+  midiSysexByte(status);
+  midiSysexByte((seq >> 14) & 0x7F);
+  midiSysexByte((seq >> 7) & 0x7F);
+  midiSysexByte(seq & 0x7F);
+  midiSysexEnd();
+}
+
+void flashTask(void* parameter) {
+  uint8_t index;
+  for (;;) {
+    if (xQueueReceive(fullBuffers, &index, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    FlashBuffer& buffer = buffers[index];
+    if (!flashError) {
+      mbedtls_sha256_update(&shaContext, buffer.data, buffer.length);
+      if (Update.write(buffer.data, buffer.length) != buffer.length) {
+        LOG_ERROR(LOG_CAT_OTA, "[OTA2] Flash write failed: %s\r\n", Update.errorString());
+        flashError = true;
+      }
+    }
+    buffer.length = 0;
+    xQueueSend(freeBuffers, &index, portMAX_DELAY);
+  }
+}
+
+void ensureFlashTask() {
+  if (flashTaskHandle) {
+    return;
+  }
+  freeBuffers = xQueueCreate(2, sizeof(uint8_t));
+  fullBuffers = xQueueCreate(2, sizeof(uint8_t));
+  for (uint8_t i = 0; i < 2; i++) {
+    buffers[i].length = 0;
+    xQueueSend(freeBuffers, &i, 0);
+  }
+  // Core 1, below the ESP-NOW task: flash program/erase overlaps USB receive on core 0
+  xTaskCreatePinnedToCore(flashTask, "OTA_Flash", OTA_FLASH_TASK_STACK_SIZE, NULL, 5, &flashTaskHandle, 1);
+}
+
+bool takeFreeBuffer(int8_t* index) {
+  uint8_t i;
+  if (xQueueReceive(freeBuffers, &i, pdMS_TO_TICKS(OTA2_BUFFER_WAIT_MS)) != pdTRUE) {
+    return false;
+  }
+  *index = static_cast<int8_t>(i);
+  return true;
+}
+
+void submitBuffer(int8_t index) {
+  uint8_t i = static_cast<uint8_t>(index);
+  xQueueSend(fullBuffers, &i, portMAX_DELAY);
+}
+
+// Wait until the flash task has written everything it was given
+bool waitFlashIdle(uint32_t timeoutMs) {
+  uint32_t start = millis();
+  uint8_t expectedFree = (fillIndex >= 0) ? 1 : 2;
+  while (uxQueueMessagesWaiting(freeBuffers) < expectedFree) {
+    if (millis() - start > timeoutMs) {
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+  return true;
+}
+
+// Where the next chunk decodes to: the tail of the fill buffer. A chunk never
+// spans buffers, so one that might not fit hands the buffer to the flash task
+// first. nullptr if the flash task is behind and no buffer is free.
+uint8_t* chunkDestination() {
+  if (fillIndex >= 0 && OTA2_FLASH_BUFFER_SIZE - buffers[fillIndex].length < CHUNK_ROOM) {
+    submitBuffer(fillIndex);
+    fillIndex = -1;
+  }
+  if (fillIndex < 0 && !takeFreeBuffer(&fillIndex)) {
+    return nullptr;
+  }
+  return &buffers[fillIndex].data[buffers[fillIndex].length];
+}
+
+void endSession(bool abortUpdate) {
+  waitFlashIdle(2000);
+  if (fillIndex >= 0) {
+    buffers[fillIndex].length = 0;
+    uint8_t i = static_cast<uint8_t>(fillIndex);
+    xQueueSend(freeBuffers, &i, 0);
+    fillIndex = -1;
+  }
+  if (abortUpdate && Update.isRunning()) {
+    Update.abort();
+  }
+  mbedtls_sha256_free(&shaContext);
+  sessionActive = false;
+}
+
+void failSession(uint8_t status) {
+  LOG_WARN(LOG_CAT_OTA, "[OTA2] Aborting session (status 0x%02X) at seq %lu\r\n", status, nextSeq);
+  endSession(true);
+  sendOtaAck(status, nextSeq);
+}
+
+}  // namespace
+
+void otaHandleBegin(const uint8_t* data, size_t length) {
+  if (length < 3 + ENCODED_BEGIN_LEN + 1) {
+    sendOtaAck(OTA_STATUS_ERR_BEGIN, 0);
+    return;
+  }
+
+  // The relay reads the image straight from the OTA partition we would overwrite
+  if (meshOtaRelayActive()) {
+    sendOtaAck(OTA_STATUS_ERR_STATE, 0);
+    return;
+  }
+
+  ensureFlashTask();
+  if (sessionActive) {
+    LOG_WARN(LOG_CAT_OTA, "[OTA2] Restarting: previous session aborted\r\n");
+    endSession(true);
+  } else if (Update.isRunning()) {
+    Update.abort();  // Left over from a v1 transfer
+  }
+
+  uint8_t raw[36];
+  decode7bitFixed<sizeof(raw)>(&data[3], raw);
+  totalSize = (static_cast<uint32_t>(raw[0]) << 24) |
+              (static_cast<uint32_t>(raw[1]) << 16) |
+              (static_cast<uint32_t>(raw[2]) << 8) |
+              static_cast<uint32_t>(raw[3]);
+  memcpy(expectedHash, &raw[4], sizeof(expectedHash));
+  // Optional target byte after the encoded block (absent = this Nowde only)
+  otaTarget = (length >= 3 + ENCODED_BEGIN_LEN + 2) ? data[3 + ENCODED_BEGIN_LEN] : OTA_TARGET_SELF;
+  if (otaTarget > OTA_TARGET_BOTH) {
+    sendOtaAck(OTA_STATUS_ERR_BEGIN, 0);
+    return;
+  }
+
+  LOG_INFO(LOG_CAT_OTA, "[OTA2 BEGIN] size=%lu bytes, chunk=%d, target=%d\r\n", totalSize, OTA2_CHUNK_SIZE, otaTarget);
+
+  if (totalSize == 0 || !Update.begin(totalSize, U_FLASH)) {
+    LOG_ERROR(LOG_CAT_OTA, "[OTA2 BEGIN] FAILED - Error: %s\r\n", Update.errorString());
+    sendOtaAck(OTA_STATUS_ERR_BEGIN, 0);
+    return;
+  }
+
+  mbedtls_sha256_init(&shaContext);
+  mbedtls_sha256_starts(&shaContext, 0);
+  flashError = false;
+  receivedSize = 0;
+  nextSeq = 0;
+  nackPending = false;
+  chunksSinceAck = 0;
+  startTime = millis();
+  sessionActive = true;
+
+  sendOtaAck(OTA_STATUS_READY, 0);
+}
+
+// OTA2_DATA is streamed (sysex_stream.h): the chunk is decoded in place after
+// the bytes already in the fill buffer, and only counted once its CRC matches.
+namespace {
+
+struct DataStream {
+  uint8_t seqBytes;
+  uint32_t seq;
+  Sysex7BitGroupDecoder decoder;
+  uint8_t* dest;  // nullptr: chunk is not going to be kept
+  size_t rawLen;
+  bool overlong;
+} dataStream;
+
+void nackChunk() {
+  sendOtaAck(OTA_STATUS_NACK, nextSeq);
+  nackPending = true;
+}
+
+void dataBegin() {
+  dataStream.seqBytes = 0;
+  dataStream.seq = 0;
+  dataStream.decoder.reset();
+  dataStream.dest = nullptr;
+  dataStream.rawLen = 0;
+  dataStream.overlong = false;
+}
+
+void dataByte(uint8_t value) {
+  if (dataStream.seqBytes < 3) {
+    dataStream.seq = (dataStream.seq << 7) | (value & 0x7F);
+    if (++dataStream.seqBytes == 3 && sessionActive && dataStream.seq == nextSeq) {
+      dataStream.dest = chunkDestination();
+    }
+    return;
+  }
+  if (!dataStream.dest) {
+    return;
+  }
+
+  if (dataStream.rawLen + 7 > CHUNK_ROOM) {
+    dataStream.overlong = true;
+    return;
+  }
+  dataStream.rawLen += dataStream.decoder.feed(value, &dataStream.dest[dataStream.rawLen]);
+}
+
+void dataEnd(bool complete) {
+  if (!sessionActive) {
+    sendOtaAck(OTA_STATUS_ERR_STATE, 0);
+    return;
+  }
+  // Cut short on USB, or no room for seq + one group: the Bridge resends on timeout
+  if (!complete || dataStream.seqBytes < 3) {
+    return;
+  }
+
+  uint32_t seq = dataStream.seq;
+  if (seq != nextSeq) {
+    if (seq < nextSeq) {
+      // Retransmitted after a lost ACK: re-ACK so the sender's window moves on
+      sendOtaAck(OTA_STATUS_ACK, nextSeq);
+    } else if (!nackPending) {
+      nackChunk();
+    }
+    return;
+  }
+
+  if (!dataStream.dest) {
+    // Flash task is behind: drop the chunk, the sender resends from nextSeq
+    nackChunk();
+    return;
+  }
+  dataStream.rawLen += dataStream.decoder.finish(&dataStream.dest[dataStream.rawLen]);
+  if (dataStream.overlong || dataStream.rawLen > MAX_RAW_CHUNK || dataStream.rawLen < 5) {
+    nackChunk();
+    return;
+  }
+
+  const uint8_t* raw = dataStream.dest;
+  size_t payloadLen = dataStream.rawLen - 4;
+  uint32_t crc = (static_cast<uint32_t>(raw[payloadLen]) << 24) |
+                 (static_cast<uint32_t>(raw[payloadLen + 1]) << 16) |
+                 (static_cast<uint32_t>(raw[payloadLen + 2]) << 8) |
+                 static_cast<uint32_t>(raw[payloadLen + 3]);
+  if (esp_crc32_le(0, raw, payloadLen) != crc) {
+    LOG_ERROR(LOG_CAT_OTA, "[OTA2 DATA] CRC mismatch on seq %lu\r\n", seq);
+    nackChunk();
+    return;
+  }
+
+  if (receivedSize + payloadLen > totalSize) {
+    failSession(OTA_STATUS_ERR_SIZE);
+    return;
+  }
+
+  if (flashError) {
+    failSession(OTA_STATUS_ERR_FLASH);
+    return;
+  }
+
+  // Keep the payload, the CRC behind it gets overwritten by the next chunk
+  buffers[fillIndex].length += payloadLen;
+  nextSeq++;
+  receivedSize += payloadLen;
+  nackPending = false;
+
+  if (++chunksSinceAck >= OTA2_ACK_INTERVAL || receivedSize == totalSize) {
+    chunksSinceAck = 0;
+    sendOtaAck(OTA_STATUS_ACK, nextSeq);
+  }
+
+  // Log progress every 10%
+  static uint8_t lastPercent = 0;
+  uint8_t percent = (static_cast<uint64_t>(receivedSize) * 100) / totalSize;
+  if (percent / 10 != lastPercent / 10 || seq == 0) {
+    LOG_INFO(LOG_CAT_OTA, "[OTA2 DATA] Progress: %u%% (%lu/%lu bytes)\r\n", percent, receivedSize, totalSize);
+  }
+  lastPercent = percent;
+}
+
+const SysexStreamHandler dataStreamHandler = {dataBegin, dataByte, dataEnd};
+
+}  // namespace
+
+const SysexStreamHandler* otaDataStream() {
+  return &dataStreamHandler;
+}
+
+void otaHandleEnd(const uint8_t* data, size_t length) {
+  if (!sessionActive) {
+    sendOtaAck(OTA_STATUS_ERR_STATE, 0);
+    return;
+  }
+
+  LOG_INFO(LOG_CAT_OTA, "[OTA2 END] %lu/%lu bytes in %lu ms\r\n",
+           receivedSize, totalSize, millis() - startTime);
+
+  if (fillIndex >= 0 && buffers[fillIndex].length > 0) {
+    submitBuffer(fillIndex);
+    fillIndex = -1;
+  }
+  if (!waitFlashIdle(2000) || flashError) {
+    failSession(OTA_STATUS_ERR_FLASH);
+    return;
+  }
+  if (receivedSize != totalSize) {
+    failSession(OTA_STATUS_ERR_SIZE);
+    return;
+  }
+
+  uint8_t hash[32];
+  mbedtls_sha256_finish(&shaContext, hash);
+  if (memcmp(hash, expectedHash, sizeof(hash)) != 0) {
+    LOG_ERROR(LOG_CAT_OTA, "[OTA2 END] SHA-256 mismatch\r\n");
+    failSession(OTA_STATUS_ERR_HASH);
+    return;
+  }
+
+  if (!Update.end(true)) {
+    LOG_ERROR(LOG_CAT_OTA, "[OTA2 END] FAILED - Error: %s\r\n", Update.errorString());
+    failSession(OTA_STATUS_ERR_FLASH);
+    return;
+  }
+
+  endSession(false);
+
+  if (otaTarget != OTA_TARGET_SELF) {
+    // Update.end() just made the new image the boot partition
+    const esp_partition_t* image = esp_ota_get_boot_partition();
+    if (otaTarget == OTA_TARGET_MESH) {
+      esp_ota_set_boot_partition(esp_ota_get_running_partition());
+    }
+    sendOtaAck(OTA_STATUS_COMPLETE, nextSeq);
+    if (!meshOtaStartRelay(image, totalSize, expectedHash, otaTarget == OTA_TARGET_BOTH)) {
+      LOG_WARN(LOG_CAT_OTA, "[OTA2 END] Could not start mesh relay\r\n");
+    }
+    return;
+  }
+
+  sendOtaAck(OTA_STATUS_COMPLETE, nextSeq);
+
+  LOG_INFO(LOG_CAT_OTA, "[OTA2 END] SUCCESS - Image verified, rebooting in 1 second...\r\n");
+  // We are the MIDI task: nothing drains the TX queue while we wait below,
+  // and the Bridge waits for COMPLETE
+  if (!midiTxFlush(OTA_REBOOT_FLUSH_MS)) {
+    LOG_WARN(LOG_CAT_OTA, "[OTA2 END] COMPLETE ack not flushed to USB\r\n");
+  }
+  profileFlush();
+  logFlush();
+  DEBUG_SERIAL.flush();
+  delay(1000);
+  esp_restart();
+}
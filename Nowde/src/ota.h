@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "sysex_stream.h"
+
+// OTA v2 over USB SysEx.
+// The Bridge streams sequence-numbered chunks, each with its own CRC32, and
+// keeps a window of them in flight. We answer with cumulative OTA_ACKs, or a
+// NACK carrying the next expected sequence (go-back-N). Chunks are collected
+// into two flash buffers that a separate task writes while USB keeps
+// receiving, and the whole image is checked against a SHA-256 before booting.
+// With a mesh target the verified image is then relayed to receivers (mesh_ota.h).
+//
+//   OTA2_BEGIN: F0 7D 08 [size(4) + sha256(32), encoded:42] [target(1), optional] F7
+//   OTA2_DATA:  F0 7D 09 [seq(3 x 7-bit, MSB first)] [payload + crc32(4), encoded] F7
+//   OTA2_END:   F0 7D 0A F7
+void otaHandleBegin(const uint8_t* data, size_t length);
+void otaHandleEnd(const uint8_t* data, size_t length);
+// OTA2_DATA is decoded as it arrives, straight into the flash buffers
+const SysexStreamHandler* otaDataStream();
@@ -0,0 +1,352 @@
+#include "peer_table.h"
+
+#include <esp_now.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <cstring>
+
+#include "layer_registry.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+
+static_assert((SENDER_INDEX_SIZE & (SENDER_INDEX_SIZE - 1)) == 0, "SENDER_INDEX_SIZE must be a power of two");
+static_assert((RECEIVER_INDEX_SIZE & (RECEIVER_INDEX_SIZE - 1)) == 0, "RECEIVER_INDEX_SIZE must be a power of two");
+static_assert(SENDER_INDEX_SIZE >= 2 * MAX_SENDERS, "sender index load factor above 0.5");
+static_assert(RECEIVER_INDEX_SIZE >= 2 * MAX_RECEIVERS, "receiver index load factor above 0.5");
+static_assert(MAX_RECEIVERS < 0xFF, "receiver slots are passed around as uint8_t");
+
+namespace {
+
+constexpr int16_t CELL_EMPTY = -1;
+constexpr int16_t CELL_TOMBSTONE = -2;
+constexpr int16_t NO_SLOT = -1;
+
+// Tables are written by the ESP-NOW task and read by the MIDI task
+portMUX_TYPE tableMux = portMUX_INITIALIZER_UNLOCKED;
+
+// FNV-1a over the 6 MAC bytes
+inline uint32_t macHash(const uint8_t* mac) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < 6; i++) {
+    hash ^= mac[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Linear-probing MAC -> slot index over an entry array. Removed entries leave a
+// tombstone; the index is rebuilt once they make up a quarter of the cells so
+// misses stay short.
+template <typename Entry, int Slots, int Cells>
+struct MacIndex {
+  Entry* entries;
+  int16_t cells[Cells];
+  uint16_t tombstones;
+
+  void clear() {
+    for (int i = 0; i < Cells; i++) {
+      cells[i] = CELL_EMPTY;
+    }
+    tombstones = 0;
+  }
+
+  int find(const uint8_t* mac) const {
+    uint32_t pos = macHash(mac) & (Cells - 1);
+    for (int probe = 0; probe < Cells; probe++) {
+      int16_t cell = cells[pos];
+      if (cell == CELL_EMPTY) {
+        return NO_SLOT;
+      }
+      if (cell >= 0 && macEqual(entries[cell].mac, mac)) {
+        return cell;
+      }
+      pos = (pos + 1) & (Cells - 1);
+    }
+    return NO_SLOT;
+  }
+
+  void place(int slot) {
+    uint32_t pos = macHash(entries[slot].mac) & (Cells - 1);
+    while (cells[pos] >= 0) {
+      pos = (pos + 1) & (Cells - 1);
+    }
+    if (cells[pos] == CELL_TOMBSTONE) {
+      tombstones--;
+    }
+    cells[pos] = static_cast<int16_t>(slot);
+  }
+
+  void rebuild() {
+    clear();
+    for (int i = 0; i < Slots; i++) {
+      if (entries[i].active) {
+        place(i);
+      }
+    }
+  }
+
+  int insert(const uint8_t* mac) {
+    for (int i = 0; i < Slots; i++) {
+      if (!entries[i].active) {
+        memcpy(entries[i].mac, mac, 6);
+        entries[i].active = true;
+        place(i);
+        return i;
+      }
+    }
+    return NO_SLOT;
+  }
+
+  void remove(int slot) {
+    uint32_t pos = macHash(entries[slot].mac) & (Cells - 1);
+    for (int probe = 0; probe < Cells && cells[pos] != CELL_EMPTY; probe++) {
+      if (cells[pos] == slot) {
+        cells[pos] = CELL_TOMBSTONE;
+        tombstones++;
+        break;
+      }
+      pos = (pos + 1) & (Cells - 1);
+    }
+    entries[slot].active = false;
+    if (tombstones > Cells / 4) {
+      rebuild();
+    }
+  }
+};
+
+MacIndex<SenderEntry, MAX_SENDERS, SENDER_INDEX_SIZE> senderIndex;
+MacIndex<ReceiverEntry, MAX_RECEIVERS, RECEIVER_INDEX_SIZE> receiverIndex;
+
+// Per-layer chains indexed by registry layer ID, linked through ReceiverEntry::nextInLayer.
+// Receivers without an ID (registry full) are not chained and get no sync.
+int16_t layerHeads[MAX_LAYER_IDS + 1];
+
+void linkLayer(int slot, uint8_t layerId) {
+  ReceiverEntry& entry = receiverTable[slot];
+  entry.layerId = layerId;
+  if (layerId == LAYER_ID_NONE) {
+    entry.nextInLayer = NO_SLOT;
+    return;
+  }
+  entry.nextInLayer = layerHeads[layerId];
+  layerHeads[layerId] = static_cast<int16_t>(slot);
+}
+
+void unlinkLayer(int slot) {
+  int16_t* link = &layerHeads[receiverTable[slot].layerId];
+  while (receiverTable[slot].layerId != LAYER_ID_NONE && *link != NO_SLOT) {
+    if (*link == slot) {
+      *link = receiverTable[slot].nextInLayer;
+      break;
+    }
+    link = &receiverTable[*link].nextInLayer;
+  }
+  receiverTable[slot].nextInLayer = NO_SLOT;
+  receiverTable[slot].layerId = LAYER_ID_NONE;
+}
+
+// ---------------- ESP-NOW peer slots ----------------
+
+struct PeerSlot {
+  uint8_t mac[6];
+  uint32_t lastUsed;
+  bool used;
+};
+
+PeerSlot peers[ESPNOW_MAX_UNICAST_PEERS];
+SemaphoreHandle_t peerLock = nullptr;
+
+}  // namespace
+
+void peerTableInit() {
+  senderIndex.entries = senderTable;
+  receiverIndex.entries = receiverTable;
+  senderIndex.rebuild();
+  receiverIndex.rebuild();
+  for (int i = 0; i <= MAX_LAYER_IDS; i++) {
+    layerHeads[i] = NO_SLOT;
+  }
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    receiverTable[i].nextInLayer = NO_SLOT;
+  }
+
+  if (peerLock == nullptr) {
+    peerLock = xSemaphoreCreateMutex();
+  }
+}
+
+int findSender(const uint8_t* mac) {
+  portENTER_CRITICAL(&tableMux);
+  int slot = senderIndex.find(mac);
+  portEXIT_CRITICAL(&tableMux);
+  return slot;
+}
+
+int findReceiver(const uint8_t* mac) {
+  portENTER_CRITICAL(&tableMux);
+  int slot = receiverIndex.find(mac);
+  portEXIT_CRITICAL(&tableMux);
+  return slot;
+}
+
+int addSender(const uint8_t* mac) {
+  portENTER_CRITICAL(&tableMux);
+  int slot = senderIndex.insert(mac);
+  portEXIT_CRITICAL(&tableMux);
+  return slot;
+}
+
+int addReceiver(const uint8_t* mac, const char* layer) {
+  uint8_t layerId = acquireLayerId(layer);
+
+  portENTER_CRITICAL(&tableMux);
+  int slot = receiverIndex.insert(mac);
+  if (slot != NO_SLOT) {
+    strncpy(receiverTable[slot].layer, layer, MAX_LAYER_LENGTH);
+    receiverTable[slot].layer[MAX_LAYER_LENGTH - 1] = '\0';
+    linkLayer(slot, layerId);
+  }
+  portEXIT_CRITICAL(&tableMux);
+
+  if (slot == NO_SLOT) {
+    releaseLayerId(layerId);
+  }
+  return slot;
+}
+
+void removeSender(int slot) {
+  portENTER_CRITICAL(&tableMux);
+  if (senderTable[slot].active) {
+    senderIndex.remove(slot);
+  }
+  portEXIT_CRITICAL(&tableMux);
+}
+
+void removeReceiver(int slot) {
+  uint8_t layerId = LAYER_ID_NONE;
+
+  portENTER_CRITICAL(&tableMux);
+  if (receiverTable[slot].active) {
+    layerId = receiverTable[slot].layerId;
+    unlinkLayer(slot);
+    receiverIndex.remove(slot);
+    receiverTable[slot].connected = false;
+  }
+  portEXIT_CRITICAL(&tableMux);
+
+  releaseLayerId(layerId);
+}
+
+void setReceiverLayer(int slot, const char* layer) {
+  uint8_t layerId = acquireLayerId(layer);
+
+  portENTER_CRITICAL(&tableMux);
+  uint8_t oldLayerId = receiverTable[slot].layerId;
+  unlinkLayer(slot);
+  strncpy(receiverTable[slot].layer, layer, MAX_LAYER_LENGTH);
+  receiverTable[slot].layer[MAX_LAYER_LENGTH - 1] = '\0';
+  linkLayer(slot, layerId);
+  portEXIT_CRITICAL(&tableMux);
+
+  releaseLayerId(oldLayerId);
+}
+
+bool hasConnectedReceiverOnLayer(uint8_t layerId) {
+  uint8_t slot;
+  return collectReceiversOnLayer(layerId, &slot, 1) > 0;
+}
+
+int collectReceiversOnLayer(uint8_t layerId, uint8_t* slots, int maxSlots) {
+  if (layerId == LAYER_ID_NONE || layerId > MAX_LAYER_IDS) {
+    return 0;
+  }
+
+  int count = 0;
+  portENTER_CRITICAL(&tableMux);
+  for (int16_t slot = layerHeads[layerId];
+       slot != NO_SLOT && count < maxSlots;
+       slot = receiverTable[slot].nextInLayer) {
+    if (receiverTable[slot].connected) {
+      slots[count++] = static_cast<uint8_t>(slot);
+    }
+  }
+  portEXIT_CRITICAL(&tableMux);
+  return count;
+}
+
+bool allReceiversOnLayerLocked(uint8_t layerId) {
+  if (layerId == LAYER_ID_NONE || layerId > MAX_LAYER_IDS) {
+    return false;
+  }
+
+  bool any = false;
+  bool locked = true;
+  portENTER_CRITICAL(&tableMux);
+  for (int16_t slot = layerHeads[layerId]; slot != NO_SLOT; slot = receiverTable[slot].nextInLayer) {
+    if (receiverTable[slot].connected) {
+      any = true;
+      locked = locked && (receiverTable[slot].sync.flags & SYNC_EST_FLAG_LOCKED);
+    }
+  }
+  portEXIT_CRITICAL(&tableMux);
+  return any && locked;
+}
+
+bool ensureEspNowPeer(const uint8_t* mac) {
+  if (macEqual(mac, broadcastAddress)) {
+    return true;  // Registered once at startup (addBroadcastPeer)
+  }
+
+  xSemaphoreTake(peerLock, portMAX_DELAY);
+
+  // Reuse the entry for this MAC, else take a free entry, else the least recently used
+  int victim = 0;
+  for (int i = 0; i < ESPNOW_MAX_UNICAST_PEERS; i++) {
+    if (peers[i].used && macEqual(peers[i].mac, mac)) {
+      peers[i].lastUsed = millis();
+      xSemaphoreGive(peerLock);
+      return true;
+    }
+    if (!peers[victim].used) {
+      continue;
+    }
+    if (!peers[i].used || static_cast<int32_t>(peers[i].lastUsed - peers[victim].lastUsed) < 0) {
+      victim = i;
+    }
+  }
+
+  if (peers[victim].used) {
+    esp_now_del_peer(peers[victim].mac);
+    peers[victim].used = false;
+  }
+
+  esp_now_peer_info_t peerInfo = {};
+  memcpy(peerInfo.peer_addr, mac, 6);
+  peerInfo.channel = 0;
+  peerInfo.encrypt = false;
+
+  esp_err_t result = esp_now_is_peer_exist(mac) ? ESP_OK : esp_now_add_peer(&peerInfo);
+  if (result == ESP_OK) {
+    memcpy(peers[victim].mac, mac, 6);
+    peers[victim].lastUsed = millis();
+    peers[victim].used = true;
+  } else {
+    LOG_ERROR(LOG_CAT_ESPNOW, "[ESP-NOW] Failed to add peer (error %d)\r\n", result);
+  }
+
+  xSemaphoreGive(peerLock);
+  return result == ESP_OK;
+}
+
+void releaseEspNowPeer(const uint8_t* mac) {
+  xSemaphoreTake(peerLock, portMAX_DELAY);
+  for (int i = 0; i < ESPNOW_MAX_UNICAST_PEERS; i++) {
+    if (peers[i].used && macEqual(peers[i].mac, mac)) {
+      esp_now_del_peer(mac);
+      peers[i].used = false;
+      break;
+    }
+  }
+  xSemaphoreGive(peerLock);
+}
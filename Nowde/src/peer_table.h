@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Indexes over senderTable[] / receiverTable[] (nowde_state.h).
+// The arrays stay the storage: an entry keeps its slot for as long as it is
+// active, and an open-addressing hash of the MAC maps to that slot. Receivers
+// are also chained per layer so the sync fan-out only visits the receivers
+// subscribed to the layer being synced (chains are keyed by layer ID, see
+// layer_registry.h).
+void peerTableInit();
+
+// Slot of the active entry with this MAC, or -1
+int findSender(const uint8_t* mac);
+int findReceiver(const uint8_t* mac);
+
+// Claim a free slot for a MAC that is not in the table yet (marked active,
+// MAC copied, everything else left to the caller). Returns -1 when full.
+int addSender(const uint8_t* mac);
+int addReceiver(const uint8_t* mac, const char* layer);
+
+void removeSender(int slot);
+void removeReceiver(int slot);
+
+// Move a receiver to another layer chain (and layer ID). Use this instead of
+// writing receiverTable[slot].layer directly.
+void setReceiverLayer(int slot, const char* layer);
+
+bool hasConnectedReceiverOnLayer(uint8_t layerId);
+// Copies the slots of connected receivers on a layer; returns how many
+int collectReceiversOnLayer(uint8_t layerId, uint8_t* slots, int maxSlots);
+// True when the layer has connected receivers and every one of them reports
+// SYNC_EST_FLAG_LOCKED (older receivers report no flags, so never are)
+bool allReceiversOnLayerLocked(uint8_t layerId);
+
+// ESP-NOW only holds ESP_NOW_MAX_TOTAL_PEER_NUM (20) peers, one of which is the
+// broadcast address. Unicast peers are registered on demand and the least
+// recently used one is evicted when the limit is reached, so any number of
+// receivers can be addressed (sync itself goes out as broadcast).
+bool ensureEspNowPeer(const uint8_t* mac);
+void releaseEspNowPeer(const uint8_t* mac);
@@ -0,0 +1,349 @@
+#include "phantom.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <esp_timer.h>
+
+#include "midi.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "peer_table.h"
+#include "scheduler.h"
+#include "sender_mode.h"
+
+namespace {
+
+constexpr uint8_t MAC_PREFIX[5] = {0x02, 0x50, 0x48, 0x4E, 0x00};  // Locally administered, "PHN"
+constexpr size_t BATCH_HEADER_LEN = offsetof(MediaSyncBatchPacket, entries);
+
+struct Phantom {
+  char layer[MAX_LAYER_LENGTH];
+  uint8_t layerId;     // Sender's ID for layer once registered (0 = none yet)
+  uint8_t mediaIndex;  // Last media index that reached it
+  uint32_t nextInfoMs;
+  uint32_t expected;   // Sync frames emitted towards it
+  uint32_t arrived;    // ... of which reached the radio
+  uint64_t latencySumUs;
+  uint32_t latencyMaxUs;
+  uint16_t windowExpected;  // Since its last ReceiverInfo (LinkReport)
+  uint16_t windowArrived;
+  uint32_t windowStartMs;
+};
+
+// Last emission per layer ID: arrivals of that frame are timed against noteUs
+struct LayerNote {
+  uint32_t meshTimestamp;
+  uint32_t noteUs;
+};
+
+// Shared by the MIDI task (start/stop, emission), every sender of
+// espnowTxSend and the RF simulation timer (arrival), and the ESP-NOW task
+portMUX_TYPE phantomMux = portMUX_INITIALIZER_UNLOCKED;
+Phantom phantoms[PHANTOM_MAX_RECEIVERS];
+LayerNote notes[MAX_LAYER_IDS + 1];
+uint8_t phantomCount = 0;       // Phantoms with data (kept after a stop for the last report)
+volatile bool running = false;
+volatile bool finalReportPending = false;
+uint32_t nextReportMs = 0;  // ESP-NOW task
+
+void phantomMac(uint8_t index, uint8_t* mac) {
+  memcpy(mac, MAC_PREFIX, sizeof(MAC_PREFIX));
+  mac[5] = index;
+}
+
+// Calls fn(layerId, mediaIndex, meshTimestamp) for each layer in a sync frame
+template <typename Fn>
+void forEachSyncLayer(const uint8_t* frame, size_t length, Fn fn) {
+  if (frame[0] == ESPNOW_MSG_MEDIA_SYNC && length >= sizeof(MediaSyncPacket)) {
+    MediaSyncPacket packet;
+    memcpy(&packet, frame, sizeof(packet));
+    fn(packet.layerId, packet.mediaIndex, packet.meshTimestamp);
+  } else if (frame[0] == ESPNOW_MSG_MEDIA_SYNC_BATCH && length >= BATCH_HEADER_LEN) {
+    uint32_t meshTimestamp;
+    memcpy(&meshTimestamp, frame + offsetof(MediaSyncBatchPacket, meshTimestamp), sizeof(meshTimestamp));
+    size_t count = std::min<size_t>({frame[offsetof(MediaSyncBatchPacket, count)], MEDIA_SYNC_BATCH_MAX_LAYERS,
+                                     (length - BATCH_HEADER_LEN) / sizeof(MediaSyncBatchEntry)});
+    for (size_t i = 0; i < count; i++) {
+      MediaSyncBatchEntry entry;
+      memcpy(&entry, frame + BATCH_HEADER_LEN + i * sizeof(entry), sizeof(entry));
+      fn(entry.layerId, entry.mediaIndex, meshTimestamp);
+    }
+  }
+}
+
+// Phantom slot a frame to mac reaches: all of them for broadcast, else one
+int8_t targetIndex(const uint8_t* mac) {
+  if (macEqual(mac, broadcastAddress)) {
+    return -1;
+  }
+  return phantomIsMac(mac) ? static_cast<int8_t>(mac[5]) : -2;
+}
+
+bool reaches(int8_t target, uint8_t index, const Phantom& phantom, uint8_t layerId) {
+  return layerId != 0 && phantom.layerId == layerId && (target == -1 || target == index);
+}
+
+void sendInfo(uint8_t index, uint32_t now) {
+  ReceiverInfo info;
+  memset(&info.sync, 0, sizeof(info.sync));
+  strncpy(info.version, NOWDE_VERSION, MAX_VERSION_LENGTH);
+  info.version[MAX_VERSION_LENGTH - 1] = '\0';
+
+  portENTER_CRITICAL(&phantomMux);
+  Phantom& phantom = phantoms[index];
+  memcpy(info.layer, phantom.layer, MAX_LAYER_LENGTH);
+  info.mediaIndex = phantom.mediaIndex;
+  info.link.syncReceived = phantom.windowArrived;
+  info.link.syncDiscarded = phantom.windowExpected > phantom.windowArrived
+                                ? phantom.windowExpected - phantom.windowArrived
+                                : 0;  // Lost, as far as a receiver can tell
+  info.link.windowMs = static_cast<uint16_t>(std::min<uint32_t>(UINT16_MAX, now - phantom.windowStartMs));
+  phantom.windowArrived = 0;
+  phantom.windowExpected = 0;
+  phantom.windowStartMs = now;
+  portEXIT_CRITICAL(&phantomMux);
+
+  info.clock.flags = CLOCK_REPORT_FLAG_MESH_SYNCED;
+  info.clock.senderOffsetMs = 0;
+  info.clock.corrected = 0;
+  info.clock.discarded = 0;
+  int8_t rssi = static_cast<int8_t>(-50 - random(0, 20));
+  info.link.rssiAvgDbm = rssi;
+  info.link.rssiMinDbm = static_cast<int8_t>(rssi - random(0, 8));
+  info.link.linkLost = 0;
+
+  uint8_t mac[6];
+  phantomMac(index, mac);
+  handleReceiverInfo(mac, reinterpret_cast<const uint8_t*>(&info), sizeof(info), rssi);
+
+  // Registration (or a layer change) assigns the layer ID sync frames carry
+  int slot = findReceiver(mac);
+  uint8_t layerId = slot != -1 ? receiverTable[slot].layerId : 0;
+  portENTER_CRITICAL(&phantomMux);
+  phantoms[index].layerId = layerId;
+  portEXIT_CRITICAL(&phantomMux);
+}
+
+void sendReport() {
+  // Format: F0 7D 2A [phantomCount] [running(1)]
+  //   phantomCount x [index(1) layerId(1) expected(4) arrived(4) latencyAvgUs(4) latencyMaxUs(4), encoded:21] F7
+  // Counts and latency are cumulative since the phantoms were started.
+  uint32_t totalExpected = 0;
+  uint32_t totalArrived = 0;
+  uint64_t totalLatencyUs = 0;
+  uint32_t maxLatencyUs = 0;
+
+  midiSysexBegin(SYSEX_CMD_PHANTOM_REPORT);
+  midiSysexByte(phantomCount);
+  midiSysexByte(running ? 1 : 0);
+  for (uint8_t i = 0; i < phantomCount; i++) {
+    portENTER_CRITICAL(&phantomMux);
+    const Phantom phantom = phantoms[i];
+    portEXIT_CRITICAL(&phantomMux);
+
+    uint32_t avgUs = phantom.arrived ? static_cast<uint32_t>(phantom.latencySumUs / phantom.arrived) : 0;
+    const uint8_t ids[2] = {i, phantom.layerId};
+    midiSysexEncode(ids, sizeof(ids));
+    midiSysexEncodeU32(phantom.expected);
+    midiSysexEncodeU32(phantom.arrived);
+    midiSysexEncodeU32(avgUs);
+    midiSysexEncodeU32(phantom.latencyMaxUs);
+    midiSysexEncodeFlush();
+
+    totalExpected += phantom.expected;
+    totalArrived += phantom.arrived;
+    totalLatencyUs += phantom.latencySumUs;
+    maxLatencyUs = std::max(maxLatencyUs, phantom.latencyMaxUs);
+  }
+  midiSysexEnd();
+
+  uint32_t lost = totalExpected > totalArrived ? totalExpected - totalArrived : 0;
+  LOG_INFO(LOG_CAT_SENDER, "[PHANTOM] %u phantom(s)%s: %lu/%lu sync frames arrived (%lu lost), latency avg %lu us, max %lu us\r\n",
+           phantomCount, running ? "" : " (stopped)", totalArrived, totalExpected, lost,
+           totalArrived ? static_cast<uint32_t>(totalLatencyUs / totalArrived) : 0, maxLatencyUs);
+}
+
+}  // namespace
+
+void phantomStart(uint8_t count, const char (*layers)[MAX_LAYER_LENGTH], uint8_t layerCount) {
+  if (!senderModeEnabled) {
+    LOG_WARN(LOG_CAT_SENDER, "[PHANTOM] Sender mode only\r\n");
+    return;
+  }
+  count = std::min<uint8_t>(count, PHANTOM_MAX_RECEIVERS);
+  if (count == 0) {
+    phantomStop();
+    return;
+  }
+
+  uint32_t now = millis();
+  portENTER_CRITICAL(&phantomMux);
+  for (uint8_t i = 0; i < count; i++) {
+    Phantom& phantom = phantoms[i];
+    memset(&phantom, 0, sizeof(phantom));
+    if (layerCount > 0) {
+      memcpy(phantom.layer, layers[i % layerCount], MAX_LAYER_LENGTH);
+      phantom.layer[MAX_LAYER_LENGTH - 1] = '\0';
+    } else {
+      strncpy(phantom.layer, PHANTOM_DEFAULT_LAYER, MAX_LAYER_LENGTH - 1);
+    }
+    // Spread the first beacons over one interval, as boards powered up together would drift apart
+    phantom.nextInfoMs = now + random(0, RECEIVER_BEACON_INTERVAL_MS);
+    phantom.windowStartMs = now;
+  }
+  memset(notes, 0, sizeof(notes));
+  phantomCount = count;
+  running = true;
+  finalReportPending = false;
+  portEXIT_CRITICAL(&phantomMux);
+
+  nextReportMs = now + PHANTOM_REPORT_INTERVAL_MS;
+  schedulerArm(SCHED_PHANTOM, now);
+  LOG_INFO(LOG_CAT_SENDER, "[PHANTOM] Started %u phantom receiver(s) on %u layer(s)\r\n",
+           count, layerCount > 0 ? layerCount : 1);
+}
+
+void phantomStop() {
+  portENTER_CRITICAL(&phantomMux);
+  bool wasRunning = running;
+  running = false;
+  if (wasRunning) {
+    finalReportPending = true;
+  }
+  portEXIT_CRITICAL(&phantomMux);
+
+  if (wasRunning) {
+    schedulerArm(SCHED_PHANTOM, millis());
+  }
+}
+
+bool phantomIsMac(const uint8_t* mac) {
+  return running && memcmp(mac, MAC_PREFIX, sizeof(MAC_PREFIX)) == 0 && mac[5] < phantomCount;
+}
+
+void phantomNoteSync(const uint8_t* mac, const uint8_t* frame, size_t length) {
+  if (!running) {
+    return;
+  }
+  uint32_t nowUs = static_cast<uint32_t>(esp_timer_get_time());
+  int8_t target = targetIndex(mac);
+  if (target == -2) {
+    return;
+  }
+
+  portENTER_CRITICAL(&phantomMux);
+  forEachSyncLayer(frame, length, [&](uint8_t layerId, uint8_t, uint32_t meshTimestamp) {
+    if (layerId == 0 || layerId > MAX_LAYER_IDS) {
+      return;
+    }
+    notes[layerId] = {meshTimestamp, nowUs};
+    for (uint8_t i = 0; i < phantomCount; i++) {
+      Phantom& phantom = phantoms[i];
+      if (reaches(target, i, phantom, layerId)) {
+        phantom.expected++;
+        if (phantom.windowExpected != UINT16_MAX) {
+          phantom.windowExpected++;
+        }
+      }
+    }
+  });
+  portEXIT_CRITICAL(&phantomMux);
+}
+
+void phantomOnAir(const uint8_t* mac, const uint8_t* frame, size_t length) {
+  if (!running || length == 0) {
+    return;
+  }
+  int8_t target = targetIndex(mac);
+  if (target == -2) {
+    return;
+  }
+
+  // CHANGE_RECEIVER_LAYER as the sender relays it: F0 7D 11 [layer] F7
+  if (target >= 0 && length >= 4 && frame[0] == SYSEX_START && frame[2] == SYSEX_CMD_CHANGE_RECEIVER_LAYER) {
+    size_t layerLen = std::min<size_t>(length - 4, MAX_LAYER_LENGTH - 1);
+    portENTER_CRITICAL(&phantomMux);
+    Phantom& phantom = phantoms[target];
+    memset(phantom.layer, 0, MAX_LAYER_LENGTH);
+    memcpy(phantom.layer, &frame[3], layerLen);
+    phantom.layerId = 0;  // Until the next ReceiverInfo moves it in the sender's table
+    phantom.nextInfoMs = millis();
+    portEXIT_CRITICAL(&phantomMux);
+    schedulerArm(SCHED_PHANTOM, millis());
+    return;
+  }
+
+  uint32_t nowUs = static_cast<uint32_t>(esp_timer_get_time());
+  uint64_t meshNowUs = meshClock.meshMicros();
+
+  portENTER_CRITICAL(&phantomMux);
+  forEachSyncLayer(frame, length, [&](uint8_t layerId, uint8_t mediaIndex, uint32_t meshTimestamp) {
+    if (layerId == 0 || layerId > MAX_LAYER_IDS) {
+      return;
+    }
+    // A frame overtaken by a newer one of its layer (RF simulation delay) is
+    // timed from its mesh timestamp instead, at millisecond resolution
+    uint32_t latencyUs;
+    if (notes[layerId].meshTimestamp == meshTimestamp && notes[layerId].noteUs != 0) {
+      latencyUs = nowUs - notes[layerId].noteUs;
+    } else {
+      int64_t age = static_cast<int64_t>(meshNowUs) - static_cast<int64_t>(meshTimestamp) * 1000;
+      latencyUs = static_cast<uint32_t>(std::max<int64_t>(0, age));
+    }
+    for (uint8_t i = 0; i < phantomCount; i++) {
+      Phantom& phantom = phantoms[i];
+      if (reaches(target, i, phantom, layerId)) {
+        phantom.arrived++;
+        if (phantom.windowArrived != UINT16_MAX) {
+          phantom.windowArrived++;
+        }
+        phantom.latencySumUs += latencyUs;
+        phantom.latencyMaxUs = std::max(phantom.latencyMaxUs, latencyUs);
+        phantom.mediaIndex = mediaIndex;
+      }
+    }
+  });
+  portEXIT_CRITICAL(&phantomMux);
+}
+
+void phantomTick(uint32_t now) {
+  if (running && !senderModeEnabled) {
+    phantomStop();
+  }
+
+  uint32_t nextDue = now + PHANTOM_REPORT_INTERVAL_MS;
+  if (running) {
+    for (uint8_t i = 0; i < phantomCount; i++) {
+      portENTER_CRITICAL(&phantomMux);
+      uint32_t infoDue = phantoms[i].nextInfoMs;
+      portEXIT_CRITICAL(&phantomMux);
+
+      if (static_cast<int32_t>(now - infoDue) >= 0) {
+        sendInfo(i, now);
+        infoDue = now + RECEIVER_BEACON_INTERVAL_MS + random(0, PHANTOM_BEACON_JITTER_MS);
+        portENTER_CRITICAL(&phantomMux);
+        phantoms[i].nextInfoMs = infoDue;
+        portEXIT_CRITICAL(&phantomMux);
+      }
+      if (static_cast<int32_t>(infoDue - nextDue) < 0) {
+        nextDue = infoDue;
+      }
+    }
+  }
+
+  bool finalReport = finalReportPending;
+  if (finalReport || (running && static_cast<int32_t>(now - nextReportMs) >= 0)) {
+    finalReportPending = false;
+    sendReport();
+    nextReportMs = now + PHANTOM_REPORT_INTERVAL_MS;
+  }
+
+  if (running) {
+    if (static_cast<int32_t>(nextReportMs - nextDue) < 0) {
+      nextDue = nextReportMs;
+    }
+    schedulerArm(SCHED_PHANTOM, nextDue);
+  }
+}
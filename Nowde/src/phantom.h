@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "nowde_config.h"
+
+// Phantom receivers ("Phantoms" in the Bridge): a sender emulates up to
+// PHANTOM_MAX_RECEIVERS receivers of its own. Fan-out, the peer tables and
+// RUNNING_STATE can then be load-tested at receiver counts we have no boards
+// for. This is a test feature, like the RF simulation.
+//
+// Each phantom has a locally administered MAC (02:50:48:4E:00:<index>) and a
+// layer, assigned round-robin over the requested ones. It enters through the
+// real receiver path: every RECEIVER_BEACON_INTERVAL_MS, plus up to
+// PHANTOM_BEACON_JITTER_MS, its ReceiverInfo goes to handleReceiverInfo.
+//
+// Sync frames are tracked per phantom on the frame's layer:
+//  - a frame counts as expected when the sender emits it (phantomNoteSync)
+//  - it counts as arrived when it reaches the radio (phantomOnAir): handed to
+//    esp_now_send, or addressed to a phantom MAC, which never goes on the air
+// Frames that never arrive were lost to the RF simulation, a TX queue overflow
+// or coalescing. Latency is the time between the two points.
+//
+// PHANTOM_REPORT goes to the Bridge every PHANTOM_REPORT_INTERVAL_MS and once
+// more on stop. Stopped phantoms time out of the receiver table like real ones.
+
+// MIDI task (PHANTOM_RECEIVERS). Replaces any running set; sender mode only.
+void phantomStart(uint8_t count, const char (*layers)[MAX_LAYER_LENGTH], uint8_t layerCount);
+void phantomStop();
+
+bool phantomIsMac(const uint8_t* mac);
+
+// A sync frame (MediaSyncPacket or MediaSyncBatchPacket) emitted towards mac
+// (broadcast or one receiver), before it is queued or simulated
+void phantomNoteSync(const uint8_t* mac, const uint8_t* frame, size_t length);
+// A frame reaching the radio (any task): sync arrival, or a layer change
+void phantomOnAir(const uint8_t* mac, const uint8_t* frame, size_t length);
+
+// ESP-NOW task (SCHED_PHANTOM): ReceiverInfo beacons and reports
+void phantomTick(uint32_t now);
@@ -1,30 +1,35 @@
 #include "receiver_mode.h"
 
 #include <cstring>
+#include <cstddef>
+#include <algorithm>
 
 #include <esp_now.h>
+#include <esp_timer.h>
 
+#include "espnow_tx.h"
+#include "layer_registry.h"
+#include "metrics.h"
 #include "midi.h"
+#include "mtc.h"
 #include "nowde_config.h"
+#include "nowde_log.h"
 #include "nowde_state.h"
+#include "peer_table.h"
+#include "scheduled_action.h"
+#include "sync_estimator.h"
+#include "sync_redundancy.h"
+#include "warm_boot.h"
 
 void cleanupSenderTable() {
   unsigned long now = millis();
   for (int i = 0; i < MAX_SENDERS; i++) {
     if (senderTable[i].active && (now - senderTable[i].lastSeen > SENDER_TIMEOUT_MS)) {
-      DEBUG_SERIAL.println("\n[TIMEOUT] Sender removed");
-      DEBUG_SERIAL.print("  MAC: ");
-      for (int j = 0; j < 6; j++) {
-        DEBUG_SERIAL.printf("%02X", senderTable[i].mac[j]);
-        if (j < 5) {
-          DEBUG_SERIAL.print(":");
-        }
-      }
-      DEBUG_SERIAL.println();
-      DEBUG_SERIAL.printf("  Remaining: %d\r\n\r\n", countActiveSenders() - 1);
+      LOG_INFO(LOG_CAT_RECEIVER, "[TIMEOUT] Sender removed: " LOG_MAC_FMT ", remaining: %d\r\n",
+               LOG_MAC_ARGS(senderTable[i].mac), countActiveSenders() - 1);
 
-      esp_now_del_peer(senderTable[i].mac);
-      senderTable[i].active = false;
+      releaseEspNowPeer(senderTable[i].mac);
+      removeSender(i);
     }
   }
 }
@@ -42,10 +47,42 @@ void sendReceiverInfo() {
   
   // Populate current playing media index (0 = stopped)
   info.mediaIndex = mediaSyncState.currentIndex;
+  syncEstimatorReport(&info.sync);
+
+  // Link window: everything since the previous ReceiverInfo
+  static unsigned long lastWindowStart = 0;
+  static uint32_t lastSyncReceived = 0;
+  static uint32_t lastSyncDiscarded = 0;
+  unsigned long now = millis();
+  uint32_t syncReceived = metricsCounter(METRIC_SYNC_RX);
+  uint32_t syncDiscarded = metricsCounter(METRIC_DISCARD_DESYNC) + metricsCounter(METRIC_DISCARD_SENDER) +
+                           metricsCounter(METRIC_DISCARD_MALFORMED);
+  info.link.syncReceived = static_cast<uint16_t>(std::min<uint32_t>(UINT16_MAX, syncReceived - lastSyncReceived));
+  info.link.syncDiscarded = static_cast<uint16_t>(std::min<uint32_t>(UINT16_MAX, syncDiscarded - lastSyncDiscarded));
+  info.link.linkLost = static_cast<uint16_t>(metricsCounter(METRIC_LINK_LOST));
+  info.link.windowMs = static_cast<uint16_t>(std::min<unsigned long>(UINT16_MAX, now - lastWindowStart));
+  lastWindowStart = now;
+  lastSyncReceived = syncReceived;
+  lastSyncDiscarded = syncDiscarded;
+
+  bool meshSynced = meshClock.getSyncState() == SyncState::SYNCED;
+  info.clock.corrected = static_cast<uint16_t>(metricsCounter(METRIC_SYNC_CORRECTED));
+  info.clock.discarded = static_cast<uint16_t>(metricsCounter(METRIC_DISCARD_DESYNC));
 
   for (int i = 0; i < MAX_SENDERS; i++) {
     if (senderTable[i].active) {
-      esp_now_send(senderTable[i].mac, reinterpret_cast<uint8_t*>(&info), sizeof(info));
+      // Clock offset and RSSI are per sender, the rest of the report is shared
+      SenderEntry& sender = senderTable[i];
+      info.clock.flags = (meshSynced ? CLOCK_REPORT_FLAG_MESH_SYNCED : 0) |
+                         (sender.clockOffsetValid ? CLOCK_REPORT_FLAG_OFFSET_VALID : 0);
+      info.clock.senderOffsetMs = static_cast<int16_t>(
+          std::max<int32_t>(INT16_MIN, std::min<int32_t>(INT16_MAX, sender.clockOffsetMs)));
+      info.link.rssiAvgDbm = sender.rssiCount ? static_cast<int8_t>(sender.rssiSum / sender.rssiCount) : 0;
+      info.link.rssiMinDbm = sender.rssiCount ? sender.rssiMin : 0;
+      sender.rssiSum = 0;
+      sender.rssiCount = 0;
+      sender.rssiMin = 0;
+      espnowTxSend(sender.mac, &info, sizeof(info), ESPNOW_TX_KEY_RECEIVER_INFO);
     }
   }
 
@@ -53,66 +90,107 @@ void sendReceiverInfo() {
   // Info packets are sent every ~1s but not logged
 }
 
-void processMediaSyncPacket(const uint8_t* data, int len) {
-  if (len < static_cast<int>(sizeof(MediaSyncPacket))) {
+void sendReceiverMetrics() {
+  if (!receiverModeEnabled) {
     return;
   }
 
-  const MediaSyncPacket* syncPacket = reinterpret_cast<const MediaSyncPacket*>(data);
-
-  if (strncmp(syncPacket->layer, subscribedLayer, MAX_LAYER_LENGTH) != 0) {
-    return;
+  MetricsPacket packet;
+  metricsSnapshot(&packet.snapshot);
+  for (int i = 0; i < MAX_SENDERS; i++) {
+    if (senderTable[i].active) {
+      espnowTxSend(senderTable[i].mac, &packet, sizeof(packet), ESPNOW_TX_KEY_METRICS);
+    }
   }
+}
 
+namespace {
+
+// Applies one layer state stamped by the sender at meshTimestamp (sender's mesh clock).
+// rxTimeUs is when the frame came off the air (RxFrame::rxTimeUs).
+void applyMediaSync(int senderSlot, uint8_t mediaIndex, uint32_t positionMs, uint8_t state,
+                    uint32_t meshTimestamp, uint32_t rxTimeUs) {
   uint32_t currentMeshTime = meshClock.meshMillis();
-  int32_t timeDelta = static_cast<int32_t>(currentMeshTime - syncPacket->meshTimestamp);
+  int32_t timeDelta = static_cast<int32_t>(currentMeshTime - meshTimestamp);
 
   if (abs(timeDelta) > static_cast<int32_t>(CLOCK_DESYNC_THRESHOLD_MS)) {
-    // Log packet discard with details
-    static unsigned long lastDiscardLog = 0;
-    if (millis() - lastDiscardLog > 1000) {  // Log at most once per second
-      DEBUG_SERIAL.printf("[MEDIA SYNC] PACKET DISCARDED - Clock desync! Delta=%ld ms (threshold=%lu ms)\r\n",
-                         timeDelta, CLOCK_DESYNC_THRESHOLD_MS);
-      lastDiscardLog = millis();
+    bool corrected = false;
+#if CLOCK_DESYNC_ADAPTIVE
+    // Our mesh clock has not converged on the sender's yet (boot, sender restart):
+    // move the timestamp into our time base with the offset seen in its beacons
+    const SenderEntry& sender = senderTable[senderSlot];
+    if (sender.clockOffsetValid && (millis() - sender.clockOffsetTime) <= SENDER_OFFSET_MAX_AGE_MS) {
+      uint32_t localTimestamp = meshTimestamp - static_cast<uint32_t>(sender.clockOffsetMs);
+      int32_t localDelta = static_cast<int32_t>(currentMeshTime - localTimestamp);
+      if (abs(localDelta) <= static_cast<int32_t>(CLOCK_DESYNC_THRESHOLD_MS)) {
+        meshTimestamp = localTimestamp;
+        timeDelta = localDelta;
+        corrected = true;
+        metricsCount(METRIC_SYNC_CORRECTED);
+      }
+    }
+#endif
+    if (!corrected) {
+      metricsCount(METRIC_DISCARD_DESYNC);
+
+      // Log packet discard with details
+      static unsigned long lastDiscardLog = 0;
+      if (millis() - lastDiscardLog > 1000) {  // Log at most once per second
+        LOG_DEFER(WARN, LOG_CAT_RECEIVER, "[MEDIA SYNC] PACKET DISCARDED - Clock desync! Delta=%ld ms (threshold=%lu ms)\r\n",
+                  static_cast<int32_t>(timeDelta), static_cast<uint32_t>(CLOCK_DESYNC_THRESHOLD_MS));
+        lastDiscardLog = millis();
+      }
+      return;
     }
-    return;
   }
 
+  metricsCount(METRIC_SYNC_RX);
+  metricsRecordUs(METRIC_HIST_SYNC_DELTA, static_cast<uint32_t>(abs(timeDelta)) * 1000);
+
   unsigned long now = millis();
-  uint32_t compensatedPositionMs = syncPacket->positionMs;
-  if (syncPacket->state == 1 && timeDelta > 0) {
+  uint32_t compensatedPositionMs = positionMs;
+  if (state == 1 && timeDelta > 0) {
     compensatedPositionMs += timeDelta;
   }
 
   // Handle state change to stopped
-  bool stateChangedToStopped = (mediaSyncState.currentState == 1 && syncPacket->state == 0);
-  bool stateChangedToPlaying = (mediaSyncState.currentState == 0 && syncPacket->state == 1);
+  bool stateChangedToStopped = (mediaSyncState.currentState == 1 && state == 0);
+  bool stateChangedToPlaying = (mediaSyncState.currentState == 0 && state == 1);
   
   // Update sync state
-  mediaSyncState.currentIndex = syncPacket->mediaIndex;
+  mediaSyncState.currentIndex = mediaIndex;
   mediaSyncState.currentPositionMs = compensatedPositionMs;
-  mediaSyncState.currentState = syncPacket->state;
+  mediaSyncState.currentState = state;
   mediaSyncState.lastSyncTime = now;
   mediaSyncState.linkLost = false;
-  
-  // Reset local clock reference when receiving sync
-  if (syncPacket->state == 1) {
-    mediaSyncState.localClockStartTime = now;
+  warmBootSave();
+
+  // Feed the estimator the sample at the instant the sender stamped it, so
+  // air/queue latency does not count as position error
+  if (state == 1) {
+    if (stateChangedToPlaying || !mtcRunning()) {
+      mtcStart(positionMs, meshTimestamp);
+    } else {
+      mtcUpdate(positionMs, meshTimestamp);
+    }
+    mtcNoteSampleRx(rxTimeUs);
+  } else if (stateChangedToStopped) {
+    mtcStop(compensatedPositionMs);
   }
 
   // Handle media index changes (but not when stopping - that's handled by state transition)
-  if (mediaSyncState.lastSentIndex != syncPacket->mediaIndex && syncPacket->mediaIndex != 0) {
-    midiSendCC100(syncPacket->mediaIndex);
-    mediaSyncState.lastSentIndex = syncPacket->mediaIndex;
+  if (mediaSyncState.lastSentIndex != mediaIndex && mediaIndex != 0) {
+    midiSendCC100(mediaIndex);
+    mediaSyncState.lastSentIndex = mediaIndex;
     mediaSyncState.lastCC100SendTime = now;
   }
 
   // Handle state transitions
   if (stateChangedToPlaying) {
-    DEBUG_SERIAL.println("[MEDIA SYNC] Media started playing");
+    LOG_DEFER(INFO, LOG_CAT_RECEIVER, "[MEDIA SYNC] Media started playing\r\n");
   } else if (stateChangedToStopped) {
     // Just stopped: send CC#100 = 0 to signal stop (only place where CC#100=0 is sent)
-    DEBUG_SERIAL.println("[MEDIA SYNC] Media stopped - sending CC#100=0");
+    LOG_DEFER(INFO, LOG_CAT_RECEIVER, "[MEDIA SYNC] Media stopped - sending CC#100=0\r\n");
     midiSendCC100(0);
     mediaSyncState.lastSentIndex = 0;
     mediaSyncState.lastCC100SendTime = now;
@@ -131,8 +209,214 @@ void processMediaSyncPacket(const uint8_t* data, int len) {
   static int syncCount = 0;
   syncCount++;
   if (syncCount % 50 == 0) {  // Every 5 seconds at 10Hz
-    DEBUG_SERIAL.printf("[MEDIA SYNC RX] #%d Index=%d, Pos=%lu ms (compensated +%ld ms), State=%s\r\n",
-                       syncCount, syncPacket->mediaIndex, compensatedPositionMs, timeDelta,
-                       syncPacket->state == 1 ? "playing" : "stopped");
+    LOG_DEFER(INFO, LOG_CAT_RECEIVER, "[MEDIA SYNC RX] #%d Index=%d, Pos=%lu ms (compensated +%ld ms), State=%s\r\n",
+              syncCount, mediaIndex, compensatedPositionMs, static_cast<int32_t>(timeDelta),
+              state == 1 ? "playing" : "stopped");
   }
 }
+
+}  // namespace
+
+void noteSenderRssi(const uint8_t* srcMac, int8_t rssi) {
+  int slot = findSender(srcMac);
+  if (slot == -1 || rssi == 0) {
+    return;
+  }
+
+  SenderEntry& sender = senderTable[slot];
+  if (sender.rssiCount == 0 || rssi < sender.rssiMin) {
+    sender.rssiMin = rssi;
+  }
+  if (sender.rssiCount < UINT16_MAX) {
+    sender.rssiSum += rssi;
+    sender.rssiCount++;
+  }
+}
+
+void updateSenderClockOffset(int senderSlot, uint32_t senderMeshTime, uint32_t rxTimeUs) {
+  // Our mesh time when the beacon arrived, not when the task got to it
+  uint32_t queuedMs = static_cast<uint32_t>(esp_timer_get_time() - rxTimeUs) / 1000;
+  uint32_t arrivalMeshTime = meshClock.meshMillis() - queuedMs;
+  int32_t sample = static_cast<int32_t>(senderMeshTime + TRANSMISSION_DELAY_US / 1000 - arrivalMeshTime);
+
+  SenderEntry& sender = senderTable[senderSlot];
+  if (!sender.clockOffsetValid || abs(sample - sender.clockOffsetMs) > static_cast<int32_t>(SENDER_OFFSET_RESET_MS)) {
+    // First sample, or one of the clocks stepped: start over from this beacon
+    sender.clockOffsetMs = sample;
+    sender.clockOffsetValid = true;
+  } else {
+    sender.clockOffsetMs += (sample - sender.clockOffsetMs) / 4;
+  }
+  sender.clockOffsetTime = millis();
+}
+
+void forgetSenderLayerIds() {
+  for (int i = 0; i < MAX_SENDERS; i++) {
+    senderTable[i].layerId = LAYER_ID_NONE;
+    senderTable[i].transitionSeqValid = false;
+  }
+  scheduledActionCancelAll();
+}
+
+bool scheduleSyncTransition(int senderSlot, const uint8_t* data, int len, int baseLen, uint32_t frameMeshTime) {
+#if SYNC_ACTION_LEAD_MS > 0
+  SenderEntry& sender = senderTable[senderSlot];
+  const SyncTransition* transition = syncRedundancyFind(data, len, baseLen, sender.layerId);
+  if (transition != nullptr &&
+      (!sender.transitionSeqValid || static_cast<int8_t>(transition->sequence - sender.transitionSeq) > 0)) {
+    // The execution time is in the sender's mesh time: move it into ours
+    // the way applyMediaSync does with sample timestamps
+    uint32_t meshNow = meshClock.meshMillis();
+    int32_t offsetMs = 0;
+    bool clockUsable = abs(static_cast<int32_t>(meshNow - frameMeshTime)) <= static_cast<int32_t>(CLOCK_DESYNC_THRESHOLD_MS);
+#if CLOCK_DESYNC_ADAPTIVE
+    if (!clockUsable && sender.clockOffsetValid && (millis() - sender.clockOffsetTime) <= SENDER_OFFSET_MAX_AGE_MS) {
+      offsetMs = sender.clockOffsetMs;
+      clockUsable = abs(static_cast<int32_t>(meshNow - (frameMeshTime - offsetMs))) <=
+                    static_cast<int32_t>(CLOCK_DESYNC_THRESHOLD_MS);
+    }
+#endif
+    ScheduledAction action;
+    action.meshTime = transition->meshTimestamp - static_cast<uint32_t>(offsetMs);
+    action.senderSlot = static_cast<int8_t>(senderSlot);
+    action.transition = *transition;
+    int32_t aheadMs = static_cast<int32_t>(action.meshTime - meshNow);
+
+    // Already due, or too far out to trust: applySyncRedundancy applies it now
+    if (clockUsable && aheadMs > 0 && aheadMs <= static_cast<int32_t>(SYNC_ACTION_MAX_HOLD_MS) &&
+        scheduledActionPost(action)) {
+      sender.transitionSeq = transition->sequence;
+      sender.transitionSeqValid = true;
+      LOG_DEFER(DEBUG, LOG_CAT_RECEIVER, "[MEDIA SYNC] Transition #%u scheduled in %ld ms\r\n",
+                transition->sequence, aheadMs);
+    }
+  }
+  return scheduledActionPending(senderSlot, sender.layerId);
+#else
+  (void)senderSlot;
+  (void)data;
+  (void)len;
+  (void)baseLen;
+  (void)frameMeshTime;
+  return false;
+#endif
+}
+
+void applyScheduledTransition(const ScheduledAction& action) {
+  int slot = action.senderSlot;
+  const SyncTransition& transition = action.transition;
+  if (slot < 0 || slot >= MAX_SENDERS || !senderTable[slot].active ||
+      senderTable[slot].layerId != transition.layerId) {
+    return;
+  }
+  // A newer transition was applied meanwhile (recovered from a trailer)
+  if (static_cast<int8_t>(transition.sequence - senderTable[slot].transitionSeq) < 0) {
+    return;
+  }
+
+  LOG_DEFER(INFO, LOG_CAT_RECEIVER, "[MEDIA SYNC] Transition #%u at mesh %lu: Index=%u, State=%u\r\n",
+            transition.sequence, action.meshTime, transition.mediaIndex, transition.state);
+  applyMediaSync(slot, transition.mediaIndex, transition.positionMs, transition.state, action.meshTime,
+                 static_cast<uint32_t>(esp_timer_get_time()));
+}
+
+void applySyncRedundancy(int senderSlot, const uint8_t* data, int len, int baseLen, uint32_t frameMeshTime,
+                         uint32_t rxTimeUs, bool layerApplied) {
+  SenderEntry& sender = senderTable[senderSlot];
+  const SyncTransition* transition = syncRedundancyFind(data, len, baseLen, sender.layerId);
+  if (transition == nullptr) {
+    return;
+  }
+
+  // First trailer from this sender (or for this layer): nothing to compare against yet
+  uint8_t lastSeq = sender.transitionSeq;
+  bool known = sender.transitionSeqValid;
+  sender.transitionSeq = transition->sequence;
+  sender.transitionSeqValid = true;
+  if (!known || layerApplied) {
+    return;  // The frame's own entry already carried the current state
+  }
+
+  // Only newer transitions: a reordered frame must not roll the layer back
+  if (static_cast<int8_t>(transition->sequence - lastSeq) <= 0) {
+    sender.transitionSeq = lastSeq;
+    return;
+  }
+
+  // Replay the transition as a sample stamped with this frame's time
+  uint32_t positionMs = transition->positionMs;
+  if (transition->state == 1) {
+    positionMs += frameMeshTime - transition->meshTimestamp;
+  }
+  metricsCount(METRIC_SYNC_RECOVERED);
+  LOG_DEFER(INFO, LOG_CAT_RECEIVER, "[MEDIA SYNC] Recovered missed transition #%u: Index=%u, State=%u\r\n",
+            transition->sequence, transition->mediaIndex, transition->state);
+  applyMediaSync(senderSlot, transition->mediaIndex, positionMs, transition->state, frameMeshTime, rxTimeUs);
+}
+
+void processMediaSyncPacket(const uint8_t* srcMac, const uint8_t* data, int len, uint32_t rxTimeUs) {
+  if (len < static_cast<int>(sizeof(MediaSyncPacket))) {
+    metricsCount(METRIC_DISCARD_MALFORMED);
+    return;
+  }
+
+  const MediaSyncPacket* syncPacket = reinterpret_cast<const MediaSyncPacket*>(data);
+
+  // Layer IDs are per sender; ours is learned from that sender's beacon
+  int senderSlot = findSender(srcMac);
+  if (senderSlot == -1 || senderTable[senderSlot].layerId == LAYER_ID_NONE) {
+    metricsCount(METRIC_DISCARD_SENDER);
+    return;
+  }
+
+  // Our layer is held while a transition announced for a later instant is pending
+  bool held = scheduleSyncTransition(senderSlot, data, len, sizeof(MediaSyncPacket), syncPacket->meshTimestamp);
+
+  // Another layer's frame still carries the sender's recent transitions
+  bool ours = syncPacket->layerId == senderTable[senderSlot].layerId;
+  if (ours && !held) {
+    applyMediaSync(senderSlot, syncPacket->mediaIndex, syncPacket->positionMs, syncPacket->state,
+                   syncPacket->meshTimestamp, rxTimeUs);
+  } else if (!ours) {
+    metricsCount(METRIC_DISCARD_SENDER);
+  }
+  applySyncRedundancy(senderSlot, data, len, sizeof(MediaSyncPacket), syncPacket->meshTimestamp, rxTimeUs,
+                      ours && !held);
+}
+
+void processMediaSyncBatchPacket(const uint8_t* srcMac, const uint8_t* data, int len, uint32_t rxTimeUs) {
+  constexpr int HEADER_LEN = offsetof(MediaSyncBatchPacket, entries);
+  if (len < HEADER_LEN) {
+    metricsCount(METRIC_DISCARD_MALFORMED);
+    return;
+  }
+
+  const MediaSyncBatchPacket* batch = reinterpret_cast<const MediaSyncBatchPacket*>(data);
+  uint8_t count = std::min<uint8_t>(batch->count, MEDIA_SYNC_BATCH_MAX_LAYERS);
+  if (len < HEADER_LEN + count * static_cast<int>(sizeof(MediaSyncBatchEntry))) {
+    metricsCount(METRIC_DISCARD_MALFORMED);
+    return;
+  }
+
+  int senderSlot = findSender(srcMac);
+  if (senderSlot == -1 || senderTable[senderSlot].layerId == LAYER_ID_NONE) {
+    metricsCount(METRIC_DISCARD_SENDER);
+    return;
+  }
+
+  int baseLen = HEADER_LEN + count * static_cast<int>(sizeof(MediaSyncBatchEntry));
+  bool held = scheduleSyncTransition(senderSlot, data, len, baseLen, batch->meshTimestamp);
+
+  uint8_t subscribedId = senderTable[senderSlot].layerId;
+  bool ours = false;
+  for (uint8_t i = 0; i < count && !held; i++) {
+    const MediaSyncBatchEntry& entry = batch->entries[i];
+    if (entry.layerId == subscribedId) {
+      applyMediaSync(senderSlot, entry.mediaIndex, entry.positionMs, entry.state, batch->meshTimestamp, rxTimeUs);
+      ours = true;
+      break;
+    }
+  }
+
+  applySyncRedundancy(senderSlot, data, len, baseLen, batch->meshTimestamp, rxTimeUs, ours);
+}
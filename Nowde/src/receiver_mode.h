@@ -2,6 +2,29 @@
 
 #include <Arduino.h>
 
+#include "scheduled_action.h"
+
 void cleanupSenderTable();
 void sendReceiverInfo();
-void processMediaSyncPacket(const uint8_t* data, int len);
+// Account the RSSI of a frame heard from a sender (ignored for unknown MACs)
+void noteSenderRssi(const uint8_t* srcMac, int8_t rssi);
+// Unicast our MetricsSnapshot to every known sender (SCHED_RECEIVER_METRICS)
+void sendReceiverMetrics();
+// Fold a beacon's mesh timestamp into the sender's clock offset estimate
+void updateSenderClockOffset(int senderSlot, uint32_t senderMeshTime, uint32_t rxTimeUs);
+// Drop the layer IDs learned from sender beacons (after subscribedLayer changes)
+void forgetSenderLayerIds();
+// Apply the newest transition for our layer from a frame's SyncRedundancyTrailer
+// (at baseLen) if we have not seen it; layerApplied when the frame's own entry
+// for our layer was just applied (only the sequence is recorded then)
+void applySyncRedundancy(int senderSlot, const uint8_t* data, int len, int baseLen, uint32_t frameMeshTime,
+                         uint32_t rxTimeUs, bool layerApplied);
+// Schedule the newest transition for our layer from a frame's trailer when its
+// execution time is still ahead (scheduled_action.h). Returns true while a
+// transition of that sender is pending: the frame's own entry must not be
+// applied before it fires. Call before applying the frame.
+bool scheduleSyncTransition(int senderSlot, const uint8_t* data, int len, int baseLen, uint32_t frameMeshTime);
+// ScheduledActionHandler: applies a transition at its mesh instant
+void applyScheduledTransition(const ScheduledAction& action);
+void processMediaSyncPacket(const uint8_t* srcMac, const uint8_t* data, int len, uint32_t rxTimeUs);
+void processMediaSyncBatchPacket(const uint8_t* srcMac, const uint8_t* data, int len, uint32_t rxTimeUs);
@@ -0,0 +1,195 @@
+#include "rf_sim.h"
+
+#include <cstring>
+
+#include <esp_now.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "espnow_tx.h"
+#include "metrics.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "peer_table.h"
+
+static_assert((RF_SIM_WHEEL_SLOTS & (RF_SIM_WHEEL_SLOTS - 1)) == 0, "RF_SIM_WHEEL_SLOTS must be a power of two");
+
+namespace {
+
+constexpr int16_t NONE = -1;
+
+struct SimPacket {
+  uint32_t dueTick;
+  int16_t next;
+  uint8_t length;
+  uint8_t mac[6];
+  uint8_t data[SYNC_FRAME_MAX_LEN];
+};
+
+// Slot lists hold every packet whose due tick maps to the slot; a packet only
+// fires on the pass where its tick matches, so delays may exceed one wheel turn
+SimPacket pool[RF_SIM_MAX_PACKETS];
+int16_t wheel[RF_SIM_WHEEL_SLOTS];
+int16_t freeHead = NONE;
+uint32_t currentTick = 0;  // Last tick the timer processed
+
+portMUX_TYPE simMux = portMUX_INITIALIZER_UNLOCKED;
+esp_timer_handle_t wheelTimer = nullptr;
+bool timerRunning = false;  // Only changed by the MIDI task
+uint32_t outageUntilMs = 0;
+bool outageActive = false;
+
+uint32_t nowTick() {
+  return static_cast<uint32_t>(esp_timer_get_time() / (RF_SIM_TICK_MS * 1000));
+}
+
+void clearPool() {
+  for (int i = 0; i < RF_SIM_WHEEL_SLOTS; i++) {
+    wheel[i] = NONE;
+  }
+  for (int i = 0; i < RF_SIM_MAX_PACKETS; i++) {
+    pool[i].next = (i + 1 < RF_SIM_MAX_PACKETS) ? i + 1 : NONE;
+  }
+  freeHead = 0;
+}
+
+// Back to the free list. Frames the timer already unlinked are freed by the timer.
+void drainWheel() {
+  for (int i = 0; i < RF_SIM_WHEEL_SLOTS; i++) {
+    while (wheel[i] != NONE) {
+      int16_t index = wheel[i];
+      wheel[i] = pool[index].next;
+      pool[index].next = freeHead;
+      freeHead = index;
+    }
+  }
+}
+
+// esp_timer task: unlink everything that is due, then send outside the lock
+void onWheelTick(void* arg) {
+  int16_t due = NONE;
+  int16_t* dueTail = &due;
+
+  portENTER_CRITICAL(&simMux);
+  uint32_t target = nowTick();
+  while (static_cast<int32_t>(target - currentTick) > 0) {
+    currentTick++;
+    int16_t* link = &wheel[currentTick & (RF_SIM_WHEEL_SLOTS - 1)];
+    while (*link != NONE) {
+      SimPacket& packet = pool[*link];
+      if (packet.dueTick == currentTick) {
+        int16_t index = *link;
+        *link = packet.next;
+        packet.next = NONE;
+        *dueTail = index;  // Appended: frames due on the same tick keep their order
+        dueTail = &packet.next;
+      } else {
+        link = &packet.next;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&simMux);
+
+  while (due != NONE) {
+    SimPacket& packet = pool[due];
+    // No coalescing: overtaking frames are what the simulation is for
+    espnowTxSend(packet.mac, packet.data, packet.length);
+
+    int16_t next = packet.next;
+    portENTER_CRITICAL(&simMux);
+    packet.next = freeHead;
+    freeHead = due;
+    portEXIT_CRITICAL(&simMux);
+    due = next;
+  }
+}
+
+// Burst outage model: once started, every frame is lost until it ends
+bool inOutage(uint32_t nowMs) {
+  if (outageActive && static_cast<int32_t>(nowMs - outageUntilMs) < 0) {
+    return true;
+  }
+  outageActive = false;
+  if (rfSimOutagePerMille > 0 && rfSimOutageMs > 0 && random(0, 1000) < rfSimOutagePerMille) {
+    outageActive = true;
+    outageUntilMs = nowMs + rfSimOutageMs;
+    LOG_DEFER(INFO, LOG_CAT_ESPNOW, "[RF SIM] Outage for %u ms\r\n", rfSimOutageMs);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+void rfSimInit() {
+  clearPool();
+
+  esp_timer_create_args_t args = {};
+  args.callback = onWheelTick;
+  args.arg = nullptr;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "rf_sim";
+  args.skip_unhandled_events = true;  // Late ticks catch up through currentTick
+
+  if (esp_timer_create(&args, &wheelTimer) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_ESPNOW, "[ERROR] RF simulation timer creation failed!\r\n");
+    wheelTimer = nullptr;
+  }
+}
+
+void rfSimSubmit(const uint8_t* mac, const void* frame, size_t length) {
+  if (!wheelTimer || length > sizeof(SimPacket::data)) {
+    return;
+  }
+  if (inOutage(millis())) {
+    return;
+  }
+  if (rfSimLossPercent > 0 && random(0, 100) < rfSimLossPercent) {
+    return;
+  }
+
+  uint32_t delayMs = random(0, rfSimMaxDelayMs + 1);
+  if (rfSimReorderPercent > 0 && random(0, 100) < rfSimReorderPercent) {
+    delayMs += RF_SIM_REORDER_HOLD_MS;
+  }
+  uint32_t delayTicks = delayMs / RF_SIM_TICK_MS;
+
+  bool startTimer = !timerRunning;
+  portENTER_CRITICAL(&simMux);
+  if (startTimer) {
+    currentTick = nowTick();
+  }
+  int16_t index = freeHead;
+  if (index != NONE) {
+    SimPacket& packet = pool[index];
+    freeHead = packet.next;
+    packet.dueTick = currentTick + (delayTicks > 0 ? delayTicks : 1);
+    packet.length = static_cast<uint8_t>(length);
+    memcpy(packet.mac, mac, 6);
+    memcpy(packet.data, frame, length);
+    int16_t* slot = &wheel[packet.dueTick & (RF_SIM_WHEEL_SLOTS - 1)];
+    packet.next = *slot;
+    *slot = index;
+  }
+  portEXIT_CRITICAL(&simMux);
+
+  if (index == NONE) {
+    metricsCount(METRIC_RF_SIM_OVERFLOW);
+    return;
+  }
+  if (startTimer) {
+    timerRunning = esp_timer_start_periodic(wheelTimer, RF_SIM_TICK_MS * 1000) == ESP_OK;
+  }
+}
+
+void rfSimReset() {
+  if (timerRunning) {
+    esp_timer_stop(wheelTimer);
+    timerRunning = false;
+  }
+  portENTER_CRITICAL(&simMux);
+  drainWheel();
+  portEXIT_CRITICAL(&simMux);
+  outageActive = false;
+}
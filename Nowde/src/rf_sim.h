@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Arduino.h>
+
+// RF simulation ("Simulate Bad RF" in the Bridge): sync frames go through a
+// simulated link instead of straight to esp_now_send, so the receivers' sync
+// estimator can be load-tested without real interference.
+//
+// Each frame is, in order: dropped while a burst outage is running (one starts
+// with rfSimOutagePerMille per frame and lasts rfSimOutageMs), dropped with
+// rfSimLossPercent, then delayed by random(0, rfSimMaxDelayMs) ms, plus
+// RF_SIM_REORDER_HOLD_MS for rfSimReorderPercent of frames so they land behind
+// newer ones. Delayed frames sit in a hashed timing wheel (1 ms slots) that an
+// esp_timer drains, so send times do not depend on the ESP-NOW task's wakeups.
+void rfSimInit();
+// MIDI task only (like rfSimReset): it also starts the wheel timer
+void rfSimSubmit(const uint8_t* mac, const void* frame, size_t length);
+// Drop everything in flight and stop the timer (simulation turned off)
+void rfSimReset();
@@ -0,0 +1,202 @@
+#include "running_state.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "midi.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "scheduler.h"
+#include "sysex.h"
+
+namespace {
+
+constexpr int JOIN_BYTES = 2 + 42 + 13 + 8 + 13 + 12;
+constexpr int UPDATE_BYTES = 2 + 6 + 13 + 8 + 13 + 12;
+constexpr int LEAVE_BYTES = 2;
+constexpr int HEADER_BYTES = 3 + 5 + 5 + 1;
+
+constexpr int16_t RSSI_CHANGE_DB = 3;
+constexpr int16_t SYNC_CHANGE_TENTHS_MS = 10;
+
+// What the Bridge was last told about each slot (ESP-NOW task only)
+struct ReportedSlot {
+  bool present;
+  bool stale;
+  uint32_t reportedAt;
+  ReceiverEntry entry;
+};
+
+ReportedSlot reported[MAX_RECEIVERS];
+
+volatile bool subscribed = false;
+volatile bool resetPending = false;  // Set by subscribe (MIDI task), applied by the tick
+uint8_t sequence = 0;
+uint32_t lastMessageTime = 0;
+
+bool sameIdentity(const ReceiverEntry& a, const ReceiverEntry& b) {
+  return macEqual(a.mac, b.mac) &&
+         strncmp(a.layer, b.layer, MAX_LAYER_LENGTH) == 0 &&
+         a.version == b.version;
+}
+
+// Changes the Bridge displays right away; everything else waits for the refresh
+bool significantChange(const ReceiverEntry& now, const ReceiverEntry& was) {
+  return now.mediaIndex != was.mediaIndex ||
+         now.sync.flags != was.sync.flags ||
+         now.sync.jumps != was.sync.jumps ||
+         abs(now.sync.errorTenthsMs - was.sync.errorTenthsMs) >= SYNC_CHANGE_TENTHS_MS ||
+         abs(static_cast<int>(now.sync.jitterTenthsMs) - was.sync.jitterTenthsMs) >= SYNC_CHANGE_TENTHS_MS ||
+         now.clock.flags != was.clock.flags ||
+         now.clock.discarded != was.clock.discarded ||
+         now.link.linkLost != was.link.linkLost ||
+         (now.link.syncDiscarded != 0) != (was.link.syncDiscarded != 0) ||
+         abs(now.link.rssiAvgDbm - was.link.rssiAvgDbm) >= RSSI_CHANGE_DB ||
+         abs(now.uplinkRssiDbm - was.uplinkRssiDbm) >= RSSI_CHANGE_DB ||
+         now.tx.failed != was.tx.failed;
+}
+
+// Collects pending ops into messages of at most RUNNING_STATE_DELTA_MAX_BYTES
+class DeltaWriter {
+ public:
+  DeltaWriter(uint8_t flags, uint8_t totalReceivers) : flags_(flags), totalReceivers_(totalReceivers) {}
+
+  void op(uint8_t code, uint8_t slot, int bytes) {
+    if (count_ == MAX_OPS || (count_ > 0 && size_ + bytes > RUNNING_STATE_DELTA_MAX_BYTES)) {
+      send(RUNNING_STATE_DELTA_FLAG_MORE);
+    }
+    codes_[count_] = code;
+    slots_[count_] = slot;
+    count_++;
+    size_ += bytes;
+  }
+
+  // Ends the pass; with force an empty message (heartbeat) goes out too
+  void finish(bool force) {
+    if (count_ > 0 || force) {
+      send(0);
+    }
+  }
+
+ private:
+  static constexpr uint8_t MAX_OPS = 32;
+
+  void send(uint8_t extraFlags) {
+    midiSysexBegin(SYSEX_CMD_RUNNING_STATE_DELTA);
+    midiSysexEncodeU32(millis());
+    midiSysexByte(meshClock.getSyncState() == SyncState::SYNCED ? 1 : 0);
+    midiSysexByte(flags_ | extraFlags);
+    midiSysexByte(sequence);
+    midiSysexByte(totalReceivers_);
+    midiSysexByte(count_);
+    for (uint8_t i = 0; i < count_; i++) {
+      const ReceiverEntry& entry = reported[slots_[i]].entry;
+      midiSysexByte(codes_[i]);
+      midiSysexByte(slots_[i]);
+      if (codes_[i] == RUNNING_STATE_OP_JOIN) {
+        sysexEncodeReceiverBlock(entry);
+      } else if (codes_[i] == RUNNING_STATE_OP_UPDATE) {
+        midiSysexEncodeU32(millis() - entry.lastSeen);
+        midiSysexEncode(&entry.mediaIndex, 1);
+        midiSysexEncodeFlush();
+        sysexEncodeReceiverReports(entry);
+      }
+    }
+    midiSysexEnd();
+
+    sequence = (sequence + 1) & 0x7F;
+    lastMessageTime = millis();
+    flags_ = 0;  // RESET only applies to the first message
+    count_ = 0;
+    size_ = HEADER_BYTES;
+  }
+
+  uint8_t flags_;
+  uint8_t totalReceivers_;
+  uint8_t codes_[MAX_OPS];
+  uint8_t slots_[MAX_OPS];
+  uint8_t count_ = 0;
+  int size_ = HEADER_BYTES;
+};
+
+}  // namespace
+
+void runningStateSubscribe(bool enable) {
+  subscribed = enable;
+  if (enable) {
+    resetPending = true;
+    schedulerArm(SCHED_RUNNING_STATE_PUSH, millis());
+  } else {
+    schedulerCancel(SCHED_RUNNING_STATE_PUSH);
+  }
+  LOG_INFO(LOG_CAT_SYSEX, "[RUNNING_STATE] Subscription %s\r\n", enable ? "ON" : "OFF");
+}
+
+bool runningStateSubscribed() {
+  return subscribed;
+}
+
+void runningStatePushTick(uint32_t now) {
+  if (!subscribed || !senderModeEnabled) {
+    return;
+  }
+  schedulerArm(SCHED_RUNNING_STATE_PUSH, now + RUNNING_STATE_PUSH_INTERVAL_MS);
+
+  uint8_t flags = 0;
+  if (resetPending) {
+    resetPending = false;
+    flags = RUNNING_STATE_DELTA_FLAG_RESET;
+    for (int i = 0; i < MAX_RECEIVERS; i++) {
+      reported[i].present = false;
+    }
+  }
+
+  uint8_t totalReceivers = 0;
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    if (receiverTable[i].active && receiverTable[i].connected) {
+      totalReceivers++;
+    }
+  }
+
+  // The receiver table is only written by this task, so entries are read in place
+  DeltaWriter writer(flags, totalReceivers);
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    const ReceiverEntry& entry = receiverTable[i];
+    ReportedSlot& slot = reported[i];
+    bool present = entry.active && entry.connected;
+
+    if (!present) {
+      if (slot.present) {
+        slot.present = false;
+        writer.op(RUNNING_STATE_OP_LEAVE, i, LEAVE_BYTES);
+      }
+      continue;
+    }
+
+    bool stale = (millis() - entry.lastSeen) > RUNNING_STATE_STALE_MS;
+    uint8_t code = 0;
+    int bytes = 0;
+    if (!slot.present || !sameIdentity(entry, slot.entry)) {
+      code = RUNNING_STATE_OP_JOIN;
+      bytes = JOIN_BYTES;
+    } else if (stale != slot.stale || significantChange(entry, slot.entry) ||
+               (now - slot.reportedAt) >= RUNNING_STATE_REFRESH_MS) {
+      code = RUNNING_STATE_OP_UPDATE;
+      bytes = UPDATE_BYTES;
+    } else {
+      continue;
+    }
+
+    memcpy(&slot.entry, &entry, sizeof(entry));
+    slot.present = true;
+    slot.stale = stale;
+    slot.reportedAt = now;
+    writer.op(code, i, bytes);
+  }
+
+  writer.finish(flags != 0 || (now - lastMessageTime) >= RUNNING_STATE_HEARTBEAT_MS);
+
+  // The Bridge no longer polls, so metrics ride on the push cadence instead
+  sendMetricsReport();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Change-driven RUNNING_STATE. Once the Bridge subscribes, the sender diffs
+// the receiver table against what it last reported every
+// RUNNING_STATE_PUSH_INTERVAL_MS and sends RUNNING_STATE_DELTA ops keyed by
+// slot: JOIN (full block), UPDATE (reports only) and LEAVE. Small drifts in the
+// estimator/link numbers are held back until RUNNING_STATE_REFRESH_MS; an
+// empty delta every RUNNING_STATE_HEARTBEAT_MS tells the Bridge we are alive.
+// QUERY_RUNNING_STATE keeps working for Bridges that never subscribe.
+void runningStateSubscribe(bool enable);
+bool runningStateSubscribed();
+// SCHED_RUNNING_STATE_PUSH (ESP-NOW task); re-arms itself while subscribed
+void runningStatePushTick(uint32_t now);
@@ -0,0 +1,68 @@
+#include "rx_queue.h"
+
+#include <atomic>
+#include <cstring>
+
+#include <esp_timer.h>
+
+#include "nowde_config.h"
+
+namespace {
+
+static_assert((RX_QUEUE_SIZE & (RX_QUEUE_SIZE - 1)) == 0, "RX_QUEUE_SIZE must be a power of two");
+
+RxFrame ring[RX_QUEUE_SIZE];
+std::atomic<uint32_t> head{0};  // Next slot to write (producer only)
+std::atomic<uint32_t> tail{0};  // Next slot to read (consumer only)
+std::atomic<uint32_t> dropped{0};
+TaskHandle_t consumerTask = nullptr;
+
+}  // namespace
+
+void rxQueueSetConsumer(TaskHandle_t task) {
+  consumerTask = task;
+}
+
+bool rxQueuePush(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
+  if (len < 1 || len > ESP_NOW_MAX_DATA_LEN) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t h = head.load(std::memory_order_relaxed);
+  if (h - tail.load(std::memory_order_acquire) >= RX_QUEUE_SIZE) {
+    // Full: drop the newest frame, the consumer is behind anyway
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  RxFrame& frame = ring[h & (RX_QUEUE_SIZE - 1)];
+  memcpy(frame.srcMac, info->src_addr, 6);
+  frame.rssi = info->rx_ctrl ? static_cast<int8_t>(info->rx_ctrl->rssi) : 0;
+  frame.length = static_cast<uint8_t>(len);
+  frame.rxTimeUs = static_cast<uint32_t>(esp_timer_get_time());
+  memcpy(frame.data, data, len);
+
+  head.store(h + 1, std::memory_order_release);
+
+  if (consumerTask) {
+    xTaskNotifyGive(consumerTask);
+  }
+  return true;
+}
+
+const RxFrame* rxQueuePeek() {
+  uint32_t t = tail.load(std::memory_order_relaxed);
+  if (t == head.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return &ring[t & (RX_QUEUE_SIZE - 1)];
+}
+
+void rxQueueRelease() {
+  tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint32_t rxQueueDropped() {
+  return dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Received ESP-NOW frame, copied out of the WiFi driver callback
+struct RxFrame {
+  uint8_t srcMac[6];
+  int8_t rssi;
+  uint8_t length;
+  uint32_t rxTimeUs;  // esp_timer time when the callback ran
+  uint8_t data[ESP_NOW_MAX_DATA_LEN];
+};
+
+// Single-producer (WiFi RX callback) / single-consumer (ESP-NOW task) lock-free ring.
+// The producer only copies the frame and notifies the consumer task.
+void rxQueueSetConsumer(TaskHandle_t task);
+bool rxQueuePush(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+
+// Consumer side: peek the oldest frame in place, then release it when done.
+const RxFrame* rxQueuePeek();
+void rxQueueRelease();
+
+uint32_t rxQueueDropped();
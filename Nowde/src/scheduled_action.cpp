@@ -0,0 +1,117 @@
+#include "scheduled_action.h"
+
+#include <esp_timer.h>
+
+#include "nowde_log.h"
+#include "nowde_state.h"
+#include "scheduler.h"
+
+namespace {
+
+// Sorted by meshTime, earliest first (ESP-NOW task only)
+ScheduledAction actions[SCHEDULED_ACTION_SLOTS];
+uint8_t actionCount = 0;
+
+ScheduledActionHandler actionHandler = nullptr;
+esp_timer_handle_t actionTimer = nullptr;
+
+// esp_timer task: only wakes the ESP-NOW task
+void onActionTimer(void* arg) {
+  schedulerWake();
+}
+
+void removeAt(uint8_t index) {
+  for (uint8_t i = index; i + 1 < actionCount; i++) {
+    actions[i] = actions[i + 1];
+  }
+  actionCount--;
+}
+
+// Timer for the earliest action (stopped when there is none)
+void armTimer(uint32_t meshNow) {
+  if (!actionTimer) {
+    return;
+  }
+  esp_timer_stop(actionTimer);
+  if (actionCount == 0) {
+    return;
+  }
+  int32_t remainingMs = static_cast<int32_t>(actions[0].meshTime - meshNow);
+  uint64_t delayUs = remainingMs > 0 ? static_cast<uint64_t>(remainingMs) * 1000 : 0;
+  esp_timer_start_once(actionTimer, delayUs);
+}
+
+}  // namespace
+
+void scheduledActionInit(ScheduledActionHandler handler) {
+  actionHandler = handler;
+
+  esp_timer_create_args_t args = {};
+  args.callback = onActionTimer;
+  args.arg = nullptr;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "sched_action";
+  args.skip_unhandled_events = true;
+
+  if (esp_timer_create(&args, &actionTimer) != ESP_OK) {
+    LOG_ERROR(LOG_CAT_RECEIVER, "[ERROR] Scheduled action timer creation failed!\r\n");
+    actionTimer = nullptr;
+  }
+}
+
+bool scheduledActionPost(const ScheduledAction& action) {
+  for (uint8_t i = 0; i < actionCount; i++) {
+    if (actions[i].senderSlot == action.senderSlot &&
+        actions[i].transition.layerId == action.transition.layerId) {
+      removeAt(i);
+      break;
+    }
+  }
+  if (actionCount == SCHEDULED_ACTION_SLOTS) {
+    return false;
+  }
+
+  uint8_t at = actionCount;
+  while (at > 0 && static_cast<int32_t>(actions[at - 1].meshTime - action.meshTime) > 0) {
+    actions[at] = actions[at - 1];
+    at--;
+  }
+  actions[at] = action;
+  actionCount++;
+
+  armTimer(meshClock.meshMillis());
+  return true;
+}
+
+bool scheduledActionPending(int senderSlot, uint8_t layerId) {
+  for (uint8_t i = 0; i < actionCount; i++) {
+    if (actions[i].senderSlot == senderSlot && actions[i].transition.layerId == layerId) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void scheduledActionCancelAll() {
+  actionCount = 0;
+  if (actionTimer) {
+    esp_timer_stop(actionTimer);
+  }
+}
+
+void scheduledActionRun() {
+  if (actionCount == 0) {
+    return;
+  }
+
+  uint32_t meshNow = meshClock.meshMillis();
+  while (actionCount > 0 && static_cast<int32_t>(meshNow - actions[0].meshTime) >= 0) {
+    // Removed first: the handler may post or cancel
+    ScheduledAction due = actions[0];
+    removeAt(0);
+    if (actionHandler) {
+      actionHandler(due);
+    }
+  }
+  armTimer(meshNow);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "nowde_config.h"
+
+// Mesh-timed actions: work that has to happen at the same meshMillis() on
+// every receiver rather than whenever each one's frame arrives. Actions sit in
+// a small buffer ordered by execution time; a one-shot esp_timer is armed for
+// the earliest and wakes the ESP-NOW task, which runs the handler, so actions
+// change sync state on the same task as everything else. Firing is within the
+// task's wake-up latency of the mesh instant (well under a millisecond, far
+// below a video frame).
+//
+// Today the only action is a layer transition announced by a sender
+// (SyncTransition); meshTime is in our mesh time base.
+
+struct ScheduledAction {
+  uint32_t meshTime;
+  int8_t senderSlot;
+  SyncTransition transition;
+};
+
+typedef void (*ScheduledActionHandler)(const ScheduledAction& action);
+
+void scheduledActionInit(ScheduledActionHandler handler);
+
+// ESP-NOW task. Replaces a pending action of the same sender and layer;
+// false when the buffer is full (the caller applies the action itself).
+bool scheduledActionPost(const ScheduledAction& action);
+// True while an action for this sender and layer has not fired yet
+bool scheduledActionPending(int senderSlot, uint8_t layerId);
+// Drops everything (layer IDs forgotten, subscription changed)
+void scheduledActionCancelAll();
+// ESP-NOW task, every wake-up: fires what is due and rearms the timer
+void scheduledActionRun();
@@ -0,0 +1,180 @@
+#include "scheduler.h"
+
+namespace {
+
+constexpr uint8_t NOT_ARMED = 0xFF;
+
+portMUX_TYPE schedMux = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t schedTask = nullptr;
+
+// Timer -> heap slot. Constant-initialized to NOT_ARMED so a timer armed
+// before schedulerInit() is never mistaken for one sitting in slot 0.
+struct SlotMap {
+  uint8_t slot[SCHED_TIMER_COUNT];
+  constexpr SlotMap() : slot() {
+    for (uint8_t& s : slot) {
+      s = NOT_ARMED;
+    }
+  }
+  uint8_t& operator[](uint8_t timer) { return slot[timer]; }
+};
+
+// Binary min-heap of timers ordered by deadline; heapPos maps timer -> heap slot
+uint8_t heap[SCHED_TIMER_COUNT];
+uint8_t heapSize = 0;
+SlotMap heapPos;
+uint32_t deadline[SCHED_TIMER_COUNT];
+
+// Wrap-safe millis() ordering
+inline bool before(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+void swapSlots(uint8_t i, uint8_t j) {
+  uint8_t t = heap[i];
+  heap[i] = heap[j];
+  heap[j] = t;
+  heapPos[heap[i]] = i;
+  heapPos[heap[j]] = j;
+}
+
+void siftUp(uint8_t i) {
+  while (i > 0) {
+    uint8_t parent = (i - 1) / 2;
+    if (!before(deadline[heap[i]], deadline[heap[parent]])) {
+      break;
+    }
+    swapSlots(i, parent);
+    i = parent;
+  }
+}
+
+void siftDown(uint8_t i) {
+  for (;;) {
+    uint8_t left = 2 * i + 1;
+    uint8_t right = left + 1;
+    uint8_t smallest = i;
+    if (left < heapSize && before(deadline[heap[left]], deadline[heap[smallest]])) {
+      smallest = left;
+    }
+    if (right < heapSize && before(deadline[heap[right]], deadline[heap[smallest]])) {
+      smallest = right;
+    }
+    if (smallest == i) {
+      break;
+    }
+    swapSlots(i, smallest);
+    i = smallest;
+  }
+}
+
+void removeAt(uint8_t i) {
+  uint8_t timer = heap[i];
+  heapSize--;
+  if (i != heapSize) {
+    swapSlots(i, heapSize);
+    siftDown(i);
+    siftUp(i);
+  }
+  heapPos[timer] = NOT_ARMED;
+}
+
+// Caller holds schedMux. Returns true when the timer is now at the heap root.
+bool armLocked(SchedTimer timer, uint32_t dueMs, bool onlyEarlier) {
+  uint8_t pos = heapPos[timer];
+  if (pos == NOT_ARMED) {
+    deadline[timer] = dueMs;
+    pos = heapSize++;
+    heap[pos] = timer;
+    heapPos[timer] = pos;
+    siftUp(pos);
+  } else {
+    if (onlyEarlier && !before(dueMs, deadline[timer])) {
+      return false;
+    }
+    deadline[timer] = dueMs;
+    siftDown(pos);
+    siftUp(heapPos[timer]);
+  }
+  return heap[0] == timer;
+}
+
+void arm(SchedTimer timer, uint32_t dueMs, bool onlyEarlier) {
+  portENTER_CRITICAL(&schedMux);
+  bool becameNext = armLocked(timer, dueMs, onlyEarlier);
+  portEXIT_CRITICAL(&schedMux);
+
+  if (becameNext && schedTask && xTaskGetCurrentTaskHandle() != schedTask) {
+    xTaskNotifyGive(schedTask);
+  }
+}
+
+}  // namespace
+
+void schedulerInit() {
+  portENTER_CRITICAL(&schedMux);
+  heapSize = 0;
+  for (uint8_t i = 0; i < SCHED_TIMER_COUNT; i++) {
+    heapPos[i] = NOT_ARMED;
+  }
+  portEXIT_CRITICAL(&schedMux);
+}
+
+void schedulerSetTask(TaskHandle_t task) {
+  portENTER_CRITICAL(&schedMux);
+  schedTask = task;
+  portEXIT_CRITICAL(&schedMux);
+}
+
+void schedulerArm(SchedTimer timer, uint32_t dueMs) {
+  arm(timer, dueMs, false);
+}
+
+void schedulerArmEarliest(SchedTimer timer, uint32_t dueMs) {
+  arm(timer, dueMs, true);
+}
+
+void schedulerCancel(SchedTimer timer) {
+  portENTER_CRITICAL(&schedMux);
+  if (heapPos[timer] != NOT_ARMED) {
+    removeAt(heapPos[timer]);
+  }
+  portEXIT_CRITICAL(&schedMux);
+}
+
+bool schedulerArmed(SchedTimer timer) {
+  portENTER_CRITICAL(&schedMux);
+  bool armed = heapPos[timer] != NOT_ARMED;
+  portEXIT_CRITICAL(&schedMux);
+  return armed;
+}
+
+bool schedulerPopDue(uint32_t nowMs, SchedTimer* timer) {
+  bool due = false;
+  portENTER_CRITICAL(&schedMux);
+  if (heapSize > 0 && !before(nowMs, deadline[heap[0]])) {
+    *timer = static_cast<SchedTimer>(heap[0]);
+    removeAt(0);
+    due = true;
+  }
+  portEXIT_CRITICAL(&schedMux);
+  return due;
+}
+
+TickType_t schedulerTicksUntilNext(uint32_t nowMs) {
+  TickType_t ticks = portMAX_DELAY;
+  portENTER_CRITICAL(&schedMux);
+  if (heapSize > 0) {
+    int32_t remaining = static_cast<int32_t>(deadline[heap[0]] - nowMs);
+    // Round up so we never wake just before the deadline and spin
+    ticks = remaining <= 0 ? 0 : pdMS_TO_TICKS(remaining) + 1;
+  }
+  portEXIT_CRITICAL(&schedMux);
+  return ticks;
+}
+
+void schedulerWake() {
+  if (schedTask) {
+    xTaskNotifyGive(schedTask);
+  }
+}
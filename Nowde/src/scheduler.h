@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Deadline scheduler for the ESP-NOW task.
+// Each timer is either idle or armed with a millis() deadline, kept in a small
+// min-heap so the task can sleep exactly until the next one is due.
+enum SchedTimer : uint8_t {
+  SCHED_SENDER_BEACON = 0,
+  SCHED_BRIDGE_REPORT,
+  SCHED_RECEIVER_TABLE_CLEANUP,
+  SCHED_RECEIVER_BEACON,
+  SCHED_SENDER_TABLE_CLEANUP,
+  SCHED_LINK_LOST,
+  SCHED_MESH_CLOCK,
+  SCHED_MESH_OTA_TX,
+  SCHED_MESH_OTA_RX,
+  SCHED_RECEIVER_METRICS,
+  SCHED_RUNNING_STATE_PUSH,
+  SCHED_CHANNEL,
+  SCHED_PHANTOM,
+  SCHED_TIMER_COUNT
+};
+
+// setup(), before any task is created (tasks may arm timers as they start)
+void schedulerInit();
+// Called by the scheduler task itself. Until then arming never notifies; the
+// task computes its first sleep from the heap anyway.
+void schedulerSetTask(TaskHandle_t task);
+
+// Arm (or move) a timer. Safe to call from any task; wakes the scheduler task
+// when the new deadline becomes the earliest one.
+void schedulerArm(SchedTimer timer, uint32_t dueMs);
+// Like schedulerArm, but never pushes an already armed deadline later
+void schedulerArmEarliest(SchedTimer timer, uint32_t dueMs);
+void schedulerCancel(SchedTimer timer);
+bool schedulerArmed(SchedTimer timer);
+
+// Pops the next timer whose deadline is <= nowMs; false when none is due
+bool schedulerPopDue(uint32_t nowMs, SchedTimer* timer);
+// Ticks to sleep until the earliest deadline (portMAX_DELAY when nothing is armed)
+TickType_t schedulerTicksUntilNext(uint32_t nowMs);
+// Wake the scheduler task without arming anything (e.g. after a mode change)
+void schedulerWake();
@@ -1,57 +1,45 @@
 #include "sender_mode.h"
 
 #include <esp_now.h>
+#include <algorithm>
 #include <cstring>
+#include <cstddef>
 
+#include "channel.h"
+#include "espnow_tx.h"
+#include "layer_registry.h"
+#include "metrics.h"
 #include "midi.h"
 #include "nowde_config.h"
+#include "nowde_log.h"
 #include "nowde_state.h"
+#include "peer_table.h"
+#include "receiver_mode.h"
+#include "sync_redundancy.h"
 
 void cleanupReceiverTable() {
   unsigned long now = millis();
   for (int i = 0; i < MAX_RECEIVERS; i++) {
     if (receiverTable[i].active) {
+      espnowTxPeerReport(receiverTable[i].mac, &receiverTable[i].tx);
       unsigned long timeSinceLastSeen = now - receiverTable[i].lastSeen;
       
       // Mark as disconnected after RECEIVER_TIMEOUT_MS (5s)
       if (receiverTable[i].connected && timeSinceLastSeen > RECEIVER_TIMEOUT_MS) {
         receiverTable[i].connected = false;
 
-        DEBUG_SERIAL.println("\n[TIMEOUT] Receiver marked as MISSING");
-        DEBUG_SERIAL.print("  MAC: ");
-        for (int j = 0; j < 6; j++) {
-          DEBUG_SERIAL.printf("%02X", receiverTable[i].mac[j]);
-          if (j < 5) {
-            DEBUG_SERIAL.print(":");
-          }
-        }
-        DEBUG_SERIAL.println();
-        DEBUG_SERIAL.print("  Layer: ");
-        DEBUG_SERIAL.println(receiverTable[i].layer);
-        DEBUG_SERIAL.println("  Status: MISSING");
-        DEBUG_SERIAL.println();
+        LOG_INFO(LOG_CAT_SENDER, "[TIMEOUT] Receiver marked as MISSING: " LOG_MAC_FMT ", layer '%s'\r\n",
+                 LOG_MAC_ARGS(receiverTable[i].mac), receiverTable[i].layer);
       }
       
       // Completely remove after 10 seconds (reduced from 30s to quickly free slots)
       if (timeSinceLastSeen > 10000) {
-        DEBUG_SERIAL.println("\n[CLEANUP] Receiver removed from table");
-        DEBUG_SERIAL.print("  MAC: ");
-        for (int j = 0; j < 6; j++) {
-          DEBUG_SERIAL.printf("%02X", receiverTable[i].mac[j]);
-          if (j < 5) {
-            DEBUG_SERIAL.print(":");
-          }
-        }
-        DEBUG_SERIAL.println();
-        DEBUG_SERIAL.printf("  Time inactive: %lu seconds\r\n", timeSinceLastSeen / 1000);
-        DEBUG_SERIAL.println();
+        LOG_INFO(LOG_CAT_SENDER, "[CLEANUP] Receiver removed from table: " LOG_MAC_FMT ", inactive %lu s\r\n",
+                 LOG_MAC_ARGS(receiverTable[i].mac), timeSinceLastSeen / 1000);
         
-        // Remove from ESP-NOW peer list
-        esp_now_del_peer(receiverTable[i].mac);
-        
-        // Mark slot as free
-        receiverTable[i].active = false;
-        receiverTable[i].connected = false;
+        // Remove from ESP-NOW peer list and free the slot
+        releaseEspNowPeer(receiverTable[i].mac);
+        removeReceiver(i);
       }
     }
   }
@@ -63,8 +51,18 @@ void sendSenderBeacon() {
   }
 
   SenderBeacon beacon;
-  esp_err_t result = esp_now_send(broadcastAddress, reinterpret_cast<uint8_t*>(&beacon), sizeof(beacon));
-  (void)result;
+  beacon.meshTimestamp = meshClock.meshMillis();
+  beacon.layerCount = fillLayerIdEntries(beacon.layers, MAX_LAYER_IDS);
+  size_t beaconLen = offsetof(SenderBeacon, layers) + beacon.layerCount * sizeof(LayerIdEntry);
+
+  // Extensions: our channel (and any pending switch), then the sync redundancy
+  // trailer, since beacons keep going out after a layer stops and the Bridge
+  // goes quiet about it
+  uint8_t frame[sizeof(SenderBeacon) + sizeof(ChannelInfo) + sizeof(SyncRedundancyTrailer)];
+  memcpy(frame, &beacon, beaconLen);
+  beaconLen = channelAppendBeaconInfo(frame, beaconLen);
+  beaconLen = syncRedundancyAppend(frame, beaconLen, LAYER_ID_NONE);
+  espnowTxSend(broadcastAddress, frame, beaconLen, ESPNOW_TX_KEY_BEACON);
 
   // Beacon logging disabled for cleaner output
   // Beacons are sent every 1s but not logged
@@ -83,159 +81,187 @@ void reportReceiversToBridge() {
   return;
 }
 
-void handleSenderBeacon(const esp_now_recv_info_t* info) {
-  bool found = false;
-  int freeSlot = -1;
+namespace {
+
+constexpr int BEACON_HEADER_LEN = offsetof(SenderBeacon, layers);
 
-  for (int i = 0; i < MAX_SENDERS; i++) {
-    if (senderTable[i].active && macEqual(senderTable[i].mac, info->src_addr)) {
-      senderTable[i].lastSeen = millis();
-      found = true;
-      break;
+// Layer entries actually present in a beacon of len bytes
+int beaconLayerCount(const uint8_t* data, int len) {
+  const SenderBeacon* beacon = reinterpret_cast<const SenderBeacon*>(data);
+  return std::min<int>(beacon->layerCount, (len - BEACON_HEADER_LEN) / static_cast<int>(sizeof(LayerIdEntry)));
+}
+
+// The sender's ID for our subscribed layer, or LAYER_ID_NONE if it has none
+uint8_t resolveLayerId(const uint8_t* data, int len) {
+  if (len < BEACON_HEADER_LEN) {
+    return LAYER_ID_NONE;
+  }
+
+  const SenderBeacon* beacon = reinterpret_cast<const SenderBeacon*>(data);
+  int count = beaconLayerCount(data, len);
+  uint32_t subscribedHash = layerHash(subscribedLayer);
+  for (int i = 0; i < count; i++) {
+    if (beacon->layers[i].layerHash == subscribedHash) {
+      return beacon->layers[i].id;
     }
-    if (!senderTable[i].active && freeSlot == -1) {
-      freeSlot = i;
+  }
+  return LAYER_ID_NONE;
+}
+
+// Extensions after the layer entries: ChannelInfo, then the sync redundancy trailer
+void handleBeaconExtensions(int slot, const uint8_t* data, int len, uint32_t rxTimeUs) {
+  if (len < BEACON_HEADER_LEN) {
+    return;
+  }
+  const SenderBeacon* beacon = reinterpret_cast<const SenderBeacon*>(data);
+  int offset = BEACON_HEADER_LEN + beaconLayerCount(data, len) * static_cast<int>(sizeof(LayerIdEntry));
+  offset += channelHandleBeacon(data + offset, len - offset);
+  scheduleSyncTransition(slot, data, len, offset, beacon->meshTimestamp);
+  applySyncRedundancy(slot, data, len, offset, beacon->meshTimestamp, rxTimeUs, false);
+}
+
+}  // namespace
+
+void handleSenderBeacon(const uint8_t* srcMac, const uint8_t* data, int len, uint32_t rxTimeUs) {
+  const SenderBeacon* beacon = reinterpret_cast<const SenderBeacon*>(data);
+  bool hasTimestamp = len >= static_cast<int>(offsetof(SenderBeacon, layerCount));
+
+  int slot = findSender(srcMac);
+  if (slot != -1) {
+    senderTable[slot].lastSeen = millis();
+    uint8_t layerId = resolveLayerId(data, len);
+    if (layerId != senderTable[slot].layerId) {
+      senderTable[slot].transitionSeqValid = false;
+      senderTable[slot].layerId = layerId;
+    }
+    if (hasTimestamp) {
+      updateSenderClockOffset(slot, beacon->meshTimestamp, rxTimeUs);
     }
+    handleBeaconExtensions(slot, data, len, rxTimeUs);
+    return;
   }
 
   // Only log when NEW sender is registered (not on every beacon)
-  if (!found && freeSlot != -1) {
-    memcpy(senderTable[freeSlot].mac, info->src_addr, 6);
-    senderTable[freeSlot].lastSeen = millis();
-    senderTable[freeSlot].active = true;
-
-    esp_now_peer_info_t peerInfo = {};
-    memcpy(peerInfo.peer_addr, info->src_addr, 6);
-    peerInfo.channel = 0;
-    peerInfo.encrypt = false;
-
-    esp_err_t addResult = esp_now_add_peer(&peerInfo);
-
-    DEBUG_SERIAL.println("\n[ESP-NOW RX] Sender Beacon");
-    DEBUG_SERIAL.print("  From: ");
-    for (int i = 0; i < 6; i++) {
-      DEBUG_SERIAL.printf("%02X", info->src_addr[i]);
-      if (i < 5) {
-        DEBUG_SERIAL.print(":");
-      }
-    }
-    DEBUG_SERIAL.println();
-    DEBUG_SERIAL.println("  Action: Registered new sender");
-    if (addResult == ESP_OK) {
-      DEBUG_SERIAL.println("  Peer: Added to ESP-NOW");
-    } else {
-      DEBUG_SERIAL.printf("  Peer: Failed to add (error %d)\r\n", addResult);
+  slot = addSender(srcMac);
+  if (slot != -1) {
+    senderTable[slot].lastSeen = millis();
+    senderTable[slot].layerId = resolveLayerId(data, len);
+    senderTable[slot].clockOffsetValid = false;
+    senderTable[slot].rssiSum = 0;
+    senderTable[slot].rssiCount = 0;
+    senderTable[slot].transitionSeqValid = false;
+    if (hasTimestamp) {
+      updateSenderClockOffset(slot, beacon->meshTimestamp, rxTimeUs);
     }
-    DEBUG_SERIAL.printf("  Total Senders: %d\r\n\r\n", countActiveSenders());
+    handleBeaconExtensions(slot, data, len, rxTimeUs);
+
+    // Receivers unicast ReceiverInfo to every sender they hear
+    bool peerAdded = ensureEspNowPeer(srcMac);
+
+    LOG_INFO(LOG_CAT_RECEIVER, "[ESP-NOW RX] Registered new sender " LOG_MAC_FMT " (peer %s), total senders: %d\r\n",
+             LOG_MAC_ARGS(srcMac), peerAdded ? "added" : "failed", countActiveSenders());
   }
 }
 
-void handleReceiverInfo(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
-  if (len < static_cast<int>(sizeof(ReceiverInfo))) {
+void handleReceiverInfo(const uint8_t* srcMac, const uint8_t* data, int len, int8_t rssi) {
+  // Older receivers stop after mediaIndex, clock or link report
+  constexpr int LEGACY_LEN = offsetof(ReceiverInfo, sync);
+  if (len < LEGACY_LEN) {
     return;
   }
 
   const ReceiverInfo* recvInfo = reinterpret_cast<const ReceiverInfo*>(data);
+  bool hasSyncReport = len >= static_cast<int>(offsetof(ReceiverInfo, clock));
+  bool hasClockReport = len >= static_cast<int>(offsetof(ReceiverInfo, link));
+  bool hasLinkReport = len >= static_cast<int>(sizeof(ReceiverInfo));
 
-  bool found = false;
-  int freeSlot = -1;
-  bool changed = false;
-
-  for (int i = 0; i < MAX_RECEIVERS; i++) {
-    if (receiverTable[i].active && macEqual(receiverTable[i].mac, info->src_addr)) {
-      receiverTable[i].lastSeen = millis();
-      
-      // Update media index silently (no logging)
-      receiverTable[i].mediaIndex = recvInfo->mediaIndex;
-
-      // Only log on RECONNECTION (was disconnected, now connected again)
-      if (!receiverTable[i].connected) {
-        receiverTable[i].connected = true;
-        changed = true;
-
-        DEBUG_SERIAL.println("\n[ESP-NOW RX] Receiver RECONNECTED");
-        DEBUG_SERIAL.print("  From: ");
-        for (int j = 0; j < 6; j++) {
-          DEBUG_SERIAL.printf("%02X", info->src_addr[j]);
-          if (j < 5) {
-            DEBUG_SERIAL.print(":");
-          }
-        }
-        DEBUG_SERIAL.println();
-        DEBUG_SERIAL.print("  Layer: ");
-        DEBUG_SERIAL.println(recvInfo->layer);
-        DEBUG_SERIAL.println("  Status: ACTIVE");
-        DEBUG_SERIAL.println();
-      }
+  // ReceiverInfo.layer is not guaranteed to be terminated on the wire
+  char layer[MAX_LAYER_LENGTH];
+  strncpy(layer, recvInfo->layer, MAX_LAYER_LENGTH);
+  layer[MAX_LAYER_LENGTH - 1] = '\0';
 
-      // Only log on LAYER CHANGE (not on every info packet)
-      if (strncmp(receiverTable[i].layer, recvInfo->layer, MAX_LAYER_LENGTH) != 0) {
-        strncpy(receiverTable[i].layer, recvInfo->layer, MAX_LAYER_LENGTH);
-        receiverTable[i].layer[MAX_LAYER_LENGTH - 1] = '\0';
-        changed = true;
-
-        DEBUG_SERIAL.println("\n[ESP-NOW RX] Receiver Info Update");
-        DEBUG_SERIAL.print("  From: ");
-        for (int j = 0; j < 6; j++) {
-          DEBUG_SERIAL.printf("%02X", info->src_addr[j]);
-          if (j < 5) {
-            DEBUG_SERIAL.print(":");
-          }
-        }
-        DEBUG_SERIAL.println();
-        DEBUG_SERIAL.print("  Layer Changed: ");
-        DEBUG_SERIAL.println(recvInfo->layer);
-        DEBUG_SERIAL.println();
-      }
+  int slot = findReceiver(srcMac);
+  if (slot != -1) {
+    ReceiverEntry& entry = receiverTable[slot];
+    entry.lastSeen = millis();
+    entry.uplinkRssiDbm = rssi;
+    entry.version = versionPack(recvInfo->version, MAX_VERSION_LENGTH);  // May have been updated
 
-      found = true;
-      break;
+    // Update media index and estimator state silently (no logging)
+    entry.mediaIndex = recvInfo->mediaIndex;
+    if (hasSyncReport) {
+      entry.sync = recvInfo->sync;
     }
-    if (!receiverTable[i].active && freeSlot == -1) {
-      freeSlot = i;
+    if (hasClockReport) {
+      entry.clock = recvInfo->clock;
+    }
+    if (hasLinkReport) {
+      entry.link = recvInfo->link;
     }
-  }
 
-  if (!found && freeSlot != -1) {
-    memcpy(receiverTable[freeSlot].mac, info->src_addr, 6);
-    strncpy(receiverTable[freeSlot].layer, recvInfo->layer, MAX_LAYER_LENGTH);
-    receiverTable[freeSlot].layer[MAX_LAYER_LENGTH - 1] = '\0';
-    strncpy(receiverTable[freeSlot].version, recvInfo->version, MAX_VERSION_LENGTH);
-    receiverTable[freeSlot].version[MAX_VERSION_LENGTH - 1] = '\0';
-    receiverTable[freeSlot].lastSeen = millis();
-    receiverTable[freeSlot].active = true;
-    receiverTable[freeSlot].connected = true;
-    receiverTable[freeSlot].mediaIndex = recvInfo->mediaIndex;  // Initialize media index
-    changed = true;
-
-    esp_now_peer_info_t peerInfo = {};
-    memcpy(peerInfo.peer_addr, info->src_addr, 6);
-    peerInfo.channel = 0;
-    peerInfo.encrypt = false;
-
-    esp_err_t addResult = esp_now_add_peer(&peerInfo);
-
-    DEBUG_SERIAL.println("\n[ESP-NOW RX] Receiver Info");
-    DEBUG_SERIAL.print("  From: ");
-    for (int i = 0; i < 6; i++) {
-      DEBUG_SERIAL.printf("%02X", info->src_addr[i]);
-      if (i < 5) {
-        DEBUG_SERIAL.print(":");
-      }
+    // Only log on RECONNECTION (was disconnected, now connected again)
+    if (!entry.connected) {
+      entry.connected = true;
+
+      LOG_INFO(LOG_CAT_SENDER, "[ESP-NOW RX] Receiver RECONNECTED: " LOG_MAC_FMT ", layer '%s'\r\n",
+               LOG_MAC_ARGS(srcMac), layer);
     }
-    DEBUG_SERIAL.println();
-    DEBUG_SERIAL.print("  Layer: ");
-    DEBUG_SERIAL.println(recvInfo->layer);
-    DEBUG_SERIAL.print("  Version: ");
-    DEBUG_SERIAL.println(recvInfo->version);
-    DEBUG_SERIAL.println("  Action: Registered new receiver");
-    if (addResult == ESP_OK) {
-      DEBUG_SERIAL.println("  Peer: Added to ESP-NOW");
-    } else {
-      DEBUG_SERIAL.printf("  Peer: Failed to add (error %d)\r\n", addResult);
+
+    // Only log on LAYER CHANGE (not on every info packet)
+    if (strncmp(entry.layer, layer, MAX_LAYER_LENGTH) != 0) {
+      setReceiverLayer(slot, layer);
+
+      LOG_INFO(LOG_CAT_SENDER, "[ESP-NOW RX] Receiver " LOG_MAC_FMT " changed layer to '%s'\r\n",
+               LOG_MAC_ARGS(srcMac), layer);
     }
-    DEBUG_SERIAL.printf("  Total Receivers: %d\r\n\r\n", countActiveReceivers());
+    return;
+  }
+
+  slot = addReceiver(srcMac, layer);
+  if (slot == -1) {
+    return;
   }
 
-  (void)changed;
+  // A reused slot still holds the previous occupant's reports and counters
+  ReceiverEntry& entry = receiverTable[slot];
+  entry.version = versionPack(recvInfo->version, MAX_VERSION_LENGTH);
+  espnowTxPeerReport(srcMac, &entry.tx);
+  entry.lastSeen = millis();
+  entry.mediaIndex = recvInfo->mediaIndex;  // Initialize media index
+  if (hasSyncReport) {
+    entry.sync = recvInfo->sync;
+  } else {
+    memset(&entry.sync, 0, sizeof(entry.sync));
+  }
+  if (hasClockReport) {
+    entry.clock = recvInfo->clock;
+  } else {
+    memset(&entry.clock, 0, sizeof(entry.clock));
+  }
+  if (hasLinkReport) {
+    entry.link = recvInfo->link;
+  } else {
+    memset(&entry.link, 0, sizeof(entry.link));
+  }
+  entry.uplinkRssiDbm = rssi;
+  entry.connected = true;
+
+  // No ESP-NOW peer yet: sync is broadcast, and unicast senders
+  // (layer change, mesh OTA) register the peer on demand.
+
+  LOG_INFO(LOG_CAT_SENDER, "[ESP-NOW RX] Registered new receiver " LOG_MAC_FMT ", layer '%s', v%u.%u, total receivers: %d\r\n",
+           LOG_MAC_ARGS(srcMac), layer, entry.version >> 8, entry.version & 0xFF, countActiveReceivers());
+}
+
+void handleReceiverMetrics(const uint8_t* srcMac, const uint8_t* data, int len) {
+  if (len < static_cast<int>(sizeof(MetricsPacket))) {
+    return;
+  }
+
+  // Only kept for receivers we track; forwarded with the next RUNNING_STATE
+  int slot = findReceiver(srcMac);
+  if (slot == -1) {
+    return;
+  }
+  metricsStoreRemote(slot, srcMac, reinterpret_cast<const MetricsPacket*>(data)->snapshot);
 }
@@ -6,5 +6,6 @@
 void cleanupReceiverTable();
 void sendSenderBeacon();
 void reportReceiversToBridge();
-void handleSenderBeacon(const esp_now_recv_info_t* info);
-void handleReceiverInfo(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+void handleSenderBeacon(const uint8_t* srcMac, const uint8_t* data, int len, uint32_t rxTimeUs);
+void handleReceiverInfo(const uint8_t* srcMac, const uint8_t* data, int len, int8_t rssi);
+void handleReceiverMetrics(const uint8_t* srcMac, const uint8_t* data, int len);
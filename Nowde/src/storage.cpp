@@ -1,33 +1,193 @@
 #include "storage.h"
 
-#include "nowde_config.h"
+#include <cstring>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "nowde_log.h"
 #include "nowde_state.h"
 
-void saveLayerToEEPROM(const char* layer) {
-  preferences.begin("nowde", false);
-  preferences.putString("layer", layer);
-  preferences.end();
-  DEBUG_SERIAL.println("[EEPROM] Layer saved");
+namespace {
+
+constexpr const char* NAMESPACE = "nowde";
+constexpr const char* PROFILE_KEY = "profile";
+
+DeviceProfile profile;    // Live copy (profileMux)
+DeviceProfile committed;  // What flash holds (commitLock)
+bool dirty = false;
+uint32_t lastChangeMs = 0;
+
+portMUX_TYPE profileMux = portMUX_INITIALIZER_UNLOCKED;
+SemaphoreHandle_t commitLock = nullptr;  // Preferences is not reentrant
+TaskHandle_t storeTaskHandle = nullptr;
+
+DeviceProfile defaultProfile() {
+  DeviceProfile defaults = {};
+  defaults.version = PROFILE_VERSION;
+  strncpy(defaults.layer, DEFAULT_RECEIVER_LAYER, MAX_LAYER_LENGTH - 1);
+  defaults.channel = CHANNEL_DEFAULT;
+  defaults.cc100Channel = CC100_DEFAULT_CHANNEL;
+  defaults.flags = PROFILE_FLAG_STOP_ON_LINK_LOST;
+  defaults.rfSimMaxDelayMs = 400;
+  return defaults;
 }
 
-String loadLayerFromEEPROM() {
-  if (!preferences.begin("nowde", true)) {
-    DEBUG_SERIAL.println("[EEPROM] No saved data found (first boot)");
-    return String(DEFAULT_RECEIVER_LAYER);
+// Firmware before the profile stored the layer and channel as separate keys
+void migrateLegacyKeys(DeviceProfile* out) {
+  String layer = preferences.getString("layer", DEFAULT_RECEIVER_LAYER);
+  if (layer.length() > 0) {
+    strncpy(out->layer, layer.c_str(), MAX_LAYER_LENGTH - 1);
+    out->layer[MAX_LAYER_LENGTH - 1] = '\0';
   }
+  out->channel = preferences.getUChar("channel", CHANNEL_DEFAULT);
+}
 
-  String layer = preferences.getString("layer", DEFAULT_RECEIVER_LAYER);
-  preferences.end();
+// Apply an edit to the live profile; wakes the store task if it changed anything
+template <typename Edit>
+void editProfile(Edit edit) {
+  portENTER_CRITICAL(&profileMux);
+  DeviceProfile before = profile;
+  edit(profile);
+  bool changed = memcmp(&before, &profile, sizeof(profile)) != 0;
+  if (changed) {
+    dirty = true;
+    lastChangeMs = millis();
+  }
+  portEXIT_CRITICAL(&profileMux);
+
+  if (changed && storeTaskHandle) {
+    xTaskNotifyGive(storeTaskHandle);
+  }
+}
+
+void commit() {
+  xSemaphoreTake(commitLock, portMAX_DELAY);
 
-  DEBUG_SERIAL.print("[EEPROM] Loaded layer: ");
-  DEBUG_SERIAL.println(layer);
+  portENTER_CRITICAL(&profileMux);
+  DeviceProfile snapshot = profile;
+  dirty = false;
+  portEXIT_CRITICAL(&profileMux);
 
-  return layer;
+  // Edits that cancel out (A -> B -> A) end up here: no flash erase for them
+  if (memcmp(&snapshot, &committed, sizeof(snapshot)) != 0) {
+    preferences.begin(NAMESPACE, false);
+    size_t written = preferences.putBytes(PROFILE_KEY, &snapshot, sizeof(snapshot));
+    preferences.end();
+    if (written == sizeof(snapshot)) {
+      committed = snapshot;
+      LOG_INFO(LOG_CAT_CORE, "[EEPROM] Profile saved\r\n");
+    } else {
+      LOG_ERROR(LOG_CAT_CORE, "[EEPROM] Profile write failed\r\n");
+    }
+  }
+
+  xSemaphoreGive(commitLock);
+}
+
+void storeTask(void* parameter) {
+  for (;;) {
+    portENTER_CRITICAL(&profileMux);
+    bool pending = dirty;
+    uint32_t quietMs = millis() - lastChangeMs;
+    portEXIT_CRITICAL(&profileMux);
+
+    if (pending && quietMs >= PROFILE_COMMIT_DEBOUNCE_MS) {
+      commit();
+      continue;
+    }
+    ulTaskNotifyTake(pdTRUE, pending ? pdMS_TO_TICKS(PROFILE_COMMIT_DEBOUNCE_MS - quietMs) : portMAX_DELAY);
+  }
+}
+
+}  // namespace
+
+void profileLoad() {
+  commitLock = xSemaphoreCreateMutex();
+  DeviceProfile loaded = defaultProfile();
+  bool fromFlash = false;
+
+  if (preferences.begin(NAMESPACE, true)) {
+    DeviceProfile stored;
+    if (preferences.getBytes(PROFILE_KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+        stored.version == PROFILE_VERSION) {
+      loaded = stored;
+      loaded.layer[MAX_LAYER_LENGTH - 1] = '\0';
+      fromFlash = true;
+    } else if (!preferences.isKey(PROFILE_KEY)) {
+      migrateLegacyKeys(&loaded);
+    }
+    preferences.end();
+  } else {
+    LOG_INFO(LOG_CAT_CORE, "[EEPROM] No saved data found (first boot)\r\n");
+  }
+
+  profile = loaded;
+  // A migrated or defaulted profile is written once the store task runs
+  committed = fromFlash ? loaded : DeviceProfile{};
+  dirty = !fromFlash;
+  lastChangeMs = millis();
+
+  LOG_INFO(LOG_CAT_CORE, "[EEPROM] Profile %s: layer '%s', channel %d\r\n",
+           fromFlash ? "loaded" : "defaulted", loaded.layer, loaded.channel);
+}
+
+void profileStartTask() {
+  // Lowest useful priority: flash erases never hold up USB or radio work
+  xTaskCreatePinnedToCore(storeTask, "Profile_Store", PROFILE_TASK_STACK_SIZE, NULL, 1, &storeTaskHandle, 1);
+}
+
+void profileFlush() {
+  portENTER_CRITICAL(&profileMux);
+  bool pending = dirty;
+  portEXIT_CRITICAL(&profileMux);
+  if (pending) {
+    commit();
+  }
+}
+
+DeviceProfile profileGet() {
+  portENTER_CRITICAL(&profileMux);
+  DeviceProfile copy = profile;
+  portEXIT_CRITICAL(&profileMux);
+  return copy;
+}
+
+void profileSetLayer(const char* layer) {
+  editProfile([layer](DeviceProfile& p) {
+    memset(p.layer, 0, sizeof(p.layer));
+    strncpy(p.layer, layer, MAX_LAYER_LENGTH - 1);
+  });
+}
+
+void profileSetChannel(uint8_t channel) {
+  editProfile([channel](DeviceProfile& p) { p.channel = channel; });
+}
+
+void profileSetRfSimulation(bool enabled, uint16_t maxDelayMs, uint8_t lossPercent, uint8_t reorderPercent,
+                            uint8_t outagePerMille, uint16_t outageMs) {
+  editProfile([=](DeviceProfile& p) {
+    p.flags = enabled ? (p.flags | PROFILE_FLAG_RF_SIMULATION) : (p.flags & ~PROFILE_FLAG_RF_SIMULATION);
+    p.rfSimMaxDelayMs = maxDelayMs;
+    p.rfSimLossPercent = lossPercent;
+    p.rfSimReorderPercent = reorderPercent;
+    p.rfSimOutagePerMille = outagePerMille;
+    p.rfSimOutageMs = outageMs;
+  });
 }
 
 void clearEEPROM() {
-  preferences.begin("nowde", false);
+  xSemaphoreTake(commitLock, portMAX_DELAY);
+  preferences.begin(NAMESPACE, false);
   preferences.clear();
   preferences.end();
-  DEBUG_SERIAL.println("[EEPROM] All data cleared");
+  committed = DeviceProfile{};
+  xSemaphoreGive(commitLock);
+
+  portENTER_CRITICAL(&profileMux);
+  profile = defaultProfile();
+  dirty = false;
+  portEXIT_CRITICAL(&profileMux);
+  LOG_INFO(LOG_CAT_CORE, "[EEPROM] All data cleared\r\n");
 }
@@ -1,7 +1,27 @@
 #pragma once
 
 #include <Arduino.h>
+#include "nowde_config.h"
 
-void saveLayerToEEPROM(const char* layer);
-String loadLayerFromEEPROM();
+// Persistent device profile (DeviceProfile). The RAM copy is authoritative:
+// setters only update it under a spinlock and wake a low-priority task, which
+// writes the whole blob to NVS once nothing has changed for
+// PROFILE_COMMIT_DEBOUNCE_MS, and skips the write when flash already holds the
+// same bytes. So setters are cheap enough for any task, and a burst of
+// changes costs a single flash write.
+
+// setup(): load the profile with one NVS read (per-key data from older
+// firmware is migrated), defaults when there is none
+void profileLoad();
+void profileStartTask();
+// Commit now if anything is pending (before a reboot)
+void profileFlush();
+
+DeviceProfile profileGet();
+void profileSetLayer(const char* layer);
+void profileSetChannel(uint8_t channel);
+void profileSetRfSimulation(bool enabled, uint16_t maxDelayMs, uint8_t lossPercent, uint8_t reorderPercent,
+                            uint8_t outagePerMille, uint16_t outageMs);
+
+// Erase the stored profile and go back to defaults
 void clearEEPROM();
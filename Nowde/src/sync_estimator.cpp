@@ -0,0 +1,167 @@
+#include "sync_estimator.h"
+
+#include <algorithm>
+
+#include <freertos/FreeRTOS.h>
+
+namespace {
+
+portMUX_TYPE anchorMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Estimate: position(t) = anchorPositionUs + (t - anchorMeshTime) * (1 + ratePpm / 1e6).
+// Written from the ESP-NOW task, read from the esp_timer task.
+int64_t anchorPositionUs = 0;
+uint32_t anchorMeshTime = 0;
+int32_t ratePpm = 0;
+
+// Loop state (ESP-NOW task only)
+bool tracking = false;
+uint32_t lastAcceptedMeshTime = 0;
+uint32_t jitterUs = 0;
+int32_t lastErrorUs = 0;
+uint8_t acceptedInRow = 0;
+uint8_t rejectedInRow = 0;
+int32_t firstRejectedErrorUs = 0;
+uint16_t outlierCount = 0;
+uint16_t jumpCount = 0;
+
+int64_t estimateUs(uint32_t meshTime) {
+  int32_t dtMs = static_cast<int32_t>(meshTime - anchorMeshTime);
+  return anchorPositionUs + static_cast<int64_t>(dtMs) * 1000 + static_cast<int64_t>(dtMs) * ratePpm / 1000;
+}
+
+void setAnchor(int64_t positionUs, uint32_t meshTime) {
+  portENTER_CRITICAL(&anchorMux);
+  anchorPositionUs = positionUs;
+  anchorMeshTime = meshTime;
+  portEXIT_CRITICAL(&anchorMux);
+}
+
+int32_t clampI32(int64_t value, int32_t limit) {
+  if (value > limit) {
+    return limit;
+  }
+  if (value < -limit) {
+    return -limit;
+  }
+  return static_cast<int32_t>(value);
+}
+
+int16_t toTenthsMs(int32_t us) {
+  return static_cast<int16_t>(clampI32(us / 100, INT16_MAX));
+}
+
+}  // namespace
+
+void syncEstimatorReset(uint32_t positionMs, uint32_t meshTime) {
+  portENTER_CRITICAL(&anchorMux);
+  anchorPositionUs = static_cast<int64_t>(positionMs) * 1000;
+  anchorMeshTime = meshTime;
+  ratePpm = 0;
+  portEXIT_CRITICAL(&anchorMux);
+
+  tracking = true;
+  lastAcceptedMeshTime = meshTime;
+  jitterUs = 0;
+  lastErrorUs = 0;
+  acceptedInRow = 0;
+  rejectedInRow = 0;
+}
+
+void syncEstimatorHold() {
+  tracking = false;
+  acceptedInRow = 0;
+  rejectedInRow = 0;
+}
+
+SyncEstimatorResult syncEstimatorUpdate(uint32_t positionMs, uint32_t meshTime) {
+  if (!tracking) {
+    syncEstimatorReset(positionMs, meshTime);
+    return SYNC_EST_JUMPED;
+  }
+
+  int64_t predictedUs = estimateUs(meshTime);
+  int64_t measuredUs = static_cast<int64_t>(positionMs) * 1000;
+  int32_t errorUs = clampI32(measuredUs - predictedUs, INT32_MAX);
+  lastErrorUs = errorUs;
+
+  uint32_t gateUs = std::max<uint32_t>(SYNC_EST_OUTLIER_MIN_MS * 1000, SYNC_EST_OUTLIER_JITTER_MULT * jitterUs);
+  if (static_cast<uint32_t>(abs(errorUs)) > gateUs) {
+    // A single wild sample is RF/scheduling noise; the same offset seen again is a real step
+    bool consistent = rejectedInRow > 0 &&
+                      static_cast<uint32_t>(abs(errorUs - firstRejectedErrorUs)) <= gateUs;
+    if (!consistent) {
+      rejectedInRow = 0;
+      firstRejectedErrorUs = errorUs;
+    }
+    rejectedInRow++;
+    acceptedInRow = 0;
+
+    if (rejectedInRow < SYNC_EST_CONFIRM_SAMPLES) {
+      outlierCount++;
+      return SYNC_EST_OUTLIER;
+    }
+
+    bool seek = static_cast<uint32_t>(abs(errorUs)) > MTC_RELOCATE_THRESHOLD_MS * 1000;
+    setAnchor(measuredUs, meshTime);
+    lastAcceptedMeshTime = meshTime;
+    rejectedInRow = 0;
+    jitterUs = 0;
+    if (seek) {
+      jumpCount++;
+      return SYNC_EST_JUMPED;
+    }
+    return SYNC_EST_REANCHORED;
+  }
+
+  rejectedInRow = 0;
+  if (acceptedInRow < UINT8_MAX) {
+    acceptedInRow++;
+  }
+  jitterUs += (static_cast<int32_t>(abs(errorUs)) - static_cast<int32_t>(jitterUs)) / 8;
+
+  // Phase: move a quarter of the way, never faster than the slew limit
+  int32_t phaseUs = clampI32(errorUs / 4, SYNC_EST_MAX_SLEW_US);
+
+  // Rate: integrate the error per elapsed millisecond. The gain is small (1/2048)
+  // so per-packet jitter barely moves it; only a sustained drift does.
+  int32_t dtMs = static_cast<int32_t>(meshTime - lastAcceptedMeshTime);
+  int32_t newRatePpm = ratePpm;
+  if (dtMs > 0) {
+    int64_t ratePpmError = static_cast<int64_t>(errorUs) * 1000 / dtMs;
+    newRatePpm = clampI32(ratePpm + ratePpmError / 2048, SYNC_EST_MAX_RATE_PPM);
+  }
+  lastAcceptedMeshTime = meshTime;
+
+  portENTER_CRITICAL(&anchorMux);
+  anchorPositionUs = predictedUs + phaseUs;
+  anchorMeshTime = meshTime;
+  ratePpm = newRatePpm;
+  portEXIT_CRITICAL(&anchorMux);
+
+  return SYNC_EST_TRACKED;
+}
+
+uint32_t syncEstimatorPosition(uint32_t meshTime) {
+  portENTER_CRITICAL(&anchorMux);
+  int64_t positionUs = estimateUs(meshTime);
+  portEXIT_CRITICAL(&anchorMux);
+  return positionUs > 0 ? static_cast<uint32_t>(positionUs / 1000) : 0;
+}
+
+void syncEstimatorReport(SyncEstimatorReport* report) {
+  report->flags = 0;
+  if (tracking) {
+    report->flags |= SYNC_EST_FLAG_TRACKING;
+    if (acceptedInRow >= SYNC_EST_LOCK_SAMPLES && jitterUs < SYNC_EST_LOCK_JITTER_US) {
+      report->flags |= SYNC_EST_FLAG_LOCKED;
+    }
+  }
+  report->errorTenthsMs = toTenthsMs(lastErrorUs);
+  report->jitterTenthsMs = static_cast<uint16_t>(std::min<uint32_t>(jitterUs / 100, UINT16_MAX));
+  portENTER_CRITICAL(&anchorMux);
+  report->ratePpm = static_cast<int16_t>(ratePpm);
+  portEXIT_CRITICAL(&anchorMux);
+  report->outliers = outlierCount;
+  report->jumps = jumpCount;
+}
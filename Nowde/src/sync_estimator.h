@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+#include "nowde_config.h"
+
+// Receiver-side estimate of media position as a function of mesh time.
+// Each MediaSync sample (position stamped by the sender at a mesh instant) is
+// compared with the current estimate: small errors are slewed out by a PI loop
+// on phase and rate, isolated large errors are rejected as outliers, and only
+// an error confirmed by consecutive samples re-anchors the estimate.
+enum SyncEstimatorResult : uint8_t {
+  SYNC_EST_TRACKED = 0,  // Sample accepted, estimate slewed towards it
+  SYNC_EST_OUTLIER,      // Sample rejected
+  SYNC_EST_REANCHORED,   // Confirmed step below MTC_RELOCATE_THRESHOLD_MS
+  SYNC_EST_JUMPED        // Confirmed step needing a relocate (seek)
+};
+
+// Start tracking from a known position (playback start)
+void syncEstimatorReset(uint32_t positionMs, uint32_t meshTime);
+// Stop tracking; stats are kept
+void syncEstimatorHold();
+SyncEstimatorResult syncEstimatorUpdate(uint32_t positionMs, uint32_t meshTime);
+
+// Estimated position at a mesh instant. Safe from any task (used by the MTC timer).
+uint32_t syncEstimatorPosition(uint32_t meshTime);
+
+void syncEstimatorReport(SyncEstimatorReport* report);
@@ -0,0 +1,129 @@
+#include "sync_rate.h"
+
+#include "layer_registry.h"
+#include "peer_table.h"
+
+namespace {
+
+struct LayerTrack {
+  uint32_t positionMs;     // Last position the Bridge sent
+  uint32_t meshTimestamp;  // Sender mesh time it was stamped with
+  uint32_t lastSentMs;     // millis() of the last frame forwarded
+  uint8_t mediaIndex;
+  uint8_t state;
+  bool known;
+};
+
+struct Burst {
+  MediaSyncPacket packet;  // As first sent (timestamp is the base for extrapolation)
+  uint32_t dueMs;
+  uint8_t remaining;       // 0 = slot free
+};
+
+// Index i tracks ID i + 1
+LayerTrack tracks[MAX_LAYER_IDS];
+Burst bursts[SYNC_BURST_SLOTS];
+
+bool isDiscontinuous(const LayerTrack& track, uint32_t positionMs, uint32_t meshTimestamp) {
+  uint32_t expected = track.positionMs;
+  if (track.state == 1) {
+    expected += meshTimestamp - track.meshTimestamp;
+  }
+  int32_t jump = static_cast<int32_t>(positionMs - expected);
+  return abs(jump) > static_cast<int32_t>(SYNC_DISCONTINUITY_MS);
+}
+
+}  // namespace
+
+SyncRateAction syncRateClassify(uint8_t layerId, uint8_t mediaIndex, uint32_t positionMs, uint8_t state,
+                                uint32_t meshTimestamp) {
+  if (layerId == LAYER_ID_NONE || layerId > MAX_LAYER_IDS) {
+    return SYNC_RATE_SEND;
+  }
+
+  LayerTrack& track = tracks[layerId - 1];
+  uint32_t now = millis();
+  bool changed = !track.known || track.mediaIndex != mediaIndex || track.state != state ||
+                 isDiscontinuous(track, positionMs, meshTimestamp);
+
+  // Every sample updates the track, forwarded or not, so the extrapolation
+  // never runs over a long gap
+  track.positionMs = positionMs;
+  track.meshTimestamp = meshTimestamp;
+  track.mediaIndex = mediaIndex;
+  track.state = state;
+  track.known = true;
+
+  if (changed) {
+    track.lastSentMs = now;
+    return SYNC_RATE_BURST;
+  }
+
+  bool steady = SYNC_STEADY_INTERVAL_MS > 0 && (state == 0 || allReceiversOnLayerLocked(layerId));
+  if (steady && (now - track.lastSentMs) < SYNC_STEADY_INTERVAL_MS) {
+    return SYNC_RATE_SKIP;
+  }
+  track.lastSentMs = now;
+  return SYNC_RATE_SEND;
+}
+
+void syncBurstStart(const MediaSyncPacket& packet) {
+  if (SYNC_BURST_REPEATS == 0) {
+    return;
+  }
+
+  // Same layer first, else the slot with the fewest repeats left (free slots have none)
+  Burst* target = nullptr;
+  for (Burst& burst : bursts) {
+    if (burst.remaining > 0 && burst.packet.layerId == packet.layerId) {
+      target = &burst;
+      break;
+    }
+  }
+  if (!target) {
+    target = &bursts[0];
+    for (Burst& burst : bursts) {
+      if (burst.remaining < target->remaining) {
+        target = &burst;
+      }
+    }
+  }
+
+  target->packet = packet;
+  target->dueMs = millis() + SYNC_BURST_SPACING_MS;
+  target->remaining = SYNC_BURST_REPEATS;
+}
+
+bool syncBurstPop(uint32_t nowMs, uint32_t meshNow, MediaSyncPacket* packet) {
+  for (Burst& burst : bursts) {
+    if (burst.remaining == 0 || static_cast<int32_t>(nowMs - burst.dueMs) < 0) {
+      continue;
+    }
+
+    *packet = burst.packet;
+    if (packet->state == 1) {
+      packet->positionMs += meshNow - burst.packet.meshTimestamp;
+    }
+    packet->meshTimestamp = meshNow;
+
+    burst.remaining--;
+    burst.dueMs = nowMs + SYNC_BURST_SPACING_MS;
+    return true;
+  }
+  return false;
+}
+
+TickType_t syncBurstTicksUntilNext(uint32_t nowMs) {
+  TickType_t ticks = portMAX_DELAY;
+  for (const Burst& burst : bursts) {
+    if (burst.remaining == 0) {
+      continue;
+    }
+    int32_t waitMs = static_cast<int32_t>(burst.dueMs - nowMs);
+    TickType_t wait = waitMs > 0 ? pdMS_TO_TICKS(waitMs) : 0;
+    if (wait < ticks) {
+      ticks = wait;
+    }
+  }
+  return ticks;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#include "nowde_config.h"
+
+// Sender-side sync rate control. The Bridge sends every layer at its own pace
+// (~10 Hz); the sender decides per layer what actually goes on the air:
+//  - a transport change (state, media index, or a position jump against the
+//    extrapolated one) goes out at once, followed by a short burst of repeats
+//    so one lost frame does not delay a start/stop/jump by a sync interval
+//  - unchanged frames are thinned to SYNC_STEADY_INTERVAL_MS once every
+//    receiver on the layer reports a locked estimator, or the layer is stopped
+//  - everything else is forwarded as it arrives
+// All of it runs on the MIDI task (SysEx handlers and the burst service).
+
+enum SyncRateAction : uint8_t {
+  SYNC_RATE_SKIP = 0,  // Steady state, not due: drop
+  SYNC_RATE_SEND,      // Forward as is
+  SYNC_RATE_BURST      // Transport change: forward and start a burst
+};
+
+// Classify the state the Bridge sent for a layer and remember it
+SyncRateAction syncRateClassify(uint8_t layerId, uint8_t mediaIndex, uint32_t positionMs, uint8_t state,
+                                uint32_t meshTimestamp);
+
+// Queue SYNC_BURST_REPEATS repeats of a frame just sent (replaces a running
+// burst of the same layer)
+void syncBurstStart(const MediaSyncPacket& packet);
+// Pops one repeat due at nowMs, stamped meshNow (position extrapolated if playing)
+bool syncBurstPop(uint32_t nowMs, uint32_t meshNow, MediaSyncPacket* packet);
+// Ticks until the next repeat is due (portMAX_DELAY when no burst is running)
+TickType_t syncBurstTicksUntilNext(uint32_t nowMs);
@@ -0,0 +1,161 @@
+#include "sync_redundancy.h"
+
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+#include <freertos/FreeRTOS.h>
+
+#include "layer_registry.h"
+
+namespace {
+
+struct LayerTrack {
+  uint8_t mediaIndex;
+  uint8_t state;
+  uint8_t sequence;
+  bool known;
+};
+
+// Index i tracks ID i + 1
+LayerTrack tracks[MAX_LAYER_IDS];
+
+#if MEDIA_SYNC_REDUNDANCY_DEPTH > 0
+// Newest transition of each layer (index i is ID i + 1). A show stop can
+// change every layer in one cycle, so one shared ring would drop transitions
+// before their copies went out. Written by the MIDI task, read by the ESP-NOW
+// task for beacons.
+struct LayerTransition {
+  SyncTransition transition;
+  uint32_t order;   // Note counter when it happened (newest is highest)
+  uint8_t carried;  // Trailers it has gone out in (saturates)
+  bool valid;
+};
+
+LayerTransition latest[MAX_LAYER_IDS];
+uint32_t noteCounter = 0;
+portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Next transition for a shared trailer: the one carried least often, newest
+// first among equals, so every layer gets its copies however many changed at
+// once. -1 when every valid one is already in the trailer (taken).
+int pickShared(const bool* taken) {
+  int best = -1;
+  for (int i = 0; i < MAX_LAYER_IDS; i++) {
+    if (!latest[i].valid || taken[i]) {
+      continue;
+    }
+    if (best < 0 || latest[i].carried < latest[best].carried ||
+        (latest[i].carried == latest[best].carried && latest[i].order > latest[best].order)) {
+      best = i;
+    }
+  }
+  return best;
+}
+#endif
+
+}  // namespace
+
+void syncRedundancyNote(uint8_t layerId, uint8_t mediaIndex, uint32_t positionMs, uint8_t state,
+                        uint32_t meshTimestamp) {
+#if MEDIA_SYNC_REDUNDANCY_DEPTH > 0
+  if (layerId == LAYER_ID_NONE || layerId > MAX_LAYER_IDS) {
+    return;
+  }
+
+  LayerTrack& track = tracks[layerId - 1];
+  if (track.known && track.mediaIndex == mediaIndex && track.state == state) {
+    return;
+  }
+  track.mediaIndex = mediaIndex;
+  track.state = state;
+  track.sequence++;
+  track.known = true;
+
+  SyncTransition transition;
+  transition.layerId = layerId;
+  transition.sequence = track.sequence;
+  transition.mediaIndex = mediaIndex;
+  transition.state = state;
+  // Receivers apply it SYNC_ACTION_LEAD_MS from now, all at the same mesh
+  // instant (scheduled_action.h): stamp it with that instant and position
+  transition.positionMs = state == 1 ? positionMs + SYNC_ACTION_LEAD_MS : positionMs;
+  transition.meshTimestamp = meshTimestamp + SYNC_ACTION_LEAD_MS;
+
+  portENTER_CRITICAL(&historyMux);
+  LayerTransition& entry = latest[layerId - 1];
+  entry.transition = transition;
+  entry.order = ++noteCounter;
+  entry.carried = 0;
+  entry.valid = true;
+  portEXIT_CRITICAL(&historyMux);
+#else
+  (void)layerId;
+  (void)mediaIndex;
+  (void)positionMs;
+  (void)state;
+  (void)meshTimestamp;
+#endif
+}
+
+size_t syncRedundancyAppend(uint8_t* frame, size_t frameLen, uint8_t layerId) {
+#if MEDIA_SYNC_REDUNDANCY_DEPTH > 0
+  SyncRedundancyTrailer trailer;
+  bool taken[MAX_LAYER_IDS] = {};
+
+  portENTER_CRITICAL(&historyMux);
+  // A layer's own frame always carries that layer's transition: its
+  // receivers are the ones listening
+  if (layerId != LAYER_ID_NONE && layerId <= MAX_LAYER_IDS && latest[layerId - 1].valid) {
+    taken[layerId - 1] = true;
+    trailer.transitions[trailer.count++] = latest[layerId - 1].transition;
+  }
+  while (trailer.count < MEDIA_SYNC_REDUNDANCY_DEPTH) {
+    int index = pickShared(taken);
+    if (index < 0) {
+      break;
+    }
+    taken[index] = true;
+    trailer.transitions[trailer.count++] = latest[index].transition;
+  }
+  for (int i = 0; i < MAX_LAYER_IDS; i++) {
+    if (taken[i] && latest[i].carried < UINT8_MAX) {
+      latest[i].carried++;
+    }
+  }
+  portEXIT_CRITICAL(&historyMux);
+
+  if (trailer.count == 0) {
+    return frameLen;
+  }
+  size_t trailerLen = offsetof(SyncRedundancyTrailer, transitions) + trailer.count * sizeof(SyncTransition);
+  memcpy(frame + frameLen, &trailer, trailerLen);
+  return frameLen + trailerLen;
+#else
+  (void)frame;
+  (void)layerId;
+  return frameLen;
+#endif
+}
+
+const SyncTransition* syncRedundancyFind(const uint8_t* data, int len, int baseLen, uint8_t layerId) {
+  constexpr int HEADER_LEN = offsetof(SyncRedundancyTrailer, transitions);
+  if (layerId == LAYER_ID_NONE || len < baseLen + HEADER_LEN) {
+    return nullptr;
+  }
+
+  const SyncRedundancyTrailer* trailer = reinterpret_cast<const SyncRedundancyTrailer*>(data + baseLen);
+  if (trailer->magic != SYNC_REDUNDANCY_MAGIC) {
+    return nullptr;
+  }
+
+  // The sender's depth may differ from ours: walk what is on the air
+  int count = std::min<int>(trailer->count, (len - baseLen - HEADER_LEN) / static_cast<int>(sizeof(SyncTransition)));
+  const SyncTransition* transitions = reinterpret_cast<const SyncTransition*>(data + baseLen + HEADER_LEN);
+  for (int i = 0; i < count; i++) {
+    if (transitions[i].layerId == layerId) {
+      return &transitions[i];  // At most one per layer
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+#include "nowde_config.h"
+
+// Redundant transitions for the fire-and-forget sync stream.
+// The sender remembers the newest layer transition (play/stop or media index
+// change) of every layer and appends up to MEDIA_SYNC_REDUNDANCY_DEPTH of them
+// as a SyncRedundancyTrailer to every sync frame and beacon. The current state
+// is already repeated at the sync rate; what a lost frame can cost is a one-off
+// transition on a layer that then goes quiet (a stop), so only those are
+// repeated, riding frames that go out anyway. A layer's own frames always carry
+// its transition; the other slots (and batches and beacons) take the ones sent
+// least often, so a stop across many layers at once still reaches them all.
+// Each transition is stamped with the mesh instant receivers apply it at
+// (SYNC_ACTION_LEAD_MS ahead).
+
+// Sender, MIDI task: account the state about to be sent for a layer
+void syncRedundancyNote(uint8_t layerId, uint8_t mediaIndex, uint32_t positionMs, uint8_t state,
+                        uint32_t meshTimestamp);
+// Sender: append the trailer after frameLen bytes (room for a
+// SyncRedundancyTrailer must follow); returns the new frame length. layerId is
+// the frame's layer, LAYER_ID_NONE for batches of several layers and beacons.
+size_t syncRedundancyAppend(uint8_t* frame, size_t frameLen, uint8_t layerId);
+
+// Receiver: newest transition for layerId in the trailer that starts at
+// baseLen, or nullptr when the frame has none
+const SyncTransition* syncRedundancyFind(const uint8_t* data, int len, int baseLen, uint8_t layerId);
@@ -1,18 +1,37 @@
 #include "sysex.h"
 
 #include <cstring>
+#include <cstddef>
 #include <algorithm>
 
+#include <esp_mac.h>
 #include <esp_now.h>
 #include <esp_system.h>
+#include <esp_timer.h>
 #include <Update.h>
 
+#include "benchmark.h"
+#include "channel.h"
+#include "diagnostics.h"
+#include "espnow_tx.h"
+#include "layer_registry.h"
+#include "metrics.h"
 #include "midi.h"
 #include "nowde_config.h"
+#include "nowde_log.h"
 #include "nowde_state.h"
+#include "ota.h"
+#include "peer_table.h"
+#include "phantom.h"
 #include "receiver_mode.h"
+#include "rf_sim.h"
+#include "running_state.h"
+#include "scheduler.h"
 #include "sender_mode.h"
 #include "storage.h"
+#include "sync_rate.h"
+#include "sync_redundancy.h"
+#include "sysex_stream.h"
 
 // OTA state tracking
 static bool otaInProgress = false;
@@ -26,59 +45,345 @@ void sendConfigState();
 void sendRunningState();
 void sendErrorReport(uint8_t errorCode, const uint8_t* context, uint8_t contextLength);
 
-// 7-bit encoding helpers
-// Encodes 8-bit data to 7-bit MIDI-safe format
-// Every 7 bytes of input becomes 8 bytes of output (MSBs packed into first byte)
-int encode7bit(const uint8_t* input, int inputLen, uint8_t* output) {
-  int outIdx = 0;
-  int inIdx = 0;
-  
-  while (inIdx < inputLen) {
-    // Pack MSBs of next 7 bytes into first output byte
-    uint8_t msbByte = 0;
-    int chunkSize = min(7, inputLen - inIdx);
-    
-    for (int i = 0; i < chunkSize; i++) {
-      if (input[inIdx + i] & 0x80) {
-        msbByte |= (1 << i);
+// Sends a sync frame, with the redundancy trailer, now or through the
+// simulated link when RF simulation is on. Burst repeats (repeat) do not
+// count towards the USB -> ESP-NOW latency histogram. A frame still queued
+// for the same peer and layer (layerId, 0 for multi-layer batches) is
+// replaced rather than sent behind. MIDI task only (shared buffer).
+static void sendMediaSyncFrame(const uint8_t* mac, const void* frame, size_t frameLen, uint8_t layerId,
+                               bool repeat) {
+  static uint8_t buffer[SYNC_FRAME_MAX_LEN];
+  memcpy(buffer, frame, frameLen);
+  frameLen = syncRedundancyAppend(buffer, frameLen, layerId);
+  phantomNoteSync(mac, buffer, frameLen);
+
+  metricsCount(METRIC_SYNC_TX);
+  if (rfSimulationEnabled) {
+    rfSimSubmit(mac, buffer, frameLen);
+    return;
+  }
+
+  espnowTxSend(mac, buffer, frameLen, layerId);
+  if (!repeat) {
+    metricsRecordUs(METRIC_HIST_USB_TO_ESPNOW,
+                    static_cast<uint32_t>(esp_timer_get_time()) - sysexStreamStartUs());
+  }
+}
+
+// One layer's MediaSyncPacket to the receivers on that layer
+static void sendLayerSyncFrame(const MediaSyncPacket& syncPacket, bool repeat) {
+#if MEDIA_SYNC_BROADCAST
+  // Single broadcast frame per layer: receivers select it by layer ID
+  // (see processMediaSyncPacket), so airtime does not grow with receiver count
+  // and all receivers on the layer hear the same frame at the same instant.
+  if (hasConnectedReceiverOnLayer(syncPacket.layerId)) {
+    sendMediaSyncFrame(broadcastAddress, &syncPacket, sizeof(syncPacket), syncPacket.layerId, repeat);
+  }
+#else
+  // Only send to CONNECTED receivers on matching layer (walks the layer chain only)
+  // Disconnected receivers (not sending info) are skipped to prevent blocking
+  uint8_t slots[MAX_RECEIVERS];
+  int slotCount = collectReceiversOnLayer(syncPacket.layerId, slots, MAX_RECEIVERS);
+  for (int i = 0; i < slotCount; i++) {
+    sendMediaSyncFrame(receiverTable[slots[i]].mac, &syncPacket, sizeof(syncPacket), syncPacket.layerId,
+                       repeat);
+  }
+#endif
+}
+
+TickType_t sysexServiceSyncBursts() {
+  if (!senderModeEnabled) {
+    return portMAX_DELAY;
+  }
+
+  uint32_t now = millis();
+  MediaSyncPacket repeat;
+  while (syncBurstPop(now, meshClock.meshMillis(), &repeat)) {
+    sendLayerSyncFrame(repeat, true);
+  }
+  return syncBurstTicksUntilNext(now);
+}
+
+// ---------------- Streamed commands (sysex_stream.h) ----------------
+
+namespace {
+
+// [layer(16)] [index(1)] [pos_encoded(5)] [state(1)]
+constexpr uint8_t SYNC_ENTRY_LEN = MAX_LAYER_LENGTH + 1 + 5 + 1;
+
+// Decodes one sync entry as its bytes arrive, writing the fields into the frame being built
+struct SyncEntryDecoder {
+  char layer[MAX_LAYER_LENGTH];
+  uint8_t offset;
+  Sysex7BitDecoder position;
+
+  void reset() {
+    offset = 0;
+  }
+
+  // True once the last byte of the entry went in (layer is terminated by then)
+  template <typename Entry>
+  bool feed(uint8_t value, Entry& out) {
+    uint8_t at = offset++;
+    if (at < MAX_LAYER_LENGTH) {
+      layer[at] = value;
+      return false;
+    }
+    if (at == MAX_LAYER_LENGTH) {
+      out.mediaIndex = value;
+      out.positionMs = 0;
+      position.reset();
+      return false;
+    }
+    if (at < SYNC_ENTRY_LEN - 1) {
+      uint8_t decoded;
+      if (position.feed(value, &decoded)) {
+        out.positionMs = (out.positionMs << 8) | decoded;
       }
+      return false;
     }
-    output[outIdx++] = msbByte;
-    
-    // Copy 7-bit data (clear MSB)
-    for (int i = 0; i < chunkSize; i++) {
-      output[outIdx++] = input[inIdx++] & 0x7F;
+    out.state = value;
+    layer[MAX_LAYER_LENGTH - 1] = '\0';
+    offset = 0;
+    return true;
+  }
+};
+
+// OTA_DATA (v1): F0 7D 06 [data(7-bit encoded)] F7
+struct LegacyOtaStream {
+  Sysex7BitDecoder decoder;
+  uint8_t pending[256];
+  size_t pendingLen;
+} legacyOta;
+
+bool legacyOtaFlush() {
+  size_t written = Update.write(legacyOta.pending, legacyOta.pendingLen);
+  if (written != legacyOta.pendingLen) {
+    LOG_ERROR(LOG_CAT_OTA, "[OTA DATA] Write failed: %d/%d bytes\r\n", written, legacyOta.pendingLen);
+    Update.abort();
+    otaInProgress = false;
+    sendErrorReport(ERROR_CONFIG_INVALID, nullptr, 0);
+    return false;
+  }
+  otaReceivedSize += written;
+  legacyOta.pendingLen = 0;
+  return true;
+}
+
+void legacyOtaBegin() {
+  legacyOta.decoder.reset();
+  legacyOta.pendingLen = 0;
+}
+
+void legacyOtaByte(uint8_t value) {
+  uint8_t decoded;
+  if (!otaInProgress || !legacyOta.decoder.feed(value, &decoded)) {
+    return;
+  }
+  legacyOta.pending[legacyOta.pendingLen++] = decoded;
+  if (legacyOta.pendingLen == sizeof(legacyOta.pending)) {
+    legacyOtaFlush();
+  }
+}
+
+void legacyOtaEnd(bool complete) {
+  if (!otaInProgress || !complete || (legacyOta.pendingLen > 0 && !legacyOtaFlush())) {
+    return;
+  }
+
+  // Log progress every 10%
+  uint8_t percent = (otaReceivedSize * 100) / otaTotalSize;
+  static uint8_t lastPercent = 0;
+  if (percent >= lastPercent + 10 || lastPercent == 0) {
+    LOG_INFO(LOG_CAT_OTA, "[OTA DATA] Progress: %u%% (%u/%u bytes)\r\n",
+             percent, otaReceivedSize, otaTotalSize);
+    lastPercent = percent;
+    if (percent >= 90) {
+      lastPercent = 0;  // Reset for next OTA session
     }
   }
-  
-  return outIdx;
 }
 
-// Decodes 7-bit MIDI format back to 8-bit data
-int decode7bit(const uint8_t* input, int inputLen, uint8_t* output) {
-  int outIdx = 0;
-  int inIdx = 0;
-  
-  while (inIdx < inputLen) {
-    // Read MSB byte
-    uint8_t msbByte = input[inIdx++];
-    
-    // Decode up to 7 data bytes
-    int chunkSize = min(7, inputLen - inIdx);
-    for (int i = 0; i < chunkSize && inIdx < inputLen; i++) {
-      output[outIdx] = input[inIdx++];
-      // Restore MSB if it was set
-      if (msbByte & (1 << i)) {
-        output[outIdx] |= 0x80;
-      }
-      outIdx++;
+// MEDIA_SYNC: F0 7D 10 [layer(16)] [index(1)] [pos_encoded(5)] [state(1)] F7
+struct MediaSyncStream {
+  SyncEntryDecoder entry;
+  MediaSyncPacket packet;
+  bool haveEntry;
+} mediaSync;
+
+void mediaSyncBegin() {
+  mediaSync.entry.reset();
+  mediaSync.haveEntry = false;
+}
+
+void mediaSyncByte(uint8_t value) {
+  if (!mediaSync.haveEntry) {
+    mediaSync.haveEntry = mediaSync.entry.feed(value, mediaSync.packet);
+  }
+}
+
+void mediaSyncEnd(bool complete) {
+  if (!complete || !mediaSync.haveEntry || !senderModeEnabled) {
+    return;
+  }
+
+  MediaSyncPacket& syncPacket = mediaSync.packet;
+  const char* targetLayer = mediaSync.entry.layer;
+  syncPacket.meshTimestamp = meshClock.meshMillis();  // Set timestamp BEFORE any delay
+
+  // Only log media sync on state changes or media index changes
+  static uint8_t lastState = 255;
+  static uint8_t lastIndex = 255;
+  bool shouldLog = (syncPacket.state != lastState) || (syncPacket.mediaIndex != lastIndex);
+
+  if (shouldLog) {
+    LOG_INFO(LOG_CAT_SYSEX, "[MEDIA SYNC] Layer='%s', Index=%d, Pos=%lu ms, State=%s, MeshTime=%lu\r\n",
+             targetLayer, syncPacket.mediaIndex, syncPacket.positionMs,
+             syncPacket.state == 1 ? "playing" : "stopped", syncPacket.meshTimestamp);
+    lastState = syncPacket.state;
+    lastIndex = syncPacket.mediaIndex;
+  }
+
+  // No ID means no receiver has registered this layer: nothing to send
+  uint8_t layerId = findLayerId(targetLayer);
+  if (layerId == LAYER_ID_NONE) {
+    return;
+  }
+  syncPacket.layerId = layerId;
+  syncRedundancyNote(layerId, syncPacket.mediaIndex, syncPacket.positionMs, syncPacket.state,
+                     syncPacket.meshTimestamp);
+
+  SyncRateAction action = syncRateClassify(layerId, syncPacket.mediaIndex, syncPacket.positionMs,
+                                           syncPacket.state, syncPacket.meshTimestamp);
+  if (action == SYNC_RATE_SKIP) {
+    metricsCount(METRIC_SYNC_SUPPRESSED);
+    return;
+  }
+  sendLayerSyncFrame(syncPacket, false);
+  if (action == SYNC_RATE_BURST) {
+    syncBurstStart(syncPacket);
+  }
+}
+
+// MEDIA_SYNC_BATCH: F0 7D 12 [count(1)] count x ([layer(16)] [index(1)] [pos_encoded(5)] [state(1)]) F7
+struct MediaSyncBatchStream {
+  SyncEntryDecoder entry;
+  MediaSyncBatchPacket batch;
+  bool haveCount;
+  uint8_t count;
+  uint8_t entriesSeen;
+} batchSync;
+
+void batchSyncBegin() {
+  batchSync.entry.reset();
+  batchSync.batch.count = 0;
+  batchSync.haveCount = false;
+  batchSync.count = 0;
+  batchSync.entriesSeen = 0;
+}
+
+void batchSyncByte(uint8_t value) {
+  if (!batchSync.haveCount) {
+    batchSync.count = value;
+    batchSync.haveCount = true;
+    return;
+  }
+  if (batchSync.entriesSeen >= batchSync.count || batchSync.count > MEDIA_SYNC_BATCH_MAX_LAYERS) {
+    return;
+  }
+
+  // Decoded in place; the entry is only kept if someone listens to its layer
+  MediaSyncBatchEntry& out = batchSync.batch.entries[batchSync.batch.count];
+  if (!batchSync.entry.feed(value, out)) {
+    return;
+  }
+  batchSync.entriesSeen++;
+
+  // Skip layers nobody listens to (saves 7 bytes of airtime each)
+  uint8_t layerId = findLayerId(batchSync.entry.layer);
+  if (hasConnectedReceiverOnLayer(layerId)) {
+    out.layerId = layerId;
+    batchSync.batch.count++;
+  }
+}
+
+void batchSyncEnd(bool complete) {
+  if (!complete || !senderModeEnabled || !batchSync.haveCount) {
+    return;
+  }
+  if (batchSync.count > MEDIA_SYNC_BATCH_MAX_LAYERS || batchSync.entriesSeen < batchSync.count) {
+    uint8_t command = SYSEX_CMD_MEDIA_SYNC_BATCH;
+    sendErrorReport(ERROR_SYSEX_PARSE_ERROR, &command, 1);
+    return;
+  }
+
+  // One mesh timestamp shared by every layer in this tick
+  MediaSyncBatchPacket& batch = batchSync.batch;
+  batch.meshTimestamp = meshClock.meshMillis();
+
+  static uint8_t lastBatchCount = 255;
+  if (batch.count != lastBatchCount) {
+    LOG_DEFER(INFO, LOG_CAT_SYSEX, "[MEDIA SYNC BATCH] %d/%d layer(s) with receivers, MeshTime=%lu\r\n",
+              batch.count, batchSync.count, batch.meshTimestamp);
+    lastBatchCount = batch.count;
+  }
+
+  // Steady layers not due are dropped from the frame (compacted in place);
+  // changed layers additionally get a burst of single-layer MediaSyncPackets
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < batch.count; i++) {
+    const MediaSyncBatchEntry entry = batch.entries[i];
+    syncRedundancyNote(entry.layerId, entry.mediaIndex, entry.positionMs, entry.state, batch.meshTimestamp);
+
+    SyncRateAction action = syncRateClassify(entry.layerId, entry.mediaIndex, entry.positionMs, entry.state,
+                                             batch.meshTimestamp);
+    if (action == SYNC_RATE_SKIP) {
+      metricsCount(METRIC_SYNC_SUPPRESSED);
+      continue;
     }
+    if (action == SYNC_RATE_BURST) {
+      MediaSyncPacket packet;
+      packet.layerId = entry.layerId;
+      packet.mediaIndex = entry.mediaIndex;
+      packet.positionMs = entry.positionMs;
+      packet.state = entry.state;
+      packet.meshTimestamp = batch.meshTimestamp;
+      syncBurstStart(packet);
+    }
+    batch.entries[kept++] = entry;
+  }
+  batch.count = kept;
+
+  // Batches are multi-layer by nature, so they always go out as one broadcast frame
+  if (batch.count > 0) {
+    size_t batchLen = offsetof(MediaSyncBatchPacket, entries) + batch.count * sizeof(MediaSyncBatchEntry);
+    uint8_t layerId = batch.count == 1 ? batch.entries[0].layerId : ESPNOW_TX_KEY_NONE;
+    sendMediaSyncFrame(broadcastAddress, &batch, batchLen, layerId, false);
+  }
+}
+
+const SysexStreamHandler legacyOtaStreamHandler = {legacyOtaBegin, legacyOtaByte, legacyOtaEnd};
+const SysexStreamHandler mediaSyncStreamHandler = {mediaSyncBegin, mediaSyncByte, mediaSyncEnd};
+const SysexStreamHandler batchSyncStreamHandler = {batchSyncBegin, batchSyncByte, batchSyncEnd};
+
+}  // namespace
+
+const SysexStreamHandler* sysexStreamHandlerFor(uint8_t command) {
+  switch (command) {
+    case SYSEX_CMD_OTA_DATA:
+      return &legacyOtaStreamHandler;
+    case SYSEX_CMD_OTA2_DATA:
+      return otaDataStream();
+    case SYSEX_CMD_MEDIA_SYNC:
+      return &mediaSyncStreamHandler;
+    case SYSEX_CMD_MEDIA_SYNC_BATCH:
+      return &batchSyncStreamHandler;
+    default:
+      return nullptr;
   }
-  
-  return outIdx;
 }
 
-void handleSysExMessage(const uint8_t* data, uint8_t length) {
+void handleSysExMessage(const uint8_t* data, size_t length) {
   // Basic validation
   if (length < 2) {
     return;  // Too short to be valid
@@ -111,42 +416,53 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       // Enable sender mode if not already active
       if (!senderModeEnabled) {
         senderModeEnabled = true;
-        DEBUG_SERIAL.println("\n=== SENDER MODE ACTIVATED ===");
-        DEBUG_SERIAL.println("Received: QUERY_CONFIG (0x01)");
-        DEBUG_SERIAL.println("Status: Broadcasting ESP-NOW beacons");
-        DEBUG_SERIAL.println("=============================\n");
+        LOG_INFO(LOG_CAT_SYSEX, "[QUERY_CONFIG] SENDER MODE ACTIVATED - broadcasting ESP-NOW beacons\r\n");
+        schedulerWake();  // Start sender timers now
       } else {
-        DEBUG_SERIAL.println("[QUERY_CONFIG] Received from Bridge");
+        LOG_INFO(LOG_CAT_SYSEX, "[QUERY_CONFIG] Received from Bridge\r\n");
       }
       
+      // New Bridge session: it subscribes again if it supports RUNNING_STATE_DELTA
+      if (runningStateSubscribed()) {
+        runningStateSubscribe(false);
+      }
+
       // Always send HELLO first (so Bridge knows we're alive/ready)
       // then send current config state
       sendHello();
-      delay(50);  // Delay between messages to ensure Bridge processes them separately
       sendConfigState();
       break;
 
     case SYSEX_CMD_PUSH_FULL_CONFIG:
-      // Format: F0 7D 02 [rfSimEnabled(1)] [rfSimMaxDelayHi(1)] [rfSimMaxDelayLo(1)] F7
+      // Format: F0 7D 02 [rfSimEnabled(1)] [rfSimMaxDelayHi(1)] [rfSimMaxDelayLo(1)]
+      //   [lossPercent(1)] [reorderPercent(1)] [outagePerMille(1)] [outageMsHi(1)] [outageMsLo(1)] F7
+      // The impairment bytes are optional (older Bridges): absent means none
       if (length >= 6) {
         // Enable sender mode if not already active
         if (!senderModeEnabled) {
           senderModeEnabled = true;
-          DEBUG_SERIAL.println("\n=== SENDER MODE ACTIVATED ===");
-          DEBUG_SERIAL.println("Received: PUSH_FULL_CONFIG (0x02)");
-          DEBUG_SERIAL.println("=============================\n");
+          LOG_INFO(LOG_CAT_SYSEX, "[PUSH_FULL_CONFIG] SENDER MODE ACTIVATED\r\n");
+          schedulerWake();
         }
         
         rfSimulationEnabled = data[3] != 0;
         // Decode from two 7-bit bytes (MIDI SysEx compatible)
         rfSimMaxDelayMs = (static_cast<uint16_t>(data[4] & 0x7F) << 7) | (data[5] & 0x7F);
+        bool hasImpairments = length >= 12;
+        rfSimLossPercent = hasImpairments ? std::min<uint8_t>(data[6], 100) : 0;
+        rfSimReorderPercent = hasImpairments ? std::min<uint8_t>(data[7], 100) : 0;
+        rfSimOutagePerMille = hasImpairments ? data[8] & 0x7F : 0;
+        rfSimOutageMs = hasImpairments ? (static_cast<uint16_t>(data[9] & 0x7F) << 7) | (data[10] & 0x7F) : 0;
+        if (!rfSimulationEnabled) {
+          rfSimReset();
+        }
+        profileSetRfSimulation(rfSimulationEnabled, rfSimMaxDelayMs, rfSimLossPercent, rfSimReorderPercent,
+                               rfSimOutagePerMille, rfSimOutageMs);
         
-        DEBUG_SERIAL.println("[PUSH_FULL_CONFIG] Configuration applied");
-        DEBUG_SERIAL.print("  RF Simulation: ");
-        DEBUG_SERIAL.println(rfSimulationEnabled ? "ENABLED" : "DISABLED");
-        DEBUG_SERIAL.print("  Max Delay: ");
-        DEBUG_SERIAL.print(rfSimMaxDelayMs);
-        DEBUG_SERIAL.println(" ms\n");
+        LOG_INFO(LOG_CAT_SYSEX, "[PUSH_FULL_CONFIG] Configuration applied: RF Simulation %s, max delay %u ms\r\n",
+                 rfSimulationEnabled ? "ENABLED" : "DISABLED", rfSimMaxDelayMs);
+        LOG_INFO(LOG_CAT_SYSEX, "  Loss: %u%%, Reorder: %u%%, Outage: %u/1000 frames x %u ms\r\n",
+                 rfSimLossPercent, rfSimReorderPercent, rfSimOutagePerMille, rfSimOutageMs);
         
         // Acknowledge with config state
         sendConfigState();
@@ -155,6 +471,13 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       }
       break;
 
+    case SYSEX_CMD_SUBSCRIBE_RUNNING_STATE:
+      // Format: F0 7D 0C [enable(1)] F7
+      if (length >= 5 && senderModeEnabled) {
+        runningStateSubscribe(data[3] != 0);
+      }
+      break;
+
     case SYSEX_CMD_QUERY_RUNNING_STATE:
       if (senderModeEnabled) {
         // Silently send running state (queried every 1s by Bridge)
@@ -162,10 +485,46 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       }
       break;
 
+    case SYSEX_CMD_RUN_BENCHMARK:
+      // Format: F0 7D 0B [testMask(1), optional] F7
+      if (senderModeEnabled) {
+        benchmarkRun(length >= 5 ? data[3] : BENCHMARK_ALL_MASK);
+      }
+      break;
+
+    case SYSEX_CMD_QUERY_DIAGNOSTICS:
+      // Format: F0 7D 0E F7 (sender or receiver)
+      diagnosticsSend();
+      break;
+
+    case SYSEX_CMD_PHANTOM_RECEIVERS: {
+      // Format: F0 7D 0F [count(1)] [layerCount(1)] layerCount x [layer(16)] F7 (count 0 = stop)
+      if (length < 5) {
+        break;
+      }
+      uint8_t layerCount = length >= 6 ? std::min<uint8_t>(data[4], PHANTOM_MAX_LAYERS) : 0;
+      if (length < 6 + static_cast<size_t>(layerCount) * MAX_LAYER_LENGTH) {
+        uint8_t command = SYSEX_CMD_PHANTOM_RECEIVERS;
+        sendErrorReport(ERROR_SYSEX_PARSE_ERROR, &command, 1);
+        break;
+      }
+      char layers[PHANTOM_MAX_LAYERS][MAX_LAYER_LENGTH];
+      memcpy(layers, &data[5], layerCount * MAX_LAYER_LENGTH);
+      phantomStart(data[3], layers, layerCount);
+      break;
+    }
+
+    case SYSEX_CMD_CHANNEL_SURVEY:
+      // Format: F0 7D 0D [mode(1)] [channel(1), CHANNEL_SURVEY_FORCE only] F7
+      if (length >= 5 && senderModeEnabled) {
+        channelRequest(data[3], length >= 6 ? data[4] : 0);
+      }
+      break;
+
     case SYSEX_CMD_ENTER_BOOTLOADER:
       // Deprecated - use OTA instead
       if (senderModeEnabled && length >= 4) {
-        DEBUG_SERIAL.println("\n[BOOTLOADER] Command deprecated - use OTA instead");
+        LOG_WARN(LOG_CAT_SYSEX, "[BOOTLOADER] Command deprecated - use OTA instead\r\n");
       }
       break;
 
@@ -174,26 +533,25 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       if (senderModeEnabled && length >= 9) {
         // Decode firmware size (4 bytes raw -> 5 bytes encoded)
         uint8_t sizeBytes[4];
-        decode7bit(&data[3], 5, sizeBytes);
+        decode7bitFixed<sizeof(sizeBytes)>(&data[3], sizeBytes);
         
         otaTotalSize = (static_cast<uint32_t>(sizeBytes[0]) << 24) |
                        (static_cast<uint32_t>(sizeBytes[1]) << 16) |
                        (static_cast<uint32_t>(sizeBytes[2]) << 8) |
                        static_cast<uint32_t>(sizeBytes[3]);
         
-        DEBUG_SERIAL.printf("\n[OTA BEGIN] Starting firmware update, size=%u bytes\r\n", otaTotalSize);
+        LOG_INFO(LOG_CAT_OTA, "[OTA BEGIN] Starting firmware update, size=%u bytes\r\n", otaTotalSize);
         
         // Abort any previous OTA session
         if (Update.isRunning()) {
           Update.abort();
-          DEBUG_SERIAL.println("[OTA BEGIN] Aborted previous OTA session");
+          LOG_WARN(LOG_CAT_OTA, "[OTA BEGIN] Aborted previous OTA session\r\n");
         }
         
         // Begin OTA update with the exact size - this is required for validation
         // U_FLASH means we're updating the app partition (not SPIFFS)
         if (!Update.begin(otaTotalSize, U_FLASH)) {
-          DEBUG_SERIAL.printf("[OTA BEGIN] FAILED - Error: %s\r\n", Update.errorString());
-          DEBUG_SERIAL.printf("[OTA BEGIN] Error code: %d\r\n", Update.getError());
+          LOG_ERROR(LOG_CAT_OTA, "[OTA BEGIN] FAILED - Error: %s (code %d)\r\n", Update.errorString(), Update.getError());
           sendErrorReport(ERROR_CONFIG_INVALID, nullptr, 0);
           break;
         }
@@ -202,59 +560,20 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
         otaReceivedSize = 0;
         otaStartTime = millis();
         
-        DEBUG_SERIAL.println("[OTA BEGIN] Ready to receive firmware data");
-        DEBUG_SERIAL.printf("[OTA BEGIN] Allocated partition size: %u bytes\r\n", Update.size());
-      }
-      break;
-
-    case SYSEX_CMD_OTA_DATA:
-      // Format: F0 7D 06 [data(7-bit encoded)] F7
-      if (otaInProgress && length > 4) {
-        // Decode data (encoded length - 3 for header/footer)
-        uint8_t encodedLen = length - 4;  // Subtract F0, 7D, 06, F7
-        uint8_t decodedData[256];
-        int decodedLen = decode7bit(&data[3], encodedLen, decodedData);
-        
-        // Write to OTA partition
-        size_t written = Update.write(decodedData, decodedLen);
-        if (written != decodedLen) {
-          DEBUG_SERIAL.printf("[OTA DATA] Write failed: %d/%d bytes\r\n", written, decodedLen);
-          Update.abort();
-          otaInProgress = false;
-          sendErrorReport(ERROR_CONFIG_INVALID, nullptr, 0);
-          break;
-        }
-        
-        otaReceivedSize += decodedLen;
-        
-        // Log progress every 10%
-        uint8_t percent = (otaReceivedSize * 100) / otaTotalSize;
-        static uint8_t lastPercent = 0;
-        if (percent >= lastPercent + 10 || lastPercent == 0) {
-          DEBUG_SERIAL.printf("[OTA DATA] Progress: %u%% (%u/%u bytes)\r\n", 
-                             percent, otaReceivedSize, otaTotalSize);
-          lastPercent = percent;
-          if (percent >= 90) {
-            lastPercent = 0;  // Reset for next OTA session
-          }
-        }
+        LOG_INFO(LOG_CAT_OTA, "[OTA BEGIN] Ready to receive firmware data (partition size: %u bytes)\r\n", Update.size());
       }
       break;
 
     case SYSEX_CMD_OTA_END:
       // Format: F0 7D 07 F7
       if (otaInProgress) {
-        DEBUG_SERIAL.printf("\n[OTA END] Finalizing firmware (%u bytes in %lu ms)\r\n",
-                           otaReceivedSize, millis() - otaStartTime);
-        DEBUG_SERIAL.printf("[OTA END] Expected: %u bytes, Received: %u bytes\r\n",
-                           otaTotalSize, otaReceivedSize);
+        LOG_INFO(LOG_CAT_OTA, "[OTA END] Finalizing firmware (%u/%u bytes in %lu ms)\r\n",
+                 otaReceivedSize, otaTotalSize, millis() - otaStartTime);
         
         // Validate that we received all expected data
         if (otaReceivedSize != otaTotalSize) {
-          DEBUG_SERIAL.printf("[OTA END] Size mismatch: received %u, expected %u\r\n",
-                             otaReceivedSize, otaTotalSize);
-          DEBUG_SERIAL.printf("[OTA END] Difference: %d bytes\r\n",
-                             (int32_t)otaReceivedSize - (int32_t)otaTotalSize);
+          LOG_ERROR(LOG_CAT_OTA, "[OTA END] Size mismatch: received %u, expected %u (%d bytes)\r\n",
+                    otaReceivedSize, otaTotalSize, (int32_t)otaReceivedSize - (int32_t)otaTotalSize);
           Update.abort();
           otaInProgress = false;
           sendErrorReport(ERROR_CONFIG_INVALID, nullptr, 0);
@@ -263,16 +582,16 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
         
         // Finalize the update - this validates and sets boot partition
         if (Update.end(true)) {
-          DEBUG_SERIAL.println("[OTA END] SUCCESS - Firmware validated");
-          DEBUG_SERIAL.printf("[OTA END] New partition will boot on restart\r\n");
-          DEBUG_SERIAL.println("[OTA END] Rebooting in 2 seconds...");
+          LOG_INFO(LOG_CAT_OTA, "[OTA END] SUCCESS - Firmware validated, rebooting in 2 seconds...\r\n");
+          midiTxFlush(OTA_REBOOT_FLUSH_MS);  // Replies already queued; the delay below does not drain them
+          profileFlush();
+          logFlush();
           DEBUG_SERIAL.flush();
           
           delay(2000);
           esp_restart();
         } else {
-          DEBUG_SERIAL.printf("[OTA END] FAILED - Error: %s\r\n", Update.errorString());
-          DEBUG_SERIAL.printf("[OTA END] Error code: %d\r\n", Update.getError());
+          LOG_ERROR(LOG_CAT_OTA, "[OTA END] FAILED - Error: %s (code %d)\r\n", Update.errorString(), Update.getError());
           sendErrorReport(ERROR_CONFIG_INVALID, nullptr, 0);
         }
         
@@ -280,88 +599,19 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       }
       break;
 
-    case SYSEX_CMD_MEDIA_SYNC:
-      if (senderModeEnabled && length >= 27) {
-        char targetLayer[MAX_LAYER_LENGTH];
-        memcpy(targetLayer, &data[3], MAX_LAYER_LENGTH);
-        targetLayer[MAX_LAYER_LENGTH - 1] = '\0';
-
-        uint8_t mediaIndex = data[19];
-        
-        // Decode 7-bit encoded position (5 bytes -> 4 bytes)
-        // Format: [MSB byte][data1][data2][data3][data4]
-        uint8_t msbByte = data[20];
-        uint8_t positionBytes[4];
-        for (int i = 0; i < 4; i++) {
-          positionBytes[i] = data[21 + i];
-          if (msbByte & (1 << i)) {
-            positionBytes[i] |= 0x80;
-          }
-        }
-        
-        uint32_t positionMs = (static_cast<uint32_t>(positionBytes[0]) << 24) |
-                              (static_cast<uint32_t>(positionBytes[1]) << 16) |
-                              (static_cast<uint32_t>(positionBytes[2]) << 8) |
-                              static_cast<uint32_t>(positionBytes[3]);
-        uint8_t state = data[25];
-        uint32_t meshTimestamp = meshClock.meshMillis();
-
-        // Only log media sync on state changes or media index changes
-        static uint8_t lastState = 255;
-        static uint8_t lastIndex = 255;
-        bool shouldLog = (state != lastState) || (mediaIndex != lastIndex);
-        
-        if (shouldLog) {
-          DEBUG_SERIAL.printf("[MEDIA SYNC] Layer='%s', Index=%d, Pos=%lu ms, State=%s, MeshTime=%lu\r\n",
-                             targetLayer, mediaIndex, positionMs,
-                             state == 1 ? "playing" : "stopped", meshTimestamp);
-          lastState = state;
-          lastIndex = mediaIndex;
-        }
-
-        MediaSyncPacket syncPacket;
-        strncpy(syncPacket.layer, targetLayer, MAX_LAYER_LENGTH);
-        syncPacket.layer[MAX_LAYER_LENGTH - 1] = '\0';
-        syncPacket.mediaIndex = mediaIndex;
-        syncPacket.positionMs = positionMs;
-        syncPacket.state = state;
-        syncPacket.meshTimestamp = meshTimestamp;  // Set timestamp BEFORE any delay
-
-        int sentCount = 0;
-        for (int i = 0; i < MAX_RECEIVERS; i++) {
-          // Only send to CONNECTED receivers on matching layer
-          // Disconnected receivers (not sending info) are skipped to prevent blocking
-          if (receiverTable[i].active && receiverTable[i].connected &&
-              strncmp(receiverTable[i].layer, targetLayer, MAX_LAYER_LENGTH) == 0) {
-            
-            if (!rfSimulationEnabled) {
-              // Normal send - no delay
-              esp_now_send(receiverTable[i].mac, reinterpret_cast<uint8_t*>(&syncPacket), sizeof(syncPacket));
-            } else {
-              // RF simulation - add random delay
-              // Find free slot in delayed packets queue
-              for (int j = 0; j < MAX_DELAYED_PACKETS; j++) {
-                if (!delayedPackets[j].active) {
-                  unsigned long delayMs = random(0, rfSimMaxDelayMs + 1);
-                  delayedPackets[j].sendTime = millis() + delayMs;
-                  delayedPackets[j].packet = syncPacket;
-                  memcpy(delayedPackets[j].receiverMac, receiverTable[i].mac, 6);
-                  delayedPackets[j].active = true;
-                  break;
-                }
-              }
-            }
-            sentCount++;
-          }
-        }
-
-        // ESP-NOW TX logging disabled for media sync to reduce clutter
-        // Sync packets sent every ~100ms but not logged
+    case SYSEX_CMD_OTA2_BEGIN:
+      if (senderModeEnabled) {
+        otaHandleBegin(data, length);
       }
       break;
+
+    case SYSEX_CMD_OTA2_END:
+      otaHandleEnd(data, length);
+      break;
+
     case SYSEX_CMD_CHANGE_RECEIVER_LAYER:
-      DEBUG_SERIAL.printf("\n[SYSEX] CHANGE_RECEIVER_LAYER received (length=%d, receiverMode=%d, senderMode=%d)\r\n", 
-                         length, receiverModeEnabled ? 1 : 0, senderModeEnabled ? 1 : 0);
+      LOG_DEBUG(LOG_CAT_SYSEX, "[SYSEX] CHANGE_RECEIVER_LAYER received (length=%d, receiverMode=%d, senderMode=%d)\r\n",
+                length, receiverModeEnabled ? 1 : 0, senderModeEnabled ? 1 : 0);
       
       // When received by SENDER via USB MIDI from Bridge
       // Format: F0 7D 11 [mac_encoded(7)] [layer_encoded(19)] F7 = 29 bytes
@@ -371,11 +621,11 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       if (senderModeEnabled && length >= 29) {
         // Decode MAC address (7 bytes encoded -> 6 bytes raw)
         uint8_t targetMac[6];
-        decode7bit(&data[3], 7, targetMac);
+        decode7bitFixed<sizeof(targetMac)>(&data[3], targetMac);
 
         // Decode layer name (19 bytes encoded -> 16 bytes raw)
         uint8_t newLayerBytes[MAX_LAYER_LENGTH];
-        decode7bit(&data[10], 19, newLayerBytes);
+        decode7bitFixed<sizeof(newLayerBytes)>(&data[10], newLayerBytes);
         
         char newLayer[MAX_LAYER_LENGTH];
         memcpy(newLayer, newLayerBytes, MAX_LAYER_LENGTH);
@@ -387,64 +637,37 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
           layerLen = i + 1;
         }
 
-        DEBUG_SERIAL.println("\n[CHANGE_RECEIVER_LAYER] Remote layer change request");
-        DEBUG_SERIAL.print("  Target MAC: ");
-        for (int j = 0; j < 6; j++) {
-          DEBUG_SERIAL.printf("%02X", targetMac[j]);
-          if (j < 5) DEBUG_SERIAL.print(":");
-        }
-        DEBUG_SERIAL.println();
-        DEBUG_SERIAL.print("  New Layer: '");
-        DEBUG_SERIAL.print(newLayer);
-        DEBUG_SERIAL.println("'");
+        LOG_INFO(LOG_CAT_SYSEX, "[CHANGE_RECEIVER_LAYER] Remote layer change request: " LOG_MAC_FMT " -> '%s'\r\n",
+                 LOG_MAC_ARGS(targetMac), newLayer);
         
-        // Debug: Show all active receivers in table
-        DEBUG_SERIAL.println("  Active receivers in table:");
-        for (int i = 0; i < MAX_RECEIVERS; i++) {
-          if (receiverTable[i].active) {
-            DEBUG_SERIAL.print("    [");
-            DEBUG_SERIAL.print(i);
-            DEBUG_SERIAL.print("] ");
-            for (int j = 0; j < 6; j++) {
-              DEBUG_SERIAL.printf("%02X", receiverTable[i].mac[j]);
-              if (j < 5) DEBUG_SERIAL.print(":");
+        if (LOG_ENABLED(DEBUG, LOG_CAT_SYSEX)) {
+          DEBUG_SERIAL.println("  Active receivers in table:");
+          for (int i = 0; i < MAX_RECEIVERS; i++) {
+            if (receiverTable[i].active) {
+              DEBUG_SERIAL.printf("    [%d] " LOG_MAC_FMT " Layer='%s'\r\n",
+                                  i, LOG_MAC_ARGS(receiverTable[i].mac), receiverTable[i].layer);
             }
-            DEBUG_SERIAL.print(" Layer='");
-            DEBUG_SERIAL.print(receiverTable[i].layer);
-            DEBUG_SERIAL.println("'");
           }
         }
 
-        bool found = false;
-        for (int i = 0; i < MAX_RECEIVERS; i++) {
-          if (receiverTable[i].active && macEqual(receiverTable[i].mac, targetMac)) {
-            found = true;
-            DEBUG_SERIAL.println("  Receiver found in table, sending ESP-NOW command...");
-
-            // Build ESP-NOW SysEx message for receiver
-            uint8_t espnowMsg[32];
-            int idx = 0;
-            espnowMsg[idx++] = SYSEX_START;
-            espnowMsg[idx++] = SYSEX_MANUFACTURER_ID;
-            espnowMsg[idx++] = SYSEX_CMD_CHANGE_RECEIVER_LAYER;  // Will be handled by receiver
-            memcpy(&espnowMsg[idx], newLayer, layerLen);
-            idx += layerLen;
-            espnowMsg[idx++] = SYSEX_END;
-
-            esp_err_t result = esp_now_send(targetMac, espnowMsg, idx);
-
-            if (result == ESP_OK) {
-              DEBUG_SERIAL.println("  ESP-NOW send: SUCCESS\n");
-            } else {
-              DEBUG_SERIAL.printf("  ESP-NOW send: FAILED (error %d)\r\n\r\n", result);
-              sendErrorReport(ERROR_ESPNOW_SEND_FAILED, targetMac, 6);
-            }
-            break;
+        if (findReceiver(targetMac) != -1) {
+
+          // Build ESP-NOW SysEx message for receiver
+          uint8_t espnowMsg[32];
+          int idx = 0;
+          espnowMsg[idx++] = SYSEX_START;
+          espnowMsg[idx++] = SYSEX_MANUFACTURER_ID;
+          espnowMsg[idx++] = SYSEX_CMD_CHANGE_RECEIVER_LAYER;  // Will be handled by receiver
+          memcpy(&espnowMsg[idx], newLayer, layerLen);
+          idx += layerLen;
+          espnowMsg[idx++] = SYSEX_END;
+
+          if (!espnowTxSend(targetMac, espnowMsg, idx)) {
+            LOG_ERROR(LOG_CAT_SYSEX, "[CHANGE_RECEIVER_LAYER] ESP-NOW send FAILED\r\n");
+            sendErrorReport(ERROR_ESPNOW_SEND_FAILED, targetMac, 6);
           }
-        }
-
-        if (!found) {
-          DEBUG_SERIAL.println("  ERROR: Receiver not found in active table!\n");
+        } else {
+          LOG_ERROR(LOG_CAT_SYSEX, "[CHANGE_RECEIVER_LAYER] Receiver not found in active table\r\n");
           sendErrorReport(ERROR_RECEIVER_TIMEOUT, targetMac, 6);
         }
       }
@@ -452,14 +675,6 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       // Format: F0 7D 11 [layer] F7 (short message, no encoding)
       // CHECK THIS LAST (shorter message = less specific match)
       else if (receiverModeEnabled && length >= 4) {
-        DEBUG_SERIAL.println("\n[CHANGE_RECEIVER_LAYER] Receiver processing layer change...");
-        DEBUG_SERIAL.printf("  Message length: %d bytes\r\n", length);
-        DEBUG_SERIAL.print("  Raw data: ");
-        for (int i = 0; i < length; i++) {
-          DEBUG_SERIAL.printf("%02X ", data[i]);
-        }
-        DEBUG_SERIAL.println();
-        
         // Short format: F0 7D 11 [layer] F7 (broadcast to all receivers on sender)
         // This is the format sent by the sender via ESP-NOW
         int layerLen = min<int>(length - 4, MAX_LAYER_LENGTH - 1);
@@ -467,24 +682,19 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
         memcpy(newLayer, &data[3], layerLen);
         newLayer[layerLen] = '\0';
         
-        DEBUG_SERIAL.print("  Extracted layer (len=");
-        DEBUG_SERIAL.print(layerLen);
-        DEBUG_SERIAL.print("): '");
-        DEBUG_SERIAL.print(newLayer);
-        DEBUG_SERIAL.println("'");
-        
         // Update subscribed layer
         strncpy(subscribedLayer, newLayer, MAX_LAYER_LENGTH);
         subscribedLayer[MAX_LAYER_LENGTH - 1] = '\0';
         
-        // Save to NVS
-        saveLayerToEEPROM(subscribedLayer);
+        // Committed to NVS by the profile task
+        profileSetLayer(subscribedLayer);
+
+        // IDs learned for the old layer no longer apply; the senders hand out
+        // the new one in the beacon that follows our ReceiverInfo
+        forgetSenderLayerIds();
         
-        DEBUG_SERIAL.println("\n=== RECEIVER LAYER CHANGED ===");
-        DEBUG_SERIAL.print("New Layer: ");
-        DEBUG_SERIAL.println(subscribedLayer);
-        DEBUG_SERIAL.println("Status: Layer saved to EEPROM");
-        DEBUG_SERIAL.println("==============================\n");
+        LOG_INFO(LOG_CAT_RECEIVER, "[CHANGE_RECEIVER_LAYER] RECEIVER LAYER CHANGED to '%s'\r\n",
+                 subscribedLayer);
         
         // Broadcast new layer info to senders
         sendReceiverInfo();
@@ -492,134 +702,111 @@ void handleSysExMessage(const uint8_t* data, uint8_t length) {
       break;
 
     default:
-      DEBUG_SERIAL.printf("[SYSEX] Unknown command: 0x%02X\r\n", command);
+      LOG_WARN(LOG_CAT_SYSEX, "[SYSEX] Unknown command: 0x%02X\r\n", command);
       sendErrorReport(ERROR_SYSEX_PARSE_ERROR, &command, 1);
       break;
   }
 }
 
+void handleRelayedSysExMessage(const uint8_t* data, size_t length) {
+  // Only the layer change a sender relays to its receivers. Everything else
+  // comes from the Bridge over USB, and the streamed commands (sync, OTA data)
+  // share their handler state with the USB parser on the MIDI task.
+  if (length < 4 || data[0] != SYSEX_START || data[1] != SYSEX_MANUFACTURER_ID ||
+      data[2] != SYSEX_CMD_CHANGE_RECEIVER_LAYER || !receiverModeEnabled) {
+    LOG_WARN(LOG_CAT_SYSEX, "[SYSEX] Ignoring relayed command 0x%02X (%u bytes)\r\n",
+             length >= 3 ? data[2] : 0, static_cast<unsigned>(length));
+    return;
+  }
+  handleSysExMessage(data, length);
+}
+
 // ============= HELPER FUNCTIONS =============
 
 void sendHello() {
   // Format: F0 7D 20 [version(8,encoded:10)] [uptimeMs(4,encoded:5)] [bootReason(1)] F7
   // Sent on boot to signal sender restart
-  
-  uint8_t rawData[16];
-  uint8_t message[64];
-  int rawIdx = 0;
-  int msgIdx = 0;
-  
-  message[msgIdx++] = SYSEX_START;
-  message[msgIdx++] = SYSEX_MANUFACTURER_ID;
-  message[msgIdx++] = SYSEX_CMD_HELLO;
-  
-  // Version string (8 bytes, padded with nulls, then encoded)
-  memset(rawData, 0, 8);
-  memcpy(rawData, NOWDE_VERSION, min(8, (int)strlen(NOWDE_VERSION)));
-  msgIdx += encode7bit(rawData, 8, &message[msgIdx]);  // 8 bytes -> 10 bytes encoded
-  rawIdx = 0;
-  
-  // Uptime (4 bytes raw -> 5 bytes encoded)
-  unsigned long uptime = millis();
-  rawData[rawIdx++] = (uptime >> 24) & 0xFF;
-  rawData[rawIdx++] = (uptime >> 16) & 0xFF;
-  rawData[rawIdx++] = (uptime >> 8) & 0xFF;
-  rawData[rawIdx++] = uptime & 0xFF;
-  msgIdx += encode7bit(rawData, rawIdx, &message[msgIdx]);
-  
+  uint8_t version[MAX_VERSION_LENGTH] = {0};
+  memcpy(version, NOWDE_VERSION, min(MAX_VERSION_LENGTH, (int)strlen(NOWDE_VERSION)));
+
+  midiSysexBegin(SYSEX_CMD_HELLO);
+  midiSysexEncode(version, sizeof(version));  // 8 bytes -> 10 bytes encoded
+  midiSysexEncodeFlush();
+  midiSysexEncodeU32(millis());                // 4 bytes -> 5 bytes encoded
   // Boot reason (1 byte - ESP32 reset reason, already 7-bit safe)
-  message[msgIdx++] = esp_reset_reason() & 0x7F;
-  
-  message[msgIdx++] = SYSEX_END;
-  int idx = msgIdx;  // Total message length
-  
-  DEBUG_SERIAL.printf("[HELLO] Sending %d bytes\\r\\n", idx);
-  
-  // Send via USB MIDI
-  int pos = 0;
-  while (pos < idx) {
-    midiEventPacket_t packet;
-    memset(&packet, 0, sizeof(packet));
-    
-    bool hasEnd = false;
-    int endPos = -1;
-    for (int i = 0; i < 3 && (pos + i) < idx; i++) {
-      if (message[pos + i] == SYSEX_END) {
-        hasEnd = true;
-        endPos = i;
-        break;
-      }
-    }
-    
-    if (hasEnd) {
-      if (endPos == 0) {
-        packet.header = 0x05;
-        packet.byte1 = message[pos];
-        packet.byte2 = 0;
-        packet.byte3 = 0;
-      } else if (endPos == 1) {
-        packet.header = 0x06;
-        packet.byte1 = message[pos];
-        packet.byte2 = message[pos + 1];
-        packet.byte3 = 0;
-      } else {
-        packet.header = 0x07;
-        packet.byte1 = message[pos];
-        packet.byte2 = message[pos + 1];
-        packet.byte3 = message[pos + 2];
-      }
-      pos += endPos + 1;
-    } else {
-      packet.header = 0x04;
-      packet.byte1 = message[pos];
-      packet.byte2 = (pos + 1 < idx) ? message[pos + 1] : 0;
-      packet.byte3 = (pos + 2 < idx) ? message[pos + 2] : 0;
-      pos += 3;
-    }
-    
-    midiWritePacket(packet);
-  }
-  
-  DEBUG_SERIAL.println("[HELLO] Sent to Bridge");
+  midiSysexByte(esp_reset_reason() & 0x7F);
+  midiSysexEnd();
+
+  LOG_INFO(LOG_CAT_SYSEX, "[HELLO] Sent to Bridge\r\n");
 }
 
 void sendConfigState() {
-  // Format: F0 7D 21 [rfSimEnabled] [rfSimMaxDelayHi(7-bit)] [rfSimMaxDelayLo(7-bit)] F7
-  uint8_t message[7];
-  message[0] = SYSEX_START;
-  message[1] = SYSEX_MANUFACTURER_ID;
-  message[2] = SYSEX_CMD_CONFIG_STATE;
-  message[3] = rfSimulationEnabled ? 1 : 0;
+  // Format: F0 7D 21 [rfSimEnabled] [rfSimMaxDelayHi(7-bit)] [rfSimMaxDelayLo(7-bit)]
+  //   [lossPercent] [reorderPercent] [outagePerMille] [outageMsHi] [outageMsLo] F7
+  midiSysexBegin(SYSEX_CMD_CONFIG_STATE);
+  midiSysexByte(rfSimulationEnabled ? 1 : 0);
   // Encode as two 7-bit bytes (MIDI SysEx compatible, 14-bit range = 0-16383)
-  message[4] = (rfSimMaxDelayMs >> 7) & 0x7F;  // Upper 7 bits
-  message[5] = rfSimMaxDelayMs & 0x7F;         // Lower 7 bits
-  message[6] = SYSEX_END;
-  
-  // Send via USB MIDI (requires chunking into MIDI packets)
-  midiEventPacket_t packet;
-  
-  // First packet: F0 7D 20
-  packet.header = 0x04;  // SysEx start
-  packet.byte1 = message[0];
-  packet.byte2 = message[1];
-  packet.byte3 = message[2];
-  midiWritePacket(packet);
-  
-  // Second packet: data bytes
-  packet.header = 0x04;
-  packet.byte1 = message[3];
-  packet.byte2 = message[4];
-  packet.byte3 = message[5];
-  midiWritePacket(packet);
-  
-  // Third packet: F7 (end)
-  packet.header = 0x05;  // SysEx end (single byte)
-  packet.byte1 = message[6];
-  packet.byte2 = 0;
-  packet.byte3 = 0;
-  midiWritePacket(packet);
-  
-  DEBUG_SERIAL.println("[CONFIG_STATE] Sent to Bridge");
+  midiSysexByte((rfSimMaxDelayMs >> 7) & 0x7F);  // Upper 7 bits
+  midiSysexByte(rfSimMaxDelayMs & 0x7F);         // Lower 7 bits
+  midiSysexByte(rfSimLossPercent);
+  midiSysexByte(rfSimReorderPercent);
+  midiSysexByte(rfSimOutagePerMille);
+  midiSysexByte((rfSimOutageMs >> 7) & 0x7F);
+  midiSysexByte(rfSimOutageMs & 0x7F);
+  midiSysexEnd();
+
+  LOG_INFO(LOG_CAT_SYSEX, "[CONFIG_STATE] Sent to Bridge\r\n");
+}
+
+void sysexEncodeReceiverBlock(const ReceiverEntry& entry) {
+  char version[MAX_VERSION_LENGTH] = {0};
+  versionFormat(entry.version, version, sizeof(version));
+
+  midiSysexEncode(entry.mac, 6);
+  midiSysexEncode(entry.layer, MAX_LAYER_LENGTH);
+  midiSysexEncode(version, MAX_VERSION_LENGTH);
+  midiSysexEncodeU32(millis() - entry.lastSeen);
+
+  const uint8_t tail[2] = {1, entry.mediaIndex};  // Active flag, media index
+  midiSysexEncode(tail, sizeof(tail));
+  midiSysexEncodeFlush();
+
+  // Extensions are encoded separately so older Bridges still parse the 42-byte block above
+  sysexEncodeReceiverReports(entry);
+}
+
+void sysexEncodeReceiverReports(const ReceiverEntry& entry) {
+  // Extension (11 raw bytes, encoded:13): sync estimator report
+  midiSysexEncode(&entry.sync.flags, 1);
+  midiSysexEncodeU16(static_cast<uint16_t>(entry.sync.errorTenthsMs));
+  midiSysexEncodeU16(entry.sync.jitterTenthsMs);
+  midiSysexEncodeU16(static_cast<uint16_t>(entry.sync.ratePpm));
+  midiSysexEncodeU16(entry.sync.outliers);
+  midiSysexEncodeU16(entry.sync.jumps);
+  midiSysexEncodeFlush();
+
+  // Extension (7 raw bytes, encoded:8): receiver clock report
+  midiSysexEncode(&entry.clock.flags, 1);
+  midiSysexEncodeU16(static_cast<uint16_t>(entry.clock.senderOffsetMs));
+  midiSysexEncodeU16(entry.clock.corrected);
+  midiSysexEncodeU16(entry.clock.discarded);
+  midiSysexEncodeFlush();
+
+  // Extension (11 raw bytes, encoded:13): link report + our RSSI of the receiver
+  const int8_t rssi[3] = {entry.link.rssiAvgDbm, entry.link.rssiMinDbm, entry.uplinkRssiDbm};
+  midiSysexEncode(&rssi[0], 2);
+  midiSysexEncodeU16(entry.link.syncReceived);
+  midiSysexEncodeU16(entry.link.syncDiscarded);
+  midiSysexEncodeU16(entry.link.linkLost);
+  midiSysexEncodeU16(entry.link.windowMs);
+  midiSysexEncode(&rssi[2], 1);
+  midiSysexEncodeFlush();
+
+  // Extension (10 raw bytes, encoded:12): our TX counters towards the receiver
+  midiSysexEncodeU32(entry.tx.delivered);
+  midiSysexEncodeU32(entry.tx.failed);
+  midiSysexEncodeU16(entry.tx.dropped);
+  midiSysexEncodeFlush();
 }
 
 void sendRunningState() {
@@ -627,34 +814,31 @@ void sendRunningState() {
   static unsigned long lastSendTime = 0;
   unsigned long now = millis();
   if (now - lastSendTime < 500) {  // Min 500ms between sends
-    DEBUG_SERIAL.println("[RUNNING_STATE] Throttled - too soon since last send");
+    LOG_DEBUG(LOG_CAT_SYSEX, "[RUNNING_STATE] Throttled - too soon since last send\r\n");
     return;
   }
   lastSendTime = now;
-  
+  sendRunningStateNow();
+}
+
+void sendRunningStateNow() {
   // Format per chunk: F0 7D 22 [uptimeMs(4,encoded:5)] [meshSynced(1)]
   //   [totalReceivers(1)] [chunkIndex(1)] [chunkCount(1)] [chunkReceivers(1)]
   //   For each receiver in this chunk: [receiverData(36 bytes, encoded:42)]
+  //     [syncEstimator(11 bytes, encoded:13)] [clock(7 bytes, encoded:8)]
+  //     [link(10 bytes) + uplinkRssi(1), encoded:13] [tx(10 bytes), encoded:12]
   //   F7
   // All multi-byte fields are 7-bit encoded to prevent 0x80-0xFF bytes in data
   
-  uint8_t rawData[256];  // Raw 8-bit data buffer
-  uint8_t message[512];  // Encoded 7-bit message buffer (larger for encoded data)
-  int rawIdx = 0;
-  int msgIdx = 0;
-  
-  // Take snapshot of receiver table to avoid race conditions
-  // (table can be modified by ESP-NOW callbacks during serialization)
-  ReceiverEntry snapshot[MAX_RECEIVERS];
+  // Collect slots of active AND connected receivers only
+  // (skip disconnected receivers waiting for cleanup - they shouldn't appear in Bridge GUI).
+  // Each entry is copied just before it is serialized: a full table snapshot
+  // no longer fits comfortably on the MIDI task stack.
+  uint8_t slots[MAX_RECEIVERS];
   uint8_t numActive = 0;
-  
-  // Debug: log receiver table state
-  // Build snapshot of active AND connected receivers only
-  // (skip disconnected receivers waiting for cleanup - they shouldn't appear in Bridge GUI)
   for (int i = 0; i < MAX_RECEIVERS; i++) {
     if (receiverTable[i].active && receiverTable[i].connected) {
-      snapshot[numActive] = receiverTable[i];
-      numActive++;
+      slots[numActive++] = static_cast<uint8_t>(i);
     }
   }
   
@@ -668,7 +852,7 @@ void sendRunningState() {
   static unsigned long lastLogTime = 0;
   static uint8_t lastLogCount = 0xFF;
   if (numActive != lastLogCount || (millis() - lastLogTime) > 10000) {
-    DEBUG_SERIAL.printf("[RUNNING_STATE] %d active receiver(s), sending %d chunk(s)\r\n", numActive, chunkCount);
+    LOG_INFO(LOG_CAT_SYSEX, "[RUNNING_STATE] %d active receiver(s), sending %d chunk(s)\r\n", numActive, chunkCount);
     lastLogTime = millis();
     lastLogCount = numActive;
   }
@@ -676,167 +860,97 @@ void sendRunningState() {
   for (uint8_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
     int startIdx = chunkIndex * RECEIVERS_PER_CHUNK;
     int remaining = numActive - startIdx;
-  uint8_t chunkReceivers = (remaining > 0)
-                 ? static_cast<uint8_t>(std::min<int>(RECEIVERS_PER_CHUNK, remaining))
-                 : 0;
-
-    msgIdx = 0;
-    rawIdx = 0;
+    uint8_t chunkReceivers = (remaining > 0)
+                                 ? static_cast<uint8_t>(std::min<int>(RECEIVERS_PER_CHUNK, remaining))
+                                 : 0;
 
-    // Build header
-    message[msgIdx++] = SYSEX_START;
-    message[msgIdx++] = SYSEX_MANUFACTURER_ID;
-    message[msgIdx++] = SYSEX_CMD_RUNNING_STATE;
+    midiSysexBegin(SYSEX_CMD_RUNNING_STATE);
 
     // Encode uptime once per chunk so Bridge can correlate packets
-    rawData[rawIdx++] = (uptime >> 24) & 0xFF;
-    rawData[rawIdx++] = (uptime >> 16) & 0xFF;
-    rawData[rawIdx++] = (uptime >> 8) & 0xFF;
-    rawData[rawIdx++] = uptime & 0xFF;
-    msgIdx += encode7bit(rawData, rawIdx, &message[msgIdx]);
-    rawIdx = 0;
+    midiSysexEncodeU32(uptime);
 
     // Metadata
-    message[msgIdx++] = synced ? 1 : 0;     // Mesh clock sync state
-    message[msgIdx++] = numActive;          // Total receivers in table
-    message[msgIdx++] = chunkIndex;         // Current chunk index (0-based)
-    message[msgIdx++] = chunkCount;         // Total number of chunks
-    message[msgIdx++] = chunkReceivers;     // Receivers included in this chunk
+    midiSysexByte(synced ? 1 : 0);     // Mesh clock sync state
+    midiSysexByte(numActive);          // Total receivers in table
+    midiSysexByte(chunkIndex);         // Current chunk index (0-based)
+    midiSysexByte(chunkCount);         // Total number of chunks
+    midiSysexByte(chunkReceivers);     // Receivers included in this chunk
 
-    // Encode receiver data for this chunk
+    // Receiver data for this chunk: 36 raw bytes per receiver, encoded as one block
     for (int i = 0; i < chunkReceivers; i++) {
-      const ReceiverEntry& entry = snapshot[startIdx + i];
-
-      rawIdx = 0;
-      memcpy(&rawData[rawIdx], entry.mac, 6);
-      rawIdx += 6;
-
-      memcpy(&rawData[rawIdx], entry.layer, MAX_LAYER_LENGTH);
-      rawIdx += MAX_LAYER_LENGTH;
-
-      memcpy(&rawData[rawIdx], entry.version, MAX_VERSION_LENGTH);
-      rawIdx += MAX_VERSION_LENGTH;
+      // Copy so the ESP-NOW task can update the slot while we serialize
+      const ReceiverEntry entry = receiverTable[slots[startIdx + i]];
+      sysexEncodeReceiverBlock(entry);
+    }
 
-      unsigned long lastSeenMs = millis() - entry.lastSeen;
-      rawData[rawIdx++] = (lastSeenMs >> 24) & 0xFF;
-      rawData[rawIdx++] = (lastSeenMs >> 16) & 0xFF;
-      rawData[rawIdx++] = (lastSeenMs >> 8) & 0xFF;
-      rawData[rawIdx++] = lastSeenMs & 0xFF;
+    midiSysexEnd();
+  }
 
-      rawData[rawIdx++] = 1;  // Active flag
-      rawData[rawIdx++] = entry.mediaIndex;
+  sendMetricsReport();
+}
 
-      int encodedLen = encode7bit(rawData, rawIdx, &message[msgIdx]);
-      if (msgIdx + encodedLen >= 512) {
-        DEBUG_SERIAL.printf("[RUNNING_STATE] ERROR: Buffer overflow in chunk %d (msgIdx=%d, encodedLen=%d)\r\n",
-                            chunkIndex, msgIdx, encodedLen);
-        return;
-      }
-      msgIdx += encodedLen;
+namespace {
+
+void sendMetricsMessage(uint8_t source, const uint8_t* mac, const MetricsSnapshot& snapshot) {
+  midiSysexBegin(SYSEX_CMD_METRICS);
+  midiSysexByte(METRIC_COUNTER_COUNT);
+  midiSysexByte(METRIC_HIST_COUNT);
+  midiSysexByte(METRIC_HIST_BUCKETS);
+  midiSysexByte(source);
+  midiSysexEncode(mac, 6);
+  midiSysexEncodeU32(snapshot.uptimeMs);
+  for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+    midiSysexEncodeU32(snapshot.counters[i]);
+  }
+  for (int h = 0; h < METRIC_HIST_COUNT; h++) {
+    for (int b = 0; b < METRIC_HIST_BUCKETS; b++) {
+      midiSysexEncodeU16(snapshot.histograms[h][b]);
     }
+  }
+  midiSysexEnd();
+}
 
-    message[msgIdx++] = SYSEX_END;
-    int totalLen = msgIdx;
-
-    // Send via USB MIDI (chunk into packets)
-    int pos = 0;
-    while (pos < totalLen) {
-      midiEventPacket_t packet;
-      memset(&packet, 0, sizeof(packet));
-
-      bool hasEnd = false;
-      int endPos = -1;
-      for (int i = 0; i < 3 && (pos + i) < totalLen; i++) {
-        if (message[pos + i] == SYSEX_END) {
-          hasEnd = true;
-          endPos = i;
-          break;
-        }
-      }
+}  // namespace
 
-      if (hasEnd) {
-        if (endPos == 0) {
-          packet.header = 0x05;
-          packet.byte1 = message[pos];
-          pos++;
-          packet.byte2 = 0;
-          packet.byte3 = 0;
-        } else if (endPos == 1) {
-          packet.header = 0x06;
-          packet.byte1 = message[pos];
-          packet.byte2 = message[pos + 1];
-          pos += 2;
-          packet.byte3 = 0;
-        } else {
-          packet.header = 0x07;
-          packet.byte1 = message[pos];
-          packet.byte2 = message[pos + 1];
-          packet.byte3 = message[pos + 2];
-          pos += 3;
-        }
-      } else {
-        packet.header = 0x04;
-        packet.byte1 = message[pos];
-        pos++;
-        packet.byte2 = (pos < totalLen) ? message[pos++] : 0;
-        packet.byte3 = (pos < totalLen) ? message[pos++] : 0;
-      }
+void sendMetricsReport() {
+  // Rides on RUNNING_STATE polling, at most once per METRICS_REPORT_INTERVAL_MS
+  static unsigned long lastSendTime = 0;
+  unsigned long now = millis();
+  if (now - lastSendTime < METRICS_REPORT_INTERVAL_MS) {
+    return;
+  }
+  lastSendTime = now;
+
+  // Format: F0 7D 24 [counterCount] [histCount] [bucketCount] [source(0=self, 1=receiver)]
+  //   [mac(6) uptimeMs(4) counters(4 each) buckets(2 each), encoded] F7
+  // Counters and buckets are cumulative; the Bridge derives rates from deltas.
+  MetricsSnapshot snapshot;
+  uint8_t mac[6];
+  esp_read_mac(mac, ESP_MAC_WIFI_STA);
+  metricsSnapshot(&snapshot);
+  sendMetricsMessage(0, mac, snapshot);
 
-      midiWritePacket(packet);
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    if (!receiverTable[i].active || !receiverTable[i].connected) {
+      continue;
+    }
+    memcpy(mac, receiverTable[i].mac, 6);
+    if (metricsRemote(i, mac, &snapshot)) {
+      sendMetricsMessage(1, mac, snapshot);
     }
   }
 }
 
 void sendErrorReport(uint8_t errorCode, const uint8_t* context, uint8_t contextLength) {
   // Format: F0 7D 30 [errorCode(1)] [contextLength(1)] [context...] F7
-  uint8_t message[64];
-  int idx = 0;
-  
-  message[idx++] = SYSEX_START;
-  message[idx++] = SYSEX_MANUFACTURER_ID;
-  message[idx++] = SYSEX_CMD_ERROR_REPORT;
-  message[idx++] = errorCode;
-  message[idx++] = contextLength;
-  
+  midiSysexBegin(SYSEX_CMD_ERROR_REPORT);
+  midiSysexByte(errorCode);
+  midiSysexByte(contextLength);
   if (context && contextLength > 0) {
-    memcpy(&message[idx], context, min<uint8_t>(contextLength, 32));
-    idx += min<uint8_t>(contextLength, 32);
-  }
-  
-  message[idx++] = SYSEX_END;
-  
-  // Send via USB MIDI
-  int pos = 0;
-  while (pos < idx) {
-    midiEventPacket_t packet;
-    
-    if (pos == 0) {
-      packet.header = 0x04;
-      packet.byte1 = message[pos++];
-      packet.byte2 = (pos < idx) ? message[pos++] : 0;
-      packet.byte3 = (pos < idx) ? message[pos++] : 0;
-    } else if (pos >= idx - 1 && message[idx - 1] == SYSEX_END) {
-      if (pos == idx - 1) {
-        packet.header = 0x05;
-        packet.byte1 = message[pos++];
-        packet.byte2 = 0;
-        packet.byte3 = 0;
-      } else {
-        packet.header = 0x06;
-        packet.byte1 = message[pos++];
-        packet.byte2 = (pos < idx) ? message[pos++] : 0;
-        packet.byte3 = 0;
-      }
-    } else {
-      packet.header = 0x04;
-      packet.byte1 = message[pos++];
-      packet.byte2 = (pos < idx) ? message[pos++] : 0;
-      packet.byte3 = (pos < idx) ? message[pos++] : 0;
-    }
-    
-    midiWritePacket(packet);
+    midiSysexBytes(context, min<uint8_t>(contextLength, 32));
   }
-  
+  midiSysexEnd();
+
   const char* errorName = "UNKNOWN";
   switch (errorCode) {
     case ERROR_CONFIG_INVALID: errorName = "CONFIG_INVALID"; break;
@@ -846,5 +960,5 @@ void sendErrorReport(uint8_t errorCode, const uint8_t* context, uint8_t contextL
     case ERROR_RECEIVER_TIMEOUT: errorName = "RECEIVER_TIMEOUT"; break;
   }
   
-  DEBUG_SERIAL.printf("[ERROR_REPORT] Sent: %s (0x%02X)\r\n", errorName, errorCode);
+  LOG_WARN(LOG_CAT_SYSEX, "[ERROR_REPORT] Sent: %s (0x%02X)\r\n", errorName, errorCode);
 }
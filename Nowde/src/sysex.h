@@ -1,6 +1,31 @@
 #pragma once
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#include "nowde_config.h"
+#include "sysex_codec.h"
 
 void sendHello();
-void handleSysExMessage(const uint8_t* data, uint8_t length);
+// At most twice per second; sendRunningStateNow() is the unthrottled body (benchmarks)
+void sendRunningState();
+void sendRunningStateNow();
+// Whole message F0 ... F7 (any length) of a buffered command; USB input goes
+// through sysex_stream.h first, which streams the others to their handlers.
+void handleSysExMessage(const uint8_t* data, size_t length);
+// ESP-NOW task: SysEx received over the air. Only CHANGE_RECEIVER_LAYER, on a
+// receiver, is accepted; the rest is dropped.
+void handleRelayedSysExMessage(const uint8_t* data, size_t length);
+
+// MIDI task: sends the sync burst repeats that are due (sync_rate.h);
+// returns the ticks until the next one
+TickType_t sysexServiceSyncBursts();
+
+// Sender -> Bridge metrics, rate limited to METRICS_REPORT_INTERVAL_MS
+void sendMetricsReport();
+
+// RUNNING_STATE receiver block (inside a midiSysexBegin/End pair):
+// identity + lastSeen + mediaIndex (36 raw, encoded:42), then the reports
+void sysexEncodeReceiverBlock(const ReceiverEntry& entry);
+// Reports only: sync (encoded:13), clock (encoded:8), link (encoded:13)
+void sysexEncodeReceiverReports(const ReceiverEntry& entry);
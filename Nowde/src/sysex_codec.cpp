@@ -0,0 +1,26 @@
+#include "sysex_codec.h"
+
+int encode7bit(const uint8_t* input, int inputLen, uint8_t* output) {
+  int inIdx = 0;
+  int outIdx = 0;
+  for (; inIdx + 7 <= inputLen; inIdx += 7, outIdx += 8) {
+    encode7bitGroup(&input[inIdx], &output[outIdx]);
+  }
+  if (inIdx < inputLen) {
+    encode7bitPartial(&input[inIdx], inputLen - inIdx, &output[outIdx]);
+    outIdx += inputLen - inIdx + 1;
+  }
+  return outIdx;
+}
+
+int decode7bit(const uint8_t* input, int inputLen, uint8_t* output) {
+  int inIdx = 0;
+  int outIdx = 0;
+  for (; inIdx + 8 <= inputLen; inIdx += 8, outIdx += 7) {
+    decode7bitGroup(&input[inIdx], &output[outIdx]);
+  }
+  if (inIdx < inputLen) {
+    outIdx += decode7bitPartial(&input[inIdx], inputLen - inIdx, &output[outIdx]);
+  }
+  return outIdx;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstring>
+
+// 7-bit SysEx codec: each group of up to 7 raw bytes is sent as
+// [MSB byte][7-bit data bytes], bit i of the MSB byte carrying bit 7 of data
+// byte i. Full groups are processed as two little-endian 32-bit words (bytes
+// 0-3 and 4-6); the MSBs are gathered and spread with one 32-bit multiply per
+// word instead of a loop over bits (the S3 has no fast 64-bit multiply).
+// Only the trailing partial group goes byte by byte.
+
+constexpr size_t encoded7bitSize(size_t rawLen) {
+  return rawLen + (rawLen + 6) / 7;
+}
+constexpr size_t decoded7bitSize(size_t encodedLen) {
+  return encodedLen - (encodedLen + 7) / 8;
+}
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "group codec assumes little-endian words");
+
+namespace codec7bit {
+
+inline uint32_t load32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline void store32(uint8_t* p, uint32_t value) {
+  memcpy(p, &value, sizeof(value));
+}
+
+// Bit 7 of each byte of a word -> bits 0-3 (the partial products never overlap)
+inline uint32_t gatherMsb(uint32_t word) {
+  return ((word & 0x80808080u) * 0x00204081u) >> 28;
+}
+
+// Bits 0-3 -> bit 7 of each byte of a word
+inline uint32_t spreadMsb(uint32_t bits) {
+  return ((bits & 0x0Fu) * 0x10204080u) & 0x80808080u;
+}
+
+}  // namespace codec7bit
+
+// 7 raw bytes -> 8 encoded bytes
+inline void encode7bitGroup(const uint8_t* in, uint8_t* out) {
+  uint32_t lo = codec7bit::load32(in);
+  uint32_t hi = in[4] | (in[5] << 8) | (in[6] << 16);
+  out[0] = static_cast<uint8_t>(codec7bit::gatherMsb(lo) | (codec7bit::gatherMsb(hi) << 4));
+  codec7bit::store32(&out[1], lo & 0x7F7F7F7Fu);
+  out[5] = in[4] & 0x7F;
+  out[6] = in[5] & 0x7F;
+  out[7] = in[6] & 0x7F;
+}
+
+// 8 encoded bytes -> 7 raw bytes
+inline void decode7bitGroup(const uint8_t* in, uint8_t* out) {
+  uint8_t msb = in[0];
+  codec7bit::store32(out, (codec7bit::load32(&in[1]) & 0x7F7F7F7Fu) | codec7bit::spreadMsb(msb));
+  uint32_t hiMsb = codec7bit::spreadMsb(msb >> 4);
+  out[4] = (in[5] & 0x7F) | (hiMsb & 0x80);
+  out[5] = (in[6] & 0x7F) | ((hiMsb >> 8) & 0x80);
+  out[6] = (in[7] & 0x7F) | ((hiMsb >> 16) & 0x80);
+}
+
+// Trailing group of 1-6 raw bytes
+inline void encode7bitPartial(const uint8_t* in, size_t rawLen, uint8_t* out) {
+  uint8_t msb = 0;
+  for (size_t i = 0; i < rawLen; i++) {
+    msb |= ((in[i] >> 7) & 1) << i;
+    out[i + 1] = in[i] & 0x7F;
+  }
+  out[0] = msb;
+}
+
+// Trailing group of 1-7 encoded bytes (MSB byte included); returns raw bytes written
+inline size_t decode7bitPartial(const uint8_t* in, size_t encodedLen, uint8_t* out) {
+  if (encodedLen == 0) {
+    return 0;
+  }
+  uint8_t msb = in[0];
+  for (size_t i = 1; i < encodedLen; i++) {
+    out[i - 1] = (in[i] & 0x7F) | (((msb >> (i - 1)) & 1) << 7);
+  }
+  return encodedLen - 1;
+}
+
+// Fixed-size fields (MAC 6, position 4, layer name 16, ...): N raw bytes,
+// group count known at compile time so the loops unroll
+template <size_t N>
+inline void encode7bitFixed(const uint8_t* in, uint8_t* out) {
+  for (size_t g = 0; g < N / 7; g++) {
+    encode7bitGroup(&in[g * 7], &out[g * 8]);
+  }
+  if (N % 7 != 0) {
+    encode7bitPartial(&in[N - N % 7], N % 7, &out[(N / 7) * 8]);
+  }
+}
+
+template <size_t N>
+inline void decode7bitFixed(const uint8_t* in, uint8_t* out) {
+  for (size_t g = 0; g < N / 7; g++) {
+    decode7bitGroup(&in[g * 8], &out[g * 7]);
+  }
+  if (N % 7 != 0) {
+    decode7bitPartial(&in[(N / 7) * 8], N % 7 + 1, &out[N - N % 7]);
+  }
+}
+
+// Variable length; return the number of bytes written
+int encode7bit(const uint8_t* input, int inputLen, uint8_t* output);
+int decode7bit(const uint8_t* input, int inputLen, uint8_t* output);
+
+// Byte-at-a-time decoder for fields spread over a streamed message (sysex_stream.h)
+class Sysex7BitDecoder {
+ public:
+  void reset() {
+    msb_ = 0;
+    pos_ = 0;
+  }
+
+  // True when value completed a decoded byte (written to *out)
+  bool feed(uint8_t value, uint8_t* out) {
+    if (pos_ == 0) {
+      msb_ = value;
+      pos_ = 1;
+      return false;
+    }
+    *out = (value & 0x7F) | ((msb_ & (1 << (pos_ - 1))) ? 0x80 : 0);
+    pos_ = (pos_ == 7) ? 0 : pos_ + 1;
+    return true;
+  }
+
+ private:
+  uint8_t msb_ = 0;
+  uint8_t pos_ = 0;
+};
+
+// Streaming decoder for a contiguous destination: encoded bytes are collected
+// and each full group is decoded in one go
+class Sysex7BitGroupDecoder {
+ public:
+  void reset() {
+    len_ = 0;
+  }
+
+  // Raw bytes written to out: 7 when value completed a group, else 0
+  size_t feed(uint8_t value, uint8_t* out) {
+    group_[len_++] = value;
+    if (len_ < sizeof(group_)) {
+      return 0;
+    }
+    len_ = 0;
+    decode7bitGroup(group_, out);
+    return 7;
+  }
+
+  // Decodes what is left of a trailing partial group
+  size_t finish(uint8_t* out) {
+    size_t written = decode7bitPartial(group_, len_, out);
+    len_ = 0;
+    return written;
+  }
+
+ private:
+  uint8_t group_[8];
+  uint8_t len_ = 0;
+};
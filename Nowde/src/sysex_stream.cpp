@@ -0,0 +1,139 @@
+#include "sysex_stream.h"
+
+#include <esp_timer.h>
+
+#include "metrics.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "sysex.h"
+
+namespace {
+
+enum class RxState : uint8_t {
+  IDLE,          // Waiting for F0
+  MANUFACTURER,  // After F0
+  COMMAND,       // After F0 7D
+  STREAM,        // Data bytes go to streamHandler
+  BUFFER,        // Data bytes are collected for handleSysExMessage
+  SKIP           // Not ours: drop until F7
+};
+
+RxState state = RxState::IDLE;
+const SysexStreamHandler* streamHandler = nullptr;
+uint8_t buffer[SYSEX_STREAM_BUFFER_SIZE];
+size_t bufferLen = 0;
+bool bufferOverflow = false;
+uint32_t startUs = 0;
+
+void bufferByte(uint8_t value) {
+  if (bufferLen < SYSEX_STREAM_BUFFER_SIZE) {
+    buffer[bufferLen++] = value;
+  } else {
+    bufferOverflow = true;  // Keep reading so we can resync at F7
+  }
+}
+
+void dispatchBuffer() {
+  if (bufferOverflow) {
+    LOG_WARN(LOG_CAT_SYSEX, "[SYSEX RX] WARNING: SysEx overflow (len>%d), discarding message\r\n", SYSEX_STREAM_BUFFER_SIZE);
+    return;
+  }
+
+  // Only log SysEx for non-repetitive messages (to reduce clutter)
+  // Skip: QUERY_RUNNING_STATE (0x03) sent at 1Hz; sync and OTA data are streamed
+  bool isRepetitive = (bufferLen >= 3 && buffer[2] == SYSEX_CMD_QUERY_RUNNING_STATE);
+  if (!isRepetitive && LOG_ENABLED(DEBUG, LOG_CAT_SYSEX)) {
+    DEBUG_SERIAL.print("[SYSEX RX] ");
+    for (size_t j = 0; j < bufferLen; j++) {
+      DEBUG_SERIAL.printf("%02X ", buffer[j]);
+    }
+    DEBUG_SERIAL.printf("(%d bytes)\r\n", bufferLen);
+  }
+  metricsCount(METRIC_USB_SYSEX_RX);
+  handleSysExMessage(buffer, bufferLen);
+}
+
+// A status byte other than F7 ended the message early
+void abandonMessage() {
+  if (state == RxState::STREAM) {
+    streamHandler->end(false);
+  }
+  state = RxState::IDLE;
+}
+
+}  // namespace
+
+void sysexStreamReplay(const SysexStreamHandler* handler, const uint8_t* data, size_t length) {
+  // F0 7D <command> ... F7
+  handler->begin();
+  for (size_t i = 3; i + 1 < length; i++) {
+    handler->data(data[i]);
+  }
+  handler->end(true);
+}
+
+void sysexStreamByte(uint8_t value) {
+  if (value == SYSEX_START) {
+    abandonMessage();
+    state = RxState::MANUFACTURER;
+    startUs = static_cast<uint32_t>(esp_timer_get_time());
+    bufferLen = 0;
+    bufferOverflow = false;
+    bufferByte(value);
+    return;
+  }
+  if (state == RxState::IDLE) {
+    return;
+  }
+
+  // Messages too short to carry a command still go the buffered way so they get an error report
+  if (value == SYSEX_END) {
+    if (state == RxState::STREAM) {
+      metricsCount(METRIC_USB_SYSEX_RX);
+      streamHandler->end(true);
+    } else if (state != RxState::SKIP) {
+      bufferByte(value);
+      dispatchBuffer();
+    }
+    state = RxState::IDLE;
+    return;
+  }
+  if (value & 0x80) {
+    abandonMessage();
+    return;
+  }
+
+  switch (state) {
+    case RxState::MANUFACTURER:
+      // Universal and other manufacturers' SysEx are not for us
+      state = (value == SYSEX_MANUFACTURER_ID) ? RxState::COMMAND : RxState::SKIP;
+      bufferByte(value);
+      break;
+
+    case RxState::COMMAND:
+      streamHandler = sysexStreamHandlerFor(value);
+      if (streamHandler) {
+        state = RxState::STREAM;
+        streamHandler->begin();
+      } else {
+        state = RxState::BUFFER;
+        bufferByte(value);
+      }
+      break;
+
+    case RxState::STREAM:
+      streamHandler->data(value);
+      break;
+
+    case RxState::BUFFER:
+      bufferByte(value);
+      break;
+
+    default:
+      break;
+  }
+}
+
+uint32_t sysexStreamStartUs() {
+  return startUs;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "sysex_codec.h"
+
+// Incremental SysEx receive path for USB.
+// midiProcess() feeds every SysEx byte in as it comes off the endpoint. Once
+// F0 7D <command> has been seen, a command with a stream handler gets its data
+// bytes one at a time and decodes them straight into their destination (OTA
+// chunks into the flash buffer, sync fields into the ESP-NOW frame), so these
+// never touch a message buffer and have no length limit. Everything else is
+// collected (up to SYSEX_STREAM_BUFFER_SIZE) and dispatched whole through
+// handleSysExMessage().
+struct SysexStreamHandler {
+  void (*begin)();
+  void (*data)(uint8_t value);  // One 7-bit data byte (header and F7 excluded)
+  void (*end)(bool complete);   // false: cut short by another status byte
+};
+
+// Stream handler for a command, or nullptr to buffer it (sysex.cpp)
+const SysexStreamHandler* sysexStreamHandlerFor(uint8_t command);
+
+// Runs a complete, already buffered message through a stream handler
+// (benchmarks). MIDI task only, like the USB parser.
+void sysexStreamReplay(const SysexStreamHandler* handler, const uint8_t* data, size_t length);
+
+void sysexStreamByte(uint8_t value);
+// esp_timer time (us) of the F0 of the message being handled
+uint32_t sysexStreamStartUs();
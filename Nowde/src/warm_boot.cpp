@@ -0,0 +1,90 @@
+#include "warm_boot.h"
+
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <cstring>
+
+#include "mtc.h"
+#include "nowde_config.h"
+#include "nowde_log.h"
+#include "nowde_state.h"
+
+namespace {
+
+// Bump the low byte when the layout changes so an OTA update never reads an
+// older firmware's snapshot
+constexpr uint32_t SNAPSHOT_MAGIC = 0x4E534E01;
+
+struct SyncSnapshot {
+  uint32_t magic;  // Written last, cleared first: a torn write is never valid
+  uint32_t positionMs;
+  uint8_t mediaIndex;
+  uint8_t state;
+  char layer[MAX_LAYER_LENGTH];
+};
+
+RTC_NOINIT_ATTR SyncSnapshot snapshot;
+
+// Resets that keep RTC memory and come back on their own
+bool warmReset(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_BROWNOUT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+void warmBootSave() {
+#if WARM_BOOT_RESUME
+  snapshot.magic = 0;
+  snapshot.positionMs = mediaSyncState.currentPositionMs;
+  snapshot.mediaIndex = mediaSyncState.currentIndex;
+  snapshot.state = mediaSyncState.currentState;
+  memcpy(snapshot.layer, subscribedLayer, MAX_LAYER_LENGTH);
+  snapshot.magic = SNAPSHOT_MAGIC;
+#endif
+}
+
+bool warmBootRestore() {
+#if WARM_BOOT_RESUME
+  bool valid = snapshot.magic == SNAPSHOT_MAGIC && warmReset(esp_reset_reason());
+  // Whatever happens, a later boot must not reuse this one
+  snapshot.magic = 0;
+
+  if (!valid || snapshot.state != 1 || !receiverModeEnabled ||
+      strncmp(snapshot.layer, subscribedLayer, MAX_LAYER_LENGTH) != 0) {
+    return false;
+  }
+
+  // The time between the last save and the reset is unknown (at most one sync
+  // interval); what is known is how long this boot has taken so far
+  uint32_t bootMs = static_cast<uint32_t>(esp_timer_get_time() / 1000);
+  uint32_t positionMs = snapshot.positionMs + bootMs;
+
+  mediaSyncState.currentIndex = snapshot.mediaIndex;
+  mediaSyncState.currentPositionMs = positionMs;
+  mediaSyncState.currentState = 1;
+  mediaSyncState.lastSyncTime = millis();
+  mediaSyncState.linkLost = false;
+  // Left at the "nothing sent" value so the first live packet re-sends CC#100
+  // once the host has enumerated us
+  mediaSyncState.lastSentIndex = 255;
+
+  // The mesh clock has not converged yet: run on local time until it has
+  mtcResume(positionMs);
+  LOG_INFO(LOG_CAT_RECEIVER, "[WARM BOOT] Resumed layer %s, media %d at %lu ms (boot took %lu ms)\r\n",
+           subscribedLayer, snapshot.mediaIndex, static_cast<unsigned long>(positionMs),
+           static_cast<unsigned long>(bootMs));
+  return true;
+#else
+  return false;
+#endif
+}
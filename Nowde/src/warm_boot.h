@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Receiver sync state kept across warm resets.
+// A snapshot of the receiver's transport (layer, media index, position, state)
+// lives in RTC memory that the boot ROM does not clear, refreshed on every
+// applied sync packet. After a panic, watchdog, brown-out or software reset
+// the receiver restarts MTC from it, extrapolated by the time spent booting,
+// so timecode resumes within a few hundred ms instead of waiting for the mesh
+// clock and the next sync packet. Until the mesh clock syncs, the resumed
+// timecode runs on local time; the first live packet after that re-anchors
+// it (and the link-lost timeout applies if none comes).
+
+// Snapshot of mediaSyncState and subscribedLayer (ESP-NOW task)
+void warmBootSave();
+// In setup(), after the profile is applied and MTC initialized. Returns true
+// when a playing state was restored.
+bool warmBootRestore();
@@ -0,0 +1,84 @@
+#pragma once
+
+// Host stubs for the native test environment (platformio.ini [env:native]).
+// Just enough of the Arduino core, ESP-IDF and FreeRTOS for the firmware
+// sources to compile and run single-threaded on a PC. Time is virtual:
+// millis(), micros() and esp_timer_get_time() read stub::nowUs, which only
+// moves when a test advances it. Nothing here runs tasks or timers.
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <freertos/FreeRTOS.h>
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+
+namespace stub {
+inline uint64_t nowUs = 0;
+
+inline void advanceUs(uint64_t us) {
+  nowUs += us;
+}
+}  // namespace stub
+
+inline unsigned long millis() {
+  return static_cast<unsigned long>(stub::nowUs / 1000);
+}
+inline unsigned long micros() {
+  return static_cast<unsigned long>(stub::nowUs);
+}
+inline void delay(unsigned long ms) {
+  stub::advanceUs(static_cast<uint64_t>(ms) * 1000);
+}
+inline long random(long howBig) {
+  return howBig > 0 ? std::rand() % howBig : 0;
+}
+inline long random(long howSmall, long howBig) {
+  return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall;
+}
+inline uint32_t getCpuFrequencyMhz() {
+  return 240;
+}
+
+class String {
+ public:
+  String(const char* s = "") : s_(s) {}
+  size_t length() const { return s_.size(); }
+  const char* c_str() const { return s_.c_str(); }
+  bool operator==(const char* other) const { return s_ == other; }
+
+ private:
+  std::string s_;
+};
+
+// Output is discarded: the firmware log is noise in test results
+class HardwareSerial {
+ public:
+  void begin(unsigned long) {}
+  template <typename T>
+  size_t print(const T&) { return 0; }
+  size_t println() { return 0; }
+  template <typename T>
+  size_t println(const T&) { return 0; }
+  int printf(const char*, ...) __attribute__((format(printf, 2, 3))) { return 0; }
+  size_t write(const uint8_t*, size_t length) { return length; }
+  void flush() {}
+  operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define SET_LOOP_TASK_STACK_SIZE(sz) \
+  size_t getArduinoLoopTaskStackSize(void) { return sz; }
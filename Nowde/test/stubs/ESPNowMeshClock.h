@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Arduino.h"
+
+// Mesh time = virtual local time + stub::meshOffsetUs; the sync state is set
+// by the test
+enum class SyncState { UNSYNCED, SYNCING, SYNCED };
+
+namespace stub {
+inline int64_t meshOffsetUs = 0;
+inline SyncState meshSyncState = SyncState::SYNCED;
+}  // namespace stub
+
+class ESPNowMeshClock {
+ public:
+  ESPNowMeshClock(uint32_t, float, uint32_t, uint32_t, uint8_t) {}
+  void begin(bool) {}
+  void loop() {}
+  void setDebugLog(int) {}
+  bool handleReceive(const uint8_t*, const uint8_t*, int) { return false; }
+  uint64_t meshMicros() { return static_cast<uint64_t>(static_cast<int64_t>(stub::nowUs) + stub::meshOffsetUs); }
+  uint32_t meshMillis() { return static_cast<uint32_t>(meshMicros() / 1000); }
+  SyncState getSyncState() { return stub::meshSyncState; }
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+// In-memory NVS: one namespace-less key space that lives as long as the test
+class Preferences {
+ public:
+  bool begin(const char*, bool = false) { return true; }
+  void end() {}
+  bool clear() {
+    store_.clear();
+    return true;
+  }
+  bool isKey(const char* key) { return store_.count(key) != 0; }
+  bool remove(const char* key) { return store_.erase(key) != 0; }
+
+  size_t putBytes(const char* key, const void* value, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    store_[key].assign(bytes, bytes + length);
+    return length;
+  }
+  size_t getBytes(const char* key, void* out, size_t maxLength) {
+    auto it = store_.find(key);
+    if (it == store_.end() || it->second.size() > maxLength) {
+      return 0;
+    }
+    memcpy(out, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+  size_t getBytesLength(const char* key) {
+    auto it = store_.find(key);
+    return it == store_.end() ? 0 : it->second.size();
+  }
+
+  size_t putUChar(const char* key, uint8_t value) { return putBytes(key, &value, 1); }
+  uint8_t getUChar(const char* key, uint8_t defaultValue = 0) {
+    uint8_t value = defaultValue;
+    return getBytes(key, &value, 1) == 1 ? value : defaultValue;
+  }
+  size_t putString(const char* key, const char* value) { return putBytes(key, value, strlen(value) + 1); }
+  String getString(const char* key, const String& defaultValue = String()) {
+    auto it = store_.find(key);
+    return it == store_.end() ? defaultValue : String(reinterpret_cast<const char*>(it->second.data()));
+  }
+
+ private:
+  std::map<std::string, std::vector<uint8_t>> store_;
+};
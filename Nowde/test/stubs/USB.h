@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_event.h"
+
+typedef enum {
+  ARDUINO_USB_ANY_EVENT = -1,
+  ARDUINO_USB_STARTED_EVENT = 0,
+  ARDUINO_USB_STOPPED_EVENT,
+  ARDUINO_USB_SUSPEND_EVENT,
+  ARDUINO_USB_RESUME_EVENT,
+  ARDUINO_USB_MAX_EVENT
+} arduino_usb_event_t;
+
+class ESPUSB {
+ public:
+  bool VID(uint16_t) { return true; }
+  bool PID(uint16_t) { return true; }
+  bool productName(const char*) { return true; }
+  bool manufacturerName(const char*) { return true; }
+  bool begin() { return true; }
+  void onEvent(arduino_usb_event_t, esp_event_handler_t) {}
+  operator bool() const { return true; }
+};
+
+inline ESPUSB USB;
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Nothing is ever received; output goes through tud_midi_stream_write
+typedef struct {
+  uint8_t header;
+  uint8_t byte1;
+  uint8_t byte2;
+  uint8_t byte3;
+} midiEventPacket_t;
+
+class USBMIDI {
+ public:
+  void begin() {}
+  bool readPacket(midiEventPacket_t*) { return false; }
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Every update fails to start: there is no flash to write
+#define U_FLASH 0
+
+class UpdateClass {
+ public:
+  bool begin(size_t, int = U_FLASH) { return false; }
+  size_t write(uint8_t*, size_t) { return 0; }
+  bool end(bool = false) { return false; }
+  void abort() {}
+  bool isRunning() { return false; }
+  const char* errorString() { return "no flash on host"; }
+  uint8_t getError() { return 1; }
+  size_t size() { return 0; }
+};
+
+inline UpdateClass Update;
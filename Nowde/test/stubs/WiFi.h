@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define WIFI_STA 1
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class WiFiClass {
+ public:
+  bool mode(int) { return true; }
+  bool disconnect() { return true; }
+  String macAddress() { return String("02:00:00:00:00:01"); }
+  int16_t scanNetworks(bool = false, bool = false, bool = false, uint32_t = 300, uint8_t = 0) { return 0; }
+  int16_t scanComplete() { return WIFI_SCAN_FAILED; }
+  void scanDelete() {}
+  int32_t RSSI(uint8_t) { return 0; }
+  int32_t channel(uint8_t) { return 1; }
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Always mounted; written bytes are counted
+namespace stub {
+inline uint32_t usbMidiBytesWritten = 0;
+}  // namespace stub
+
+inline bool tud_mounted() {
+  return true;
+}
+inline uint32_t tud_midi_stream_write(uint8_t, const uint8_t*, uint32_t size) {
+  stub::usbMidiBytesWritten += size;
+  return size;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Cycles of a 240 MHz core, from the host's steady clock (on-device benchmarks)
+inline uint32_t esp_cpu_get_cycle_count() {
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  return static_cast<uint32_t>(static_cast<uint64_t>(ns) * 240 / 1000);
+}
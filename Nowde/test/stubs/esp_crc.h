@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Same result as the ROM implementation (reflected CRC-32, 0xEDB88320)
+inline uint32_t esp_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Frames handed to esp_now_send are counted, never delivered
+#define ESP_NOW_ETH_ALEN 6
+#define ESP_NOW_MAX_DATA_LEN 250
+#define ESP_NOW_MAX_TOTAL_PEER_NUM 20
+
+typedef enum { ESP_NOW_SEND_SUCCESS = 0, ESP_NOW_SEND_FAIL } esp_now_send_status_t;
+
+typedef struct {
+  uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+  uint8_t lmk[16];
+  uint8_t channel;
+  int ifidx;
+  bool encrypt;
+  void* priv;
+} esp_now_peer_info_t;
+
+typedef struct {
+  uint8_t* src_addr;
+  uint8_t* des_addr;
+  wifi_pkt_rx_ctrl_t* rx_ctrl;
+} esp_now_recv_info_t;
+
+typedef wifi_tx_info_t esp_now_send_info_t;
+typedef void (*esp_now_send_cb_t)(const esp_now_send_info_t*, esp_now_send_status_t);
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t*, const uint8_t*, int);
+
+namespace stub {
+inline uint32_t espnowFramesSent = 0;
+inline uint32_t espnowBytesSent = 0;
+}  // namespace stub
+
+inline esp_err_t esp_now_init() {
+  return ESP_OK;
+}
+inline esp_err_t esp_now_send(const uint8_t*, const uint8_t*, size_t length) {
+  stub::espnowFramesSent++;
+  stub::espnowBytesSent += length;
+  return ESP_OK;
+}
+inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t*) {
+  return ESP_OK;
+}
+inline esp_err_t esp_now_del_peer(const uint8_t*) {
+  return ESP_OK;
+}
+inline esp_err_t esp_now_mod_peer(const esp_now_peer_info_t*) {
+  return ESP_OK;
+}
+inline bool esp_now_is_peer_exist(const uint8_t*) {
+  return true;
+}
+inline esp_err_t esp_now_register_send_cb(esp_now_send_cb_t) {
+  return ESP_OK;
+}
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t) {
+  return ESP_OK;
+}
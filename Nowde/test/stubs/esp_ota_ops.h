@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+// No flash on the host: there is no partition to update
+typedef uint32_t esp_ota_handle_t;
+
+inline const esp_partition_t* esp_ota_get_running_partition() {
+  return nullptr;
+}
+inline const esp_partition_t* esp_ota_get_boot_partition() {
+  return nullptr;
+}
+inline const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t*) {
+  return nullptr;
+}
+inline esp_err_t esp_ota_begin(const esp_partition_t*, size_t, esp_ota_handle_t*) {
+  return ESP_FAIL;
+}
+inline esp_err_t esp_ota_write_with_offset(esp_ota_handle_t, const void*, size_t, uint32_t) {
+  return ESP_FAIL;
+}
+inline esp_err_t esp_ota_end(esp_ota_handle_t) {
+  return ESP_FAIL;
+}
+inline esp_err_t esp_ota_abort(esp_ota_handle_t) {
+  return ESP_OK;
+}
+inline esp_err_t esp_ota_set_boot_partition(const esp_partition_t*) {
+  return ESP_FAIL;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+} esp_partition_t;
+
+inline esp_err_t esp_partition_read(const esp_partition_t*, size_t, void*, size_t) {
+  return ESP_FAIL;
+}
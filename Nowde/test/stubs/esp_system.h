@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+typedef enum {
+  ESP_RST_UNKNOWN,
+  ESP_RST_POWERON,
+  ESP_RST_EXT,
+  ESP_RST_SW,
+  ESP_RST_PANIC,
+  ESP_RST_INT_WDT,
+  ESP_RST_TASK_WDT,
+  ESP_RST_WDT,
+  ESP_RST_DEEPSLEEP,
+  ESP_RST_BROWNOUT,
+  ESP_RST_SDIO
+} esp_reset_reason_t;
+
+inline esp_reset_reason_t esp_reset_reason() {
+  return ESP_RST_POWERON;
+}
+[[noreturn]] inline void esp_restart() {
+  std::abort();
+}
+inline uint32_t esp_get_free_heap_size(void) {
+  return 0;
+}
+inline uint32_t esp_get_minimum_free_heap_size(void) {
+  return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Arduino.h"
+#include "esp_err.h"
+
+// Timers are created but never fire on their own; a test calls
+// stub::fireTimer() to run a callback at the current virtual time
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct esp_timer {
+  esp_timer_create_args_t args;
+  bool active;
+};
+typedef esp_timer* esp_timer_handle_t;
+
+namespace stub {
+inline void fireTimer(esp_timer_handle_t timer) {
+  if (timer && timer->active) {
+    timer->args.callback(timer->args.arg);
+  }
+}
+}  // namespace stub
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  *out = new esp_timer{*args, false};
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t) {
+  timer->active = true;
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t) {
+  timer->active = true;
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  timer->active = false;
+  return ESP_OK;
+}
+inline bool esp_timer_is_active(esp_timer_handle_t timer) {
+  return timer->active;
+}
+inline int64_t esp_timer_get_time() {
+  return static_cast<int64_t>(stub::nowUs);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+inline esp_err_t esp_wifi_set_channel(uint8_t, wifi_second_chan_t) {
+  return ESP_OK;
+}
+inline esp_err_t esp_wifi_get_channel(uint8_t* primary, wifi_second_chan_t* second) {
+  *primary = 1;
+  *second = WIFI_SECOND_CHAN_NONE;
+  return ESP_OK;
+}
+inline esp_err_t esp_wifi_set_promiscuous(bool) {
+  return ESP_OK;
+}
+inline esp_err_t esp_wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t) {
+  return ESP_OK;
+}
+inline esp_err_t esp_wifi_set_promiscuous_filter(const wifi_promiscuous_filter_t*) {
+  return ESP_OK;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+typedef struct {
+  signed rssi : 8;
+  unsigned rate : 5;
+  unsigned channel : 4;
+  signed noise_floor : 8;
+  unsigned timestamp : 32;
+  unsigned sig_len : 12;
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct {
+  const uint8_t* des_addr;
+  const uint8_t* src_addr;
+  int ifidx;
+} wifi_tx_info_t;
+
+typedef enum { WIFI_SECOND_CHAN_NONE = 0, WIFI_SECOND_CHAN_ABOVE, WIFI_SECOND_CHAN_BELOW } wifi_second_chan_t;
+typedef enum { WIFI_PKT_MGMT, WIFI_PKT_CTRL, WIFI_PKT_DATA, WIFI_PKT_MISC } wifi_promiscuous_pkt_type_t;
+
+typedef struct {
+  uint32_t filter_mask;
+} wifi_promiscuous_filter_t;
+
+typedef struct {
+  wifi_pkt_rx_ctrl_t rx_ctrl;
+  uint8_t payload[0];
+} wifi_promiscuous_pkt_t;
+
+typedef void (*wifi_promiscuous_cb_t)(void* buf, wifi_promiscuous_pkt_type_t type);
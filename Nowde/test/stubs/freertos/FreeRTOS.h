@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define pdTICKS_TO_MS(x) ((uint32_t)(x))
+#define portMAX_DELAY 0xFFFFFFFF
+#define configMAX_PRIORITIES 25
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define errQUEUE_FULL 0
+#define tskIDLE_PRIORITY 0
+
+// Single-threaded host: critical sections have nothing to exclude
+typedef struct {
+  int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(m) (void)(m)
+#define portEXIT_CRITICAL(m) (void)(m)
+#define portENTER_CRITICAL_ISR(m) (void)(m)
+#define portEXIT_CRITICAL_ISR(m) (void)(m)
+#define portENTER_CRITICAL_SAFE(m) (void)(m)
+#define portEXIT_CRITICAL_SAFE(m) (void)(m)
+#define portYIELD_FROM_ISR(x) (void)(x)
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "FreeRTOS.h"
+
+// Bounded FIFO. No task drains queues on the host, so a send to a full queue
+// drops the oldest item instead of failing: producers behave as if their
+// consumer kept up, and stub::queueOverwritten says how often that happened.
+namespace stub {
+struct Queue {
+  size_t depth;
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+inline uint32_t queueOverwritten = 0;
+}  // namespace stub
+
+typedef stub::Queue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t depth, UBaseType_t itemSize) {
+  return new stub::Queue{depth, itemSize, {}};
+}
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t) {
+  if (queue->items.size() == queue->depth) {
+    queue->items.pop_front();
+    stub::queueOverwritten++;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(item);
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  return pdTRUE;
+}
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t) {
+  if (queue->items.empty()) {
+    return pdFALSE;
+  }
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  return pdTRUE;
+}
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  return queue->items.size();
+}
+inline UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+  return queue->depth - queue->items.size();
+}
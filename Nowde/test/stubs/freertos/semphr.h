@@ -0,0 +1,23 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Single-threaded host: every take succeeds
+typedef void* SemaphoreHandle_t;
+
+namespace stub {
+inline int semaphore = 0;
+}  // namespace stub
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return &stub::semaphore;
+}
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return &stub::semaphore;
+}
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) {
+  return pdTRUE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) {
+  return pdTRUE;
+}
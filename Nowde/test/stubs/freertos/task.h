@@ -0,0 +1,42 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Tasks are never started; the test itself is the one "current" task
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+namespace stub {
+inline int testTask = 0;
+}  // namespace stub
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+  if (handle) {
+    *handle = nullptr;
+  }
+  return pdPASS;
+}
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return &stub::testTask;
+}
+inline TaskHandle_t xTaskGetHandle(const char*) {
+  return nullptr;
+}
+inline void vTaskDelay(TickType_t) {}
+inline TickType_t xTaskGetTickCount() {
+  return 0;
+}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) {
+  return 0;
+}
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) {
+  return pdPASS;
+}
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+  return 0;
+}
+inline int xPortGetCoreID() {
+  return 0;
+}
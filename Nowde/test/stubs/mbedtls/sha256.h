@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// Not a hash: OTA images are never verified on the host
+typedef struct {
+  int unused;
+} mbedtls_sha256_context;
+
+inline void mbedtls_sha256_init(mbedtls_sha256_context*) {}
+inline void mbedtls_sha256_free(mbedtls_sha256_context*) {}
+inline int mbedtls_sha256_starts(mbedtls_sha256_context*, int) {
+  return 0;
+}
+inline int mbedtls_sha256_update(mbedtls_sha256_context*, const unsigned char*, size_t) {
+  return 0;
+}
+inline int mbedtls_sha256_finish(mbedtls_sha256_context*, unsigned char* output) {
+  memset(output, 0, 32);
+  return 0;
+}
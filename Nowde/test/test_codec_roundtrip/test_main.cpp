@@ -0,0 +1,294 @@
+// 7-bit codec round trip (pio test -e native -f test_codec_roundtrip).
+// The word-at-a-time codec in sysex_codec.h must produce exactly what the
+// original byte-wise encode7bit/decode7bit did, for every length a message can
+// carry and for every decoder the firmware uses. The decode micro-benchmark at
+// the end prints both implementations side by side on this host.
+
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "sysex_codec.h"
+
+namespace {
+
+constexpr int MAX_LEN = 600;
+
+// ---- Reference: the byte-wise codec sysex_codec.cpp replaced ----
+
+int referenceEncode7bit(const uint8_t* input, int inputLen, uint8_t* output) {
+  int outIdx = 0;
+  int inIdx = 0;
+  while (inIdx < inputLen) {
+    uint8_t msbByte = 0;
+    int chunkSize = std::min(7, inputLen - inIdx);
+    for (int i = 0; i < chunkSize; i++) {
+      if (input[inIdx + i] & 0x80) {
+        msbByte |= (1 << i);
+      }
+    }
+    output[outIdx++] = msbByte;
+    for (int i = 0; i < chunkSize; i++) {
+      output[outIdx++] = input[inIdx++] & 0x7F;
+    }
+  }
+  return outIdx;
+}
+
+int referenceDecode7bit(const uint8_t* input, int inputLen, uint8_t* output) {
+  int outIdx = 0;
+  int inIdx = 0;
+  while (inIdx < inputLen) {
+    uint8_t msbByte = input[inIdx++];
+    int chunkSize = std::min(7, inputLen - inIdx);
+    for (int i = 0; i < chunkSize && inIdx < inputLen; i++) {
+      output[outIdx] = input[inIdx++];
+      if (msbByte & (1 << i)) {
+        output[outIdx] |= 0x80;
+      }
+      outIdx++;
+    }
+  }
+  return outIdx;
+}
+
+// ---- Inputs ----
+
+uint32_t nextRandom(uint32_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+enum Pattern { PATTERN_RANDOM, PATTERN_ZERO, PATTERN_ONES, PATTERN_MSB_ONLY, PATTERN_LOW_ONLY, PATTERN_COUNT };
+
+std::vector<uint8_t> makeRaw(int len, Pattern pattern, uint32_t seed) {
+  std::vector<uint8_t> raw(len);
+  for (int i = 0; i < len; i++) {
+    switch (pattern) {
+      case PATTERN_RANDOM: raw[i] = static_cast<uint8_t>(nextRandom(&seed)); break;
+      case PATTERN_ZERO: raw[i] = 0x00; break;
+      case PATTERN_ONES: raw[i] = 0xFF; break;
+      case PATTERN_MSB_ONLY: raw[i] = 0x80; break;
+      case PATTERN_LOW_ONLY: raw[i] = 0x7F; break;
+      default: break;
+    }
+  }
+  return raw;
+}
+
+// Padding past the expected output catches writes beyond it
+constexpr size_t GUARD = 16;
+constexpr uint8_t GUARD_BYTE = 0xA5;
+
+bool guardIntact(const std::vector<uint8_t>& buffer, size_t used) {
+  for (size_t i = used; i < buffer.size(); i++) {
+    if (buffer[i] != GUARD_BYTE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// ---- Fixed-size variants, for every N from 1 to 40 (covers 4, 6, 16, 36 in use) ----
+
+template <size_t N>
+bool checkFixed(uint32_t seed) {
+  uint8_t raw[N];
+  for (size_t i = 0; i < N; i++) {
+    raw[i] = static_cast<uint8_t>(nextRandom(&seed));
+  }
+  uint8_t expected[encoded7bitSize(N)];
+  referenceEncode7bit(raw, N, expected);
+
+  uint8_t encoded[encoded7bitSize(N) + GUARD];
+  memset(encoded, GUARD_BYTE, sizeof(encoded));
+  encode7bitFixed<N>(raw, encoded);
+  if (memcmp(encoded, expected, sizeof(expected)) != 0) {
+    return false;
+  }
+
+  uint8_t decoded[N + GUARD];
+  memset(decoded, GUARD_BYTE, sizeof(decoded));
+  decode7bitFixed<N>(expected, decoded);
+  if (memcmp(decoded, raw, N) != 0) {
+    return false;
+  }
+  for (size_t i = 0; i < GUARD; i++) {
+    if (encoded[encoded7bitSize(N) + i] != GUARD_BYTE || decoded[N + i] != GUARD_BYTE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <size_t... Ns>
+int firstFixedFailure(std::index_sequence<Ns...>) {
+  int failed = 0;
+  // Sizes start at 1: index_sequence counts from 0
+  ((failed == 0 && !checkFixed<Ns + 1>(0x9E3779B9u + Ns) ? failed = Ns + 1 : 0), ...);
+  return failed;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_encode_matches_reference() {
+  for (int p = 0; p < PATTERN_COUNT; p++) {
+    for (int len = 0; len <= MAX_LEN; len++) {
+      std::vector<uint8_t> raw = makeRaw(len, static_cast<Pattern>(p), 0x2545F491u + len);
+      std::vector<uint8_t> expected(encoded7bitSize(len));
+      int expectedLen = referenceEncode7bit(raw.data(), len, expected.data());
+
+      std::vector<uint8_t> encoded(encoded7bitSize(len) + GUARD, GUARD_BYTE);
+      int encodedLen = encode7bit(raw.data(), len, encoded.data());
+
+      TEST_ASSERT_EQUAL_MESSAGE(expectedLen, encodedLen, "encoded length");
+      TEST_ASSERT_EQUAL(static_cast<int>(encoded7bitSize(len)), encodedLen);
+      TEST_ASSERT_TRUE_MESSAGE(memcmp(expected.data(), encoded.data(), expectedLen) == 0, "encoded bytes");
+      TEST_ASSERT_TRUE_MESSAGE(guardIntact(encoded, encodedLen), "encode wrote past its output");
+    }
+  }
+}
+
+void test_decode_matches_reference() {
+  for (int p = 0; p < PATTERN_COUNT; p++) {
+    for (int len = 0; len <= MAX_LEN; len++) {
+      std::vector<uint8_t> raw = makeRaw(len, static_cast<Pattern>(p), 0x68E31DA4u + len);
+      std::vector<uint8_t> encoded(encoded7bitSize(len));
+      int encodedLen = referenceEncode7bit(raw.data(), len, encoded.data());
+
+      std::vector<uint8_t> decoded(len + GUARD, GUARD_BYTE);
+      int decodedLen = decode7bit(encoded.data(), encodedLen, decoded.data());
+
+      TEST_ASSERT_EQUAL_MESSAGE(len, decodedLen, "decoded length");
+      TEST_ASSERT_EQUAL(static_cast<int>(decoded7bitSize(encodedLen)), decodedLen);
+      TEST_ASSERT_TRUE_MESSAGE(memcmp(raw.data(), decoded.data(), len) == 0, "decoded bytes");
+      TEST_ASSERT_TRUE_MESSAGE(guardIntact(decoded, len), "decode wrote past its output");
+    }
+  }
+}
+
+// Any 7-bit input, not only what an encoder produces (what a Bridge may send)
+void test_decode_arbitrary_input_matches_reference() {
+  uint32_t seed = 0x1B873593u;
+  for (int len = 0; len <= MAX_LEN; len++) {
+    std::vector<uint8_t> input(len);
+    for (int i = 0; i < len; i++) {
+      input[i] = static_cast<uint8_t>(nextRandom(&seed) & 0x7F);
+    }
+    std::vector<uint8_t> expected(len);
+    int expectedLen = referenceDecode7bit(input.data(), len, expected.data());
+
+    std::vector<uint8_t> decoded(len + GUARD, GUARD_BYTE);
+    int decodedLen = decode7bit(input.data(), len, decoded.data());
+
+    TEST_ASSERT_EQUAL_MESSAGE(expectedLen, decodedLen, "decoded length");
+    TEST_ASSERT_TRUE_MESSAGE(memcmp(expected.data(), decoded.data(), expectedLen) == 0, "decoded bytes");
+    TEST_ASSERT_TRUE_MESSAGE(guardIntact(decoded, decodedLen), "decode wrote past its output");
+  }
+}
+
+void test_group_decoder_matches_reference() {
+  for (int p = 0; p < PATTERN_COUNT; p++) {
+    for (int len = 0; len <= MAX_LEN; len++) {
+      std::vector<uint8_t> raw = makeRaw(len, static_cast<Pattern>(p), 0x85EBCA6Bu + len);
+      std::vector<uint8_t> encoded(encoded7bitSize(len));
+      int encodedLen = referenceEncode7bit(raw.data(), len, encoded.data());
+
+      // One byte at a time, as sysex_stream.h delivers them
+      std::vector<uint8_t> decoded(len + 7 + GUARD, GUARD_BYTE);
+      Sysex7BitGroupDecoder decoder;
+      decoder.reset();
+      size_t written = 0;
+      for (int i = 0; i < encodedLen; i++) {
+        written += decoder.feed(encoded[i], &decoded[written]);
+      }
+      written += decoder.finish(&decoded[written]);
+
+      TEST_ASSERT_EQUAL_MESSAGE(len, static_cast<int>(written), "decoded length");
+      TEST_ASSERT_TRUE_MESSAGE(memcmp(raw.data(), decoded.data(), len) == 0, "decoded bytes");
+      TEST_ASSERT_TRUE_MESSAGE(guardIntact(decoded, written), "group decoder wrote past its output");
+    }
+  }
+}
+
+void test_byte_decoder_matches_reference() {
+  for (int len = 0; len <= MAX_LEN; len++) {
+    std::vector<uint8_t> raw = makeRaw(len, PATTERN_RANDOM, 0xC2B2AE35u + len);
+    std::vector<uint8_t> encoded(encoded7bitSize(len));
+    int encodedLen = referenceEncode7bit(raw.data(), len, encoded.data());
+
+    std::vector<uint8_t> decoded;
+    Sysex7BitDecoder decoder;
+    decoder.reset();
+    for (int i = 0; i < encodedLen; i++) {
+      uint8_t out;
+      if (decoder.feed(encoded[i], &out)) {
+        decoded.push_back(out);
+      }
+    }
+
+    TEST_ASSERT_EQUAL_MESSAGE(len, static_cast<int>(decoded.size()), "decoded length");
+    TEST_ASSERT_TRUE_MESSAGE(len == 0 || memcmp(raw.data(), decoded.data(), len) == 0, "decoded bytes");
+  }
+}
+
+void test_fixed_variants_match_reference() {
+  int failedSize = firstFixedFailure(std::make_index_sequence<40>{});
+  TEST_ASSERT_EQUAL_MESSAGE(0, failedSize, "encode7bitFixed/decode7bitFixed<N> mismatch at this N");
+}
+
+// Decode micro-benchmark: the same ~1 MB of encoded data through both
+// decoders, per message size (a MAC field, a RUNNING_STATE block, an OTA2
+// chunk). Printed only; host timings are not device timings.
+void test_decode_benchmark() {
+  using Clock = std::chrono::steady_clock;
+  constexpr size_t TOTAL_ENCODED = 1 << 20;
+  const int rawSizes[] = {6, 36, 512};
+
+  for (int rawLen : rawSizes) {
+    std::vector<uint8_t> raw = makeRaw(rawLen, PATTERN_RANDOM, 0x27D4EB2Fu);
+    std::vector<uint8_t> encoded(encoded7bitSize(rawLen));
+    int encodedLen = encode7bit(raw.data(), rawLen, encoded.data());
+    size_t runs = TOTAL_ENCODED / encodedLen;
+    std::vector<uint8_t> out(rawLen);
+    uint32_t sink = 0;
+
+    auto start = Clock::now();
+    for (size_t r = 0; r < runs; r++) {
+      sink += referenceDecode7bit(encoded.data(), encodedLen, out.data()) + out[r % rawLen];
+    }
+    auto referenceNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (size_t r = 0; r < runs; r++) {
+      sink += decode7bit(encoded.data(), encodedLen, out.data()) + out[r % rawLen];
+    }
+    auto wordNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    printf("[BENCH] decode7bit %3d raw bytes x %zu: byte-wise %lld us, word-at-a-time %lld us (sink %u)\n", rawLen,
+           runs, static_cast<long long>(referenceNs / 1000), static_cast<long long>(wordNs / 1000), sink);
+    TEST_ASSERT_TRUE(sink != 0);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_encode_matches_reference);
+  RUN_TEST(test_decode_matches_reference);
+  RUN_TEST(test_decode_arbitrary_input_matches_reference);
+  RUN_TEST(test_group_decoder_matches_reference);
+  RUN_TEST(test_byte_decoder_matches_reference);
+  RUN_TEST(test_fixed_variants_match_reference);
+  RUN_TEST(test_decode_benchmark);
+  return UNITY_END();
+}
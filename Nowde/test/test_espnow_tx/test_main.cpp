@@ -0,0 +1,84 @@
+// ESP-NOW TX in-flight budget (pio test -e native -f test_espnow_tx).
+// Mesh clock frames (espnowTxSendExternal, what the firmware's
+// --wrap=esp_now_send routes the library to) share the driver with our own
+// frames; their send callbacks must not free a slot an outstanding data frame
+// still holds.
+
+#include <unity.h>
+
+#include <esp_now.h>
+
+#include "espnow_tx.h"
+#include "nowde_config.h"
+#include "peer_table.h"
+
+namespace {
+
+const uint8_t BROADCAST[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+const uint8_t RECEIVER[6] = {0x02, 0xBE, 0x4C, 0x00, 0x00, 0x01};
+const uint8_t FRAME[16] = {0x42};
+
+// Pumps until the budget or the queue stops it; frames handed to the driver
+uint32_t pump() {
+  uint32_t before = stub::espnowFramesSent;
+  espnowTxPump();
+  return stub::espnowFramesSent - before;
+}
+
+}  // namespace
+
+void setUp() {
+  espnowTxInit();
+}
+void tearDown() {}
+
+void test_mesh_clock_callbacks_do_not_free_data_slots() {
+  uint32_t before = stub::espnowFramesSent;
+  for (int i = 0; i < ESPNOW_TX_MAX_INFLIGHT; i++) {
+    TEST_ASSERT_TRUE(espnowTxSend(BROADCAST, FRAME, sizeof(FRAME)));
+  }
+  TEST_ASSERT_EQUAL(ESPNOW_TX_MAX_INFLIGHT, stub::espnowFramesSent - before);
+
+  // Budget full: these wait in the pool
+  TEST_ASSERT_TRUE(espnowTxSend(RECEIVER, FRAME, sizeof(FRAME)));
+  TEST_ASSERT_TRUE(espnowTxSend(RECEIVER, FRAME, sizeof(FRAME)));
+  TEST_ASSERT_EQUAL(0, pump());
+
+  // Two mesh clock broadcasts go out at once and complete first
+  TEST_ASSERT_EQUAL(ESP_OK, espnowTxSendExternal(BROADCAST, FRAME, sizeof(FRAME)));
+  TEST_ASSERT_EQUAL(ESP_OK, espnowTxSendExternal(BROADCAST, FRAME, sizeof(FRAME)));
+  TEST_ASSERT_EQUAL(ESPNOW_TX_MAX_INFLIGHT + 2, stub::espnowFramesSent - before);
+  espnowTxOnSent(BROADCAST, true);
+  espnowTxOnSent(BROADCAST, true);
+  TEST_ASSERT_EQUAL_MESSAGE(0, pump(), "mesh clock callbacks freed data frame slots");
+
+  // Each data frame callback frees exactly one
+  espnowTxOnSent(BROADCAST, true);
+  TEST_ASSERT_EQUAL(1, pump());
+  espnowTxOnSent(BROADCAST, true);
+  TEST_ASSERT_EQUAL(1, pump());
+  TEST_ASSERT_EQUAL(0, pump());  // Queue empty
+}
+
+void test_mesh_clock_send_beyond_budget_is_counted() {
+  for (int i = 0; i < ESPNOW_TX_MAX_INFLIGHT; i++) {
+    TEST_ASSERT_TRUE(espnowTxSend(BROADCAST, FRAME, sizeof(FRAME)));
+  }
+  TEST_ASSERT_EQUAL(ESP_OK, espnowTxSendExternal(BROADCAST, FRAME, sizeof(FRAME)));
+  TEST_ASSERT_TRUE(espnowTxSend(RECEIVER, FRAME, sizeof(FRAME)));
+
+  // One over budget: the first callback (whichever frame it was) leaves it full
+  espnowTxOnSent(BROADCAST, true);
+  TEST_ASSERT_EQUAL(0, pump());
+  espnowTxOnSent(BROADCAST, true);
+  TEST_ASSERT_EQUAL(1, pump());
+}
+
+int main() {
+  peerTableInit();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_mesh_clock_callbacks_do_not_free_data_slots);
+  RUN_TEST(test_mesh_clock_send_beyond_budget_is_counted);
+  return UNITY_END();
+}
@@ -0,0 +1,114 @@
+// Host benchmark suite (pio test -e native -f test_host_bench).
+// Runs the on-device benchmarks (benchmark.h) against the stubbed platform in
+// test/stubs: SysEx parse throughput, RUNNING_STATE cost against the receiver
+// count and the MTC error of the sync estimator under the RF simulation delay
+// model. Timings are host timings and only comparable between runs on the same
+// machine; the assertions check behaviour and catch gross regressions.
+
+#include <unity.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "benchmark.h"
+#include "midi.h"
+#include "nowde_config.h"
+#include "nowde_state.h"
+#include "peer_table.h"
+#include "sender_mode.h"
+
+namespace {
+
+void report(const char* name, const char* paramName, uint16_t param, const BenchmarkStats& stats) {
+  printf("[BENCH] %-14s %s=%-4u n=%-4u min=%lu avg=%lu max=%lu ns\n", name, paramName, param, stats.samples,
+         static_cast<unsigned long>(stats.minNs), static_cast<unsigned long>(stats.avgNs()),
+         static_cast<unsigned long>(stats.maxNs));
+}
+
+// Receivers join through handleReceiverInfo, like beacons off the air
+void addReceivers(uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    ReceiverInfo info = {};
+    info.type = ESPNOW_MSG_RECEIVER_INFO;
+    snprintf(info.layer, sizeof(info.layer), "layer%u", i % 4);
+    strncpy(info.version, NOWDE_VERSION, sizeof(info.version) - 1);
+    info.mediaIndex = static_cast<uint8_t>(i % 8);
+    const uint8_t mac[6] = {0x02, 0xBE, 0x4C, 0x00, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+    handleReceiverInfo(mac, reinterpret_cast<const uint8_t*>(&info), sizeof(info), -50);
+  }
+}
+
+uint16_t connectedReceivers() {
+  uint16_t count = 0;
+  for (int i = 0; i < MAX_RECEIVERS; i++) {
+    if (receiverTable[i].active && receiverTable[i].connected) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_sysex_parse_throughput() {
+  uint16_t layers = 0;
+  BenchmarkStats stats = benchmarkSysexParse(&layers);
+  report("sysex_parse", "layers", layers, stats);
+
+  TEST_ASSERT_EQUAL(MEDIA_SYNC_BATCH_MAX_LAYERS, layers);
+  TEST_ASSERT_EQUAL(BENCHMARK_ITERATIONS, stats.samples);
+  TEST_ASSERT_TRUE(stats.minNs <= stats.avgNs() && stats.avgNs() <= stats.maxNs);
+  if (stats.avgNs() > 0) {
+    printf("[BENCH] sysex_parse    %lu batch messages/s\n", static_cast<unsigned long>(1000000000ULL / stats.avgNs()));
+  }
+}
+
+void test_running_state_cost_vs_receivers() {
+  const uint16_t counts[] = {0, 1, 8, 16, 32, MAX_RECEIVERS};
+  uint16_t present = 0;
+  for (uint16_t count : counts) {
+    addReceivers(count);
+    present = count;
+    TEST_ASSERT_EQUAL(present, connectedReceivers());
+
+    uint16_t receivers = 0;
+    BenchmarkStats stats = benchmarkRunningState(&receivers);
+    report("running_state", "receivers", receivers, stats);
+
+    TEST_ASSERT_EQUAL(present, receivers);
+    TEST_ASSERT_EQUAL(BENCHMARK_RUNNING_STATE_RUNS, stats.samples);
+  }
+}
+
+void test_mtc_error_under_rf_delay() {
+  // Around 2 ms average and under 10 ms worst case at every delay today;
+  // the limits leave room so only a real loss of tracking fails
+  constexpr uint32_t AVG_LIMIT_MS = 5;
+  constexpr uint32_t MAX_LIMIT_MS = 25;
+  const uint16_t delays[] = {0, 20, 50, 100, 200, 500};
+  for (uint16_t maxDelayMs : delays) {
+    BenchmarkStats stats = benchmarkMtcError(maxDelayMs);
+    printf("[BENCH] mtc_error      delay=%-4u n=%-4u avg=%lu.%03lu max=%lu ms\n", maxDelayMs, stats.samples,
+           static_cast<unsigned long>(stats.avgNs() / 1000000), static_cast<unsigned long>(stats.avgNs() / 1000 % 1000),
+           static_cast<unsigned long>(stats.maxNs / 1000000));
+
+    TEST_ASSERT_GREATER_THAN(0, stats.samples);
+    TEST_ASSERT_LESS_THAN(AVG_LIMIT_MS * 1000000, stats.avgNs());
+    TEST_ASSERT_LESS_THAN(MAX_LIMIT_MS * 1000000, stats.maxNs);
+  }
+}
+
+int main() {
+  peerTableInit();
+  midiInit();
+  senderModeEnabled = true;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sysex_parse_throughput);
+  RUN_TEST(test_running_state_cost_vs_receivers);
+  RUN_TEST(test_mtc_error_under_rf_delay);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+// Sync redundancy trailer (pio test -e native -f test_sync_redundancy).
+// A show stop changes many layers in the same cycle; every one of those
+// transitions has to ride later frames, not only the last
+// MEDIA_SYNC_REDUNDANCY_DEPTH of them.
+
+#include <unity.h>
+
+#include <cstring>
+
+#include "layer_registry.h"
+#include "nowde_config.h"
+#include "sync_redundancy.h"
+
+namespace {
+
+constexpr int BASE_LEN = 16;  // Stands in for the MediaSyncPacket before the trailer
+constexpr uint8_t LAYERS = 3 * MEDIA_SYNC_REDUNDANCY_DEPTH + 1;
+
+struct Frame {
+  uint8_t data[BASE_LEN + sizeof(SyncRedundancyTrailer)];
+  int len;
+};
+
+Frame appendFor(uint8_t layerId) {
+  Frame frame;
+  memset(frame.data, 0, sizeof(frame.data));
+  frame.len = static_cast<int>(syncRedundancyAppend(frame.data, BASE_LEN, layerId));
+  return frame;
+}
+
+// All layers start playing, then stop in the same cycle
+void startThenStopAll(uint8_t firstLayer) {
+  for (uint8_t i = 0; i < LAYERS; i++) {
+    syncRedundancyNote(firstLayer + i, 1, 1000, 1, 5000);
+  }
+  for (uint8_t i = 0; i < LAYERS; i++) {
+    syncRedundancyNote(firstLayer + i, 1, 2000, 0, 6000);
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_own_frame_carries_its_layer_after_many_transitions() {
+  const uint8_t first = 1;
+  startThenStopAll(first);
+
+  for (uint8_t i = 0; i < LAYERS; i++) {
+    Frame frame = appendFor(first + i);
+    TEST_ASSERT_LESS_OR_EQUAL(static_cast<int>(sizeof(frame.data)), frame.len);
+    const SyncTransition* transition = syncRedundancyFind(frame.data, frame.len, BASE_LEN, first + i);
+    TEST_ASSERT_NOT_NULL(transition);
+    TEST_ASSERT_EQUAL(0, transition->state);
+    TEST_ASSERT_EQUAL(2, transition->sequence);  // The stop, not the start before it
+  }
+}
+
+void test_shared_frames_rotate_through_every_layer() {
+  const uint8_t first = 1 + LAYERS;
+  startThenStopAll(first);
+
+  // Beacons and multi-layer batches: every stopped layer within
+  // ceil(LAYERS / depth) frames, however many changed at once
+  bool seen[LAYERS] = {};
+  constexpr int FRAMES = (LAYERS + MEDIA_SYNC_REDUNDANCY_DEPTH - 1) / MEDIA_SYNC_REDUNDANCY_DEPTH;
+  for (int f = 0; f < FRAMES; f++) {
+    Frame frame = appendFor(LAYER_ID_NONE);
+    for (uint8_t i = 0; i < LAYERS; i++) {
+      const SyncTransition* transition = syncRedundancyFind(frame.data, frame.len, BASE_LEN, first + i);
+      if (transition != nullptr && transition->state == 0) {
+        seen[i] = true;
+      }
+    }
+  }
+  for (uint8_t i = 0; i < LAYERS; i++) {
+    TEST_ASSERT_TRUE_MESSAGE(seen[i], "stopped layer missing from the shared trailers");
+  }
+}
+
+void test_newest_transition_goes_first_in_shared_frames() {
+  const uint8_t layer = 1 + 2 * LAYERS;
+  syncRedundancyNote(layer, 4, 0, 1, 7000);
+
+  Frame frame = appendFor(LAYER_ID_NONE);
+  const SyncTransition* transition = syncRedundancyFind(frame.data, frame.len, BASE_LEN, layer);
+  TEST_ASSERT_NOT_NULL(transition);
+  TEST_ASSERT_EQUAL(4, transition->mediaIndex);
+  TEST_ASSERT_EQUAL(7000 + SYNC_ACTION_LEAD_MS, transition->meshTimestamp);
+}
+
+void test_unchanged_state_is_not_a_transition() {
+  const uint8_t layer = 2 + 2 * LAYERS;
+  syncRedundancyNote(layer, 2, 0, 1, 8000);
+  syncRedundancyNote(layer, 2, 500, 1, 8500);
+
+  Frame frame = appendFor(layer);
+  const SyncTransition* transition = syncRedundancyFind(frame.data, frame.len, BASE_LEN, layer);
+  TEST_ASSERT_NOT_NULL(transition);
+  TEST_ASSERT_EQUAL(1, transition->sequence);
+}
+
+int main() {
+  static_assert(2 + 2 * LAYERS <= MAX_LAYER_IDS, "test layers exceed the registry");
+  UNITY_BEGIN();
+  RUN_TEST(test_own_frame_carries_its_layer_after_many_transitions);
+  RUN_TEST(test_shared_frames_rotate_through_every_layer);
+  RUN_TEST(test_newest_transition_goes_first_in_shared_frames);
+  RUN_TEST(test_unchanged_state_is_not_a_transition);
+  return UNITY_END();
+}